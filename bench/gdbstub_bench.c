@@ -0,0 +1,1346 @@
+/** @file
+ * GDB stub benchmark - replays GDB sessions against a mock target.
+ */
+
+/*
+ * Copyright (C) 2020 Alexander Eichner <alexander.eichner@campus.tu-berlin.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * The benchmark drives GDBStubCtxRun() through an in-memory I/O interface against a deterministic mock target,
+ * so every run of a trace produces exactly the same replies. A trace is the data the remote end sent to the stub,
+ * either generated for one of the built-in sessions or recorded from a live session. Recording serves the mock
+ * target on a TCP port and captures everything crossing the I/O interface, the replies are stored as well so
+ * a replay can verify the stub still answers the same way.
+ *
+ * Recorded trace file layout, all integers are little endian:
+ *     "GDBTRC01"                                  magic
+ *     { uint8_t bDir; uint32_t cb; uint8_t ab[cb]; }  records until the end of the file,
+ *                                                 bDir is GDBBENCH_TRC_DIR_IN or GDBBENCH_TRC_DIR_OUT
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+#include <libgdbstub.h>
+
+
+/** Magic at the start of a recorded trace file. */
+#define GDBBENCH_TRC_MAGIC          "GDBTRC01"
+/** Record holding data the remote end sent to the stub. */
+#define GDBBENCH_TRC_DIR_IN         'i'
+/** Record holding data the stub sent to the remote end. */
+#define GDBBENCH_TRC_DIR_OUT        'o'
+
+/** Size of the mock target memory, addresses wrap around. */
+#define GDBBENCH_TGT_MEM_SIZE       (16 * 1024 * 1024)
+/** Number of bytes read by a single 'm' packet of the memory dump trace. */
+#define GDBBENCH_DUMP_CHUNK         0x800
+/** Number of steps of the stepping trace. */
+#define GDBBENCH_STEP_COUNT         256
+
+
+/**
+ * A growable byte buffer.
+ */
+typedef struct GDBBENCHBUF
+{
+    /** The data. */
+    uint8_t                 *pbData;
+    /** Number of bytes used. */
+    size_t                  cbData;
+    /** Number of bytes allocated. */
+    size_t                  cbAlloc;
+} GDBBENCHBUF;
+/** Pointer to a growable byte buffer. */
+typedef GDBBENCHBUF *PGDBBENCHBUF;
+
+
+/**
+ * A trace to replay.
+ */
+typedef struct GDBBENCHTRACE
+{
+    /** Name of the trace for the report. */
+    const char              *pszName;
+    /** Data sent by the remote end. */
+    GDBBENCHBUF             In;
+    /** Replies sent by the stub when the trace was recorded, empty if unknown. */
+    GDBBENCHBUF             Out;
+    /** Sizes of the individual reads (size_t) when the trace was recorded, empty if everything arrived at once. */
+    GDBBENCHBUF             Reads;
+    /** Number of packets the remote end sent. */
+    uint64_t                cPkts;
+} GDBBENCHTRACE;
+/** Pointer to a trace. */
+typedef GDBBENCHTRACE *PGDBBENCHTRACE;
+
+
+/**
+ * The in-memory transport state.
+ */
+typedef struct GDBBENCHIO
+{
+    /** The data to hand to the stub. */
+    const uint8_t           *pbIn;
+    /** Size of the data in bytes. */
+    size_t                  cbIn;
+    /** Current read offset. */
+    size_t                  offIn;
+    /** Offset up to which data is available for reading right now. */
+    size_t                  offInAvail;
+    /** Maximum number of bytes returned by a single read, 0 for no limit. */
+    size_t                  cbReadMax;
+    /** Number of bytes written by the stub. */
+    uint64_t                cbOut;
+    /** Replies to compare the written data against, NULL if not verifying. */
+    const uint8_t           *pbVerify;
+    /** Size of the replies to compare against. */
+    size_t                  cbVerify;
+    /** Offset of the first mismatch, UINT64_MAX if everything matched so far. */
+    uint64_t                offMismatch;
+} GDBBENCHIO;
+/** Pointer to the in-memory transport state. */
+typedef GDBBENCHIO *PGDBBENCHIO;
+
+
+/**
+ * The socket transport state used while recording.
+ */
+typedef struct GDBBENCHRECIO
+{
+    /** The connected socket. */
+    int                     iFdSock;
+    /** The trace file to record to. */
+    FILE                    *pFile;
+} GDBBENCHRECIO;
+/** Pointer to the socket transport state. */
+typedef GDBBENCHRECIO *PGDBBENCHRECIO;
+
+
+/** Latency of every mock target callback in nanoseconds. */
+static uint64_t g_cNsTgtLatency = 0;
+/** Number of memory allocations done by the stub. */
+static uint64_t g_cAllocs = 0;
+/** The mock target registers. */
+static uint32_t g_au32TgtRegs[17];
+/** The mock target memory. */
+static uint8_t *g_pbTgtMem = NULL;
+
+
+/**
+ * Mock target registers (ARM).
+ */
+static const GDBSTUBREG g_aGdbStubRegs[] =
+{
+    { "r0",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r1",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r2",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r3",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r4",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r5",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r6",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r7",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r8",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r9",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r10",  32, GDBSTUBREGTYPE_GP,        0 },
+    { "r11",  32, GDBSTUBREGTYPE_GP,        GDBSTUBREG_F_EXPEDITE },
+    { "r12",  32, GDBSTUBREGTYPE_GP,        0 },
+    { "sp",   32, GDBSTUBREGTYPE_STACK_PTR, GDBSTUBREG_F_EXPEDITE },
+    { "lr",   32, GDBSTUBREGTYPE_CODE_PTR,  0 },
+    { "pc",   32, GDBSTUBREGTYPE_PC,        GDBSTUBREG_F_EXPEDITE },
+    { "cpsr", 32, GDBSTUBREGTYPE_STATUS,    0 },
+    { NULL,    0, GDBSTUBREGTYPE_INVALID,   0 }
+};
+
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ *
+ * @returns Timestamp.
+ */
+static uint64_t gdbBenchTimeNs(void)
+{
+    struct timespec Ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &Ts);
+    return (uint64_t)Ts.tv_sec * 1000000000ULL + (uint64_t)Ts.tv_nsec;
+}
+
+
+/**
+ * Simulates the configured target latency by spinning (sleeping is far too coarse for it).
+ *
+ * @returns nothing.
+ */
+static void gdbBenchTgtLatency(void)
+{
+    if (g_cNsTgtLatency)
+    {
+        uint64_t tsEnd = gdbBenchTimeNs() + g_cNsTgtLatency;
+        while (gdbBenchTimeNs() < tsEnd)
+            ;
+    }
+}
+
+
+/**
+ * Resets the mock target to the state at the beginning of a session.
+ *
+ * @returns nothing.
+ */
+static void gdbBenchTgtReset(void)
+{
+    for (uint32_t i = 0; i < 17; i++)
+        g_au32TgtRegs[i] = i * 0x01010101;
+    g_au32TgtRegs[13] = 0x00800000; /* sp */
+    g_au32TgtRegs[15] = 0x00010000; /* pc */
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnMemAlloc}
+ */
+static void *gdbBenchIfMemAlloc(GDBSTUBCTX hGdbStubCtx, void *pvUser, size_t cb)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    g_cAllocs++;
+    return calloc(1, cb);
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnMemFree}
+ */
+static void gdbBenchIfMemFree(GDBSTUBCTX hGdbStubCtx, void *pvUser, void *pv)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    free(pv);
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtGetState}
+ */
+static GDBSTUBTGTSTATE gdbBenchIfTgtGetState(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    /* The target never runs for real, see gdbBenchIfTgtCont(). */
+    return GDBSTUBTGTSTATE_STOPPED;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtStop}
+ */
+static int gdbBenchIfTgtStop(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    gdbBenchTgtLatency();
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtRestart}
+ */
+static int gdbBenchIfTgtRestart(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    gdbBenchTgtLatency();
+    gdbBenchTgtReset();
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtKill}
+ */
+static int gdbBenchIfTgtKill(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    gdbBenchTgtLatency();
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtStep}
+ */
+static int gdbBenchIfTgtStep(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    gdbBenchTgtLatency();
+    g_au32TgtRegs[15] += 4;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtCont}
+ */
+static int gdbBenchIfTgtCont(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)pvUser;
+
+    /*
+     * The target hits a breakpoint right away, notified like an asynchronous stop so the stop reply
+     * goes out the same way for the polling transport used while recording and the in-memory one.
+     */
+    gdbBenchTgtLatency();
+    return GDBStubCtxNotifyStop(hGdbStubCtx, GDBSTUBSTOPREASON_TRAP);
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtMemRead}
+ */
+static int gdbBenchIfTgtMemRead(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtMemAddr, void *pvDst, size_t cbRead)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    uint8_t *pbDst = (uint8_t *)pvDst;
+
+    gdbBenchTgtLatency();
+    while (cbRead)
+    {
+        size_t offMem = (size_t)(GdbTgtMemAddr % GDBBENCH_TGT_MEM_SIZE);
+        size_t cbThisRead = GDBBENCH_TGT_MEM_SIZE - offMem;
+        if (cbThisRead > cbRead)
+            cbThisRead = cbRead;
+
+        memcpy(pbDst, &g_pbTgtMem[offMem], cbThisRead);
+        pbDst         += cbThisRead;
+        cbRead        -= cbThisRead;
+        GdbTgtMemAddr += cbThisRead;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtMemWrite}
+ */
+static int gdbBenchIfTgtMemWrite(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtMemAddr, const void *pvSrc, size_t cbWrite)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    const uint8_t *pbSrc = (const uint8_t *)pvSrc;
+
+    gdbBenchTgtLatency();
+    while (cbWrite)
+    {
+        size_t offMem = (size_t)(GdbTgtMemAddr % GDBBENCH_TGT_MEM_SIZE);
+        size_t cbThisWrite = GDBBENCH_TGT_MEM_SIZE - offMem;
+        if (cbThisWrite > cbWrite)
+            cbThisWrite = cbWrite;
+
+        memcpy(&g_pbTgtMem[offMem], pbSrc, cbThisWrite);
+        pbSrc         += cbThisWrite;
+        cbWrite       -= cbThisWrite;
+        GdbTgtMemAddr += cbThisWrite;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtRegsRead}
+ */
+static int gdbBenchIfTgtRegsRead(GDBSTUBCTX hGdbStubCtx, void *pvUser, uint32_t *paRegs, uint32_t cRegs, void *pvDst)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    uint32_t *pau32Regs = (uint32_t *)pvDst;
+
+    gdbBenchTgtLatency();
+    for (uint32_t i = 0; i < cRegs; i++)
+        pau32Regs[i] = g_au32TgtRegs[paRegs[i]];
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtRegsWrite}
+ */
+static int gdbBenchIfTgtRegsWrite(GDBSTUBCTX hGdbStubCtx, void *pvUser, uint32_t *paRegs, uint32_t cRegs, const void *pvSrc)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    const uint32_t *pau32Regs = (const uint32_t *)pvSrc;
+
+    gdbBenchTgtLatency();
+    for (uint32_t i = 0; i < cRegs; i++)
+        g_au32TgtRegs[paRegs[i]] = pau32Regs[i];
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtTpSet}
+ */
+static int gdbBenchIfTgtTpSet(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind,
+                              GDBSTUBTPACTION enmTpAction)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+    (void)GdbTgtTpAddr;
+    (void)enmTpType;
+    (void)uKind;
+    (void)enmTpAction;
+
+    gdbBenchTgtLatency();
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtTpClear}
+ */
+static int gdbBenchIfTgtTpClear(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+    (void)GdbTgtTpAddr;
+    (void)enmTpType;
+    (void)uKind;
+
+    gdbBenchTgtLatency();
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtMemMap}
+ */
+static int gdbBenchIfTgtMemMap(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtMemAddr, size_t cbMap, const void **ppvMap,
+                               size_t *pcbMapped)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    size_t offMem = (size_t)(GdbTgtMemAddr % GDBBENCH_TGT_MEM_SIZE);
+    size_t cbMapped = GDBBENCH_TGT_MEM_SIZE - offMem;
+
+    gdbBenchTgtLatency();
+    *ppvMap    = &g_pbTgtMem[offMem];
+    *pcbMapped = cbMapped < cbMap ? cbMapped : cbMap;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTgtMemUnmap}
+ */
+static void gdbBenchIfTgtMemUnmap(GDBSTUBCTX hGdbStubCtx, void *pvUser, const void *pvMap, size_t cbMapped)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+    (void)pvMap;
+    (void)cbMapped;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIF,pfnTimeNsQuery}
+ */
+static uint64_t gdbBenchIfTimeNsQuery(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+    (void)pvUser;
+
+    return gdbBenchTimeNs();
+}
+
+
+/**
+ * Mock target interface callback table, pfnTgtMemMap and pfnTgtMemUnmap are filled in when requested.
+ */
+static GDBSTUBIF g_GdbStubIf =
+{
+    /** enmArch */
+    GDBSTUBTGTARCH_ARM,
+    /** paRegs */
+    &g_aGdbStubRegs[0],
+    /** paCmds */
+    NULL,
+    /** pfnMemAlloc */
+    gdbBenchIfMemAlloc,
+    /** pfnMemFree */
+    gdbBenchIfMemFree,
+    /** pfnTgtGetState */
+    gdbBenchIfTgtGetState,
+    /** pfnTgtStop */
+    gdbBenchIfTgtStop,
+    /** pfnTgtRestart */
+    gdbBenchIfTgtRestart,
+    /** pfnTgtKill */
+    gdbBenchIfTgtKill,
+    /** pfnTgtStep */
+    gdbBenchIfTgtStep,
+    /** pfnTgtCont */
+    gdbBenchIfTgtCont,
+    /** pfnTgtMemRead */
+    gdbBenchIfTgtMemRead,
+    /** pfnTgtMemWrite */
+    gdbBenchIfTgtMemWrite,
+    /** pfnTgtRegsRead */
+    gdbBenchIfTgtRegsRead,
+    /** pfnTgtRegsWrite */
+    gdbBenchIfTgtRegsWrite,
+    /** pfnTgtTpSet */
+    gdbBenchIfTgtTpSet,
+    /** pfnTgtTpClear */
+    gdbBenchIfTgtTpClear,
+    /** pfnMonCmd */
+    NULL,
+    /** pfnTgtMemMap */
+    NULL,
+    /** pfnTgtMemUnmap */
+    NULL,
+    /** pfnTgtThrdsQuery */
+    NULL,
+    /** pfnTgtThrdSelect */
+    NULL,
+    /** pfnTgtThrdGetState */
+    NULL,
+    /** pfnTgtThrdAction */
+    NULL,
+    /** paTgtDescAnnexes */
+    NULL,
+    /** paMemRegions */
+    NULL,
+    /** pfnTgtFlashErase */
+    NULL,
+    /** pfnTgtFlashWrite */
+    NULL,
+    /** pfnTgtFlashDone */
+    NULL,
+    /** pfnTimeNsQuery */
+    gdbBenchIfTimeNsQuery
+};
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnPeek}
+ */
+static size_t gdbBenchIoIfPeek(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHIO pIo = (PGDBBENCHIO)pvUser;
+    return pIo->offInAvail - pIo->offIn;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnRead}
+ */
+static int gdbBenchIoIfRead(GDBSTUBCTX hGdbStubCtx, void *pvUser, void *pvDst, size_t cbRead, size_t *pcbRead)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHIO pIo = (PGDBBENCHIO)pvUser;
+    size_t cbThisRead = pIo->offInAvail - pIo->offIn;
+
+    if (cbThisRead > cbRead)
+        cbThisRead = cbRead;
+    if (   pIo->cbReadMax
+        && cbThisRead > pIo->cbReadMax)
+        cbThisRead = pIo->cbReadMax;
+
+    memcpy(pvDst, &pIo->pbIn[pIo->offIn], cbThisRead);
+    pIo->offIn += cbThisRead;
+    *pcbRead = cbThisRead;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnWrite}
+ */
+static int gdbBenchIoIfWrite(GDBSTUBCTX hGdbStubCtx, void *pvUser, const void *pvPkt, size_t cbPkt)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHIO pIo = (PGDBBENCHIO)pvUser;
+
+    if (   pIo->pbVerify
+        && pIo->offMismatch == UINT64_MAX)
+    {
+        const uint8_t *pbPkt = (const uint8_t *)pvPkt;
+
+        for (size_t i = 0; i < cbPkt; i++)
+        {
+            if (   pIo->cbOut + i >= pIo->cbVerify
+                || pIo->pbVerify[pIo->cbOut + i] != pbPkt[i])
+            {
+                pIo->offMismatch = pIo->cbOut + i;
+                break;
+            }
+        }
+    }
+
+    pIo->cbOut += cbPkt;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * In-memory I/O interface callback table, there is no polling as everything is available right away.
+ */
+static const GDBSTUBIOIF g_GdbBenchIoIf =
+{
+    /** pfnPeek */
+    gdbBenchIoIfPeek,
+    /** pfnRead */
+    gdbBenchIoIfRead,
+    /** pfnWrite */
+    gdbBenchIoIfWrite,
+    /** pfnPoll */
+    NULL,
+    /** pfnPollWakeup */
+    NULL
+};
+
+
+/**
+ * Appends data to the given buffer, exiting on allocation failure.
+ *
+ * @returns nothing.
+ * @param   pBuf                The buffer to append to.
+ * @param   pvData              The data to append.
+ * @param   cbData              Number of bytes to append.
+ */
+static void gdbBenchBufAppend(PGDBBENCHBUF pBuf, const void *pvData, size_t cbData)
+{
+    if (pBuf->cbData + cbData > pBuf->cbAlloc)
+    {
+        size_t cbAlloc = pBuf->cbAlloc ? pBuf->cbAlloc : 4096;
+        while (cbAlloc < pBuf->cbData + cbData)
+            cbAlloc *= 2;
+
+        uint8_t *pbData = (uint8_t *)realloc(pBuf->pbData, cbAlloc);
+        if (!pbData)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        pBuf->pbData  = pbData;
+        pBuf->cbAlloc = cbAlloc;
+    }
+
+    memcpy(&pBuf->pbData[pBuf->cbData], pvData, cbData);
+    pBuf->cbData += cbData;
+}
+
+
+/**
+ * Appends a complete packet with the given payload (already escaped) to the trace, acknowledging the
+ * reply of the previous packet first like GDB does.
+ *
+ * @returns nothing.
+ * @param   pTrace              The trace to append to.
+ * @param   pvPayload           The packet payload.
+ * @param   cbPayload           Size of the payload in bytes.
+ */
+static void gdbBenchTracePktAppend(PGDBBENCHTRACE pTrace, const void *pvPayload, size_t cbPayload)
+{
+    const uint8_t *pbPayload = (const uint8_t *)pvPayload;
+    uint8_t uChkSum = 0;
+    char szEnd[4];
+
+    for (size_t i = 0; i < cbPayload; i++)
+        uChkSum += pbPayload[i];
+    snprintf(&szEnd[0], sizeof(szEnd), "#%02x", uChkSum);
+
+    if (pTrace->cPkts)
+        gdbBenchBufAppend(&pTrace->In, "+", 1);
+    gdbBenchBufAppend(&pTrace->In, "$", 1);
+    gdbBenchBufAppend(&pTrace->In, pbPayload, cbPayload);
+    gdbBenchBufAppend(&pTrace->In, &szEnd[0], 3);
+    pTrace->cPkts++;
+}
+
+
+/**
+ * Appends a packet with the given printf style payload to the trace.
+ *
+ * @returns nothing.
+ * @param   pTrace              The trace to append to.
+ * @param   pszFmt              The format string of the payload.
+ * @param   ...                 Format arguments.
+ */
+static void gdbBenchTracePktAppendF(PGDBBENCHTRACE pTrace, const char *pszFmt, ...) __attribute__((format(printf, 2, 3)));
+static void gdbBenchTracePktAppendF(PGDBBENCHTRACE pTrace, const char *pszFmt, ...)
+{
+    char szPayload[256];
+    va_list hArgs;
+
+    va_start(hArgs, pszFmt);
+    int cchPayload = vsnprintf(&szPayload[0], sizeof(szPayload), pszFmt, hArgs);
+    va_end(hArgs);
+
+    gdbBenchTracePktAppend(pTrace, &szPayload[0], (size_t)cchPayload);
+}
+
+
+/**
+ * Generates the trace of GDB connecting to the target.
+ *
+ * @returns nothing.
+ * @param   pTrace              The trace to generate.
+ */
+static void gdbBenchTraceGenConnect(PGDBBENCHTRACE pTrace)
+{
+    gdbBenchTracePktAppendF(pTrace, "qSupported:multiprocess+;swbreak+;hwbreak+;qRelocInsn+;fork-events+;vfork-events+;"
+                                    "exec-events+;vContSupported+;QThreadEvents+;no-resumed+");
+    gdbBenchTracePktAppendF(pTrace, "vMustReplyEmpty");
+    gdbBenchTracePktAppendF(pTrace, "Hg0");
+    gdbBenchTracePktAppendF(pTrace, "qXfer:features:read:target.xml:0,ffb");
+    gdbBenchTracePktAppendF(pTrace, "qXfer:features:read:target.xml:ffb,ffb");
+    gdbBenchTracePktAppendF(pTrace, "qTStatus");
+    gdbBenchTracePktAppendF(pTrace, "?");
+    gdbBenchTracePktAppendF(pTrace, "qfThreadInfo");
+    gdbBenchTracePktAppendF(pTrace, "qsThreadInfo");
+    gdbBenchTracePktAppendF(pTrace, "qAttached");
+    gdbBenchTracePktAppendF(pTrace, "Hc-1");
+    gdbBenchTracePktAppendF(pTrace, "qC");
+    gdbBenchTracePktAppendF(pTrace, "qOffsets");
+    gdbBenchTracePktAppendF(pTrace, "g");
+    gdbBenchTracePktAppendF(pTrace, "qXfer:memory-map:read::0,ffb");
+    gdbBenchTracePktAppendF(pTrace, "m10000,4");
+    gdbBenchTracePktAppendF(pTrace, "m7ffff0,40");
+    gdbBenchTracePktAppendF(pTrace, "qSymbol::");
+}
+
+
+/**
+ * Generates the trace of GDB dumping and restoring a memory range.
+ *
+ * @returns nothing.
+ * @param   pTrace              The trace to generate.
+ */
+static void gdbBenchTraceGenMemDump(PGDBBENCHTRACE pTrace)
+{
+    /* Dump 512KiB. */
+    for (uint32_t i = 0; i < 256; i++)
+        gdbBenchTracePktAppendF(pTrace, "m%x,%x", 0x100000 + i * GDBBENCH_DUMP_CHUNK, GDBBENCH_DUMP_CHUNK);
+
+    /* Restore part of it through hex encoded writes. */
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        GDBBENCHBUF Pkt = { NULL, 0, 0 };
+        char szHdr[32];
+        int cchHdr = snprintf(&szHdr[0], sizeof(szHdr), "M%x,%x:", 0x200000 + i * 0x200, 0x200);
+
+        gdbBenchBufAppend(&Pkt, &szHdr[0], (size_t)cchHdr);
+        for (uint32_t off = 0; off < 0x200; off++)
+        {
+            char szByte[3];
+            snprintf(&szByte[0], sizeof(szByte), "%02x", (uint8_t)(off * 13 + i));
+            gdbBenchBufAppend(&Pkt, &szByte[0], 2);
+        }
+        gdbBenchTracePktAppend(pTrace, Pkt.pbData, Pkt.cbData);
+        free(Pkt.pbData);
+    }
+
+    /* And through binary writes, escaping the characters with a special meaning. */
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        GDBBENCHBUF Pkt = { NULL, 0, 0 };
+        char szHdr[32];
+        int cchHdr = snprintf(&szHdr[0], sizeof(szHdr), "X%x,%x:", 0x300000 + i * 0x400, 0x400);
+
+        gdbBenchBufAppend(&Pkt, &szHdr[0], (size_t)cchHdr);
+        for (uint32_t off = 0; off < 0x400; off++)
+        {
+            uint8_t b = (uint8_t)(off * 7 + i);
+            if (b == '$' || b == '#' || b == '}' || b == '*')
+            {
+                uint8_t abEsc[2] = { '}', (uint8_t)(b ^ 0x20) };
+                gdbBenchBufAppend(&Pkt, &abEsc[0], sizeof(abEsc));
+            }
+            else
+                gdbBenchBufAppend(&Pkt, &b, 1);
+        }
+        gdbBenchTracePktAppend(pTrace, Pkt.pbData, Pkt.cbData);
+        free(Pkt.pbData);
+    }
+}
+
+
+/**
+ * Generates the trace of GDB single stepping through code, refreshing the registers and the stack every step.
+ *
+ * @returns nothing.
+ * @param   pTrace              The trace to generate.
+ */
+static void gdbBenchTraceGenStep(PGDBBENCHTRACE pTrace)
+{
+    gdbBenchTracePktAppendF(pTrace, "Z0,10400,4");
+    for (uint32_t i = 0; i < GDBBENCH_STEP_COUNT; i++)
+    {
+        gdbBenchTracePktAppendF(pTrace, "s");
+        gdbBenchTracePktAppendF(pTrace, "g");
+        gdbBenchTracePktAppendF(pTrace, "m%x,4", 0x10000 + (i + 1) * 4);
+        gdbBenchTracePktAppendF(pTrace, "m7fffc0,40");
+        gdbBenchTracePktAppendF(pTrace, "pe");
+    }
+    gdbBenchTracePktAppendF(pTrace, "z0,10400,4");
+    gdbBenchTracePktAppendF(pTrace, "c");
+    gdbBenchTracePktAppendF(pTrace, "g");
+}
+
+
+/**
+ * Loads a recorded trace from the given file.
+ *
+ * @returns 0 on success, -1 on failure.
+ * @param   pTrace              The trace to load into.
+ * @param   pszFilename         The file to load.
+ */
+static int gdbBenchTraceLoad(PGDBBENCHTRACE pTrace, const char *pszFilename)
+{
+    FILE *pFile = fopen(pszFilename, "rb");
+    if (!pFile)
+    {
+        fprintf(stderr, "Opening %s failed: %s\n", pszFilename, strerror(errno));
+        return -1;
+    }
+
+    int rc = 0;
+    char achMagic[sizeof(GDBBENCH_TRC_MAGIC) - 1];
+    if (   fread(&achMagic[0], sizeof(achMagic), 1, pFile) != 1
+        || memcmp(&achMagic[0], GDBBENCH_TRC_MAGIC, sizeof(achMagic)))
+    {
+        fprintf(stderr, "%s is not a trace file\n", pszFilename);
+        rc = -1;
+    }
+
+    while (!rc)
+    {
+        uint8_t abHdr[5];
+        size_t cbHdr = fread(&abHdr[0], 1, sizeof(abHdr), pFile);
+        if (!cbHdr)
+            break;
+
+        uint32_t cbRec = abHdr[1] | (uint32_t)abHdr[2] << 8 | (uint32_t)abHdr[3] << 16 | (uint32_t)abHdr[4] << 24;
+        uint8_t *pbRec = cbHdr == sizeof(abHdr) ? (uint8_t *)malloc(cbRec ? cbRec : 1) : NULL;
+        if (   !pbRec
+            || fread(pbRec, 1, cbRec, pFile) != cbRec
+            || (abHdr[0] != GDBBENCH_TRC_DIR_IN && abHdr[0] != GDBBENCH_TRC_DIR_OUT))
+        {
+            fprintf(stderr, "%s is truncated or corrupted\n", pszFilename);
+            rc = -1;
+        }
+        else if (abHdr[0] == GDBBENCH_TRC_DIR_IN)
+        {
+            size_t cbRead = cbRec;
+
+            gdbBenchBufAppend(&pTrace->Reads, &cbRead, sizeof(cbRead));
+            /* The start character is never escaped, so counting it gives the number of packets. */
+            for (uint32_t i = 0; i < cbRec; i++)
+            {
+                if (pbRec[i] == '$')
+                    pTrace->cPkts++;
+            }
+            gdbBenchBufAppend(&pTrace->In, pbRec, cbRec);
+        }
+        else
+            gdbBenchBufAppend(&pTrace->Out, pbRec, cbRec);
+
+        free(pbRec);
+    }
+
+    fclose(pFile);
+    pTrace->pszName = pszFilename;
+    return rc;
+}
+
+
+/**
+ * Writes a single record to the trace file being recorded.
+ *
+ * @returns nothing.
+ * @param   pFile               The trace file.
+ * @param   bDir                The direction of the data.
+ * @param   pvData              The data.
+ * @param   cbData              Size of the data in bytes.
+ */
+static void gdbBenchTraceRecWrite(FILE *pFile, uint8_t bDir, const void *pvData, size_t cbData)
+{
+    uint8_t abHdr[5] = { bDir, (uint8_t)cbData, (uint8_t)(cbData >> 8), (uint8_t)(cbData >> 16), (uint8_t)(cbData >> 24) };
+
+    fwrite(&abHdr[0], sizeof(abHdr), 1, pFile);
+    fwrite(pvData, cbData, 1, pFile);
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnPeek}
+ */
+static size_t gdbBenchRecIoIfPeek(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHRECIO pIo = (PGDBBENCHRECIO)pvUser;
+    int cbAvail = 0;
+    int rc = ioctl(pIo->iFdSock, FIONREAD, &cbAvail);
+    if (rc)
+        return 0;
+
+    return (size_t)cbAvail;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnRead}
+ */
+static int gdbBenchRecIoIfRead(GDBSTUBCTX hGdbStubCtx, void *pvUser, void *pvDst, size_t cbRead, size_t *pcbRead)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHRECIO pIo = (PGDBBENCHRECIO)pvUser;
+    ssize_t cbRet = recv(pIo->iFdSock, pvDst, cbRead, MSG_DONTWAIT);
+    if (cbRet > 0)
+    {
+        gdbBenchTraceRecWrite(pIo->pFile, GDBBENCH_TRC_DIR_IN, pvDst, (size_t)cbRet);
+        *pcbRead = (size_t)cbRet;
+        return GDBSTUB_INF_SUCCESS;
+    }
+
+    if (!cbRet)
+        return GDBSTUB_ERR_PEER_DISCONNECTED;
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return GDBSTUB_INF_TRY_AGAIN;
+
+    return GDBSTUB_ERR_INTERNAL_ERROR;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnWrite}
+ */
+static int gdbBenchRecIoIfWrite(GDBSTUBCTX hGdbStubCtx, void *pvUser, const void *pvPkt, size_t cbPkt)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHRECIO pIo = (PGDBBENCHRECIO)pvUser;
+    ssize_t cbRet = send(pIo->iFdSock, pvPkt, cbPkt, MSG_NOSIGNAL);
+    if (cbRet == (ssize_t)cbPkt)
+    {
+        gdbBenchTraceRecWrite(pIo->pFile, GDBBENCH_TRC_DIR_OUT, pvPkt, cbPkt);
+        return GDBSTUB_INF_SUCCESS;
+    }
+
+    return GDBSTUB_ERR_PEER_DISCONNECTED;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnPoll}
+ */
+static int gdbBenchRecIoIfPoll(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+
+    PGDBBENCHRECIO pIo = (PGDBBENCHRECIO)pvUser;
+    struct pollfd PollFd;
+
+    PollFd.fd      = pIo->iFdSock;
+    PollFd.events  = POLLIN | POLLHUP | POLLERR;
+    PollFd.revents = 0;
+
+    for (;;)
+    {
+        int rcPsx = poll(&PollFd, 1, -1);
+        if (rcPsx == 1)
+            break;
+        if (   rcPsx == -1
+            && errno != EINTR)
+            return GDBSTUB_ERR_INTERNAL_ERROR;
+    }
+
+    /* Readable without any data available means the remote end closed the connection. */
+    if (!gdbBenchRecIoIfPeek(hGdbStubCtx, pvUser))
+        return GDBSTUB_ERR_PEER_DISCONNECTED;
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Socket I/O interface callback table used while recording.
+ */
+static const GDBSTUBIOIF g_GdbBenchRecIoIf =
+{
+    /** pfnPeek */
+    gdbBenchRecIoIfPeek,
+    /** pfnRead */
+    gdbBenchRecIoIfRead,
+    /** pfnWrite */
+    gdbBenchRecIoIfWrite,
+    /** pfnPoll */
+    gdbBenchRecIoIfPoll,
+    /** pfnPollWakeup */
+    NULL
+};
+
+
+/**
+ * Serves the mock target to a single GDB connection on the given port, recording the session.
+ *
+ * @returns Process exit code.
+ * @param   pszFilename         The trace file to record to.
+ * @param   uPort               The TCP port to listen on.
+ */
+static int gdbBenchRecord(const char *pszFilename, uint16_t uPort)
+{
+    int iFdListen = socket(AF_INET, SOCK_STREAM, 0);
+    if (iFdListen == -1)
+    {
+        fprintf(stderr, "Creating the socket failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    int fReuse = 1;
+    struct sockaddr_in SockAddr;
+    memset(&SockAddr, 0, sizeof(SockAddr));
+    SockAddr.sin_family      = AF_INET;
+    SockAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    SockAddr.sin_port        = htons(uPort);
+    setsockopt(iFdListen, SOL_SOCKET, SO_REUSEADDR, &fReuse, sizeof(fReuse));
+    if (   bind(iFdListen, (struct sockaddr *)&SockAddr, sizeof(SockAddr))
+        || listen(iFdListen, 1))
+    {
+        fprintf(stderr, "Listening on port %u failed: %s\n", uPort, strerror(errno));
+        close(iFdListen);
+        return 1;
+    }
+
+    printf("Waiting for GDB on port %u (target extended-remote localhost:%u)\n", uPort, uPort);
+    GDBBENCHRECIO Io;
+    Io.iFdSock = accept(iFdListen, NULL, NULL);
+    close(iFdListen);
+    if (Io.iFdSock == -1)
+    {
+        fprintf(stderr, "Accepting the connection failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    int fNoDelay = 1;
+    setsockopt(Io.iFdSock, IPPROTO_TCP, TCP_NODELAY, &fNoDelay, sizeof(fNoDelay));
+
+    Io.pFile = fopen(pszFilename, "wb");
+    if (!Io.pFile)
+    {
+        fprintf(stderr, "Creating %s failed: %s\n", pszFilename, strerror(errno));
+        close(Io.iFdSock);
+        return 1;
+    }
+    fwrite(GDBBENCH_TRC_MAGIC, sizeof(GDBBENCH_TRC_MAGIC) - 1, 1, Io.pFile);
+
+    GDBSTUBCTX hGdbStubCtx = NULL;
+    gdbBenchTgtReset();
+    int rc = GDBStubCtxCreate(&hGdbStubCtx, &g_GdbBenchRecIoIf, &g_GdbStubIf, &Io);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        rc = GDBStubCtxRun(hGdbStubCtx);
+        GDBStubCtxDestroy(hGdbStubCtx);
+    }
+
+    fclose(Io.pFile);
+    close(Io.iFdSock);
+    printf("Session ended with %d, recorded to %s\n", rc, pszFilename);
+    return rc == GDBSTUB_ERR_PEER_DISCONNECTED ? 0 : 1;
+}
+
+
+/**
+ * Replays the given trace the given number of times and prints the results.
+ *
+ * @returns 0 on success, -1 if processing failed or the replies didn't match the recorded ones.
+ * @param   pTrace              The trace to replay.
+ * @param   cIterations         Number of times to replay the trace.
+ * @param   cbReadMax           Maximum number of bytes returned by a single read, 0 for no limit.
+ * @param   fStats              Flag whether to print the stub statistics of the last iteration.
+ */
+static int gdbBenchReplay(PGDBBENCHTRACE pTrace, uint32_t cIterations, size_t cbReadMax, bool fStats)
+{
+    uint64_t cbOut = 0;
+    uint64_t cAllocsStart = g_cAllocs;
+    uint64_t cNsTotal = 0;
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    for (uint32_t i = 0; i < cIterations && rc == GDBSTUB_INF_SUCCESS; i++)
+    {
+        GDBBENCHIO Io;
+        GDBSTUBCTX hGdbStubCtx = NULL;
+
+        Io.pbIn        = pTrace->In.pbData;
+        Io.cbIn        = pTrace->In.cbData;
+        Io.offIn       = 0;
+        Io.offInAvail  = 0;
+        Io.cbReadMax   = cbReadMax;
+        Io.cbOut       = 0;
+        Io.pbVerify    = i == 0 && pTrace->Out.cbData ? pTrace->Out.pbData : NULL;
+        Io.cbVerify    = pTrace->Out.cbData;
+        Io.offMismatch = UINT64_MAX;
+
+        /* Every iteration is a new session, so creating the context is accounted as well. */
+        gdbBenchTgtReset();
+        uint64_t tsStart = gdbBenchTimeNs();
+        rc = GDBStubCtxCreate(&hGdbStubCtx, &g_GdbBenchIoIf, &g_GdbStubIf, &Io);
+
+        /*
+         * Hand out the data in the same pieces it was received while recording, pipelined packets
+         * are processed differently from the ones arriving one after another.
+         */
+        size_t cReads = pTrace->Reads.cbData / sizeof(size_t);
+        const size_t *pacbReads = (const size_t *)pTrace->Reads.pbData;
+        for (size_t idxRead = 0; idxRead < (cReads ? cReads : 1) && rc == GDBSTUB_INF_SUCCESS; idxRead++)
+        {
+            Io.offInAvail += cReads ? pacbReads[idxRead] : Io.cbIn;
+            while (   rc == GDBSTUB_INF_SUCCESS
+                   && Io.offIn < Io.offInAvail)
+            {
+                rc = GDBStubCtxRun(hGdbStubCtx);
+                if (rc == GDBSTUB_INF_TRY_AGAIN)
+                    rc = GDBSTUB_INF_SUCCESS;
+            }
+        }
+        cNsTotal += gdbBenchTimeNs() - tsStart;
+
+        if (   rc == GDBSTUB_INF_SUCCESS
+            && fStats
+            && i == cIterations - 1)
+        {
+            GDBSTUBSTATS Stats;
+            if (GDBStubCtxQueryStats(hGdbStubCtx, &Stats) == GDBSTUB_INF_SUCCESS)
+            {
+                for (uint32_t idxPkt = 0; idxPkt < GDBSTUBSTATS_PKT_TYPES; idxPkt++)
+                {
+                    if (Stats.aPkts[idxPkt].cPkts)
+                        printf("    '%c': %llu packets, avg %llu ns\n", idxPkt ? (char)idxPkt : ' ',
+                               (unsigned long long)Stats.aPkts[idxPkt].cPkts,
+                               (unsigned long long)(Stats.aPkts[idxPkt].cNsTotal / Stats.aPkts[idxPkt].cPkts));
+                }
+            }
+            else
+                printf("    statistics not available, rebuild with GDBSTUB_WITH_STATS\n");
+        }
+
+        if (hGdbStubCtx)
+            GDBStubCtxDestroy(hGdbStubCtx);
+
+        if (Io.pbVerify)
+        {
+            if (Io.offMismatch == UINT64_MAX && Io.cbOut != Io.cbVerify)
+                Io.offMismatch = Io.cbOut;
+            if (Io.offMismatch != UINT64_MAX)
+            {
+                fprintf(stderr, "%s: reply differs from the recorded one at offset %llu\n", pTrace->pszName,
+                        (unsigned long long)Io.offMismatch);
+                return -1;
+            }
+        }
+
+        cbOut += Io.cbOut;
+    }
+
+    if (rc != GDBSTUB_INF_SUCCESS)
+    {
+        fprintf(stderr, "%s: processing failed with %d\n", pTrace->pszName, rc);
+        return -1;
+    }
+
+    double dSecs = (double)cNsTotal / 1000000000.0;
+    uint64_t cPkts = pTrace->cPkts * cIterations;
+    uint64_t cbTotal = (uint64_t)pTrace->In.cbData * cIterations + cbOut;
+    printf("%-12s %8llu packets %10.0f packets/s %8.2f MB/s %6.3f allocations/packet %8.1f ns/packet\n",
+           pTrace->pszName, (unsigned long long)cPkts, (double)cPkts / dSecs, (double)cbTotal / dSecs / (1024.0 * 1024.0),
+           (double)(g_cAllocs - cAllocsStart) / (double)cPkts, (double)cNsTotal / (double)cPkts);
+    return 0;
+}
+
+
+/**
+ * Prints the usage.
+ *
+ * @returns nothing.
+ * @param   pszArgv0            The program name.
+ */
+static void gdbBenchUsage(const char *pszArgv0)
+{
+    printf("Usage: %s [-n <iterations>] [-l <target latency ns>] [-c <read chunk bytes>] [-m] [-s] <trace>...\n"
+           "       %s -r <file> <port>\n"
+           "\n"
+           "Traces: connect, memdump, step, all or a file recorded with -r.\n"
+           "  -m  Let the mock target support mapping memory.\n"
+           "  -s  Print the stub statistics of the last iteration (needs GDBSTUB_WITH_STATS).\n"
+           "  -r  Serve the mock target on the given port and record the session of the connecting GDB.\n",
+           pszArgv0, pszArgv0);
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t cIterations = 100;
+    size_t cbReadMax = 0;
+    bool fStats = false;
+    const char *pszRecord = NULL;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "n:l:c:msr:h")) != -1)
+    {
+        switch (ch)
+        {
+            case 'n':
+                cIterations = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                g_cNsTgtLatency = strtoull(optarg, NULL, 0);
+                break;
+            case 'c':
+                cbReadMax = strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                g_GdbStubIf.pfnTgtMemMap   = gdbBenchIfTgtMemMap;
+                g_GdbStubIf.pfnTgtMemUnmap = gdbBenchIfTgtMemUnmap;
+                break;
+            case 's':
+                fStats = true;
+                break;
+            case 'r':
+                pszRecord = optarg;
+                break;
+            default:
+                gdbBenchUsage(argv[0]);
+                return ch == 'h' ? 0 : 1;
+        }
+    }
+
+    if (   optind >= argc
+        || !cIterations)
+    {
+        gdbBenchUsage(argv[0]);
+        return 1;
+    }
+
+    /* A fixed pattern, so replies are the same for every run (required for verifying recorded traces). */
+    g_pbTgtMem = (uint8_t *)malloc(GDBBENCH_TGT_MEM_SIZE);
+    if (!g_pbTgtMem)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < GDBBENCH_TGT_MEM_SIZE; i++)
+        g_pbTgtMem[i] = (uint8_t)(i * 7 + (i >> 12));
+
+    if (pszRecord)
+        return gdbBenchRecord(pszRecord, (uint16_t)strtoul(argv[optind], NULL, 0));
+
+    int rcExit = 0;
+    for (int i = optind; i < argc; i++)
+    {
+        static const struct
+        {
+            const char *pszName;
+            void      (*pfnGen)(PGDBBENCHTRACE pTrace);
+        } s_aTraces[] =
+        {
+            { "connect", gdbBenchTraceGenConnect },
+            { "memdump", gdbBenchTraceGenMemDump },
+            { "step",    gdbBenchTraceGenStep    }
+        };
+        bool fAll = !strcmp(argv[i], "all");
+        bool fFound = false;
+
+        for (uint32_t idxTrace = 0; idxTrace < sizeof(s_aTraces) / sizeof(s_aTraces[0]); idxTrace++)
+        {
+            if (   fAll
+                || !strcmp(argv[i], s_aTraces[idxTrace].pszName))
+            {
+                GDBBENCHTRACE Trace;
+
+                memset(&Trace, 0, sizeof(Trace));
+                Trace.pszName = s_aTraces[idxTrace].pszName;
+                s_aTraces[idxTrace].pfnGen(&Trace);
+                if (gdbBenchReplay(&Trace, cIterations, cbReadMax, fStats))
+                    rcExit = 1;
+                free(Trace.In.pbData);
+                fFound = true;
+            }
+        }
+
+        if (!fFound)
+        {
+            GDBBENCHTRACE Trace;
+
+            memset(&Trace, 0, sizeof(Trace));
+            if (   gdbBenchTraceLoad(&Trace, argv[i])
+                || gdbBenchReplay(&Trace, cIterations, cbReadMax, fStats))
+                rcExit = 1;
+            free(Trace.In.pbData);
+            free(Trace.Out.pbData);
+            free(Trace.Reads.pbData);
+        }
+    }
+
+    free(g_pbTgtMem);
+    return rcExit;
+}
@@ -0,0 +1,64 @@
+/** @file
+ * GDB stub examples - build time configuration for a fixed ARM target.
+ *
+ * Build the library with -DGDBSTUB_CONFIG_FILE='"gdbstub-config-arm.h"' (or the CMake option of the same name)
+ * to fix the architecture and register table at build time, the register table and architecture of the
+ * interface callback table passed to GDBStubCtxCreate() are ignored then.
+ */
+
+/*
+ * Copyright (C) 2020 Alexander Eichner <alexander.eichner@campus.tu-berlin.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __gdbstub_config_arm_h
+#define __gdbstub_config_arm_h
+
+/** The architecture, the suffix of one of the GDBSTUBTGTARCH_XXX values. */
+#define GDBSTUB_FIXED_ARCH      ARM
+
+/**
+ * The register table in the order GDB expects it, each entry gives the name, the size in bits
+ * (a decimal literal), the suffix of GDBSTUBREGTYPE_XXX and the GDBSTUBREG_F_XXX flags.
+ */
+#define GDBSTUB_FIXED_REGS(a_Reg) \
+    a_Reg(r0,   32, GP,        0) \
+    a_Reg(r1,   32, GP,        0) \
+    a_Reg(r2,   32, GP,        0) \
+    a_Reg(r3,   32, GP,        0) \
+    a_Reg(r4,   32, GP,        0) \
+    a_Reg(r5,   32, GP,        0) \
+    a_Reg(r6,   32, GP,        0) \
+    a_Reg(r7,   32, GP,        0) \
+    a_Reg(r8,   32, GP,        0) \
+    a_Reg(r9,   32, GP,        0) \
+    a_Reg(r10,  32, GP,        0) \
+    a_Reg(r11,  32, GP,        GDBSTUBREG_F_EXPEDITE) \
+    a_Reg(r12,  32, GP,        0) \
+    a_Reg(sp,   32, STACK_PTR, GDBSTUBREG_F_EXPEDITE) \
+    a_Reg(lr,   32, CODE_PTR,  0) \
+    a_Reg(pc,   32, PC,        GDBSTUBREG_F_EXPEDITE) \
+    a_Reg(cpsr, 32, STATUS,    0)
+
+/* Protocol features the target has no use for. */
+#define GDBSTUB_WITHOUT_TRACEPOINTS
+#define GDBSTUB_WITHOUT_FLASH
+#define GDBSTUB_WITHOUT_NON_STOP
+
+#endif /* __gdbstub_config_arm_h */
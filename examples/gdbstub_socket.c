@@ -31,6 +31,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 
 #include <poll.h>
@@ -55,28 +56,28 @@ typedef const GDBSOCKSTUB *PCGDBSOCKSTUB;
 
 
 /**
- * GDB stub register names (for ARM).
+ * GDB stub register names (for ARM), the frame pointer, stack pointer and program counter are sent with every stop reply.
  */
 static const GDBSTUBREG g_aGdbStubRegs[] =
 {
-    { "r0",   32, GDBSTUBREGTYPE_GP        },
-    { "r1",   32, GDBSTUBREGTYPE_GP        },
-    { "r2",   32, GDBSTUBREGTYPE_GP        },
-    { "r3",   32, GDBSTUBREGTYPE_GP        },
-    { "r4",   32, GDBSTUBREGTYPE_GP        },
-    { "r5",   32, GDBSTUBREGTYPE_GP        },
-    { "r6",   32, GDBSTUBREGTYPE_GP        },
-    { "r7",   32, GDBSTUBREGTYPE_GP        },
-    { "r8",   32, GDBSTUBREGTYPE_GP        },
-    { "r9",   32, GDBSTUBREGTYPE_GP        },
-    { "r10",  32, GDBSTUBREGTYPE_GP        },
-    { "r11",  32, GDBSTUBREGTYPE_GP        },
-    { "r12",  32, GDBSTUBREGTYPE_GP        },
-    { "sp",   32, GDBSTUBREGTYPE_STACK_PTR },
-    { "lr",   32, GDBSTUBREGTYPE_CODE_PTR  },
-    { "pc",   32, GDBSTUBREGTYPE_PC        },
-    { "cpsr", 32, GDBSTUBREGTYPE_STATUS    },
-    { NULL,    0, GDBSTUBREGTYPE_INVALID   }
+    { "r0",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r1",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r2",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r3",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r4",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r5",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r6",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r7",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r8",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r9",   32, GDBSTUBREGTYPE_GP,        0 },
+    { "r10",  32, GDBSTUBREGTYPE_GP,        0 },
+    { "r11",  32, GDBSTUBREGTYPE_GP,        GDBSTUBREG_F_EXPEDITE },
+    { "r12",  32, GDBSTUBREGTYPE_GP,        0 },
+    { "sp",   32, GDBSTUBREGTYPE_STACK_PTR, GDBSTUBREG_F_EXPEDITE },
+    { "lr",   32, GDBSTUBREGTYPE_CODE_PTR,  0 },
+    { "pc",   32, GDBSTUBREGTYPE_PC,        GDBSTUBREG_F_EXPEDITE },
+    { "cpsr", 32, GDBSTUBREGTYPE_STATUS,    0 },
+    { NULL,    0, GDBSTUBREGTYPE_INVALID,   0 }
 };
 
 
@@ -232,10 +233,11 @@ static int gdbStubIfTgtRegsWrite(GDBSTUBCTX hGdbStubCtx, void *pvUser, uint32_t
 /**
  * @copydoc{GDBSTUBIF,pfnTgtTpSet}
  */
-static int gdbStubIfTgtTpSet(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, GDBSTUBTPACTION enmTpAction)
+static int gdbStubIfTgtTpSet(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind,
+                             GDBSTUBTPACTION enmTpAction)
 {
-    printf("gdbStubIfTgtTpSet: hGdbStubCtx=%p pvUser=%p GdbTgtTpAddr=%#llx enmTpType=%u enmTpAction=%u\n",
-           hGdbStubCtx, pvUser, GdbTgtTpAddr, enmTpType, enmTpAction);
+    printf("gdbStubIfTgtTpSet: hGdbStubCtx=%p pvUser=%p GdbTgtTpAddr=%#llx enmTpType=%u uKind=%llu enmTpAction=%u\n",
+           hGdbStubCtx, pvUser, GdbTgtTpAddr, enmTpType, uKind, enmTpAction);
     return GDBSTUB_INF_SUCCESS;
 }
 
@@ -243,10 +245,10 @@ static int gdbStubIfTgtTpSet(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR
 /**
  * @copydoc{GDBSTUBIF,pfnTgtTpClear}
  */
-static int gdbStubIfTgtTpClear(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr)
+static int gdbStubIfTgtTpClear(GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind)
 {
-    printf("gdbStubIfTgtTpClear: hGdbStubCtx=%p pvUser=%p GdbTgtTpAddr=%#llx\n",
-           hGdbStubCtx, pvUser, GdbTgtTpAddr);
+    printf("gdbStubIfTgtTpClear: hGdbStubCtx=%p pvUser=%p GdbTgtTpAddr=%#llx enmTpType=%u uKind=%llu\n",
+           hGdbStubCtx, pvUser, GdbTgtTpAddr, enmTpType, uKind);
     return GDBSTUB_INF_SUCCESS;
 }
 
@@ -302,7 +304,21 @@ const GDBSTUBIF g_GdbStubIf =
     /** pfnTgtTpClear */
     gdbStubIfTgtTpClear,
     /** pfnMonCmd */
-    gdbStubIfMonCmd
+    gdbStubIfMonCmd,
+    /** pfnTgtMemMap */
+    NULL,
+    /** pfnTgtMemUnmap */
+    NULL,
+    /** pfnTgtThrdsQuery */
+    NULL,
+    /** pfnTgtThrdSelect */
+    NULL,
+    /** pfnTgtThrdGetState */
+    NULL,
+    /** pfnTgtThrdAction */
+    NULL,
+    /** paTgtDescAnnexes */
+    NULL
 };
 
 
@@ -391,7 +407,9 @@ const GDBSTUBIOIF g_GdbStubIoIf =
     /** pfnWrite */
     gdbStubIoIfWrite,
     /** pfnPoll */
-    gdbStubIoIfPoll
+    gdbStubIoIfPoll,
+    /** pfnPollWakeup */
+    NULL
 };
 
 
@@ -423,6 +441,10 @@ int main(int argc, char *argv[])
         int iFdSock = accept(iFdListen, (struct sockaddr *)NULL, NULL);
         printf("Got new connection\n");
 
+        /* The stub hands over complete packets in a single write, so there is no point in letting Nagle delay them. */
+        int fNoDelay = 1;
+        setsockopt(iFdSock, IPPROTO_TCP, TCP_NODELAY, &fNoDelay, sizeof(fNoDelay));
+
         GDBSTUBCTX hGdbStubCtx = NULL;
         GDBSOCKSTUB GdbStub;
 
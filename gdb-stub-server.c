@@ -0,0 +1,748 @@
+/** @file
+ * Generic GDB stub library - multi-session server.
+ */
+
+/*
+ * Copyright (C) 2020 Alexander Eichner <alexander.eichner@campus.tu-berlin.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * The server multiplexes all connections over a single epoll instance which is shared by the worker threads.
+ * Every connection has its own epoll instance watching the socket and an eventfd used to wake up the connection
+ * for asynchronous stop notifications. Only this per connection epoll descriptor is registered (with EPOLLONESHOT)
+ * in the shared instance, so a connection is always processed by exactly one worker at a time and gets re-armed
+ * after GDBStubCtxRun() returned with GDBSTUB_INF_TRY_AGAIN.
+ */
+
+/* Required for accept4(). */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+
+#include "libgdbstub-server.h"
+
+
+/**
+ * Type of an object registered in the shared epoll instance.
+ */
+typedef enum GDBSTUBSRVOBJTYPE
+{
+    /** Invalid type, do not use. */
+    GDBSTUBSRVOBJTYPE_INVALID = 0,
+    /** A listening endpoint. */
+    GDBSTUBSRVOBJTYPE_LISTENER,
+    /** A connection. */
+    GDBSTUBSRVOBJTYPE_CONN,
+    /** 32bit hack. */
+    GDBSTUBSRVOBJTYPE_32BIT_HACK = 0x7fffffff
+} GDBSTUBSRVOBJTYPE;
+
+
+/** Pointer to the internal server instance. */
+typedef struct GDBSTUBSRVINT *PGDBSTUBSRVINT;
+
+
+/**
+ * A listening endpoint.
+ */
+typedef struct GDBSTUBSRVLISTENER
+{
+    /** The object type, must come first. */
+    GDBSTUBSRVOBJTYPE           enmType;
+    /** The listening socket. */
+    int                         iFdSock;
+    /** Opaque user data passed to the connect callback. */
+    void                        *pvEndpoint;
+    /** Next listener in the list. */
+    struct GDBSTUBSRVLISTENER   *pNext;
+} GDBSTUBSRVLISTENER;
+/** Pointer to a listening endpoint. */
+typedef GDBSTUBSRVLISTENER *PGDBSTUBSRVLISTENER;
+
+
+/**
+ * A single connection.
+ */
+typedef struct GDBSTUBSRVCONN
+{
+    /** The object type, must come first. */
+    GDBSTUBSRVOBJTYPE           enmType;
+    /** The owning server. */
+    PGDBSTUBSRVINT              pSrv;
+    /** The connected socket. */
+    int                         iFdSock;
+    /** The eventfd used to wake up the connection. */
+    int                         iFdEvt;
+    /** The epoll instance watching the socket and the eventfd. */
+    int                         iFdEpoll;
+    /** The GDB stub context. */
+    GDBSTUBCTX                  hCtx;
+    /** Opaque user data of the target. */
+    void                        *pvTgtUser;
+    /** The previous connection in the list. */
+    struct GDBSTUBSRVCONN       *pPrev;
+    /** The next connection in the list. */
+    struct GDBSTUBSRVCONN       *pNext;
+} GDBSTUBSRVCONN;
+/** Pointer to a connection. */
+typedef GDBSTUBSRVCONN *PGDBSTUBSRVCONN;
+
+
+/**
+ * Internal GDB stub server instance.
+ */
+typedef struct GDBSTUBSRVINT
+{
+    /** The server callback table. */
+    PCGDBSTUBSRVIF              pSrvIf;
+    /** Opaque user data passed in the callbacks. */
+    void                        *pvUser;
+    /** The epoll instance shared by all workers. */
+    int                         iFdEpoll;
+    /** The eventfd signalling the workers to terminate, stays signalled once set. */
+    int                         iFdShutdown;
+    /** Number of worker threads started. */
+    uint32_t                    cWorkers;
+    /** The worker threads. */
+    pthread_t                   *paWorkers;
+    /** Protects the listener and connection lists. */
+    pthread_mutex_t             Mtx;
+    /** List of listening endpoints. */
+    PGDBSTUBSRVLISTENER         pListeners;
+    /** List of connections. */
+    PGDBSTUBSRVCONN             pConns;
+} GDBSTUBSRVINT;
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnPeek}
+ */
+static size_t gdbStubSrvIoIfPeek(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+
+    PGDBSTUBSRVCONN pConn = (PGDBSTUBSRVCONN)pvUser;
+    int cbAvail = 0;
+    int rc = ioctl(pConn->iFdSock, FIONREAD, &cbAvail);
+    if (rc)
+        return 0;
+
+    if (!cbAvail)
+    {
+        /*
+         * Nothing to read might also mean the remote end closed the connection, let the read
+         * callback report it, otherwise the connection would get re-armed forever.
+         */
+        uint8_t bPeek;
+        if (!recv(pConn->iFdSock, &bPeek, sizeof(bPeek), MSG_PEEK | MSG_DONTWAIT))
+            return 1;
+    }
+
+    return (size_t)cbAvail;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnRead}
+ */
+static int gdbStubSrvIoIfRead(GDBSTUBCTX hGdbStubCtx, void *pvUser, void *pvDst, size_t cbRead, size_t *pcbRead)
+{
+    (void)hGdbStubCtx;
+
+    PGDBSTUBSRVCONN pConn = (PGDBSTUBSRVCONN)pvUser;
+    ssize_t cbRet = recv(pConn->iFdSock, pvDst, cbRead, MSG_DONTWAIT);
+    if (cbRet > 0)
+    {
+        *pcbRead = (size_t)cbRet;
+        return GDBSTUB_INF_SUCCESS;
+    }
+
+    if (!cbRet)
+        return GDBSTUB_ERR_PEER_DISCONNECTED;
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return GDBSTUB_INF_TRY_AGAIN;
+
+    return GDBSTUB_ERR_PEER_DISCONNECTED;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnWrite}
+ */
+static int gdbStubSrvIoIfWrite(GDBSTUBCTX hGdbStubCtx, void *pvUser, const void *pvPkt, size_t cbPkt)
+{
+    (void)hGdbStubCtx;
+
+    PGDBSTUBSRVCONN pConn = (PGDBSTUBSRVCONN)pvUser;
+    const uint8_t *pbPkt = (const uint8_t *)pvPkt;
+
+    /*
+     * The socket is non-blocking, wait for it to become writable if the send buffer is full. A remote end
+     * not making room within the timeout is treated as gone, the worker would be blocked forever otherwise.
+     */
+    while (cbPkt)
+    {
+        ssize_t cbRet = send(pConn->iFdSock, pbPkt, cbPkt, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (cbRet > 0)
+        {
+            pbPkt += cbRet;
+            cbPkt -= (size_t)cbRet;
+        }
+        else if (   cbRet == -1
+                 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd PollFd;
+
+            PollFd.fd      = pConn->iFdSock;
+            PollFd.events  = POLLOUT;
+            PollFd.revents = 0;
+            int rcPsx = poll(&PollFd, 1, GDBSTUBSRV_WRITE_TIMEOUT_MS);
+            if (   !rcPsx
+                || (   rcPsx == -1
+                    && errno != EINTR))
+                return GDBSTUB_ERR_PEER_DISCONNECTED;
+        }
+        else if (   cbRet == -1
+                 && errno == EINTR)
+            continue;
+        else
+            return GDBSTUB_ERR_PEER_DISCONNECTED;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * @copydoc{GDBSTUBIOIF,pfnPollWakeup}
+ */
+static void gdbStubSrvIoIfPollWakeup(GDBSTUBCTX hGdbStubCtx, void *pvUser)
+{
+    (void)hGdbStubCtx;
+
+    PGDBSTUBSRVCONN pConn = (PGDBSTUBSRVCONN)pvUser;
+    uint64_t u64Inc = 1;
+    ssize_t cbRet = write(pConn->iFdEvt, &u64Inc, sizeof(u64Inc));
+    (void)cbRet; /* Can only fail if the counter would overflow, in which case the connection is woken up already. */
+}
+
+
+/**
+ * GDB stub I/O interface callback table for the connections, there is no poll callback
+ * so GDBStubCtxRun() returns GDBSTUB_INF_TRY_AGAIN when there is nothing to read.
+ */
+static const GDBSTUBIOIF g_GdbStubSrvIoIf =
+{
+    /** pfnPeek */
+    gdbStubSrvIoIfPeek,
+    /** pfnRead */
+    gdbStubSrvIoIfRead,
+    /** pfnWrite */
+    gdbStubSrvIoIfWrite,
+    /** pfnPoll */
+    NULL,
+    /** pfnPollWakeup */
+    gdbStubSrvIoIfPollWakeup
+};
+
+
+/**
+ * Converts the given errno value to a status code.
+ *
+ * @returns Status code.
+ * @param   iErr                The errno value.
+ */
+static int gdbStubSrvErrnoToSts(int iErr)
+{
+    switch (iErr)
+    {
+        case ENOMEM:
+        case ENOBUFS:
+            return GDBSTUB_ERR_NO_MEMORY;
+        case EINVAL:
+        case EBADF:
+        case ENOTSOCK:
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+        default:
+            break;
+    }
+
+    return GDBSTUB_ERR_INTERNAL_ERROR;
+}
+
+
+/**
+ * Re-arms the given object in the shared epoll instance.
+ *
+ * @returns Status code.
+ * @param   pThis               The server instance.
+ * @param   iFd                 The descriptor registered for the object.
+ * @param   pvObj               The object.
+ * @param   iOp                 The epoll operation (EPOLL_CTL_ADD or EPOLL_CTL_MOD).
+ */
+static int gdbStubSrvObjArm(PGDBSTUBSRVINT pThis, int iFd, void *pvObj, int iOp)
+{
+    struct epoll_event Evt;
+
+    Evt.events   = EPOLLIN | EPOLLONESHOT;
+    Evt.data.ptr = pvObj;
+    if (epoll_ctl(pThis->iFdEpoll, iOp, iFd, &Evt))
+        return gdbStubSrvErrnoToSts(errno);
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Frees all resources of the given connection (which must not be in the connection list).
+ *
+ * @returns nothing.
+ * @param   pConn               The connection to free.
+ */
+static void gdbStubSrvConnFree(PGDBSTUBSRVCONN pConn)
+{
+    if (pConn->iFdEpoll != -1)
+        close(pConn->iFdEpoll);
+    if (pConn->iFdEvt != -1)
+        close(pConn->iFdEvt);
+    close(pConn->iFdSock);
+    free(pConn);
+}
+
+
+/**
+ * Closes the given connection, notifying the owner of the target.
+ *
+ * @returns nothing.
+ * @param   pThis               The server instance.
+ * @param   pConn               The connection to close.
+ */
+static void gdbStubSrvConnClose(PGDBSTUBSRVINT pThis, PGDBSTUBSRVCONN pConn)
+{
+    pthread_mutex_lock(&pThis->Mtx);
+    if (pConn->pPrev)
+        pConn->pPrev->pNext = pConn->pNext;
+    else
+        pThis->pConns = pConn->pNext;
+    if (pConn->pNext)
+        pConn->pNext->pPrev = pConn->pPrev;
+    pthread_mutex_unlock(&pThis->Mtx);
+
+    pThis->pSrvIf->pfnDisconnect(pThis, pThis->pvUser, pConn->hCtx, pConn->pvTgtUser);
+    GDBStubCtxDestroy(pConn->hCtx);
+    gdbStubSrvConnFree(pConn);
+}
+
+
+/**
+ * Creates a new connection for the given connected socket.
+ *
+ * @returns Status code.
+ * @param   pThis               The server instance.
+ * @param   iFdSock             The connected socket (non-blocking), closed on failure.
+ * @param   pvEndpoint          Opaque user data passed to the connect callback.
+ */
+static int gdbStubSrvConnCreate(PGDBSTUBSRVINT pThis, int iFdSock, void *pvEndpoint)
+{
+    PCGDBSTUBIF pIf = NULL;
+    PCGDBSTUBCFG pCfg = NULL;
+    void *pvTgtUser = NULL;
+
+    int rc = pThis->pSrvIf->pfnConnect(pThis, pThis->pvUser, pvEndpoint, &pIf, &pCfg, &pvTgtUser);
+    if (rc != GDBSTUB_INF_SUCCESS)
+    {
+        close(iFdSock);
+        return rc;
+    }
+
+    PGDBSTUBSRVCONN pConn = (PGDBSTUBSRVCONN)calloc(1, sizeof(*pConn));
+    if (pConn)
+    {
+        pConn->enmType   = GDBSTUBSRVOBJTYPE_CONN;
+        pConn->pSrv      = pThis;
+        pConn->iFdSock   = iFdSock;
+        pConn->pvTgtUser = pvTgtUser;
+        pConn->iFdEvt    = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pConn->iFdEpoll  = epoll_create1(EPOLL_CLOEXEC);
+        if (   pConn->iFdEvt != -1
+            && pConn->iFdEpoll != -1)
+        {
+            struct epoll_event Evt;
+
+            /* Level triggered, the shared instance reports the connection as long as something is pending. */
+            Evt.events   = EPOLLIN | EPOLLRDHUP;
+            Evt.data.ptr = NULL;
+            if (   !epoll_ctl(pConn->iFdEpoll, EPOLL_CTL_ADD, iFdSock, &Evt)
+                && !epoll_ctl(pConn->iFdEpoll, EPOLL_CTL_ADD, pConn->iFdEvt, &Evt))
+            {
+                /* The I/O callbacks get the connection while the target callbacks keep their own user data. */
+                GDBSTUBCFG Cfg;
+                if (pCfg)
+                    Cfg = *pCfg;
+                else
+                    memset(&Cfg, 0, sizeof(Cfg));
+                Cfg.pvIoUser = pConn;
+
+                rc = GDBStubCtxCreateEx(&pConn->hCtx, &g_GdbStubSrvIoIf, pIf, &Cfg, pvTgtUser);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    pthread_mutex_lock(&pThis->Mtx);
+                    pConn->pNext = pThis->pConns;
+                    if (pThis->pConns)
+                        pThis->pConns->pPrev = pConn;
+                    pThis->pConns = pConn;
+                    pthread_mutex_unlock(&pThis->Mtx);
+
+                    if (pThis->pSrvIf->pfnConnected)
+                        pThis->pSrvIf->pfnConnected(pThis, pThis->pvUser, pConn->hCtx, pvTgtUser);
+
+                    /* From here on a worker might process the connection already. */
+                    rc = gdbStubSrvObjArm(pThis, pConn->iFdEpoll, pConn, EPOLL_CTL_ADD);
+                    if (rc != GDBSTUB_INF_SUCCESS)
+                        gdbStubSrvConnClose(pThis, pConn);
+                    return rc;
+                }
+            }
+            else
+                rc = gdbStubSrvErrnoToSts(errno);
+        }
+        else
+            rc = gdbStubSrvErrnoToSts(errno);
+
+        gdbStubSrvConnFree(pConn);
+    }
+    else
+    {
+        close(iFdSock);
+        rc = GDBSTUB_ERR_NO_MEMORY;
+    }
+
+    pThis->pSrvIf->pfnDisconnect(pThis, pThis->pvUser, NULL, pvTgtUser);
+    return rc;
+}
+
+
+/**
+ * Processes pending data and stop notifications of the given connection.
+ *
+ * @returns nothing.
+ * @param   pThis               The server instance.
+ * @param   pConn               The connection to process.
+ */
+static void gdbStubSrvConnProcess(PGDBSTUBSRVINT pThis, PGDBSTUBSRVCONN pConn)
+{
+    /* Reset the wakeup indicator first so a notification arriving while running isn't lost. */
+    uint64_t u64Cnt = 0;
+    ssize_t cbRet = read(pConn->iFdEvt, &u64Cnt, sizeof(u64Cnt));
+    (void)cbRet;
+
+    int rc = GDBStubCtxRun(pConn->hCtx);
+    if (rc == GDBSTUB_INF_TRY_AGAIN)
+        rc = gdbStubSrvObjArm(pThis, pConn->iFdEpoll, pConn, EPOLL_CTL_MOD);
+
+    if (rc != GDBSTUB_INF_SUCCESS)
+        gdbStubSrvConnClose(pThis, pConn);
+}
+
+
+/**
+ * Accepts all pending connections on the given listening endpoint.
+ *
+ * @returns nothing.
+ * @param   pThis               The server instance.
+ * @param   pListener           The listening endpoint.
+ */
+static void gdbStubSrvListenerProcess(PGDBSTUBSRVINT pThis, PGDBSTUBSRVLISTENER pListener)
+{
+    for (;;)
+    {
+        int iFdSock = accept4(pListener->iFdSock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (iFdSock == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        /* The stub hands over complete packets in a single write, so there is no point in letting Nagle delay them. */
+        int fNoDelay = 1;
+        setsockopt(iFdSock, IPPROTO_TCP, TCP_NODELAY, &fNoDelay, sizeof(fNoDelay));
+
+        gdbStubSrvConnCreate(pThis, iFdSock, pListener->pvEndpoint);
+    }
+
+    gdbStubSrvObjArm(pThis, pListener->iFdSock, pListener, EPOLL_CTL_MOD);
+}
+
+
+/**
+ * The worker thread loop.
+ *
+ * @returns NULL.
+ * @param   pvUser              The server instance.
+ */
+static void *gdbStubSrvWorker(void *pvUser)
+{
+    PGDBSTUBSRVINT pThis = (PGDBSTUBSRVINT)pvUser;
+
+    for (;;)
+    {
+        struct epoll_event Evt;
+        int rcPsx = epoll_wait(pThis->iFdEpoll, &Evt, 1, -1);
+        if (rcPsx == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        /* The shutdown event is the only one without an object. */
+        if (!Evt.data.ptr)
+            break;
+
+        GDBSTUBSRVOBJTYPE enmType = *(GDBSTUBSRVOBJTYPE *)Evt.data.ptr;
+        if (enmType == GDBSTUBSRVOBJTYPE_LISTENER)
+            gdbStubSrvListenerProcess(pThis, (PGDBSTUBSRVLISTENER)Evt.data.ptr);
+        else if (enmType == GDBSTUBSRVOBJTYPE_CONN)
+            gdbStubSrvConnProcess(pThis, (PGDBSTUBSRVCONN)Evt.data.ptr);
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Signals all workers to terminate and waits for them.
+ *
+ * @returns nothing.
+ * @param   pThis               The server instance.
+ * @param   cWorkers            Number of workers to wait for.
+ */
+static void gdbStubSrvWorkersTerminate(PGDBSTUBSRVINT pThis, uint32_t cWorkers)
+{
+    /* The shutdown event is level triggered and never reset, so every worker sees it. */
+    uint64_t u64Inc = 1;
+    ssize_t cbRet = write(pThis->iFdShutdown, &u64Inc, sizeof(u64Inc));
+    (void)cbRet;
+
+    for (uint32_t i = 0; i < cWorkers; i++)
+        pthread_join(pThis->paWorkers[i], NULL);
+}
+
+
+int GDBStubSrvCreate(PGDBSTUBSRV phSrv, PCGDBSTUBSRVIF pSrvIf, uint32_t cWorkers, void *pvUser)
+{
+    if (   !phSrv
+        || !pSrvIf
+        || !pSrvIf->pfnConnect
+        || !pSrvIf->pfnDisconnect)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    if (!cWorkers)
+        cWorkers = GDBSTUBSRV_WORKERS_DEF;
+
+    int rc = GDBSTUB_INF_SUCCESS;
+    PGDBSTUBSRVINT pThis = (PGDBSTUBSRVINT)calloc(1, sizeof(*pThis));
+    if (pThis)
+    {
+        pThis->pSrvIf      = pSrvIf;
+        pThis->pvUser      = pvUser;
+        pThis->pListeners  = NULL;
+        pThis->pConns      = NULL;
+        pThis->iFdEpoll    = epoll_create1(EPOLL_CLOEXEC);
+        pThis->iFdShutdown = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pThis->paWorkers   = (pthread_t *)calloc(cWorkers, sizeof(pthread_t));
+        if (   pThis->iFdEpoll != -1
+            && pThis->iFdShutdown != -1
+            && pThis->paWorkers)
+        {
+            struct epoll_event Evt;
+
+            Evt.events   = EPOLLIN;
+            Evt.data.ptr = NULL;
+            if (!epoll_ctl(pThis->iFdEpoll, EPOLL_CTL_ADD, pThis->iFdShutdown, &Evt))
+            {
+                pthread_mutex_init(&pThis->Mtx, NULL);
+
+                while (   pThis->cWorkers < cWorkers
+                       && !pthread_create(&pThis->paWorkers[pThis->cWorkers], NULL, gdbStubSrvWorker, pThis))
+                    pThis->cWorkers++;
+
+                if (pThis->cWorkers == cWorkers)
+                {
+                    *phSrv = pThis;
+                    return GDBSTUB_INF_SUCCESS;
+                }
+
+                rc = GDBSTUB_ERR_NO_MEMORY;
+                gdbStubSrvWorkersTerminate(pThis, pThis->cWorkers);
+                pthread_mutex_destroy(&pThis->Mtx);
+            }
+            else
+                rc = gdbStubSrvErrnoToSts(errno);
+        }
+        else
+            rc = GDBSTUB_ERR_NO_MEMORY;
+
+        if (pThis->iFdEpoll != -1)
+            close(pThis->iFdEpoll);
+        if (pThis->iFdShutdown != -1)
+            close(pThis->iFdShutdown);
+        free(pThis->paWorkers);
+        free(pThis);
+    }
+    else
+        rc = GDBSTUB_ERR_NO_MEMORY;
+
+    return rc;
+}
+
+
+void GDBStubSrvDestroy(GDBSTUBSRV hSrv)
+{
+    PGDBSTUBSRVINT pThis = hSrv;
+
+    if (!pThis)
+        return;
+
+    /* Nothing gets processed once the workers are gone, so the lists can be torn down without further care. */
+    gdbStubSrvWorkersTerminate(pThis, pThis->cWorkers);
+
+    while (pThis->pConns)
+        gdbStubSrvConnClose(pThis, pThis->pConns);
+
+    PGDBSTUBSRVLISTENER pListener = pThis->pListeners;
+    while (pListener)
+    {
+        PGDBSTUBSRVLISTENER pNext = pListener->pNext;
+
+        close(pListener->iFdSock);
+        free(pListener);
+        pListener = pNext;
+    }
+
+    pthread_mutex_destroy(&pThis->Mtx);
+    close(pThis->iFdEpoll);
+    close(pThis->iFdShutdown);
+    free(pThis->paWorkers);
+    free(pThis);
+}
+
+
+int GDBStubSrvListenTcp(GDBSTUBSRV hSrv, const char *pszAddr, uint16_t uPort, void *pvEndpoint)
+{
+    PGDBSTUBSRVINT pThis = hSrv;
+
+    if (!pThis)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    char szPort[8];
+    snprintf(&szPort[0], sizeof(szPort), "%u", uPort);
+
+    struct addrinfo Hints;
+    struct addrinfo *pAddrInfo = NULL;
+    memset(&Hints, 0, sizeof(Hints));
+    Hints.ai_family   = AF_UNSPEC;
+    Hints.ai_socktype = SOCK_STREAM;
+    Hints.ai_flags    = AI_PASSIVE;
+    if (getaddrinfo(pszAddr, &szPort[0], &Hints, &pAddrInfo))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    int rc = GDBSTUB_INF_SUCCESS;
+    int iFdSock = socket(pAddrInfo->ai_family, pAddrInfo->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, pAddrInfo->ai_protocol);
+    if (iFdSock != -1)
+    {
+        int fReuseAddr = 1;
+        setsockopt(iFdSock, SOL_SOCKET, SO_REUSEADDR, &fReuseAddr, sizeof(fReuseAddr));
+
+        if (   !bind(iFdSock, pAddrInfo->ai_addr, pAddrInfo->ai_addrlen)
+            && !listen(iFdSock, SOMAXCONN))
+        {
+            PGDBSTUBSRVLISTENER pListener = (PGDBSTUBSRVLISTENER)calloc(1, sizeof(*pListener));
+            if (pListener)
+            {
+                pListener->enmType    = GDBSTUBSRVOBJTYPE_LISTENER;
+                pListener->iFdSock    = iFdSock;
+                pListener->pvEndpoint = pvEndpoint;
+
+                pthread_mutex_lock(&pThis->Mtx);
+                pListener->pNext  = pThis->pListeners;
+                pThis->pListeners = pListener;
+                pthread_mutex_unlock(&pThis->Mtx);
+
+                /* The listener stays in the list on failure and gets cleaned up on destruction. */
+                rc = gdbStubSrvObjArm(pThis, iFdSock, pListener, EPOLL_CTL_ADD);
+                freeaddrinfo(pAddrInfo);
+                return rc;
+            }
+            else
+                rc = GDBSTUB_ERR_NO_MEMORY;
+        }
+        else
+            rc = gdbStubSrvErrnoToSts(errno);
+
+        close(iFdSock);
+    }
+    else
+        rc = gdbStubSrvErrnoToSts(errno);
+
+    freeaddrinfo(pAddrInfo);
+    return rc;
+}
+
+
+int GDBStubSrvAttachFd(GDBSTUBSRV hSrv, int iFd, void *pvEndpoint)
+{
+    PGDBSTUBSRVINT pThis = hSrv;
+
+    if (!pThis)
+    {
+        close(iFd);
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+    }
+
+    int fFlags = fcntl(iFd, F_GETFL);
+    if (   fFlags == -1
+        || fcntl(iFd, F_SETFL, fFlags | O_NONBLOCK) == -1)
+    {
+        int rc = gdbStubSrvErrnoToSts(errno);
+        close(iFd);
+        return rc;
+    }
+
+    return gdbStubSrvConnCreate(pThis, iFd, pvEndpoint);
+}
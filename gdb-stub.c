@@ -25,23 +25,64 @@
  */
 
 #include <stdarg.h>
+#include <stdatomic.h>
 
 #include "libgdbstub.h"
 
+#if defined(GDBSTUB_WITH_SIMD)
+# if defined(__AVX2__)
+#  include <immintrin.h>
+#  define GDBSTUB_SIMD_AVX2
+# endif
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define GDBSTUB_SIMD_SSE2
+# endif
+# if defined(__SSSE3__)
+#  include <tmmintrin.h>
+#  define GDBSTUB_SIMD_SSSE3
+# endif
+# if defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#  define GDBSTUB_SIMD_NEON
+# endif
+#endif
+
+/*
+ * A configuration header supplied through GDBSTUB_CONFIG_FILE can fix the architecture and the register
+ * table at build time (GDBSTUB_FIXED_ARCH and GDBSTUB_FIXED_REGS) and strip protocol features which are
+ * not needed (GDBSTUB_WITHOUT_XXX), see examples/gdbstub-config-arm.h.
+ */
+#if defined(GDBSTUB_CONFIG_FILE)
+# include GDBSTUB_CONFIG_FILE
+#endif
+#if defined(GDBSTUB_FIXED_REGS) && !defined(GDBSTUB_FIXED_ARCH)
+# error "GDBSTUB_FIXED_REGS requires GDBSTUB_FIXED_ARCH"
+#endif
+
 
 /** Character indicating the start of a packet. */
 #define GDBSTUB_PKT_START       '$'
+/** Character indicating the start of a notification. */
+#define GDBSTUB_NOTIFY_START    '%'
 /** Character indicating the end of a packet (excluding the checksum). */
 #define GDBSTUB_PKT_END         '#'
 /** The escape character. */
-#define GDBSTUB_PKT_ESCAPE      '{'
+#define GDBSTUB_PKT_ESCAPE      '}'
+/** The value escaped characters are XORed with. */
+#define GDBSTUB_PKT_ESCAPE_XOR  0x20
 /** The out-of-band interrupt character. */
 #define GDBSTUB_OOB_INTERRUPT   0x03
 
+/** Number of bytes required for the framing of a packet ('$', '#' and the two checksum characters). */
+#define GDBSTUB_PKT_FRAMING_SIZE 4
+
 /** Returns the number of elements from a static array. */
 #define ELEMENTS(a_Array) (sizeof(a_Array)/sizeof(a_Array[0]))
 /** Returns the minimum of two given values. */
 #define MIN(a_Val1, a_Val2) ((a_Val1) < (a_Val2) ? (a_Val1) : (a_Val2))
+/** Returns the maximum of two given values. */
+#define MAX(a_Val1, a_Val2) ((a_Val1) > (a_Val2) ? (a_Val1) : (a_Val2))
 /** Sets the specified bit. */
 #define BIT(a_Bit) (1 << (a_Bit))
 /** Return the absolute value of a given number .*/
@@ -54,6 +95,105 @@ typedef uint8_t bool;
 /** false value. */
 #define false 0
 
+/** Concatenates the two given tokens after expanding them. */
+#define GDBSTUB_CONCAT(a_1, a_2)    GDBSTUB_CONCAT_EXP(a_1, a_2)
+/** Helper for GDBSTUB_CONCAT(). */
+#define GDBSTUB_CONCAT_EXP(a_1, a_2) a_1 ## a_2
+
+/** GDB architecture and core feature names for each architecture. */
+#define GDBSTUB_ARCH_NAME_ARM       "arm"
+#define GDBSTUB_ARCH_FEAT_ARM       "org.gnu.gdb.arm.core"
+#define GDBSTUB_ARCH_NAME_X86       "i386"
+#define GDBSTUB_ARCH_FEAT_X86       "org.gnu.gdb.i386.core"
+#define GDBSTUB_ARCH_NAME_AMD64     "i386"
+#define GDBSTUB_ARCH_FEAT_AMD64     "org.gnu.gdb.arm.core"
+
+/** Start of the target XML description up to the architecture name. */
+#define GDBSTUB_TGT_DESC_START      "<?xml version=\"1.0\"?>\n" \
+                                    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n" \
+                                    "<target version=\"1.0\">\n" \
+                                    "<architecture>"
+/** End of the target XML description. */
+#define GDBSTUB_TGT_DESC_END        "</feature>\n</target>\n"
+
+#if defined(GDBSTUB_FIXED_REGS)
+/** Register table entry for GDBSTUB_FIXED_REGS(). */
+# define GDBSTUB_FIXED_REG_ENTRY(a_Name, a_cBits, a_Type, a_fFlags) \
+    { #a_Name, a_cBits, GDBSTUBREGTYPE_ ## a_Type, a_fFlags },
+/** Member of GDBSTUBFIXEDREGS for GDBSTUB_FIXED_REGS(). */
+# define GDBSTUB_FIXED_REG_MEMBER(a_Name, a_cBits, a_Type, a_fFlags) \
+    uint8_t ab ## a_Name[(a_cBits) / 8];
+/** Counts a register for GDBSTUB_FIXED_REGS(). */
+# define GDBSTUB_FIXED_REG_COUNT(a_Name, a_cBits, a_Type, a_fFlags) \
+    + 1
+/** Accounts a register sent along with a stop reply for GDBSTUB_FIXED_REGS(). */
+# define GDBSTUB_FIXED_REG_EXPEDITE_SIZE(a_Name, a_cBits, a_Type, a_fFlags) \
+    + (((a_fFlags) & GDBSTUBREG_F_EXPEDITE) ? (a_cBits) / 8 : 0)
+/** Accounts a register sent along with a stop reply by default for GDBSTUB_FIXED_REGS(). */
+# define GDBSTUB_FIXED_REG_EXPEDITE_DEF_SIZE(a_Name, a_cBits, a_Type, a_fFlags) \
+    + (   GDBSTUBREGTYPE_ ## a_Type == GDBSTUBREGTYPE_PC \
+       || GDBSTUBREGTYPE_ ## a_Type == GDBSTUBREGTYPE_STACK_PTR ? (a_cBits) / 8 : 0)
+/** Checks a register for being the program counter for GDBSTUB_FIXED_REGS(). */
+# define GDBSTUB_FIXED_REG_IS_PC(a_Name, a_cBits, a_Type, a_fFlags) \
+    || GDBSTUBREGTYPE_ ## a_Type == GDBSTUBREGTYPE_PC
+/** Target XML description of a register for GDBSTUB_FIXED_REGS(), matching gdbStubTgtDescFmt(). */
+# define GDBSTUB_FIXED_REG_TGT_DESC(a_Name, a_cBits, a_Type, a_fFlags) \
+    "<reg name=\"" #a_Name "\" bitsize=\"" #a_cBits "\"" GDBSTUB_FIXED_REG_TGT_DESC_ ## a_Type "/>\n"
+/** The type attribute for each register type. */
+# define GDBSTUB_FIXED_REG_TGT_DESC_GP          ""
+# define GDBSTUB_FIXED_REG_TGT_DESC_PC          " type=\"code_ptr\""
+# define GDBSTUB_FIXED_REG_TGT_DESC_STACK_PTR   " type=\"data_ptr\""
+# define GDBSTUB_FIXED_REG_TGT_DESC_CODE_PTR    " type=\"code_ptr\""
+# define GDBSTUB_FIXED_REG_TGT_DESC_STATUS      ""
+
+/**
+ * Content of all registers fixed at build time, the size of the structure is the size of all registers.
+ */
+typedef struct GDBSTUBFIXEDREGS
+{
+    GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_MEMBER)
+} GDBSTUBFIXEDREGS;
+
+/**
+ * Content of any single register fixed at build time, the size of the union is the size of the largest register.
+ */
+typedef union GDBSTUBFIXEDREG
+{
+    GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_MEMBER)
+} GDBSTUBFIXEDREG;
+
+/** The register table fixed at build time, replacing GDBSTUBIF::paRegs. */
+static const GDBSTUBREG g_aFixedRegs[] =
+{
+    GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_ENTRY)
+    { NULL, 0, GDBSTUBREGTYPE_INVALID, 0 }
+};
+
+/** The target XML description for the register table fixed at build time. */
+static const char g_szFixedTgtDesc[] =
+    GDBSTUB_TGT_DESC_START
+    GDBSTUB_CONCAT(GDBSTUB_ARCH_NAME_, GDBSTUB_FIXED_ARCH)
+    "</architecture>\n<feature name=\""
+    GDBSTUB_CONCAT(GDBSTUB_ARCH_FEAT_, GDBSTUB_FIXED_ARCH)
+    "\">\n"
+    GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_TGT_DESC)
+    GDBSTUB_TGT_DESC_END;
+
+/** Returns the architecture of the given interface callback table. */
+# define GDBSTUBIF_ARCH(a_pIf)          ((void)(a_pIf), GDBSTUB_CONCAT(GDBSTUBTGTARCH_, GDBSTUB_FIXED_ARCH))
+/** Returns the register table of the given interface callback table. */
+# define GDBSTUBIF_REGS(a_pIf)          ((void)(a_pIf), &g_aFixedRegs[0])
+/** Returns the number of registers of the given context. */
+# define GDBSTUBCTX_REGS_COUNT(a_pThis) ((uint32_t)(0 GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_COUNT)))
+/** Returns the size of all registers of the given context in bytes. */
+# define GDBSTUBCTX_REGS_SIZE(a_pThis)  sizeof(GDBSTUBFIXEDREGS)
+#else
+# define GDBSTUBIF_ARCH(a_pIf)          ((a_pIf)->enmArch)
+# define GDBSTUBIF_REGS(a_pIf)          ((a_pIf)->paRegs)
+# define GDBSTUBCTX_REGS_COUNT(a_pThis) ((a_pThis)->cRegs)
+# define GDBSTUBCTX_REGS_SIZE(a_pThis)  ((a_pThis)->cbRegs)
+#endif
+
 
 /** Pointer to an internal PSP proxy context. */
 typedef struct GDBSTUBCTXINT *PGDBSTUBCTXINT;
@@ -71,6 +211,10 @@ typedef enum GDBSTUBRECVSTATE
     GDBSTUBRECVSTATE_PACKET_RECEIVE_BODY,
     /** Receiving the checksum. */
     GDBSTUBRECVSTATE_PACKET_RECEIVE_CHECKSUM,
+    /** Discarding the body of a packet exceeding the packet buffer up until the END character. */
+    GDBSTUBRECVSTATE_PACKET_DISCARD_BODY,
+    /** Discarding the checksum of a packet exceeding the packet buffer. */
+    GDBSTUBRECVSTATE_PACKET_DISCARD_CHECKSUM,
     /** Blow up the enum to 32bits for easier alignment of members in structs. */
     GDBSTUBRECVSTATE_32BIT_HACK = 0x7fffffff
 } GDBSTUBRECVSTATE;
@@ -85,10 +229,16 @@ typedef struct GDBSTUBOUTCTX
     GDBSTUBCMDOUTHLP            Hlp;
     /** Pointer to the owning GDB stub context. */
     PGDBSTUBCTXINT              pGdbStubCtx;
-    /** Current offset into the scratch buffer. */
-    uint32_t                    offScratch;
-    /** Scratch buffer. */
-    uint8_t                     abScratch[512];
+    /** Status of the first failure to send the output, returned by all helpers afterwards. */
+    int                         rc;
+    /** Flag whether the output is streamed as 'O' packets ahead of the reply, see GDBSTUBCFG_F_MON_OUTPUT_STREAM. */
+    bool                        fStream;
+    /** Number of output bytes so far. */
+    size_t                      cbOutput;
+    /** Number of output bytes in the 'O' packet being sent when streaming, 0 if none is started. */
+    size_t                      cbPktOutput;
+    /** Maximum number of output bytes per 'O' packet, derived from the packet size advertised to the remote end. */
+    size_t                      cbPktOutputMax;
 } GDBSTUBOUTCTX;
 /** Pointer to a command output context. */
 typedef GDBSTUBOUTCTX *PGDBSTUBOUTCTX;
@@ -96,6 +246,207 @@ typedef GDBSTUBOUTCTX *PGDBSTUBOUTCTX;
 typedef const GDBSTUBOUTCTX *PCGDBSTUBOUTCTX;
 
 
+/**
+ * A single target memory cache line.
+ */
+typedef struct GDBSTUBMEMCACHELINE
+{
+    /** The target address of the first byte in the line. */
+    GDBTGTMEMADDR               GdbTgtMemAddr;
+    /** Flag whether the line holds valid data. */
+    bool                        fValid;
+} GDBSTUBMEMCACHELINE;
+/** Pointer to a target memory cache line. */
+typedef GDBSTUBMEMCACHELINE *PGDBSTUBMEMCACHELINE;
+
+
+/**
+ * A breakpoint with conditions evaluated by the stub.
+ */
+typedef struct GDBSTUBBPCOND
+{
+    /** Flag whether the slot is in use. */
+    bool                        fUsed;
+    /** The breakpoint type. */
+    GDBSTUBTPTYPE               enmTpType;
+    /** The breakpoint address. */
+    GDBTGTMEMADDR               GdbTgtTpAddr;
+    /** Number of bytes used in the condition list. */
+    size_t                      cbConds;
+    /** The condition list, each condition is stored as the 16bit little endian size of the
+     * agent expression bytecode followed by the bytecode. */
+    uint8_t                     *pbConds;
+} GDBSTUBBPCOND;
+/** Pointer to a breakpoint with conditions. */
+typedef GDBSTUBBPCOND *PGDBSTUBBPCOND;
+
+
+/**
+ * A breakpoint inserted by the remote end.
+ */
+typedef struct GDBSTUBBP
+{
+    /** The breakpoint type. */
+    GDBSTUBTPTYPE               enmTpType;
+    /** The breakpoint address. */
+    GDBTGTMEMADDR               GdbTgtTpAddr;
+} GDBSTUBBP;
+/** Pointer to an inserted breakpoint. */
+typedef GDBSTUBBP *PGDBSTUBBP;
+
+
+/**
+ * A tracepoint location defined by the remote end.
+ */
+typedef struct GDBSTUBTRACEPOINT
+{
+    /** Flag whether the slot is in use. */
+    bool                        fUsed;
+    /** Flag whether the tracepoint is enabled. */
+    bool                        fEnabled;
+    /** The tracepoint number assigned by the remote end (shared by all locations of a tracepoint). */
+    uint32_t                    uNum;
+    /** The tracepoint address. */
+    GDBTGTMEMADDR               GdbTgtTpAddr;
+    /** The breakpoint kind the location is set with in the target. */
+    uint64_t                    uKind;
+    /** Number of hits after which tracing stops, 0 for no limit. */
+    uint64_t                    cPass;
+    /** Number of hits during the current trace run. */
+    uint64_t                    cHits;
+    /** Size of the condition bytecode at the start of the action list, 0 if the tracepoint is unconditional. */
+    size_t                      cbCond;
+    /** Number of bytes used in the action list. */
+    size_t                      cbActions;
+    /** The condition bytecode followed by the actions, each action is stored as the action type ('M' or 'X'),
+     * the 16bit little endian size of the data and the data. */
+    uint8_t                     *pbActions;
+} GDBSTUBTRACEPOINT;
+/** Pointer to a tracepoint location. */
+typedef GDBSTUBTRACEPOINT *PGDBSTUBTRACEPOINT;
+
+
+/**
+ * Reason why tracing stopped.
+ */
+typedef enum GDBSTUBTRACESTOP
+{
+    /** Tracing is running or wasn't started so far. */
+    GDBSTUBTRACESTOP_NOT_RUN = 0,
+    /** Stopped by the remote end. */
+    GDBSTUBTRACESTOP_USER,
+    /** The trace buffer is full. */
+    GDBSTUBTRACESTOP_FULL,
+    /** A tracepoint reached its pass count. */
+    GDBSTUBTRACESTOP_PASS_COUNT,
+    /** 32bit type blow up hack. */
+    GDBSTUBTRACESTOP_32BIT_HACK = 0x7fffffff
+} GDBSTUBTRACESTOP;
+
+
+/** Size of a trace frame header (16bit tracepoint number and 32bit size of the blocks following). */
+#define GDBSTUBTRACE_FRAME_HDR_SIZE         6
+/** Size of the header of a memory block in a trace frame ('M', 64bit address and 16bit size of the data). */
+#define GDBSTUBTRACE_BLOCK_MEM_HDR_SIZE     11
+/** Size of the data of a memory collection action (32bit base register, 64bit offset and 32bit size). */
+#define GDBSTUBTRACE_ACTION_MEM_SIZE        16
+/** Base register of a memory collection action for absolute addresses. */
+#define GDBSTUBTRACE_ACTION_MEM_ABS         UINT32_MAX
+
+
+/** Maximum number of stops waiting to be reported to the remote end. */
+#define GDBSTUBCTX_STOP_EVTS_MAX            64
+/** Maximum number of breakpoints tracked to tell them apart from tracepoints, once more are inserted
+ * a tracepoint is assumed to share its address with a breakpoint. */
+#define GDBSTUBCTX_BPS_MAX                  64
+/** Number of slots in the queue of events from other threads, must be a power of two. */
+#define GDBSTUBCTX_EVTS_MAX                 64
+/** Maximum number of console output bytes carried by a single event, longer output takes multiple events. */
+#define GDBSTUBCTX_EVT_OUTPUT_MAX           48
+/** Size of the buffer holding console output until the remote end accepts it. */
+#define GDBSTUBCTX_CONS_OUT_MAX             1024
+/** Maximum number of console output bytes sent in a single 'O' packet. */
+#define GDBSTUBCTX_CONS_OUT_PKT_MAX         256
+/** Size of the register scratch space, registers are transferred in batches fitting into it
+ * (it is always large enough to hold the largest register and all expedited registers). */
+#define GDBSTUBCTX_REGS_SCRATCH_SIZE        1024
+
+
+/**
+ * Hashed index over a table of named entries (packet processors or commands).
+ */
+typedef struct GDBSTUBNAMEIDX
+{
+    /** Number of buckets minus one, the number of buckets is a power of two. */
+    uint32_t                    fBucketMask;
+    /** The buckets holding the index of the entry plus one, 0 if the bucket is empty. */
+    uint16_t                    *paidxBuckets;
+} GDBSTUBNAMEIDX;
+/** Pointer to a hashed name index. */
+typedef GDBSTUBNAMEIDX *PGDBSTUBNAMEIDX;
+/** Pointer to a const hashed name index. */
+typedef const GDBSTUBNAMEIDX *PCGDBSTUBNAMEIDX;
+
+
+/**
+ * Event type queued from other threads.
+ */
+typedef enum GDBSTUBCTXEVTTYPE
+{
+    /** Invalid type, do not use. */
+    GDBSTUBCTXEVTTYPE_INVALID = 0,
+    /** A thread stopped. */
+    GDBSTUBCTXEVTTYPE_STOP,
+    /** Console output for the remote end. */
+    GDBSTUBCTXEVTTYPE_OUTPUT,
+    /** 32bit hack. */
+    GDBSTUBCTXEVTTYPE_32BIT_HACK = 0x7fffffff
+} GDBSTUBCTXEVTTYPE;
+
+
+/**
+ * Slot of the event queue, see gdbStubCtxEvtEnqueue().
+ */
+typedef struct GDBSTUBCTXEVT
+{
+    /** Sequence number telling whether the slot is free for the producer (position) or holds
+     * an event for the consumer (position + 1). */
+    atomic_uint_least32_t       uSeq;
+    /** The event type. */
+    GDBSTUBCTXEVTTYPE           enmType;
+    /** The thread which stopped for GDBSTUBCTXEVTTYPE_STOP. */
+    GDBTGTTHRDID                idThrd;
+    /** The reason the thread stopped for GDBSTUBCTXEVTTYPE_STOP. */
+    GDBSTUBSTOPREASON           enmReason;
+    /** Number of output bytes for GDBSTUBCTXEVTTYPE_OUTPUT. */
+    uint32_t                    cbOutput;
+    /** The output for GDBSTUBCTXEVTTYPE_OUTPUT. */
+    uint8_t                     abOutput[GDBSTUBCTX_EVT_OUTPUT_MAX];
+} GDBSTUBCTXEVT;
+/** Pointer to an event queue slot. */
+typedef GDBSTUBCTXEVT *PGDBSTUBCTXEVT;
+
+
+/**
+ * A stop taken out of the event queue waiting to be reported.
+ */
+typedef struct GDBSTUBCTXSTOPEVT
+{
+    /** The thread which stopped. */
+    GDBTGTTHRDID                idThrd;
+    /** The reason the thread stopped. */
+    GDBSTUBSTOPREASON           enmReason;
+} GDBSTUBCTXSTOPEVT;
+/** Pointer to a stop waiting to be reported. */
+typedef GDBSTUBCTXSTOPEVT *PGDBSTUBCTXSTOPEVT;
+
+
+/** Alignment of the individual memory regions of a context. */
+#define GDBSTUBCTX_MEM_ALIGNMENT            16
+/** Aligns the given size or address to GDBSTUBCTX_MEM_ALIGNMENT. */
+#define GDBSTUBCTX_MEM_ALIGN(a_cb)          (((a_cb) + GDBSTUBCTX_MEM_ALIGNMENT - 1) & ~(size_t)(GDBSTUBCTX_MEM_ALIGNMENT - 1))
+
+
 /**
  * Internal PSP proxy context.
  */
@@ -107,45 +458,278 @@ typedef struct GDBSTUBCTXINT
     PCGDBSTUBIF                 pIf;
     /** Opaque user data passed in the callbacks. */
     void                        *pvUser;
+    /** Opaque user data passed in the I/O interface callbacks. */
+    void                        *pvIoUser;
+    /** Flag whether the context lives in an arena supplied by the caller (nothing to free on destruction). */
+    bool                        fArena;
     /** The current state when receiving a new packet. */
     GDBSTUBRECVSTATE            enmState;
+    /** Maximum packet size (without the framing) advertised to the remote end. */
+    size_t                      cbPktMax;
     /** Maximum number of bytes the packet buffer can hold. */
     size_t                      cbPktBufMax;
     /** Current offset into the packet buffer. */
     uint32_t                    offPktBuf;
+    /** Offset of the start character of the packet being received in the packet buffer. */
+    uint32_t                    offPktStart;
     /** The size of the packet (minus the start, end characters and the checksum). */
     uint32_t                    cbPkt;
     /** Pointer to the packet buffer data. */
     uint8_t                     *pbPktBuf;
     /** Number of bytes left for the checksum. */
     size_t                      cbChksumRecvLeft;
+    /** Checksum of the packet being received, accumulated while searching for the end character. */
+    uint8_t                     uChkSumRecv;
     /** Last target state seen. */
     GDBSTUBTGTSTATE             enmTgtStateLast;
+    /** Events queued by other threads (bounded lock-free multi producer single consumer ring),
+     * see gdbStubCtxEvtEnqueue(). */
+    GDBSTUBCTXEVT               aEvts[GDBSTUBCTX_EVTS_MAX];
+    /** Position of the next event queue slot to fill, advanced by the producers. */
+    atomic_uint_least32_t       uEvtPosEnq;
+    /** Position of the next event queue slot to take out, owned by the thread running the stub. */
+    uint32_t                    uEvtPosDeq;
+    /** Flag whether a disconnect was requested through GDBStubCtxDisconnect(). */
+    atomic_bool                 fDisconnectReq;
+    /** Stops taken out of the event queue which weren't reported so far (ring in the order of notification). */
+    GDBSTUBCTXSTOPEVT           aStopEvts[GDBSTUBCTX_STOP_EVTS_MAX];
+    /** Index of the oldest stop in aStopEvts. */
+    uint32_t                    idxStopEvtFirst;
+    /** Number of stops in aStopEvts. */
+    uint32_t                    cStopEvts;
+    /** Console output taken out of the event queue waiting to be sent while the target is running. */
+    uint8_t                     abConsOut[GDBSTUBCTX_CONS_OUT_MAX];
+    /** Number of bytes in abConsOut. */
+    uint32_t                    cbConsOut;
+    /** Flag whether a '%Stop' notification was sent and the remote end didn't collect all stops through 'vStopped' yet. */
+    bool                        fStopNotifyInFlight;
+    /** The thread selected for register and memory accesses, GDBTGTTHRDID_ANY if none selected yet. */
+    GDBTGTTHRDID                idThrdGen;
+    /** Index of the next thread to report for 'qsThreadInfo'. */
+    uint32_t                    idxThrdInfoNext;
     /** Number of registers this architecture has. */
     uint32_t                    cRegs;
     /** Overall size to return all registers. */
     size_t                      cbRegs;
     /** Register scratch space (for reading writing registers). */
     void                        *pvRegsScratch;
+    /** Size of the register scratch space in bytes. */
+    size_t                      cbRegsScratch;
     /** Register index array for querying setting. */
     uint32_t                    *paidxRegs;
+    /** Number of registers sent along with a stop reply. */
+    uint32_t                    cRegsExpedite;
+    /** Register index array of the registers sent along with a stop reply. */
+    uint32_t                    *paidxRegsExpedite;
+    /** The register cache, laid out like the reply to 'g', NULL if disabled. */
+    uint8_t                     *pbRegsCache;
+    /** Offset of each register in the register cache. */
+    uint32_t                    *paoffRegsCache;
+    /** State of each register in the cache, combination of GDBSTUBCTX_REGS_CACHE_F_XXX. */
+    uint8_t                     *pafRegsCache;
+    /** Register index array for batching reads and write backs of the register cache. */
+    uint32_t                    *paidxRegsCacheBatch;
+    /** The target memory cache lines, NULL if the memory cache is disabled. */
+    PGDBSTUBMEMCACHELINE        paMemCacheLines;
+    /** The data of the memory cache lines. */
+    uint8_t                     *pbMemCache;
+    /** Number of memory cache lines. */
+    uint32_t                    cMemCacheLines;
+    /** Size of a memory cache line in bytes. */
+    size_t                      cbMemCacheLine;
+    /** Index of the program counter register, UINT32_MAX if the target has none. */
+    uint32_t                    idxRegPc;
+    /** The breakpoints with conditions evaluated by the stub, NULL if disabled. */
+    PGDBSTUBBPCOND              paBpConds;
+    /** Number of breakpoint condition slots. */
+    uint32_t                    cBpConds;
+    /** Number of slots in use. */
+    uint32_t                    cBpCondsUsed;
+    /** Maximum size of the condition list of a single breakpoint. */
+    size_t                      cbBpCondsMax;
+    /** Flag whether a thread was single stepped asynchronously since the last stop, the next stop is always reported. */
+    bool                        fStepPending;
+    /** The breakpoints inserted by the remote end, a stop at one of them is reported even if a tracepoint is hit. */
+    GDBSTUBBP                   aBps[GDBSTUBCTX_BPS_MAX];
+    /** Number of entries in aBps. */
+    uint32_t                    cBps;
+    /** Number of inserted breakpoints not fitting into aBps. */
+    uint32_t                    cBpsUntracked;
+    /** The tracepoint slots, NULL if tracepoints are disabled. */
+    PGDBSTUBTRACEPOINT          paTracePoints;
+    /** Number of tracepoint slots. */
+    uint32_t                    cTracePoints;
+    /** Maximum size of the condition and actions of a single tracepoint. */
+    size_t                      cbTracePointMax;
+    /** The trace frame buffer, frames are laid out like in the trace file format of GDB. */
+    uint8_t                     *pbTraceBuf;
+    /** Size of the trace frame buffer in bytes. */
+    size_t                      cbTraceBuf;
+    /** Offset of the oldest frame. */
+    size_t                      offTraceTail;
+    /** Offset right after the newest frame, the frame being collected starts here. */
+    size_t                      offTraceHead;
+    /** Offset right after the last frame before the end of the buffer if the frames wrapped around. */
+    size_t                      offTraceWrap;
+    /** Flag whether the frames wrapped around, the oldest ones end at offTraceWrap and the newest start at 0. */
+    bool                        fTraceWrapped;
+    /** Number of bytes of the frame being collected. */
+    size_t                      cbTraceFrame;
+    /** Number of frames in the buffer. */
+    uint32_t                    cTraceFrames;
+    /** Number of frames dropped to make room for new ones, frame numbers stay the same while the buffer wraps. */
+    uint32_t                    cTraceFramesDropped;
+    /** Number of the selected frame register and memory accesses are served from, UINT32_MAX if none is selected. */
+    uint32_t                    idTraceFrameSel;
+    /** Offset of the selected frame. */
+    size_t                      offTraceFrameSel;
+    /** Flag whether tracing is running. */
+    bool                        fTraceRunning;
+    /** Flag whether the oldest frames are dropped when the buffer is full instead of stopping tracing. */
+    bool                        fTraceCircular;
+    /** Reason why tracing stopped. */
+    GDBSTUBTRACESTOP            enmTraceStop;
+    /** The tracepoint number which caused tracing to stop. */
+    uint32_t                    uTraceStopTp;
     /** Send packet checksum. */
     uint8_t                     uChkSumSend;
+    /** Output buffer, replies (and ACKs) are assembled here and written in one go. */
+    uint8_t                     *pbOutBuf;
+    /** Size of the output buffer in bytes. */
+    size_t                      cbOutBufMax;
+    /** Number of bytes currently queued in the output buffer. */
+    size_t                      offOutBuf;
+    /** Flag whether the queued replies are only written when requested through GDBStubCtxFlush(), see GDBSTUBCFG_F_FLUSH_MANUAL. */
+    bool                        fFlushManual;
+    /** Flag whether the output of monitor commands is streamed as 'O' packets, see GDBSTUBCFG_F_MON_OUTPUT_STREAM. */
+    bool                        fMonOutputStream;
     /** Feature flags supported we negotiated with the remote end. */
     uint32_t                    fFeatures;
-    /** Pointer to the XML target description. */
-    uint8_t                     *pbTgtXmlDesc;
+    /** Pointer to the XML target description generated from the register table (or fixed at build time),
+     * unused if the target supplies prebuilt annexes. */
+    const uint8_t               *pbTgtXmlDesc;
     /** Size of the XML target description. */
     size_t                      cbTgtXmlDesc;
+    /** Pointer to the XML memory map generated from the memory region table, NULL if the target has none. */
+    uint8_t                     *pbMemMap;
+    /** Size of the XML memory map. */
+    size_t                      cbMemMap;
+    /** Buffer merging the flash writes to a single erase block, NULL if the target has no flash regions. */
+    uint8_t                     *pbFlashBlock;
+    /** Start address of the erase block in the buffer. */
+    GDBTGTMEMADDR               GdbTgtMemAddrFlashBlock;
+    /** Size of the erase block in the buffer, 0 if there is no pending write. */
+    size_t                      cbFlashBlock;
+    /** Index over the 'q' packet processors. */
+    GDBSTUBNAMEIDX              IdxQPktProcs;
+    /** Index over the 'Q' packet processors. */
+    GDBSTUBNAMEIDX              IdxQSetPktProcs;
+    /** Index over the 'v' packet processors. */
+    GDBSTUBNAMEIDX              IdxVPktProcs;
+    /** Index over the custom commands in GDBSTUBIF::paCmds. */
+    GDBSTUBNAMEIDX              IdxCmds;
     /** Flag whether the stub is in extended mode. */
     bool                        fExtendedMode;
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
     /** Output context. */
     GDBSTUBOUTCTX               OutCtx;
+#endif
+#if defined(GDBSTUB_WITH_STATS)
+    /** The collected statistics. */
+    GDBSTUBSTATS                Stats;
+    /** Flag whether the statistics are reset after the current packet was processed. */
+    bool                        fStatsReset;
+#endif
 } GDBSTUBCTXINT;
 
 
+/**
+ * Memory layout of a context, computed during creation.
+ */
+typedef struct GDBSTUBCTXMEMLAYOUT
+{
+    /** Maximum packet size (without the framing). */
+    size_t                      cbPktMax;
+    /** Number of registers. */
+    uint32_t                    cRegs;
+    /** Size of all registers in bytes. */
+    size_t                      cbRegs;
+    /** Size of the register scratch space in bytes. */
+    size_t                      cbRegsScratch;
+    /** Flag whether the register cache is enabled. */
+    bool                        fRegsCache;
+    /** Number of memory cache lines. */
+    uint32_t                    cMemCacheLines;
+    /** Size of a memory cache line in bytes. */
+    size_t                      cbMemCacheLine;
+    /** Number of breakpoint condition slots. */
+    uint32_t                    cBpConds;
+    /** Maximum size of the condition list of a single breakpoint. */
+    size_t                      cbBpCondsMax;
+    /** Number of tracepoint slots. */
+    uint32_t                    cTracePoints;
+    /** Maximum size of the condition and actions of a single tracepoint. */
+    size_t                      cbTracePointMax;
+    /** Size of the trace frame buffer in bytes. */
+    size_t                      cbTraceBuf;
+    /** Offset of the register scratch space. */
+    size_t                      offRegsScratch;
+    /** Offset of the packet buffer. */
+    size_t                      offPktBuf;
+    /** Offset of the output buffer. */
+    size_t                      offOutBuf;
+    /** Offset of the memory cache. */
+    size_t                      offMemCache;
+    /** Offset of the breakpoint condition slots. */
+    size_t                      offBpConds;
+    /** Offset of the tracepoint slots. */
+    size_t                      offTracePoints;
+    /** Offset of the trace frame buffer. */
+    size_t                      offTraceBuf;
+    /** Offset of the target XML description. */
+    size_t                      offTgtXmlDesc;
+    /** Size of the target XML description in bytes. */
+    size_t                      cbTgtXmlDesc;
+    /** Offset of the XML memory map. */
+    size_t                      offMemMap;
+    /** Size of the XML memory map in bytes. */
+    size_t                      cbMemMap;
+    /** Offset of the flash erase block buffer. */
+    size_t                      offFlashBlock;
+    /** Size of the largest flash erase block in bytes, 0 if there are no flash regions. */
+    size_t                      cbFlashBlockMax;
+    /** Number of custom commands. */
+    uint32_t                    cCmds;
+    /** Number of buckets for the 'q' packet processor index. */
+    uint32_t                    cBucketsQPktProcs;
+    /** Number of buckets for the 'Q' packet processor index. */
+    uint32_t                    cBucketsQSetPktProcs;
+    /** Number of buckets for the 'v' packet processor index. */
+    uint32_t                    cBucketsVPktProcs;
+    /** Number of buckets for the custom command index. */
+    uint32_t                    cBucketsCmds;
+    /** Offset of the buckets for all indices. */
+    size_t                      offNameIdxBuckets;
+    /** Total number of bytes required. */
+    size_t                      cbTotal;
+} GDBSTUBCTXMEMLAYOUT;
+/** Pointer to a context memory layout. */
+typedef GDBSTUBCTXMEMLAYOUT *PGDBSTUBCTXMEMLAYOUT;
+
+
 /** Indicate support for the 'qXfer:features:read' packet to support the target description. */
 #define GDBSTUBCTX_FEATURES_F_TGT_DESC      BIT(0)
+/** The remote end requested to disable acknowledges through 'QStartNoAckMode'. */
+#define GDBSTUBCTX_FEATURES_F_NO_ACK_MODE   BIT(1)
+/** The target provides the thread callbacks. */
+#define GDBSTUBCTX_FEATURES_F_THRDS         BIT(2)
+/** The remote end enabled the non-stop mode through 'QNonStop:1'. */
+#define GDBSTUBCTX_FEATURES_F_NON_STOP      BIT(3)
+
+/** The cached register content is valid. */
+#define GDBSTUBCTX_REGS_CACHE_F_VALID       BIT(0)
+/** The cached register was modified and needs to be written back before the target resumes. */
+#define GDBSTUBCTX_REGS_CACHE_F_DIRTY       BIT(1)
 
 /**
  * Specific query packet processor callback.
@@ -231,54 +815,141 @@ typedef GDBSTUBFEATDESC *PGDBSTUBFEATDESC;
 typedef const GDBSTUBFEATDESC *PCGDBSTUBFEATDESC;
 
 
+/**
+ * Agent expression opcode descriptor.
+ */
+typedef struct GDBSTUBAXOPDESC
+{
+    /** Size of the immediate operand following the opcode in bytes, GDBSTUBAX_OP_INVALID if the opcode is not supported. */
+    uint8_t                     cbImm;
+    /** Number of stack entries the opcode consumes. */
+    uint8_t                     cPop;
+    /** Number of stack entries the opcode produces. */
+    uint8_t                     cPush;
+} GDBSTUBAXOPDESC;
+/** Pointer to a const agent expression opcode descriptor. */
+typedef const GDBSTUBAXOPDESC *PCGDBSTUBAXOPDESC;
+
+/** Marks an unsupported agent expression opcode in GDBSTUBAXOPDESC::cbImm. */
+#define GDBSTUBAX_OP_INVALID                0xff
+/** Maximum depth of the agent expression evaluation stack. */
+#define GDBSTUBAX_STACK_MAX                 32
+/** Maximum number of agent expression opcodes executed for a single evaluation, bounds loops. */
+#define GDBSTUBAX_STEPS_MAX                 4096
+
+
 /**
  * GDB architecture names.
  */
-static const char *s_aGdbArchMapping[] =
+static const char * const s_aGdbArchMapping[] =
 {
-    NULL,   /* GDBSTUBTGTARCH_INVALID */
-    "arm",  /* GDBSTUBTGTARCH_ARM     */
-    "i386", /* GDBSTUBTGTARCH_X86     */
-    "i386", /* GDBSTUBTGTARCH_AMD64   */
+    NULL,                       /* GDBSTUBTGTARCH_INVALID */
+    GDBSTUB_ARCH_NAME_ARM,      /* GDBSTUBTGTARCH_ARM     */
+    GDBSTUB_ARCH_NAME_X86,      /* GDBSTUBTGTARCH_X86     */
+    GDBSTUB_ARCH_NAME_AMD64,    /* GDBSTUBTGTARCH_AMD64   */
 };
 
 
 /**
  * Core feature mapping names for each architecture.
  */
-static const char *s_aGdbArchFeatMapping[] =
+static const char * const s_aGdbArchFeatMapping[] =
 {
-    NULL,                    /* GDBSTUBTGTARCH_INVALID */
-    "org.gnu.gdb.arm.core",  /* GDBSTUBTGTARCH_ARM     */
-    "org.gnu.gdb.i386.core", /* GDBSTUBTGTARCH_X86     */
-    "org.gnu.gdb.arm.core",  /* GDBSTUBTGTARCH_AMD64   */
+    NULL,                       /* GDBSTUBTGTARCH_INVALID */
+    GDBSTUB_ARCH_FEAT_ARM,      /* GDBSTUBTGTARCH_ARM     */
+    GDBSTUB_ARCH_FEAT_X86,      /* GDBSTUBTGTARCH_X86     */
+    GDBSTUB_ARCH_FEAT_AMD64,    /* GDBSTUBTGTARCH_AMD64   */
 };
 
 
+#if defined(GDBSTUB_WITH_STATS)
+/** Starts profiling, storing the start timestamp in a new variable with the given name. */
+# define GDBSTUB_STATS_PROFILE_START(a_pThis, a_TsStart)        uint64_t const a_TsStart = gdbStubCtxStatsTsQuery(a_pThis)
+/** Stops profiling an interface callback started with GDBSTUB_STATS_PROFILE_START(). */
+# define GDBSTUB_STATS_PROFILE_IF_STOP(a_pThis, a_enmIf, a_TsStart) \
+    gdbStubCtxStatsLatAdd(&(a_pThis)->Stats.aTgtIf[a_enmIf], gdbStubCtxStatsTsQuery(a_pThis) - (a_TsStart))
+/** Adds the given value to a statistics counter. */
+# define GDBSTUB_STATS_ADD(a_pThis, a_Member, a_cAdd)           ((a_pThis)->Stats.a_Member += (a_cAdd))
+/** Counts the acknowledges in the given data skipped while searching for the start of a packet. */
+# define GDBSTUB_STATS_ACKS_COUNT(a_pThis, a_pbData, a_cbData)  gdbStubCtxStatsAcksCount(a_pThis, a_pbData, a_cbData)
+#else
+# define GDBSTUB_STATS_PROFILE_START(a_pThis, a_TsStart)        do { } while (0)
+# define GDBSTUB_STATS_PROFILE_IF_STOP(a_pThis, a_enmIf, a_TsStart) do { } while (0)
+# define GDBSTUB_STATS_ADD(a_pThis, a_Member, a_cAdd)           do { } while (0)
+# define GDBSTUB_STATS_ACKS_COUNT(a_pThis, a_pbData, a_cbData)  do { } while (0)
+#endif
+
+
+#if defined(GDBSTUB_WITH_STATS)
 /**
- * Wrapper for allocating memory using the callback interface.
+ * Returns the current timestamp for the statistics.
  *
- * @returns Pointer to the allocated memory on success or NULL if out of memory.
+ * @returns Timestamp in nanoseconds, 0 if the target doesn't provide a time source.
  * @param   pThis               The GDB stub context.
- * @param   cbAlloc             Number of bytes to allocate.
  */
-static inline void *gdbStubCtxIfMemAlloc(PGDBSTUBCTXINT pThis, size_t cbAlloc)
+static inline uint64_t gdbStubCtxStatsTsQuery(PGDBSTUBCTXINT pThis)
+{
+    if (pThis->pIf->pfnTimeNsQuery)
+        return pThis->pIf->pfnTimeNsQuery(pThis, pThis->pvUser);
+
+    return 0;
+}
+
+
+/**
+ * Adds a sample to the given latency statistics.
+ *
+ * @returns nothing.
+ * @param   pLat                The latency statistics to update.
+ * @param   cNs                 The sample in nanoseconds.
+ */
+static void gdbStubCtxStatsLatAdd(PGDBSTUBSTATSLAT pLat, uint64_t cNs)
 {
-    return pThis->pIf->pfnMemAlloc(pThis, pThis->pvUser, cbAlloc);
+    uint32_t idxBucket = 0;
+    for (uint64_t cUs = cNs >> 10; cUs && idxBucket < GDBSTUBSTATS_LAT_BUCKETS - 1; cUs >>= 1)
+        idxBucket++;
+
+    pLat->cSamples++;
+    pLat->cNsTotal += cNs;
+    pLat->cNsMax    = MAX(pLat->cNsMax, cNs);
+    pLat->acBuckets[idxBucket]++;
 }
 
 
 /**
- * Wrapper for freeing memory using the callback interface.
+ * Counts the acknowledges the remote end sent in the given data.
  *
  * @returns nothing.
  * @param   pThis               The GDB stub context.
- * @param   pv                  The pointer to free.
+ * @param   pbData              The data skipped while searching for the start of a packet.
+ * @param   cbData              Size of the data in bytes.
  */
-static inline void gdbStubCtxIfMemFree(PGDBSTUBCTXINT pThis, void *pv)
+static void gdbStubCtxStatsAcksCount(PGDBSTUBCTXINT pThis, const uint8_t *pbData, size_t cbData)
 {
-    return pThis->pIf->pfnMemFree(pThis, pThis->pvUser, pv);
+    for (size_t i = 0; i < cbData; i++)
+    {
+        if (pbData[i] == '+')
+            pThis->Stats.cAcksRecv++;
+        else if (pbData[i] == '-')
+            pThis->Stats.cNaksRecv++;
+    }
 }
+#endif
+
+
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+/**
+ * Software breakpoint kind for each architecture, used for tracepoints as the remote end doesn't
+ * send one along (the kind it uses for breakpoints in the default instruction set).
+ */
+static const uint64_t s_auGdbArchBpKind[] =
+{
+    0,                          /* GDBSTUBTGTARCH_INVALID */
+    4,                          /* GDBSTUBTGTARCH_ARM     */
+    1,                          /* GDBSTUBTGTARCH_X86     */
+    1,                          /* GDBSTUBTGTARCH_AMD64   */
+};
+#endif
 
 
 /**
@@ -289,7 +960,10 @@ static inline void gdbStubCtxIfMemFree(PGDBSTUBCTXINT pThis, void *pv)
  */
 static inline GDBSTUBTGTSTATE gdbStubCtxIfTgtGetState(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIf->pfnTgtGetState(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    GDBSTUBTGTSTATE enmState = pThis->pIf->pfnTgtGetState(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_GET_STATE, TsStart);
+    return enmState;
 }
 
 
@@ -301,7 +975,10 @@ static inline GDBSTUBTGTSTATE gdbStubCtxIfTgtGetState(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIfTgtStop(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIf->pfnTgtStop(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtStop(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_STOP, TsStart);
+    return rc;
 }
 
 
@@ -313,7 +990,10 @@ static inline int gdbStubCtxIfTgtStop(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIfTgtRestart(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIf->pfnTgtRestart(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtRestart(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_RESTART, TsStart);
+    return rc;
 }
 
 
@@ -325,7 +1005,10 @@ static inline int gdbStubCtxIfTgtRestart(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIfTgtKill(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIf->pfnTgtKill(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtKill(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_KILL, TsStart);
+    return rc;
 }
 
 
@@ -337,7 +1020,10 @@ static inline int gdbStubCtxIfTgtKill(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIfTgtStep(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIf->pfnTgtStep(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtStep(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_STEP, TsStart);
+    return rc;
 }
 
 
@@ -349,7 +1035,10 @@ static inline int gdbStubCtxIfTgtStep(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIfTgtContinue(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIf->pfnTgtCont(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtCont(pThis, pThis->pvUser);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_CONT, TsStart);
+    return rc;
 }
 
 
@@ -364,7 +1053,49 @@ static inline int gdbStubCtxIfTgtContinue(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIfTgtMemRead(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, void *pvDst, size_t cbRead)
 {
-    return pThis->pIf->pfnTgtMemRead(pThis, pThis->pvUser, GdbTgtMemAddr, pvDst, cbRead);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtMemRead(pThis, pThis->pvUser, GdbTgtMemAddr, pvDst, cbRead);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_MEM_READ, TsStart);
+    return rc;
+}
+
+
+/**
+ * Wrapper for the interface target memory map callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       The target memory address to map.
+ * @param   cbMap               Number of bytes to map.
+ * @param   ppvMap              Where to store the pointer to the mapping on success.
+ * @param   pcbMapped           Where to store the number of contiguous bytes accessible through the mapping on success.
+ */
+static inline int gdbStubCtxIfTgtMemMap(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, size_t cbMap, const void **ppvMap, size_t *pcbMapped)
+{
+    if (pThis->pIf->pfnTgtMemMap)
+    {
+        GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+        int rc = pThis->pIf->pfnTgtMemMap(pThis, pThis->pvUser, GdbTgtMemAddr, cbMap, ppvMap, pcbMapped);
+        GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_MEM_MAP, TsStart);
+        return rc;
+    }
+
+    return GDBSTUB_ERR_NOT_SUPPORTED;
+}
+
+
+/**
+ * Wrapper for the interface target memory unmap callback.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ * @param   pvMap               The mapping to release.
+ * @param   cbMapped            Number of bytes mapped as returned by gdbStubCtxIfTgtMemMap().
+ */
+static inline void gdbStubCtxIfTgtMemUnmap(PGDBSTUBCTXINT pThis, const void *pvMap, size_t cbMapped)
+{
+    if (pThis->pIf->pfnTgtMemUnmap)
+        pThis->pIf->pfnTgtMemUnmap(pThis, pThis->pvUser, pvMap, cbMapped);
 }
 
 
@@ -379,7 +1110,10 @@ static inline int gdbStubCtxIfTgtMemRead(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR Gdb
  */
 static inline int gdbStubCtxIfTgtMemWrite(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, void *pvSrc, size_t cbWrite)
 {
-    return pThis->pIf->pfnTgtMemWrite(pThis, pThis->pvUser, GdbTgtMemAddr, pvSrc, cbWrite);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtMemWrite(pThis, pThis->pvUser, GdbTgtMemAddr, pvSrc, cbWrite);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_MEM_WRITE, TsStart);
+    return rc;
 }
 
 
@@ -395,7 +1129,10 @@ static inline int gdbStubCtxIfTgtMemWrite(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR Gd
  */
 static inline int gdbStubCtxIfTgtRegsRead(PGDBSTUBCTXINT pThis, uint32_t *paRegs, uint32_t cRegs, void *pvDst)
 {
-    return pThis->pIf->pfnTgtRegsRead(pThis, pThis->pvUser, paRegs, cRegs, pvDst);
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtRegsRead(pThis, pThis->pvUser, paRegs, cRegs, pvDst);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_REGS_READ, TsStart);
+    return rc;
 }
 
 
@@ -411,7 +1148,15 @@ static inline int gdbStubCtxIfTgtRegsRead(PGDBSTUBCTXINT pThis, uint32_t *paRegs
  */
 static inline int gdbStubCtxIfTgtRegsWrite(PGDBSTUBCTXINT pThis, uint32_t *paRegs, uint32_t cRegs, void *pvSrc)
 {
-    return pThis->pIf->pfnTgtRegsWrite(pThis, pThis->pvUser, paRegs, cRegs, pvSrc);
+    if (pThis->pIf->pfnTgtRegsWrite)
+    {
+        GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+        int rc = pThis->pIf->pfnTgtRegsWrite(pThis, pThis->pvUser, paRegs, cRegs, pvSrc);
+        GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_REGS_WRITE, TsStart);
+        return rc;
+    }
+
+    return GDBSTUB_ERR_NOT_SUPPORTED;
 }
 
 
@@ -422,12 +1167,19 @@ static inline int gdbStubCtxIfTgtRegsWrite(PGDBSTUBCTXINT pThis, uint32_t *paReg
  * @param   pThis               The GDB stub context.
  * @param   GdbTgtTpAddr        The target address space memory address to set the trace point at.
  * @param   enmTpType           The tracepoint type (working on instructions or memory accesses).
+ * @param   uKind               The number of bytes to watch or the breakpoint kind.
  * @param   enmTpAction         The action to execute if the tracepoint is hit.
  */
-static inline int gdbStubCtxIfTgtTpSet(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, GDBSTUBTPACTION enmTpAction)
+static inline int gdbStubCtxIfTgtTpSet(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind,
+                                       GDBSTUBTPACTION enmTpAction)
 {
     if (pThis->pIf->pfnTgtTpSet)
-        return pThis->pIf->pfnTgtTpSet(pThis, pThis->pvUser, GdbTgtTpAddr, enmTpType, enmTpAction);
+    {
+        GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+        int rc = pThis->pIf->pfnTgtTpSet(pThis, pThis->pvUser, GdbTgtTpAddr, enmTpType, uKind, enmTpAction);
+        GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_TP_SET, TsStart);
+        return rc;
+    }
 
     return GDBSTUB_ERR_NOT_SUPPORTED;
 }
@@ -439,16 +1191,146 @@ static inline int gdbStubCtxIfTgtTpSet(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTg
  * @returns Status code.
  * @param   pThis               The GDB stub context.
  * @param   GdbTgtTpAddr        The target address space memory address to remove the trace point from.
+ * @param   enmTpType           The tracepoint type.
+ * @param   uKind               The number of bytes watched or the breakpoint kind.
  */
-static inline int gdbStubCtxIfTgtTpClear(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr)
+static inline int gdbStubCtxIfTgtTpClear(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind)
 {
     if (pThis->pIf->pfnTgtTpClear)
-        return pThis->pIf->pfnTgtTpClear(pThis, pThis->pvUser, GdbTgtTpAddr);
+    {
+        GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+        int rc = pThis->pIf->pfnTgtTpClear(pThis, pThis->pvUser, GdbTgtTpAddr, enmTpType, uKind);
+        GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_TP_CLEAR, TsStart);
+        return rc;
+    }
 
     return GDBSTUB_ERR_NOT_SUPPORTED;
 }
 
 
+/**
+ * Wrapper for the interface target thread enumeration callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   idxStart            Index of the first thread to return.
+ * @param   paidThrds           Where to store the thread IDs.
+ * @param   cThrds              Maximum number of thread IDs to return.
+ * @param   pcThrds             Where to store the number of thread IDs returned.
+ */
+static inline int gdbStubCtxIfTgtThrdsQuery(PGDBSTUBCTXINT pThis, uint32_t idxStart, GDBTGTTHRDID *paidThrds, uint32_t cThrds, uint32_t *pcThrds)
+{
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtThrdsQuery(pThis, pThis->pvUser, idxStart, paidThrds, cThrds, pcThrds);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_THRDS_QUERY, TsStart);
+    return rc;
+}
+
+
+/**
+ * Wrapper for the interface target thread select callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   idThrd              The thread to select.
+ */
+static inline int gdbStubCtxIfTgtThrdSelect(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd)
+{
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtThrdSelect(pThis, pThis->pvUser, idThrd);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_THRD_SELECT, TsStart);
+    return rc;
+}
+
+
+/**
+ * Wrapper for the interface target thread state callback.
+ *
+ * @returns Thread state.
+ * @param   pThis               The GDB stub context.
+ * @param   idThrd              The thread to query.
+ */
+static inline GDBSTUBTGTSTATE gdbStubCtxIfTgtThrdGetState(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd)
+{
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    GDBSTUBTGTSTATE enmState = pThis->pIf->pfnTgtThrdGetState(pThis, pThis->pvUser, idThrd);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_THRD_GET_STATE, TsStart);
+    return enmState;
+}
+
+
+/**
+ * Wrapper for the interface target thread action callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   idThrd              The thread to apply the action to.
+ * @param   enmAction           The action to apply.
+ */
+static inline int gdbStubCtxIfTgtThrdAction(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd, GDBSTUBTHRDACTION enmAction)
+{
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtThrdAction(pThis, pThis->pvUser, idThrd, enmAction);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_THRD_ACTION, TsStart);
+    return rc;
+}
+
+
+/**
+ * Wrapper for the interface target flash erase callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       Start of the range to erase.
+ * @param   cbErase             Number of bytes to erase.
+ */
+static inline int gdbStubCtxIfTgtFlashErase(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, size_t cbErase)
+{
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtFlashErase(pThis, pThis->pvUser, GdbTgtMemAddr, cbErase);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_FLASH_ERASE, TsStart);
+    return rc;
+}
+
+
+/**
+ * Wrapper for the interface target flash write callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       Start of the erase block to write.
+ * @param   pvSrc               The content of the erase block.
+ * @param   cbWrite             Size of the erase block in bytes.
+ */
+static inline int gdbStubCtxIfTgtFlashWrite(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, const void *pvSrc, size_t cbWrite)
+{
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+    int rc = pThis->pIf->pfnTgtFlashWrite(pThis, pThis->pvUser, GdbTgtMemAddr, pvSrc, cbWrite);
+    GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_FLASH_WRITE, TsStart);
+    return rc;
+}
+
+
+/**
+ * Wrapper for the interface target flash done callback.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static inline int gdbStubCtxIfTgtFlashDone(PGDBSTUBCTXINT pThis)
+{
+    if (pThis->pIf->pfnTgtFlashDone)
+    {
+        GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+        int rc = pThis->pIf->pfnTgtFlashDone(pThis, pThis->pvUser);
+        GDBSTUB_STATS_PROFILE_IF_STOP(pThis, GDBSTUBSTATSIF_TGT_FLASH_DONE, TsStart);
+        return rc;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
 /**
  * Wrapper for the I/O interface peek callback.
  *
@@ -457,7 +1339,11 @@ static inline int gdbStubCtxIfTgtTpClear(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR Gdb
  */
 static inline size_t gdbStubCtxIoIfPeek(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIoIf->pfnPeek(pThis, pThis->pvUser);
+    /* Nothing to read if all data gets handed over through GDBStubCtxFeed(). */
+    if (!pThis->pIoIf->pfnPeek)
+        return 0;
+
+    return pThis->pIoIf->pfnPeek(pThis, pThis->pvIoUser);
 }
 
 
@@ -472,7 +1358,7 @@ static inline size_t gdbStubCtxIoIfPeek(PGDBSTUBCTXINT pThis)
  */
 static inline int gdbStubCtxIoIfRead(PGDBSTUBCTXINT pThis, void *pvDst, size_t cbRead, size_t *pcbRead)
 {
-    return pThis->pIoIf->pfnRead(pThis, pThis->pvUser, pvDst, cbRead, pcbRead);
+    return pThis->pIoIf->pfnRead(pThis, pThis->pvIoUser, pvDst, cbRead, pcbRead);
 }
 
 
@@ -486,7 +1372,7 @@ static inline int gdbStubCtxIoIfRead(PGDBSTUBCTXINT pThis, void *pvDst, size_t c
  */
 static inline int gdbStubCtxIoIfWrite(PGDBSTUBCTXINT pThis, const void *pvPkt, size_t cbPkt)
 {
-    return pThis->pIoIf->pfnWrite(pThis, pThis->pvUser, pvPkt, cbPkt);
+    return pThis->pIoIf->pfnWrite(pThis, pThis->pvIoUser, pvPkt, cbPkt);
 }
 
 
@@ -498,7 +1384,20 @@ static inline int gdbStubCtxIoIfWrite(PGDBSTUBCTXINT pThis, const void *pvPkt, s
  */
 static inline size_t gdbStubCtxIoIfPoll(PGDBSTUBCTXINT pThis)
 {
-    return pThis->pIoIf->pfnPoll(pThis, pThis->pvUser);
+    return pThis->pIoIf->pfnPoll(pThis, pThis->pvIoUser);
+}
+
+
+/**
+ * Wrapper for the I/O interface poll wakeup callback.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static inline void gdbStubCtxIoIfPollWakeup(PGDBSTUBCTXINT pThis)
+{
+    if (pThis->pIoIf->pfnPollWakeup)
+        pThis->pIoIf->pfnPollWakeup(pThis, pThis->pvIoUser);
 }
 
 
@@ -581,6 +1480,31 @@ static inline char gdbStubCtxHexToChr(uint8_t uHex)
 }
 
 
+/**
+ * Formats the given value as a hex number without leading zeros (at least one digit).
+ *
+ * @returns Number of characters written (no zero terminator is added).
+ * @param   pchDst              Where to store the digits, must have room for at least 16 characters.
+ * @param   u64                 The value to format.
+ */
+static size_t gdbStubCtxFmtHexU64(char *pchDst, uint64_t u64)
+{
+    char achTmp[16];
+    size_t cch = 0;
+
+    do
+    {
+        achTmp[cch++] = gdbStubCtxHexToChr(u64 & 0xf);
+        u64 >>= 4;
+    } while (u64);
+
+    for (size_t i = 0; i < cch; i++)
+        pchDst[i] = achTmp[cch - i - 1];
+
+    return cch;
+}
+
+
 /**
  * Internal memchr.
  *
@@ -682,1404 +1606,1427 @@ static size_t gdbStubStrlen(const char *psz)
 
 
 /**
- * Compares two strings.
+ * Hashes the given name (FNV-1a).
  *
- * @returns 0 if both strings are equal,
- *          < 0 if psz1 is less than psz2,
- *          > 0 if psz1 is less than psz2,
- * @param   psz1                    Pointer to the first string.
- * @param   psz2                    Pointer to the first string.
- *
- * @todo Allow using optimized variants of strcmp.
+ * @returns Hash value.
+ * @param   pvName                  The name to hash.
+ * @param   cchName                 Number of characters in the name.
  */
-static int gdbStubStrcmp(const char *psz1, const char *psz2)
+static uint32_t gdbStubNameHash(const void *pvName, size_t cchName)
 {
-    for (;;)
-    {
-        if (*psz1 < *psz2)
-            return -1;
-        if (*psz1 > *psz2)
-            return 1;
-
-        if (*psz1 == '\0' && *psz2 == '\0')
-            break;
+    const uint8_t *pbName = (const uint8_t *)pvName;
+    uint32_t uHash = 2166136261U;
 
-        psz1++;
-        psz2++;
-    }
+    for (size_t i = 0; i < cchName; i++)
+        uHash = (uHash ^ pbName[i]) * 16777619U;
 
-    return 0;
+    return uHash;
 }
 
 
 /**
- * Starts transmission of a new reply packet.
+ * Returns the number of buckets to use for an index over the given number of entries,
+ * keeping the load factor at or below 50%.
  *
- * @returns Status code.
- * @param   pThis               The GDB stub context.
+ * @returns Number of buckets.
+ * @param   cEntries                Number of entries to index.
  */
-static int gdbStubCtxReplySendBegin(PGDBSTUBCTXINT pThis)
+static uint32_t gdbStubNameIdxBucketsQuery(uint32_t cEntries)
 {
-    pThis->uChkSumSend = 0;
+    uint32_t cBuckets = 1;
 
-    uint8_t chPktStart = GDBSTUB_PKT_START;
-    return gdbStubCtxIoIfWrite(pThis, &chPktStart, sizeof(chPktStart));
+    while (cBuckets < 2 * cEntries)
+        cBuckets <<= 1;
+
+    return cBuckets;
 }
 
 
 /**
- * Sends the given data in the reply.
+ * Returns the name of the given table entry, every entry starts with a pointer to its name.
  *
- * @returns Status code.
- * @param   pThis               The GDB stub context.
- * @param   pbReplyData         The reply data to send.
- * @param   cbReplyData         Size of the reply data in bytes.
+ * @returns Pointer to the zero terminated name.
+ * @param   paEntries               The table.
+ * @param   cbEntry                 Size of a single entry in bytes.
+ * @param   idxEntry                The entry index.
  */
-static int gdbStubCtxReplySendData(PGDBSTUBCTXINT pThis, const uint8_t *pbReplyData, size_t cbReplyData)
+static inline const char *gdbStubNameIdxEntryName(const void *paEntries, size_t cbEntry, uint32_t idxEntry)
 {
-    /* Update checksum. */
-    for (uint32_t i = 0; i < cbReplyData; i++)
-        pThis->uChkSumSend += pbReplyData[i];
-
-    return gdbStubCtxIoIfWrite(pThis, pbReplyData, cbReplyData);
+    return *(const char * const *)((const uint8_t *)paEntries + idxEntry * cbEntry);
 }
 
 
 /**
- * Finishes transmission of the current reply by sending the packet end character and the checksum.
+ * Initializes a hashed index over the given table.
  *
- * @returns Status code.
- * @param   pThis               The GDB stub context.
+ * @returns nothing.
+ * @param   pIdx                    The index to initialize.
+ * @param   paidxBuckets            The bucket array.
+ * @param   cBuckets                Number of buckets (a power of two, see gdbStubNameIdxBucketsQuery()).
+ * @param   paEntries               The table to index.
+ * @param   cbEntry                 Size of a single entry in bytes.
+ * @param   cEntries                Number of entries in the table.
+ *
+ * @note If a name appears multiple times the first entry wins.
  */
-static int gdbStubCtxReplySendEnd(PGDBSTUBCTXINT pThis)
+static void gdbStubNameIdxInit(PGDBSTUBNAMEIDX pIdx, uint16_t *paidxBuckets, uint32_t cBuckets,
+                               const void *paEntries, size_t cbEntry, uint32_t cEntries)
 {
-    uint8_t achPktEnd[3];
+    pIdx->fBucketMask  = cBuckets - 1;
+    pIdx->paidxBuckets = paidxBuckets;
 
-    achPktEnd[0] = GDBSTUB_PKT_END;
-    achPktEnd[1] = gdbStubCtxHexToChr(pThis->uChkSumSend >> 4);
-    achPktEnd[2] = gdbStubCtxHexToChr(pThis->uChkSumSend & 0xf);
+    for (uint32_t i = 0; i < cBuckets; i++)
+        paidxBuckets[i] = 0;
+
+    for (uint32_t i = 0; i < cEntries; i++)
+    {
+        const char *pszName = gdbStubNameIdxEntryName(paEntries, cbEntry, i);
+        uint32_t idxBucket = gdbStubNameHash(pszName, gdbStubStrlen(pszName)) & pIdx->fBucketMask;
 
-    return gdbStubCtxIoIfWrite(pThis, &achPktEnd[0], sizeof(achPktEnd));
+        while (paidxBuckets[idxBucket])
+            idxBucket = (idxBucket + 1) & pIdx->fBucketMask;
+        paidxBuckets[idxBucket] = (uint16_t)(i + 1);
+    }
 }
 
 
 /**
- * Appends a single character to the given output context.
+ * Looks up the entry with the given name.
  *
- * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   ch         The character to append.
+ * @returns Index of the entry or UINT32_MAX if not found.
+ * @param   pIdx                    The index.
+ * @param   paEntries               The indexed table.
+ * @param   cbEntry                 Size of a single entry in bytes.
+ * @param   pvName                  The name to look for (not terminated).
+ * @param   cchName                 Number of characters in the name.
  */
-static void gdbStubOutCtxAppendChar(PGDBSTUBOUTCTX pThis, const char ch)
+static uint32_t gdbStubNameIdxLookup(PCGDBSTUBNAMEIDX pIdx, const void *paEntries, size_t cbEntry,
+                                     const void *pvName, size_t cchName)
 {
-    if (pThis->offScratch + 2 > sizeof(pThis->abScratch))
+    uint32_t idxBucket = gdbStubNameHash(pvName, cchName) & pIdx->fBucketMask;
+
+    while (pIdx->paidxBuckets[idxBucket])
     {
-        gdbStubCtxReplySendData(pThis->pGdbStubCtx, &pThis->abScratch[0], pThis->offScratch);
-        pThis->offScratch = 0;
+        uint32_t idxEntry = pIdx->paidxBuckets[idxBucket] - 1;
+        const char *pszName = gdbStubNameIdxEntryName(paEntries, cbEntry, idxEntry);
+
+        if (   gdbStubStrlen(pszName) == cchName
+            && !gdbStubMemcmp(pszName, pvName, cchName))
+            return idxEntry;
+
+        idxBucket = (idxBucket + 1) & pIdx->fBucketMask;
     }
 
-    pThis->abScratch[pThis->offScratch++] = gdbStubCtxHexToChr(ch >> 4);
-    pThis->abScratch[pThis->offScratch++] = gdbStubCtxHexToChr(ch & 0xf);
+    return UINT32_MAX;
 }
 
 
 /**
- * Converts a given unsigned 32bit integer into a string and appends it to the scratch buffer.
+ * Returns the length of the packet name at the start of the given buffer.
  *
- * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   u32        The value to log.
- * @param   cDigits    Minimum number of digits to log, if the number has fewer
- *                     the gap is prepended with 0.
+ * @returns Number of characters in the name.
+ * @param   pbPkt                   The packet data, must contain the end character.
+ * @param   pszDelims               The characters terminating the name besides the end character.
  */
-static void gdbStubOutCtxAppendU32(PGDBSTUBOUTCTX pThis, uint32_t u32, uint32_t cDigits)
+static size_t gdbStubPktNameLen(const uint8_t *pbPkt, const char *pszDelims)
 {
-    char achDigits[] = "0123456789";
-    char aszBuf[32];
-    unsigned offBuf = 0;
-
-    /** @todo: Optimize. */
+    size_t cchName = 0;
 
-    while (u32)
+    for (;;)
     {
-        uint8_t u8Val = u32 % 10;
-        u32 /= 10;
+        uint8_t ch = pbPkt[cchName];
+        if (ch == GDBSTUB_PKT_END)
+            break;
 
-        aszBuf[offBuf++] = achDigits[u8Val];
-    }
+        const char *pszDelim = pszDelims;
+        while (   *pszDelim
+               && (uint8_t)*pszDelim != ch)
+            pszDelim++;
+        if (*pszDelim)
+            break;
 
-    /* Prepend 0. */
-    if (offBuf < cDigits)
-    {
-        while (cDigits - offBuf > 0)
-        {
-            gdbStubOutCtxAppendChar(pThis, '0');
-            cDigits--;
-        }
+        cchName++;
     }
 
-    while (offBuf-- > 0)
-        gdbStubOutCtxAppendChar(pThis, aszBuf[offBuf]);
+    return cchName;
 }
 
 
 /**
- * Converts a given unsigned 64bit integer into a string and appends it to the scratch buffer.
+ * Returns the given little endian value zero extended to 64bit.
  *
- * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   u64        The value to log.
- * @param   cDigits    Minimum number of digits to log, if the number has fewer
- *                     the gap is prepended with 0.
+ * @returns The value.
+ * @param   pbVal               The value.
+ * @param   cbVal               Size of the value in bytes, only the lower 8 bytes are used.
  */
-static void gdbStubOutCtxAppendU64(PGDBSTUBOUTCTX pThis, uint64_t u64, uint32_t cDigits)
+static uint64_t gdbStubValFromLe(const uint8_t *pbVal, size_t cbVal)
 {
-    char achDigits[] = "0123456789";
-    char aszBuf[32];
-    unsigned offBuf = 0;
-
-    /** @todo: Optimize. */
-
-    while (u64)
-    {
-        uint8_t u8Val = u64 % 10;
-        u64 /= 10;
-
-        aszBuf[offBuf++] = achDigits[u8Val];
-    }
+    uint64_t uVal = 0;
 
-    /* Prepend 0. */
-    if (offBuf < cDigits)
+    cbVal = MIN(cbVal, sizeof(uVal));
+    while (cbVal)
     {
-        while (cDigits - offBuf > 0)
-        {
-            gdbStubOutCtxAppendChar(pThis, '0');
-            cDigits--;
-        }
+        cbVal--;
+        uVal = (uVal << 8) | pbVal[cbVal];
     }
 
-    while (offBuf-- > 0)
-        gdbStubOutCtxAppendChar(pThis, aszBuf[offBuf]);
+    return uVal;
 }
 
 
 /**
- * Converts a given unsigned 32bit integer into a string as hex and appends it to the scratch buffer.
+ * Stores the given value in little endian byte order.
  *
  * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   u32        The value to log.
- * @param   cDigits    Minimum number of digits to log, if the number has fewer
- *                     the gap is prepended with 0.
+ * @param   pbDst               Where to store the value.
+ * @param   uVal                The value.
+ * @param   cbVal               Number of bytes to store, at most 8.
  */
-static void gdbStubOutCtxAppendHexU32(PGDBSTUBOUTCTX pThis, uint32_t u32, uint32_t cDigits)
+static void gdbStubValToLe(uint8_t *pbDst, uint64_t uVal, size_t cbVal)
 {
-    char achDigits[] = "0123456789abcdef";
-    char aszBuf[10];
-    unsigned offBuf = 0;
-
-    /** @todo: Optimize. */
-
-    while (u32)
-    {
-        uint8_t u8Val = u32 & 0xf;
-        u32 >>= 4;
-
-        aszBuf[offBuf++] = achDigits[u8Val];
-    }
-
-    /* Prepend 0. */
-    if (offBuf < cDigits)
+    for (size_t i = 0; i < cbVal; i++)
     {
-        while (cDigits - offBuf > 0)
-        {
-            gdbStubOutCtxAppendChar(pThis, '0');
-            cDigits--;
-        }
+        pbDst[i] = (uint8_t)uVal;
+        uVal >>= 8;
     }
-
-    while (offBuf-- > 0)
-        gdbStubOutCtxAppendChar(pThis, aszBuf[offBuf]);
 }
 
+
 /**
- * Converts a given unsigned 64bit integer into a string as hex and appends it to the scratch buffer.
+ * Returns the size of the given trace frame including the header.
  *
- * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   u64        The value to log.
- * @param   cDigits    Minimum number of digits to log, if the number has fewer
- *                     the gap is prepended with 0.
+ * @returns Size of the frame in bytes.
+ * @param   pThis               The GDB stub context.
+ * @param   offFrame            Offset of the frame in the trace buffer.
  */
-static void gdbStubOutCtxAppendHexU64(PGDBSTUBOUTCTX pThis, uint64_t u64, uint32_t cDigits)
+static size_t gdbStubCtxTraceFrameSize(PGDBSTUBCTXINT pThis, size_t offFrame)
 {
-    char achDigits[] = "0123456789abcdef";
-    char aszBuf[20];
-    unsigned offBuf = 0;
-
-    /** @todo: Optimize. */
-
-    while (u64)
-    {
-        uint8_t u8Val = u64 & 0xf;
-        u64 >>= 4;
+    return GDBSTUBTRACE_FRAME_HDR_SIZE + (size_t)gdbStubValFromLe(&pThis->pbTraceBuf[offFrame + sizeof(uint16_t)], sizeof(uint32_t));
+}
 
-        aszBuf[offBuf++] = achDigits[u8Val];
-    }
 
-    /* Prepend 0. */
-    if (offBuf < cDigits)
-    {
-        while (cDigits - offBuf > 0)
-        {
-            gdbStubOutCtxAppendChar(pThis, '0');
-            cDigits--;
-        }
-    }
+/**
+ * Returns the offset of the frame following the given one, taking care of the buffer wrapping around.
+ *
+ * @returns Offset of the next frame.
+ * @param   pThis               The GDB stub context.
+ * @param   offFrame            Offset of the frame in the trace buffer.
+ */
+static size_t gdbStubCtxTraceFrameNext(PGDBSTUBCTXINT pThis, size_t offFrame)
+{
+    offFrame += gdbStubCtxTraceFrameSize(pThis, offFrame);
+    if (   pThis->fTraceWrapped
+        && offFrame == pThis->offTraceWrap)
+        offFrame = 0;
 
-    while (offBuf-- > 0)
-        gdbStubOutCtxAppendChar(pThis, aszBuf[offBuf]);
+    return offFrame;
 }
 
 
 /**
- * Converts a given signed 32bit integer into a string and appends it to the scratch buffer.
+ * Looks up the trace frame with the given number.
  *
- * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   i32        The value to log.
- * @param   cDigits    Minimum number of digits to log, if the number has fewer
- *                     the gap is prepended with 0.
+ * @returns Flag whether the frame is still in the buffer.
+ * @param   pThis               The GDB stub context.
+ * @param   idFrame             The frame number.
+ * @param   poffFrame           Where to store the offset of the frame.
  */
-static void gdbStubOutCtxAppendS32(PGDBSTUBOUTCTX pThis, int32_t i32, uint32_t cDigits)
+static bool gdbStubCtxTraceFrameFind(PGDBSTUBCTXINT pThis, uint32_t idFrame, size_t *poffFrame)
 {
-    /* Add sign? */
-    if (i32 < 0)
-    {
-        gdbStubOutCtxAppendChar(pThis, '-');
-        i32 = ABS(i32);
-    }
+    if (   idFrame < pThis->cTraceFramesDropped
+        || idFrame - pThis->cTraceFramesDropped >= pThis->cTraceFrames)
+        return false;
 
-    /* Treat as unsigned from here on. */
-    gdbStubOutCtxAppendU32(pThis, (uint32_t)i32, cDigits);
+    size_t offFrame = pThis->offTraceTail;
+    for (uint32_t i = pThis->cTraceFramesDropped; i < idFrame; i++)
+        offFrame = gdbStubCtxTraceFrameNext(pThis, offFrame);
+
+    *poffFrame = offFrame;
+    return true;
 }
 
 
 /**
- * Appends a given string to the logger instance.
+ * Reads the given registers from a trace frame, all registers are collected as the first block of each frame.
  *
- * @returns nothing.
- * @param   pThis      The output context instance.
- * @param   psz        The string to append.
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   offFrame            Offset of the frame in the trace buffer.
+ * @param   paidxRegs           The register indices to read.
+ * @param   cRegs               Number of registers to read.
+ * @param   pvDst               Where to store the register content.
  */
-static void gdbStubOutCtxAppendString(PGDBSTUBOUTCTX pThis, const char *psz)
+static int gdbStubCtxTraceFrameRegsRead(PGDBSTUBCTXINT pThis, size_t offFrame, const uint32_t *paidxRegs, uint32_t cRegs, void *pvDst)
 {
-    /** @todo: Optimize */
-    if (!psz)
+    const uint8_t *pbRegs = &pThis->pbTraceBuf[offFrame + GDBSTUBTRACE_FRAME_HDR_SIZE + 1];
+    uint8_t *pbDst = (uint8_t *)pvDst;
+
+    for (uint32_t i = 0; i < cRegs; i++)
     {
-        gdbStubOutCtxAppendString(pThis, "<null>");
-        return;
+        size_t offReg = 0;
+        for (uint32_t idxReg = 0; idxReg < paidxRegs[i]; idxReg++)
+            offReg += GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8;
+
+        size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[paidxRegs[i]].cRegBits / 8;
+        gdbStubCtxMemcpy(pbDst, &pbRegs[offReg], cbReg);
+        pbDst += cbReg;
     }
 
-    while (*psz)
-        gdbStubOutCtxAppendChar(pThis, *psz++);
+    return GDBSTUB_INF_SUCCESS;
 }
 
 
 /**
- * @copydoc{GDBSTUBOUTHLP,pfnPrintf}
+ * Returns the memory collected in the selected trace frame starting at the given address.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_NOT_FOUND if the memory at the given address wasn't collected.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       The target memory address to start at.
+ * @param   cb                  Number of bytes remaining to be accessed.
+ * @param   ppbData             Where to store the pointer to the data on success.
+ * @param   pcbData             Where to store the number of bytes accessible through the pointer on success (at most cb).
  */
-static int gdbStubOutCtxPrintf(PCGDBSTUBOUTHLP pHlp, const char *pszFmt, ...)
+static int gdbStubCtxTraceFrameMemQuery(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, size_t cb,
+                                        const uint8_t **ppbData, size_t *pcbData)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
-    PGDBSTUBOUTCTX pThis = (PGDBSTUBOUTCTX)pHlp;
-    va_list hArgs;
-    va_start(hArgs, pszFmt);
+    const uint8_t *pbFrame = &pThis->pbTraceBuf[pThis->offTraceFrameSel];
+    size_t cbFrame = gdbStubCtxTraceFrameSize(pThis, pThis->offTraceFrameSel);
 
-    while (*pszFmt)
+    /* Skip the register block, only memory blocks follow. */
+    size_t offBlock = GDBSTUBTRACE_FRAME_HDR_SIZE + 1 + GDBSTUBCTX_REGS_SIZE(pThis);
+    while (offBlock < cbFrame)
     {
-        char ch = *pszFmt++;
+        const uint8_t *pbBlock = &pbFrame[offBlock];
+        GDBTGTMEMADDR GdbTgtBlockAddr = gdbStubValFromLe(&pbBlock[1], sizeof(uint64_t));
+        size_t cbBlock = (size_t)gdbStubValFromLe(&pbBlock[1 + sizeof(uint64_t)], sizeof(uint16_t));
 
-        switch (ch)
+        if (   GdbTgtMemAddr >= GdbTgtBlockAddr
+            && GdbTgtMemAddr - GdbTgtBlockAddr < cbBlock)
         {
-            case '%':
-            {
-                /* Format specifier. */
-                char chFmt = *pszFmt;
-                pszFmt++;
-
-                if (chFmt == '#')
-                {
-                    gdbStubOutCtxAppendString(pThis, "0x");
-                    chFmt = *pszFmt++;
-                }
+            size_t offData = (size_t)(GdbTgtMemAddr - GdbTgtBlockAddr);
 
-                switch (chFmt)
-                {
-                    case '%':
-                    {
-                        gdbStubOutCtxAppendChar(pThis, '%');
-                        break;
-                    }
-                    case 'u':
-                    {
-                        uint32_t u32 = va_arg(hArgs, uint32_t);
-                        gdbStubOutCtxAppendU32(pThis, u32, 1);
-                        break;
-                    }
-                    case 'd':
-                    {
-                        int32_t i32 = va_arg(hArgs, int32_t);
-                        gdbStubOutCtxAppendS32(pThis, i32, 1);
-                        break;
-                    }
-                    case 's':
-                    {
-                        const char *psz = va_arg(hArgs, const char *);
-                        gdbStubOutCtxAppendString(pThis, psz);
-                        break;
-                    }
-                    case 'x':
-                    {
-                        uint32_t u32 = va_arg(hArgs, uint32_t);
-                        gdbStubOutCtxAppendHexU32(pThis, u32, 1);
-                        break;
-                    }
-                    case 'X':
-                    {
-                        uint64_t u64 = va_arg(hArgs, uint64_t);
-                        gdbStubOutCtxAppendHexU64(pThis, u64, 1);
-                        break;
-                    }
-                    case 'p': /** @todo: Works only on 32bit... */
-                    {
-                        void *pv = va_arg(hArgs, void *);
-                        gdbStubOutCtxAppendString(pThis, "0x");
-                        if (sizeof(void *) == 4)
-                            gdbStubOutCtxAppendHexU32(pThis, (uint32_t)(uintptr_t)pv, 0);
-                        else if (sizeof(void *) == 8)
-                            gdbStubOutCtxAppendHexU64(pThis, (uint64_t)(uintptr_t)pv, 0);
-                        else
-                            gdbStubOutCtxAppendString(pThis, "<Unrecognised pointer width>");
-                    }
-                    default:
-                        /** @todo: Ignore or assert? */
-                        ;
-                }
-                break;
-            }
-            default:
-                gdbStubOutCtxAppendChar(pThis, ch);
+            *ppbData = &pbBlock[GDBSTUBTRACE_BLOCK_MEM_HDR_SIZE + offData];
+            *pcbData = MIN(cb, cbBlock - offData);
+            return GDBSTUB_INF_SUCCESS;
         }
+
+        offBlock += GDBSTUBTRACE_BLOCK_MEM_HDR_SIZE + cbBlock;
     }
 
-    va_end(hArgs);
-    return rc;
+    return GDBSTUB_ERR_NOT_FOUND;
 }
 
 
 /**
- * Resets the given output context.
+ * Returns the number of registers at the start of the given index array fitting into the register scratch space.
  *
- * @returns nothing.
- * @param   pThis               The output context instance.
+ * @returns Number of registers in the batch, at least one if cRegs is not 0.
+ * @param   pThis               The GDB stub context.
+ * @param   paidxRegs           The register indices.
+ * @param   cRegs               Number of registers in the index array.
+ * @param   pcbBatch            Where to store the size of the batch in bytes.
  */
-static void gdbStubOutCtxReset(PGDBSTUBOUTCTX pThis)
+static uint32_t gdbStubCtxRegsBatchQuery(PGDBSTUBCTXINT pThis, const uint32_t *paidxRegs, uint32_t cRegs, size_t *pcbBatch)
 {
-    pThis->offScratch = 0;
-    gdbStubCtxMemset(&pThis->abScratch[0], 0, sizeof(pThis->abScratch));
-}
+    uint32_t cRegsBatch = 0;
+    size_t cbBatch = 0;
 
+    while (cRegsBatch < cRegs)
+    {
+        size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[paidxRegs[cRegsBatch]].cRegBits / 8;
 
-/**
- * Initializes the given output context.
- *
- * @returns nothing.
- * @param   pThis               The output context instance.
- * @param   pGdbStubCtx         The GDB stub context.
- */
-static void gdbStubOutCtxInit(PGDBSTUBOUTCTX pThis, PGDBSTUBCTXINT pGdbStubCtx)
-{
-    pThis->Hlp.pfnPrintf = gdbStubOutCtxPrintf;
-    pThis->pGdbStubCtx   = pGdbStubCtx;
-    gdbStubOutCtxReset(pThis);
+        if (cbBatch + cbReg > pThis->cbRegsScratch)
+            break;
+
+        cbBatch += cbReg;
+        cRegsBatch++;
+    }
+
+    *pcbBatch = cbBatch;
+    return cRegsBatch;
 }
 
 
 /**
- * Encodes the given buffer as a hexstring string it into the given destination buffer.
+ * Reads the given registers, going through the register cache if enabled.
  *
  * @returns Status code.
- * @param   pbDst               Where store the resulting hex string on success.
- * @param   cbDst               Size of the destination buffer in bytes.
- * @param   pvSrc               The data to encode.
- * @param   cbSrc               Number of bytes to encode.
+ * @param   pThis               The GDB stub context.
+ * @param   paidxRegs           The register indices to read.
+ * @param   cRegs               Number of registers to read.
+ * @param   pvDst               Where to store the register content.
  */
-static int gdbStubCtxEncodeBinaryAsHex(uint8_t *pbDst, size_t cbDst, void *pvSrc, size_t cbSrc)
+static int gdbStubCtxRegsRead(PGDBSTUBCTXINT pThis, uint32_t *paidxRegs, uint32_t cRegs, void *pvDst)
 {
-    if (cbSrc * 2 > cbDst)
-        return GDBSTUB_ERR_INVALID_PARAMETER;
+    if (pThis->idTraceFrameSel != UINT32_MAX)
+        return gdbStubCtxTraceFrameRegsRead(pThis, pThis->offTraceFrameSel, paidxRegs, cRegs, pvDst);
+    if (!pThis->pbRegsCache)
+        return gdbStubCtxIfTgtRegsRead(pThis, paidxRegs, cRegs, pvDst);
+
+    /* Fetch everything not cached so far in as few batches as the scratch space allows. */
+    uint32_t cRegsMiss = 0;
+    for (uint32_t i = 0; i < cRegs; i++)
+    {
+        if (!(pThis->pafRegsCache[paidxRegs[i]] & GDBSTUBCTX_REGS_CACHE_F_VALID))
+            pThis->paidxRegsCacheBatch[cRegsMiss++] = paidxRegs[i];
+    }
 
-    uint8_t *pbSrc = (uint8_t *)pvSrc;
-    for (size_t i = 0; i < cbSrc; i++)
+    int rc = GDBSTUB_INF_SUCCESS;
+    uint32_t idxMiss = 0;
+    while (   idxMiss < cRegsMiss
+           && rc == GDBSTUB_INF_SUCCESS)
     {
-        uint8_t bSrc = *pbSrc++;
+        uint8_t *pbRegs = (uint8_t *)pThis->pvRegsScratch;
+        size_t cbBatch = 0;
+        uint32_t cRegsBatch = gdbStubCtxRegsBatchQuery(pThis, &pThis->paidxRegsCacheBatch[idxMiss], cRegsMiss - idxMiss, &cbBatch);
 
-        *pbDst++ = gdbStubCtxHexToChr(bSrc >> 4);
-        *pbDst++ = gdbStubCtxHexToChr(bSrc & 0xf);
+        rc = gdbStubCtxIfTgtRegsRead(pThis, &pThis->paidxRegsCacheBatch[idxMiss], cRegsBatch, pbRegs);
+        for (uint32_t i = 0; i < cRegsBatch && rc == GDBSTUB_INF_SUCCESS; i++)
+        {
+            uint32_t idxReg = pThis->paidxRegsCacheBatch[idxMiss + i];
+            size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8;
+
+            gdbStubCtxMemcpy(&pThis->pbRegsCache[pThis->paoffRegsCache[idxReg]], pbRegs, cbReg);
+            pThis->pafRegsCache[idxReg] = GDBSTUBCTX_REGS_CACHE_F_VALID;
+            pbRegs += cbReg;
+        }
+
+        idxMiss += cRegsBatch;
     }
 
-    return GDBSTUB_INF_SUCCESS;
+    uint8_t *pbDst = (uint8_t *)pvDst;
+    for (uint32_t i = 0; i < cRegs && rc == GDBSTUB_INF_SUCCESS; i++)
+    {
+        size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[paidxRegs[i]].cRegBits / 8;
+
+        gdbStubCtxMemcpy(pbDst, &pThis->pbRegsCache[pThis->paoffRegsCache[paidxRegs[i]]], cbReg);
+        pbDst += cbReg;
+    }
+
+    return rc;
 }
 
 
 /**
- * Decodes the given ASCII hexstring as binary data up until the given separator is found or the end of the string is reached.
+ * Writes the given registers, only updating the register cache if enabled.
  *
  * @returns Status code.
- * @param   pbBuf               The buffer containing the hexstring to convert.
- * @param   cbBuf               Size of the buffer in bytes.
- * @param   pvDst               Where to store the decoded data.
- * @param   cbDst               Maximum buffer sizein bytes.
- * @param   chSep               The character to stop conversion at.
- * @param   ppbSep              Where to store the pointer in the buffer where the separator was found, optional.
+ * @param   pThis               The GDB stub context.
+ * @param   paidxRegs           The register indices to write.
+ * @param   cRegs               Number of registers to write.
+ * @param   pvSrc               The new register content.
  */
-static int gdbStubCtxParseHexStringAsInteger(const uint8_t *pbBuf, size_t cbBuf, uint64_t *puVal, uint8_t chSep, const uint8_t **ppbSep)
+static int gdbStubCtxRegsWrite(PGDBSTUBCTXINT pThis, uint32_t *paidxRegs, uint32_t cRegs, void *pvSrc)
 {
-    uint64_t uVal = 0;
+    /* The registers collected in a trace frame can't be modified. */
+    if (pThis->idTraceFrameSel != UINT32_MAX)
+        return GDBSTUB_ERR_NOT_SUPPORTED;
 
-    while (   cbBuf
-           && *pbBuf != chSep)
-    {
-        uVal = uVal * 16 + gdbStubCtxChrToHex(*pbBuf++);
-        cbBuf--;
-    }
+    /* Without a write callback the error is reported right away instead of when the cache gets flushed. */
+    if (   !pThis->pbRegsCache
+        || !pThis->pIf->pfnTgtRegsWrite)
+        return gdbStubCtxIfTgtRegsWrite(pThis, paidxRegs, cRegs, pvSrc);
 
-    *puVal = uVal;
+    /* Writing back happens in gdbStubCtxRegsCacheFlush() before the target resumes. */
+    const uint8_t *pbSrc = (const uint8_t *)pvSrc;
+    for (uint32_t i = 0; i < cRegs; i++)
+    {
+        size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[paidxRegs[i]].cRegBits / 8;
 
-    if (ppbSep)
-        *ppbSep = pbBuf;
+        gdbStubCtxMemcpy(&pThis->pbRegsCache[pThis->paoffRegsCache[paidxRegs[i]]], pbSrc, cbReg);
+        pThis->pafRegsCache[paidxRegs[i]] = GDBSTUBCTX_REGS_CACHE_F_VALID | GDBSTUBCTX_REGS_CACHE_F_DIRTY;
+        pbSrc += cbReg;
+    }
 
     return GDBSTUB_INF_SUCCESS;
 }
 
 
 /**
- * Decodes the given ASCII hexstring as a byte buffer up until the given separator is found or the end of the string is reached.
+ * Invalidates the complete register cache, discarding any modifications not written back.
  *
- * @returns Status code.
- * @param   pbBuf               The buffer containing the hexstring to convert.
- * @param   cbBuf               Size of the buffer in bytes.
- * @param   pvDst               Where to store the decoded data.
- * @param   cbDst               Maximum buffer size in bytes.
- * @param   pcbDecoded          Where to store the number of consumed bytes from the input.
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
  */
-static int gdbStubCtxParseHexStringAsByteBuf(const uint8_t *pbBuf, size_t cbBuf, void *pvDst, size_t cbDst, size_t *pcbDecoded)
+static void gdbStubCtxRegsCacheInvalidate(PGDBSTUBCTXINT pThis)
 {
-    size_t cbDecode = MIN(cbBuf, cbDst * 2);
-
-    /* A single byte is constructed from two hex digits. */
-    if (cbDecode % 2 != 0)
-        return GDBSTUB_ERR_INVALID_PARAMETER;
-
-    if (pcbDecoded)
-        *pcbDecoded = cbDecode;
-
-    uint8_t *pbDst = (uint8_t *)pvDst;
-    while (   cbBuf
-           && cbDst)
-    {
-        uint8_t bByte = (gdbStubCtxChrToHex(*pbBuf) << 4) | gdbStubCtxChrToHex(*(pbBuf + 1));
-        *pbDst++ = bByte;
-        pbBuf += 2;
-        cbBuf -= 2;
-        cbDst--;
-    }
-
-    return GDBSTUB_INF_SUCCESS;
+    if (pThis->pbRegsCache)
+        gdbStubCtxMemset(pThis->pafRegsCache, 0, GDBSTUBCTX_REGS_COUNT(pThis));
 }
 
 
 /**
- * Ensures that there is at least the given amount of bytes of free space left in the packet buffer.
+ * Writes all modified registers in the register cache back to the target in one go.
  *
- * @returns Status code (error when increasing the buffer failed).
+ * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   cbSpace             Number of bytes required.
+ *
+ * @note If writing back fails the error is returned once and the cache is invalidated, dropping the modifications
+ *       so the target can still be resumed afterwards.
  */
-static int gdbStubCtxEnsurePktBufSpace(PGDBSTUBCTXINT pThis, size_t cbSpace)
+static int gdbStubCtxRegsCacheFlush(PGDBSTUBCTXINT pThis)
 {
-    if (pThis->cbPktBufMax - pThis->offPktBuf >= cbSpace)
+    if (!pThis->pbRegsCache)
         return GDBSTUB_INF_SUCCESS;
 
-    /* Slow path allocate new buffer and copy content over. */
     int rc = GDBSTUB_INF_SUCCESS;
-    size_t cbPktBufMaxNew = pThis->cbPktBufMax - pThis->offPktBuf + cbSpace;
-    void *pvNew = gdbStubCtxIfMemAlloc(pThis, cbPktBufMaxNew);
-    if (pvNew)
+    uint32_t idxReg = 0;
+    while (   idxReg < GDBSTUBCTX_REGS_COUNT(pThis)
+           && rc == GDBSTUB_INF_SUCCESS)
     {
-        gdbStubCtxMemcpy(pvNew, pThis->pbPktBuf, pThis->offPktBuf);
-        if (pThis->pbPktBuf)
-            gdbStubCtxIfMemFree(pThis, pThis->pbPktBuf);
-        pThis->pbPktBuf    = (uint8_t *)pvNew;
-        pThis->cbPktBufMax = cbPktBufMaxNew;
+        /* Gather as many dirty registers as fit into the scratch space. */
+        uint8_t *pbRegs = (uint8_t *)pThis->pvRegsScratch;
+        size_t cbBatch = 0;
+        uint32_t cRegsDirty = 0;
+        for (; idxReg < GDBSTUBCTX_REGS_COUNT(pThis); idxReg++)
+        {
+            if (pThis->pafRegsCache[idxReg] & GDBSTUBCTX_REGS_CACHE_F_DIRTY)
+            {
+                size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8;
+
+                if (cbBatch + cbReg > pThis->cbRegsScratch)
+                    break;
+
+                gdbStubCtxMemcpy(&pbRegs[cbBatch], &pThis->pbRegsCache[pThis->paoffRegsCache[idxReg]], cbReg);
+                pThis->paidxRegsCacheBatch[cRegsDirty++] = idxReg;
+                cbBatch += cbReg;
+            }
+        }
+
+        if (cRegsDirty)
+        {
+            rc = gdbStubCtxIfTgtRegsWrite(pThis, pThis->paidxRegsCacheBatch, cRegsDirty, pThis->pvRegsScratch);
+            if (rc == GDBSTUB_INF_SUCCESS)
+            {
+                for (uint32_t i = 0; i < cRegsDirty; i++)
+                    pThis->pafRegsCache[pThis->paidxRegsCacheBatch[i]] &= ~GDBSTUBCTX_REGS_CACHE_F_DIRTY;
+            }
+            else
+                gdbStubCtxRegsCacheInvalidate(pThis);
+        }
     }
-    else
-        rc = GDBSTUB_ERR_NO_MEMORY;
 
     return rc;
 }
 
 
 /**
- * Sends the given reply packet, doing the framing, checksumming, etc. in one call.
+ * Returns the data of the given target memory range from the memory cache, filling the cache line if required.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   pbReplyPkt          The reply packet to send.
- * @param   cbReplyPkt          Size of the reply packet in bytes.
+ * @param   GdbTgtMemAddr       The target memory address to start at.
+ * @param   cb                  Number of bytes requested.
+ * @param   ppbData             Where to store the pointer to the cached data on success.
+ * @param   pcbData             Where to store the number of bytes available through the pointer on success
+ *                              (at most cb, ends at the cache line boundary).
  */
-static int gdbStubCtxReplySend(PGDBSTUBCTXINT pThis, const uint8_t *pbReplyPkt, size_t cbReplyPkt)
+static int gdbStubCtxMemCacheQuery(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, size_t cb,
+                                   const uint8_t **ppbData, size_t *pcbData)
 {
-    int rc = gdbStubCtxReplySendBegin(pThis);
-    if (rc == GDBSTUB_INF_SUCCESS)
+    GDBTGTMEMADDR GdbTgtMemAddrLine = GdbTgtMemAddr & ~((GDBTGTMEMADDR)pThis->cbMemCacheLine - 1);
+    uint32_t idxLine = (uint32_t)((GdbTgtMemAddrLine / pThis->cbMemCacheLine) % pThis->cMemCacheLines);
+    PGDBSTUBMEMCACHELINE pLine = &pThis->paMemCacheLines[idxLine];
+    uint8_t *pbLine = &pThis->pbMemCache[idxLine * pThis->cbMemCacheLine];
+
+    if (   !pLine->fValid
+        || pLine->GdbTgtMemAddr != GdbTgtMemAddrLine)
     {
-        rc = gdbStubCtxReplySendData(pThis, pbReplyPkt, cbReplyPkt);
-        if (rc == GDBSTUB_INF_SUCCESS)
-            rc = gdbStubCtxReplySendEnd(pThis);
+        pLine->fValid = false;
+
+        int rc = gdbStubCtxIfTgtMemRead(pThis, GdbTgtMemAddrLine, pbLine, pThis->cbMemCacheLine);
+        if (rc != GDBSTUB_INF_SUCCESS)
+            return rc;
+
+        pLine->GdbTgtMemAddr = GdbTgtMemAddrLine;
+        pLine->fValid        = true;
     }
 
-    return rc;
+    size_t offLine = (size_t)(GdbTgtMemAddr - GdbTgtMemAddrLine);
+    *ppbData = &pbLine[offLine];
+    *pcbData = MIN(cb, pThis->cbMemCacheLine - offLine);
+    return GDBSTUB_INF_SUCCESS;
 }
 
 
 /**
- * Sends a 'OK' part of a reply packet only (packet start and end needs to be handled separately).
+ * Invalidates all memory cache lines overlapping with the given target memory range.
  *
- * @returns Status code.
+ * @returns nothing.
  * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       The target memory address to start at.
+ * @param   cb                  Size of the range in bytes.
  */
-static int gdbStubCtxReplySendOkData(PGDBSTUBCTXINT pThis)
+static void gdbStubCtxMemCacheInvalidateRange(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, size_t cb)
 {
-    char achOk[2] = { 'O', 'K' };
-    return gdbStubCtxReplySendData(pThis, &achOk[0], sizeof(achOk));
+    if (!pThis->paMemCacheLines)
+        return;
+
+    GDBTGTMEMADDR GdbTgtMemAddrLine = GdbTgtMemAddr & ~((GDBTGTMEMADDR)pThis->cbMemCacheLine - 1);
+    size_t cLines = (size_t)((GdbTgtMemAddr + cb - GdbTgtMemAddrLine + pThis->cbMemCacheLine - 1) / pThis->cbMemCacheLine);
+
+    for (size_t i = 0; i < MIN(cLines, pThis->cMemCacheLines); i++)
+    {
+        uint32_t idxLine = (uint32_t)((GdbTgtMemAddrLine / pThis->cbMemCacheLine) % pThis->cMemCacheLines);
+        PGDBSTUBMEMCACHELINE pLine = &pThis->paMemCacheLines[idxLine];
+
+        /* If the range covers more lines than the cache has every line gets checked anyway. */
+        if (   pLine->fValid
+            && (   cLines > pThis->cMemCacheLines
+                || pLine->GdbTgtMemAddr == GdbTgtMemAddrLine))
+            pLine->fValid = false;
+
+        GdbTgtMemAddrLine += pThis->cbMemCacheLine;
+    }
 }
 
 
 /**
- * Sends a 'OK' reply packet.
+ * Invalidates everything cached about the target state.
  *
- * @returns Status code.
+ * @returns nothing.
  * @param   pThis               The GDB stub context.
  */
-static int gdbStubCtxReplySendOk(PGDBSTUBCTXINT pThis)
+static void gdbStubCtxCachesInvalidate(PGDBSTUBCTXINT pThis)
 {
-    char achOk[2] = { 'O', 'K' };
-    return gdbStubCtxReplySend(pThis, &achOk[0], sizeof(achOk));
+    gdbStubCtxRegsCacheInvalidate(pThis);
+
+    for (uint32_t i = 0; i < pThis->cMemCacheLines; i++)
+        pThis->paMemCacheLines[i].fValid = false;
 }
 
 
 /**
- * Sends a 'E NN' part of a reply packet only (packet start and end needs to be handled separately).
+ * Resumes the target after writing back all modified registers.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   uErr                The error code to send.
+ * @param   fStep               Flag whether to single step the target instead of letting it run.
  */
-static int gdbStubCtxReplySendErrData(PGDBSTUBCTXINT pThis, uint8_t uErr)
+static int gdbStubCtxTgtResume(PGDBSTUBCTXINT pThis, bool fStep)
 {
-    char achErr[3] = { 'E', 0, 0 };
-    achErr[1] = gdbStubCtxHexToChr(uErr >> 4);
-    achErr[2] = gdbStubCtxHexToChr(uErr & 0xf);
-    return gdbStubCtxReplySendData(pThis, &achErr[0], sizeof(achErr));
+    int rc = gdbStubCtxRegsCacheFlush(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        /* Whatever is cached is stale as soon as the target executes code. */
+        gdbStubCtxCachesInvalidate(pThis);
+        if (fStep)
+            rc = gdbStubCtxIfTgtStep(pThis);
+        else
+            rc = gdbStubCtxIfTgtContinue(pThis);
+    }
+
+    return rc;
 }
 
 
 /**
- * Sends a 'E NN' reply packet.
+ * Selects the thread the register and memory accesses operate on, writing back the modified registers
+ * of the previously selected thread.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   uErr                The error code to send.
+ * @param   idThrd              The thread to select, GDBTGTTHRDID_ANY and GDBTGTTHRDID_ALL keep the current thread
+ *                              (or select the first one if nothing was selected so far).
  */
-static int gdbStubCtxReplySendErr(PGDBSTUBCTXINT pThis, uint8_t uErr)
+static int gdbStubCtxThrdSelect(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd)
 {
-    char achErr[3] = { 'E', 0, 0 };
-    achErr[1] = gdbStubCtxHexToChr(uErr >> 4);
-    achErr[2] = gdbStubCtxHexToChr(uErr & 0xf);
-    return gdbStubCtxReplySend(pThis, &achErr[0], sizeof(achErr));
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    if (   idThrd == GDBTGTTHRDID_ANY
+        || idThrd == GDBTGTTHRDID_ALL)
+    {
+        if (pThis->idThrdGen != GDBTGTTHRDID_ANY)
+            return GDBSTUB_INF_SUCCESS;
+
+        uint32_t cThrds = 0;
+        rc = gdbStubCtxIfTgtThrdsQuery(pThis, 0 /*idxStart*/, &idThrd, 1, &cThrds);
+        if (   rc == GDBSTUB_INF_SUCCESS
+            && !cThrds)
+            rc = GDBSTUB_ERR_NOT_FOUND;
+    }
+
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && idThrd != pThis->idThrdGen)
+    {
+        /* The register cache belongs to the previously selected thread. */
+        rc = gdbStubCtxRegsCacheFlush(pThis);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            gdbStubCtxRegsCacheInvalidate(pThis);
+            rc = gdbStubCtxIfTgtThrdSelect(pThis, idThrd);
+            if (rc == GDBSTUB_INF_SUCCESS)
+                pThis->idThrdGen = idThrd;
+        }
+    }
+
+    return rc;
 }
 
 
 /**
- * Sends a signal trap (S 05) packet to indicate that the target has stopped.
+ * Queues an event for the thread running the stub, safe to call from any number of threads concurrently.
  *
  * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if all slots are occupied.
  * @param   pThis               The GDB stub context.
+ * @param   enmType             The event type.
+ * @param   idThrd              The thread which stopped for GDBSTUBCTXEVTTYPE_STOP.
+ * @param   enmReason           The reason the thread stopped for GDBSTUBCTXEVTTYPE_STOP.
+ * @param   pbOutput            The output for GDBSTUBCTXEVTTYPE_OUTPUT.
+ * @param   cbOutput            Number of output bytes, at most GDBSTUBCTX_EVT_OUTPUT_MAX.
+ *
+ * @note The slot at a given position is free for the producers while its sequence number equals the position,
+ *       a producer claims it by advancing the enqueue position and publishes the event by setting the sequence
+ *       number to the position plus one. The consumer hands the slot back for the next round by setting the
+ *       sequence number to the position plus the number of slots, so neither side ever blocks the other.
  */
-static int gdbStubCtxReplySendSigTrap(PGDBSTUBCTXINT pThis)
+static int gdbStubCtxEvtEnqueue(PGDBSTUBCTXINT pThis, GDBSTUBCTXEVTTYPE enmType, GDBTGTTHRDID idThrd,
+                                GDBSTUBSTOPREASON enmReason, const uint8_t *pbOutput, size_t cbOutput)
 {
-    uint8_t achSigTrap[3] = { 'S', '0', '5' };
-    return gdbStubCtxReplySend(pThis, &achSigTrap[0], sizeof(achSigTrap));
+    uint32_t uPos = atomic_load_explicit(&pThis->uEvtPosEnq, memory_order_relaxed);
+
+    for (;;)
+    {
+        PGDBSTUBCTXEVT pEvt = &pThis->aEvts[uPos & (GDBSTUBCTX_EVTS_MAX - 1)];
+        uint32_t uSeq = atomic_load_explicit(&pEvt->uSeq, memory_order_acquire);
+        int32_t iDiff = (int32_t)(uSeq - uPos);
+
+        if (!iDiff)
+        {
+            if (atomic_compare_exchange_weak_explicit(&pThis->uEvtPosEnq, &uPos, uPos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                pEvt->enmType   = enmType;
+                pEvt->idThrd    = idThrd;
+                pEvt->enmReason = enmReason;
+                pEvt->cbOutput  = (uint32_t)cbOutput;
+                if (cbOutput)
+                    gdbStubCtxMemcpy(&pEvt->abOutput[0], pbOutput, cbOutput);
+
+                atomic_store_explicit(&pEvt->uSeq, uPos + 1, memory_order_release);
+                return GDBSTUB_INF_SUCCESS;
+            }
+            /* The failed exchange loaded the current position. */
+        }
+        else if (iDiff < 0) /* The slot still holds an event from the previous round, the queue is full. */
+            return GDBSTUB_ERR_BUFFER_OVERFLOW;
+        else /* Another producer claimed the slot already. */
+            uPos = atomic_load_explicit(&pThis->uEvtPosEnq, memory_order_relaxed);
+    }
 }
 
 
 /**
- * Sends a GDB stub status code indicating an error using the error reply packet,
- * data part only, packet start and and end needs to be handled separately.
+ * Appends a stop to the stops waiting to be reported, only called from the thread running the stub.
  *
- * @returns Status code.
+ * @returns Flag whether the stop was appended, false if too many stops are waiting already.
  * @param   pThis               The GDB stub context.
- * @param   rc                  The status code to send.
+ * @param   idThrd              The thread which stopped.
+ * @param   enmReason           The reason the thread stopped.
  */
-static int gdbStubCtxReplySendErrStsData(PGDBSTUBCTXINT pThis, int rc)
+static bool gdbStubCtxStopEvtPush(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd, GDBSTUBSTOPREASON enmReason)
 {
-    /** Todo convert error codes maybe. */
-    return gdbStubCtxReplySendErrData(pThis, (-rc) & 0xff);
+    if (pThis->cStopEvts == ELEMENTS(pThis->aStopEvts))
+        return false;
+
+    PGDBSTUBCTXSTOPEVT pStopEvt = &pThis->aStopEvts[(pThis->idxStopEvtFirst + pThis->cStopEvts) % ELEMENTS(pThis->aStopEvts)];
+    pStopEvt->idThrd    = idThrd;
+    pStopEvt->enmReason = enmReason;
+    pThis->cStopEvts++;
+    return true;
 }
 
 
 /**
- * Sends a GDB stub status code indicating an error using the error reply packet.
+ * Takes all events queued by other threads out of the queue, only called from the thread running the stub.
  *
- * @returns Status code.
+ * @returns nothing.
  * @param   pThis               The GDB stub context.
- * @param   rc                  The status code to send.
+ *
+ * @note Stops stay queued in order if too many are waiting to be reported already, console output not fitting
+ *       into the buffer is dropped so it can't hold up any stops.
  */
-static int gdbStubCtxReplySendErrSts(PGDBSTUBCTXINT pThis, int rc)
+static void gdbStubCtxEvtQueueDrain(PGDBSTUBCTXINT pThis)
 {
-    /** Todo convert error codes maybe. */
-    return gdbStubCtxReplySendErr(pThis, (-rc) & 0xff);
+    for (;;)
+    {
+        uint32_t uPos = pThis->uEvtPosDeq;
+        PGDBSTUBCTXEVT pEvt = &pThis->aEvts[uPos & (GDBSTUBCTX_EVTS_MAX - 1)];
+
+        /* Empty or the producer claiming the slot didn't publish the event yet. */
+        if (atomic_load_explicit(&pEvt->uSeq, memory_order_acquire) != uPos + 1)
+            break;
+
+        if (pEvt->enmType == GDBSTUBCTXEVTTYPE_STOP)
+        {
+            if (!gdbStubCtxStopEvtPush(pThis, pEvt->idThrd, pEvt->enmReason))
+                break;
+        }
+        else if (pEvt->enmType == GDBSTUBCTXEVTTYPE_OUTPUT)
+        {
+            if (pEvt->cbOutput <= sizeof(pThis->abConsOut) - pThis->cbConsOut)
+            {
+                gdbStubCtxMemcpy(&pThis->abConsOut[pThis->cbConsOut], &pEvt->abOutput[0], pEvt->cbOutput);
+                pThis->cbConsOut += pEvt->cbOutput;
+            }
+        }
+
+        atomic_store_explicit(&pEvt->uSeq, uPos + GDBSTUBCTX_EVTS_MAX, memory_order_release);
+        pThis->uEvtPosDeq = uPos + 1;
+    }
 }
 
 
 /**
- * Parses the arguments of a 'Z' and 'z' packet.
+ * Returns whether a stop of the given thread is waiting to be reported, only called from the thread running the stub.
  *
- * @returns Status code.
- * @param   pbArgs                  Pointer to the start of the first argument.
- * @param   cbArgs                  Number of argument bytes.
- * @param   penmTpType              Where to store the tracepoint type on success.
- * @param   pGdbTgtAddr             Where to store the address on success.
- * @param   puKind                  Where to store the kind argument on success.
+ * @returns Flag whether a stop of the thread is waiting.
+ * @param   pThis               The GDB stub context.
+ * @param   idThrd              The thread to look for.
  */
-static int gdbStubCtxParseTpPktArgs(const uint8_t *pbArgs, size_t cbArgs, GDBSTUBTPTYPE *penmTpType, GDBTGTMEMADDR *pGdbTgtAddr, uint64_t *puKind)
+static bool gdbStubCtxStopEvtIsPending(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd)
 {
-    const uint8_t *pbPktSep = NULL;
-    uint64_t uType = 0;
-
-    int rc = gdbStubCtxParseHexStringAsInteger(pbArgs, cbArgs, &uType,
-                                               ',', &pbPktSep);
-    if (rc == GDBSTUB_INF_SUCCESS)
+    for (uint32_t i = 0; i < pThis->cStopEvts; i++)
     {
-        cbArgs -= (uintptr_t)(pbPktSep - pbArgs) - 1;
-        rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, cbArgs, pGdbTgtAddr,
-                                               ',', &pbPktSep);
-        if (rc == GDBSTUB_INF_SUCCESS)
-        {
-            cbArgs -= (uintptr_t)(pbPktSep - pbArgs) - 1;
-            rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, cbArgs, puKind,
-                                                   GDBSTUB_PKT_END, NULL);
-            if (rc == GDBSTUB_INF_SUCCESS)
-            {
-                switch (uType)
-                {
-                    case 0:
-                        *penmTpType = GDBSTUBTPTYPE_EXEC_SW;
-                        break;
-                    case 1:
-                        *penmTpType = GDBSTUBTPTYPE_EXEC_HW;
-                        break;
-                    case 2:
-                        *penmTpType = GDBSTUBTPTYPE_MEM_WRITE;
-                        break;
-                    case 3:
-                        *penmTpType = GDBSTUBTPTYPE_MEM_READ;
-                        break;
-                    case 4:
-                        *penmTpType = GDBSTUBTPTYPE_MEM_ACCESS;
-                        break;
-                    default:
-                        rc = GDBSTUB_ERR_INVALID_PARAMETER;
-                        break;
-                }
-            }
-        }
+        if (pThis->aStopEvts[(pThis->idxStopEvtFirst + i) % ELEMENTS(pThis->aStopEvts)].idThrd == idThrd)
+            return true;
     }
 
-    return rc;
+    return false;
 }
 
 
 /**
- * Processes the 'TStatus' query.
+ * Dequeues the next stop to report in the order they were notified, only called from the thread running the stub.
  *
- * @returns Status code.
+ * @returns Flag whether a stop was dequeued.
  * @param   pThis               The GDB stub context.
- * @param   pbArgs              Pointer to the start of the arguments in the packet.
- * @param   cbArgs              Size of arguments in bytes.
+ * @param   pidThrd             Where to store the thread which stopped.
+ * @param   penmReason          Where to store the reason the thread stopped.
  */
-static int gdbStubCtxPktProcessQueryTStatus(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+static bool gdbStubCtxStopEvtDequeue(PGDBSTUBCTXINT pThis, GDBTGTTHRDID *pidThrd, GDBSTUBSTOPREASON *penmReason)
 {
-    char achReply[2] = { 'T', '0' };
-    return gdbStubCtxReplySend(pThis, &achReply[0], sizeof(achReply));
+    gdbStubCtxEvtQueueDrain(pThis);
+    if (!pThis->cStopEvts)
+        return false;
+
+    PGDBSTUBCTXSTOPEVT pStopEvt = &pThis->aStopEvts[pThis->idxStopEvtFirst];
+    *pidThrd    = pStopEvt->idThrd;
+    *penmReason = pStopEvt->enmReason;
+    pThis->idxStopEvtFirst = (pThis->idxStopEvtFirst + 1) % ELEMENTS(pThis->aStopEvts);
+    pThis->cStopEvts--;
+    return true;
 }
 
 
 /**
- * @copydoc{FNGDBSTUBQPKTPROC}
+ * Returns the signal number to report for the given stop reason.
+ *
+ * @returns Signal number.
+ * @param   enmReason           The reason the target stopped.
  */
-static int gdbStubCtxPktProcessFeatXmlRegs(PGDBSTUBCTXINT pThis, const uint8_t *pbVal, size_t cbVal)
+static uint8_t gdbStubCtxStopReasonToSignal(GDBSTUBSTOPREASON enmReason)
 {
-    /*
-     * xmlRegisters contain a list of supported architectures delimited by ','.
-     * Check that the architecture is in the supported list.
-     */
-    int rc = GDBSTUB_INF_SUCCESS;
-    while (cbVal)
+    switch (enmReason)
     {
-        /* Find the next delimiter. */
-        size_t cbThisVal = cbVal;
-        const uint8_t *pbDelim = gdbStubCtxMemchr(pbVal, ',', cbVal);
-        if (pbDelim)
-            cbThisVal = pbDelim - pbVal;
-
-        size_t cchArch = gdbStubStrlen(s_aGdbArchMapping[pThis->pIf->enmArch]);
-        if (!gdbStubMemcmp(pbVal, s_aGdbArchMapping[pThis->pIf->enmArch], MIN(cbVal, cchArch)))
-        {
-            /* Set the flag to support the qXfer:features:read packet. */
-            pThis->fFeatures |= GDBSTUBCTX_FEATURES_F_TGT_DESC;
+        case GDBSTUBSTOPREASON_INTERRUPT:
+            return 2; /*SIGINT*/
+        case GDBSTUBSTOPREASON_STOP_REQUEST:
+            return 0;
+        default:
             break;
-        }
-
-        cbVal -= cbThisVal + (pbDelim ? 1 : 0);
-        pbVal = pbDelim + (pbDelim ? 1 : 0);
     }
 
-    return rc;
+    return 5; /*SIGTRAP*/
 }
 
 
 /**
- * Features which can be reported by the remote GDB which we might support.
+ * Returns the checksum over the given data.
  *
- * @note The sorting matters for features which start the same, the longest must come first.
+ * @returns Updated checksum.
+ * @param   uChkSum             The checksum to start with.
+ * @param   pbData              The data to sum up.
+ * @param   cbData              Size of the data in bytes.
  */
-static const GDBSTUBFEATDESC g_aGdbFeatures[] =
+static uint8_t gdbStubCtxChkSumUpdate(uint8_t uChkSum, const uint8_t *pbData, size_t cbData)
 {
-#define GDBSTUBFEATDESC_INIT(a_Name, a_pfnHnd, a_fVal) { a_Name, sizeof(a_Name) - 1, a_pfnHnd, a_fVal }
-    GDBSTUBFEATDESC_INIT("xmlRegisters",   gdbStubCtxPktProcessFeatXmlRegs, true),
-#undef GDBSTUBFEATDESC_INIT
-};
+#if defined(GDBSTUB_SIMD_SSE2)
+    /* The sum of absolute differences against zero gives the byte sum of each half, only the low 8 bits are of interest. */
+    __m128i Sum = _mm_setzero_si128();
+    for (; cbData >= 16; cbData -= 16, pbData += 16)
+        Sum = _mm_add_epi64(Sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)pbData), _mm_setzero_si128()));
+    uChkSum += (uint8_t)(_mm_cvtsi128_si32(Sum) + _mm_cvtsi128_si32(_mm_srli_si128(Sum, 8)));
+#elif defined(GDBSTUB_SIMD_NEON)
+    for (; cbData >= 16; cbData -= 16, pbData += 16)
+        uChkSum += vaddvq_u8(vld1q_u8(pbData)); /* Wraps around like the checksum does. */
+#endif
+
+    while (cbData--)
+        uChkSum += *pbData++;
+
+    return uChkSum;
+}
 
 
 /**
- * Calculates the feature length of the next feature pointed to by the given arguments buffer.
+ * Searches for the packet start character or an out of band interrupt, whichever comes first.
  *
- * @returns Status code.
- * @param   pbArgs              Pointer to the start of the arguments in the packet.
- * @param   cbArgs              Size of arguments in bytes.
- * @param   pcbArg              Where to store the size of the argument in bytes on success (excluding the delimiter).
- * @param   pfTerminator        Whereto store the flag whether the packet terminator (#) was seen as a delimiter.
+ * @returns Offset of the first start or interrupt character, cbData if none was found.
+ * @param   pbData              The data to search in.
+ * @param   cbData              Size of the data in bytes.
  */
-static int gdbStubCtxQueryPktQueryFeatureLen(const uint8_t *pbArgs, size_t cbArgs, size_t *pcbArg, bool *pfTerminator)
+static size_t gdbStubCtxScanStart(const uint8_t *pbData, size_t cbData)
 {
-    const uint8_t *pbArgCur = pbArgs;
+    size_t off = 0;
 
-    while (   cbArgs
-           && *pbArgCur != ';'
-           && *pbArgCur != GDBSTUB_PKT_END)
+#if defined(GDBSTUB_SIMD_SSE2)
+    for (; off + 16 <= cbData; off += 16)
     {
-        cbArgs--;
-        pbArgCur++;
+        __m128i Val = _mm_loadu_si128((const __m128i *)&pbData[off]);
+        __m128i Match = _mm_or_si128(_mm_cmpeq_epi8(Val, _mm_set1_epi8(GDBSTUB_PKT_START)),
+                                     _mm_cmpeq_epi8(Val, _mm_set1_epi8(GDBSTUB_OOB_INTERRUPT)));
+        if (_mm_movemask_epi8(Match))
+            break; /* The scalar loop below finds the exact position. */
     }
+#elif defined(GDBSTUB_SIMD_NEON)
+    for (; off + 16 <= cbData; off += 16)
+    {
+        uint8x16_t Val = vld1q_u8(&pbData[off]);
+        uint8x16_t Match = vorrq_u8(vceqq_u8(Val, vdupq_n_u8(GDBSTUB_PKT_START)),
+                                    vceqq_u8(Val, vdupq_n_u8(GDBSTUB_OOB_INTERRUPT)));
+        if (vmaxvq_u8(Match))
+            break;
+    }
+#endif
 
-    if (   !cbArgs
-        && *pbArgCur != ';'
-        && *pbArgCur != GDBSTUB_PKT_END)
-        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
-
-    *pcbArg       = pbArgCur - pbArgs;
-    *pfTerminator = *pbArgCur == GDBSTUB_PKT_END ? true : false;
+    for (; off < cbData; off++)
+        if (   pbData[off] == GDBSTUB_PKT_START
+            || pbData[off] == GDBSTUB_OOB_INTERRUPT)
+            break;
 
-    return GDBSTUB_INF_SUCCESS;
+    return off;
 }
 
 
 /**
- * Sends the reply to the 'qSupported' packet.
+ * Searches for the packet end character and accumulates the checksum of everything before it in the same pass.
  *
- * @returns Status code.
- * @param   pThis               The GDB stub context.
+ * @returns Offset of the end character, cbData if it wasn't found.
+ * @param   pbData              The data to search in.
+ * @param   cbData              Size of the data in bytes.
+ * @param   puChkSum            The checksum to update with all bytes before the end character.
  */
-static int gdbStubCtxPktProcessQuerySupportedReply(PGDBSTUBCTXINT pThis)
+static size_t gdbStubCtxScanEnd(const uint8_t *pbData, size_t cbData, uint8_t *puChkSum)
 {
-    /** @todo Enhance. */
-    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_TGT_DESC)
-        return gdbStubCtxReplySend(pThis, "qXfer:features:read+", sizeof("qXfer:features:read+") - 1);
+    size_t off = 0;
+    uint8_t uChkSum = *puChkSum;
 
-    return gdbStubCtxReplySend(pThis, NULL, 0);
+#if defined(GDBSTUB_SIMD_SSE2)
+    __m128i Sum = _mm_setzero_si128();
+    for (; off + 16 <= cbData; off += 16)
+    {
+        __m128i Val = _mm_loadu_si128((const __m128i *)&pbData[off]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(Val, _mm_set1_epi8(GDBSTUB_PKT_END))))
+            break; /* The scalar loop below finds the exact position and sums up the remainder. */
+        Sum = _mm_add_epi64(Sum, _mm_sad_epu8(Val, _mm_setzero_si128()));
+    }
+    uChkSum += (uint8_t)(_mm_cvtsi128_si32(Sum) + _mm_cvtsi128_si32(_mm_srli_si128(Sum, 8)));
+#elif defined(GDBSTUB_SIMD_NEON)
+    for (; off + 16 <= cbData; off += 16)
+    {
+        uint8x16_t Val = vld1q_u8(&pbData[off]);
+        if (vmaxvq_u8(vceqq_u8(Val, vdupq_n_u8(GDBSTUB_PKT_END))))
+            break;
+        uChkSum += vaddvq_u8(Val);
+    }
+#endif
+
+    for (; off < cbData; off++)
+    {
+        if (pbData[off] == GDBSTUB_PKT_END)
+            break;
+        uChkSum += pbData[off];
+    }
+
+    *puChkSum = uChkSum;
+    return off;
 }
 
 
 /**
- * Processes the 'Supported' query.
+ * Writes all data queued in the output buffer to the underlying transport layer.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   pbArgs              Pointer to the start of the arguments in the packet.
- * @param   cbArgs              Size of arguments in bytes.
  */
-static int gdbStubCtxPktProcessQuerySupported(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+static int gdbStubCtxOutBufFlush(PGDBSTUBCTXINT pThis)
 {
-    /* Skip the : following the qSupported start. */
-    if (   cbArgs < 1
-        || pbArgs[0] != ':')
-        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
-
-    cbArgs--;
-    pbArgs++;
-
-    /*
-     * Each feature but the last one are separated by ; and the last one is delimited by the # packet end symbol.
-     * We first determine the boundaries of the reported feature and pass it to the appropriate handler.
-     */
     int rc = GDBSTUB_INF_SUCCESS;
-    while (   cbArgs
-           && rc == GDBSTUB_INF_SUCCESS)
-    {
-        bool fTerminator = false;
-        size_t cbArg = 0;
-        rc = gdbStubCtxQueryPktQueryFeatureLen(pbArgs, cbArgs, &cbArg, &fTerminator);
-        if (rc == GDBSTUB_INF_SUCCESS)
-        {
-            /* Search for the feature handler. */
-            for (uint32_t i = 0; i < ELEMENTS(g_aGdbFeatures); i++)
-            {
-                PCGDBSTUBFEATDESC pFeatDesc = &g_aGdbFeatures[i];
-
-                if (   cbArg > pFeatDesc->cchName /* At least one character must come after the feature name ('+', '-' or '='). */
-                    && !gdbStubMemcmp(pFeatDesc->pszName, pbArgs, pFeatDesc->cchName))
-                {
-                    /* Found, execute handler after figuring out whether there is a value attached. */
-                    const uint8_t *pbVal = pbArgs + pFeatDesc->cchName;
-                    size_t cbVal = cbArg - pFeatDesc->cchName;
-
-                    if (pFeatDesc->fVal)
-                    {
-                        if (   *pbVal == '='
-                            && cbVal > 1)
-                        {
-                            pbVal++;
-                            cbVal--;
-                        }
-                        else
-                            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
-                    }
-                    else if (   cbVal != 1
-                             || (   *pbVal != '+'
-                                 && *pbVal != '-')) /* '+' and '-' are allowed to indicate support for a particular feature. */
-                        rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
-
-                    if (rc == GDBSTUB_INF_SUCCESS)
-                        rc = pFeatDesc->pfnHandler(pThis, pbVal, cbVal);
-                    break;
-                }
-            }
 
-            cbArgs -= cbArg;
-            pbArgs += cbArg;
-            if (!fTerminator)
-            {
-                cbArgs--;
-                pbArgs++;
-            }
-            else
-                break;
-        }
+    if (pThis->offOutBuf)
+    {
+        GDBSTUB_STATS_ADD(pThis, cbOut, pThis->offOutBuf);
+        rc = gdbStubCtxIoIfWrite(pThis, pThis->pbOutBuf, pThis->offOutBuf);
+        pThis->offOutBuf = 0;
     }
 
-    /* If everything went alright send the reply with our supported features. */
-    if (rc == GDBSTUB_INF_SUCCESS)
-        rc = gdbStubCtxPktProcessQuerySupportedReply(pThis);
-
     return rc;
 }
 
 
 /**
- * Sends the reply to a 'qXfer:<object>:read:...' request.
+ * Queues the given data in the output buffer, flushing it as it fills up.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   offRead             Where to start reading from within the object.
- * @param   cbRead              How much to read.
- * @param   pbObj               The start of the object.
- * @param   cbObj               Size of the object.
+ * @param   pvData              The data to queue.
+ * @param   cbData              Size of the data in bytes.
  */
-static int gdbStubCtxQueryXferReadReply(PGDBSTUBCTXINT pThis, uint32_t offRead, size_t cbRead, const uint8_t *pbObj, size_t cbObj)
+static int gdbStubCtxOutBufAppend(PGDBSTUBCTXINT pThis, const void *pvData, size_t cbData)
 {
     int rc = GDBSTUB_INF_SUCCESS;
+    const uint8_t *pbData = (const uint8_t *)pvData;
 
-    if (offRead < cbObj)
+    while (   cbData
+           && rc == GDBSTUB_INF_SUCCESS)
     {
-        /** @todo Escaping */
-        size_t cbThisRead = offRead + cbRead < cbObj ? cbRead : cbObj - offRead;
+        size_t cbThisAppend = MIN(cbData, pThis->cbOutBufMax - pThis->offOutBuf);
 
-        rc = gdbStubCtxEnsurePktBufSpace(pThis, cbThisRead + 1);
-        if (rc == GDBSTUB_INF_SUCCESS)
-        {
-            uint8_t *pbPktBuf = pThis->pbPktBuf;
-            *pbPktBuf++ = cbThisRead < cbRead ? 'l' : 'm';
-            gdbStubCtxMemcpy(pbPktBuf, pbObj + offRead, cbThisRead);
-            rc = gdbStubCtxReplySend(pThis, pThis->pbPktBuf, cbThisRead + 1);
-        }
-        else
-            rc = gdbStubCtxReplySendErr(pThis, GDBSTUB_ERR_NO_MEMORY);
+        gdbStubCtxMemcpy(&pThis->pbOutBuf[pThis->offOutBuf], pbData, cbThisAppend);
+        pThis->offOutBuf += cbThisAppend;
+        pbData           += cbThisAppend;
+        cbData           -= cbThisAppend;
+
+        if (pThis->offOutBuf == pThis->cbOutBufMax)
+            rc = gdbStubCtxOutBufFlush(pThis);
     }
-    else if (offRead == cbObj)
-        rc = gdbStubCtxReplySend(pThis, "l", sizeof("l") - 1);
-    else
-        rc = gdbStubCtxReplySendErr(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
 
     return rc;
 }
 
 
 /**
- * Parses the annex:offset,length part of a 'qXfer:<object>:read:...' request.
+ * Starts transmission of a new reply packet.
  *
  * @returns Status code.
- * @param   pbArgs              Start of the arguments beginning with <annex>.
- * @param   cbArgs              Number of bytes remaining for the arguments.
- * @param   ppchAnnex           Where to store the pointer to the beginning of the annex on success.
- * @param   pcchAnnex           Where to store the number of characters for the annex on success.
- * @param   poff                Where to store the offset on success.
- * @param   pcb                 Where to store the length on success.
+ * @param   pThis               The GDB stub context.
  */
-static int gdbStubCtxPktProcessQueryXferParseAnnexOffLen(const uint8_t *pbArgs, size_t cbArgs, const char **ppchAnnex, size_t *pcchAnnex,
-                                                         uint32_t *poffRead, size_t *pcbRead)
+static int gdbStubCtxReplySendBegin(PGDBSTUBCTXINT pThis)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
-    const uint8_t *pbSep = gdbStubCtxMemchr(pbArgs, ':', cbArgs);
-    if (pbSep)
-    {
-        *ppchAnnex = (const char *)pbArgs;
-        *pcchAnnex = pbSep - pbArgs;
+    pThis->uChkSumSend = 0;
 
-        pbSep++;
-        cbArgs -= *pcchAnnex + 1;
+    uint8_t chPktStart = GDBSTUB_PKT_START;
+    return gdbStubCtxOutBufAppend(pThis, &chPktStart, sizeof(chPktStart));
+}
 
-        uint64_t u64Tmp = 0;
-        const uint8_t *pbLenStart = NULL;
-        rc = gdbStubCtxParseHexStringAsInteger(pbSep, cbArgs, &u64Tmp, ',', &pbLenStart);
-        if (   rc == GDBSTUB_INF_SUCCESS
-            && (uint32_t)u64Tmp == u64Tmp)
-        {
-            *poffRead = (uint32_t)u64Tmp;
-            cbArgs -= pbLenStart - pbSep;
 
-            rc = gdbStubCtxParseHexStringAsInteger(pbLenStart + 1, cbArgs, &u64Tmp, '#', &pbLenStart);
-            if (   rc == GDBSTUB_INF_SUCCESS
-                && (size_t)u64Tmp == u64Tmp)
-                *pcbRead = (size_t)u64Tmp;
-            else
-                rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
-        }
-        else
-            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
-    }
-    else
-        rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+/**
+ * Sends the given data in the reply.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbReplyData         The reply data to send.
+ * @param   cbReplyData         Size of the reply data in bytes.
+ */
+static int gdbStubCtxReplySendData(PGDBSTUBCTXINT pThis, const uint8_t *pbReplyData, size_t cbReplyData)
+{
+    pThis->uChkSumSend = gdbStubCtxChkSumUpdate(pThis->uChkSumSend, pbReplyData, cbReplyData);
 
-    return rc;
+    return gdbStubCtxOutBufAppend(pThis, pbReplyData, cbReplyData);
 }
 
 
 /**
- * Creates the target XML description.
+ * Starts transmission of a new notification packet.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
+ * @param   pszName             The notification name.
+ *
+ * @note The notification is finished with gdbStubCtxReplySendEnd() like an ordinary reply.
  */
-static int gdbStubCtxTgtXmlDescCreate(PGDBSTUBCTXINT pThis)
+static int gdbStubCtxNotifySendBegin(PGDBSTUBCTXINT pThis, const char *pszName)
 {
-    static const char s_szXmlTgtHdr[] =
-        "<?xml version=\"1.0\"?>\n"
-        "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
-        "<target version=\"1.0\">\n";
-    static const char s_szXmlTgtFooter[] =
-        "</target>\n";
+    pThis->uChkSumSend = 0;
 
-    /** @todo Redo ASAP, this is crappy as hell. */
-    int rc = GDBSTUB_INF_SUCCESS;
-    size_t cbXmlTgtDesc = sizeof(s_szXmlTgtHdr) + sizeof(s_szXmlTgtFooter);
+    uint8_t chNotifyStart = GDBSTUB_NOTIFY_START;
+    int rc = gdbStubCtxOutBufAppend(pThis, &chNotifyStart, sizeof(chNotifyStart));
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)pszName, gdbStubStrlen(pszName));
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)":", 1);
 
-    /* Add length for architecture. */
-    cbXmlTgtDesc +=   (sizeof("<architecture>") - 1)
-                    + (sizeof("</architecture>\n") - 1)
-                    + gdbStubStrlen(s_aGdbArchMapping[pThis->pIf->enmArch]);
+    return rc;
+}
 
-    /* Add length for the <feature></feature>. */
-    cbXmlTgtDesc +=  (sizeof("<feature name=\"\">\n") - 1)
-                    + (sizeof("</feature>\n") - 1)
-                    + gdbStubStrlen(s_aGdbArchFeatMapping[pThis->pIf->enmArch]);
 
-    /* Add the length for each register. */
-    for (uint32_t i = 0; i < pThis->cRegs; i++)
-    {
-        PCGDBSTUBREG pReg = &pThis->pIf->paRegs[i];
+/**
+ * Returns whether the given byte needs to be escaped when sent as binary data in a reply.
+ *
+ * @returns Flag whether the byte needs to be escaped.
+ * @param   b                   The byte to check.
+ *
+ * @note Besides the framing characters '*' is escaped as well so it can't be mistaken for run-length encoding.
+ */
+static inline bool gdbStubCtxBinaryNeedsEscape(uint8_t b)
+{
+    return    b == GDBSTUB_PKT_START
+           || b == GDBSTUB_PKT_END
+           || b == GDBSTUB_PKT_ESCAPE
+           || b == '*';
+}
 
-        size_t cchRegName = gdbStubStrlen(pReg->pszName);
-        cbXmlTgtDesc +=   (sizeof("<reg name=\"\" bitsize=\"\"/>\n") - 1)
-                        + cchRegName + 2; /* Up to two characters for bitsize for now. */
 
-        if (   pReg->enmType == GDBSTUBREGTYPE_PC
-            || pReg->enmType == GDBSTUBREGTYPE_STACK_PTR
-            || pReg->enmType == GDBSTUBREGTYPE_CODE_PTR)
-        {
-            size_t cchTypeName = pReg->enmType == GDBSTUBREGTYPE_STACK_PTR ? sizeof("data_ptr") - 1 : sizeof("code_ptr") - 1;
-            cbXmlTgtDesc += sizeof(" type=\"\"") + cchTypeName - 1;
-        }
-    }
+/**
+ * Determines how much of the given binary data fits into the given budget after escaping.
+ *
+ * @returns Number of bytes from the given buffer which fit into the budget.
+ * @param   pbData              The binary data to check.
+ * @param   cbData              Size of the binary data in bytes.
+ * @param   cbBudget            Number of bytes available for the escaped data in the reply.
+ * @param   pcbEscaped          Where to store the number of bytes the fitting part occupies after escaping.
+ */
+static size_t gdbStubCtxBinaryEscapedFit(const uint8_t *pbData, size_t cbData, size_t cbBudget, size_t *pcbEscaped)
+{
+    size_t cbEscaped = 0;
+    size_t i = 0;
 
-    pThis->pbTgtXmlDesc = (uint8_t *)gdbStubCtxIfMemAlloc(pThis, cbXmlTgtDesc);
-    if (pThis->pbTgtXmlDesc)
+    for (; i < cbData; i++)
     {
-        uint8_t *pbXmlCur = pThis->pbTgtXmlDesc;
-        pThis->cbTgtXmlDesc = cbXmlTgtDesc;
-
-        gdbStubCtxMemcpy(pbXmlCur, &s_szXmlTgtHdr[0], sizeof(s_szXmlTgtHdr) - 1);
-        pbXmlCur += sizeof(s_szXmlTgtHdr) - 1;
-
-        gdbStubCtxMemcpy(pbXmlCur, "<architecture>", sizeof("<architecture>") - 1);
-        pbXmlCur += sizeof("<architecture>") - 1;
-
-        size_t cch = gdbStubStrlen(s_aGdbArchMapping[pThis->pIf->enmArch]);
-        gdbStubCtxMemcpy(pbXmlCur, s_aGdbArchMapping[pThis->pIf->enmArch], cch);
-        pbXmlCur += cch;
-
-        gdbStubCtxMemcpy(pbXmlCur, "</architecture>\n", sizeof("</architecture>\n") - 1);
-        pbXmlCur += sizeof("</architecture>\n") - 1;
-
-        gdbStubCtxMemcpy(pbXmlCur, "<feature name=\"", sizeof("<feature name=\"") - 1);
-        pbXmlCur += sizeof("<feature name=\"") - 1;
-
-        cch = gdbStubStrlen(s_aGdbArchFeatMapping[pThis->pIf->enmArch]);
-        gdbStubCtxMemcpy(pbXmlCur, s_aGdbArchFeatMapping[pThis->pIf->enmArch], cch);
-        pbXmlCur += cch;
-
-        gdbStubCtxMemcpy(pbXmlCur, "\">\n", sizeof("\">\n") - 1);
-        pbXmlCur += sizeof("\">\n") - 1;
-
-        /* Register */
-        for (uint32_t i = 0; i < pThis->cRegs; i++)
-        {
-            PCGDBSTUBREG pReg = &pThis->pIf->paRegs[i];
-            size_t cchRegName = gdbStubStrlen(pReg->pszName);
-
-            gdbStubCtxMemcpy(pbXmlCur, "<reg name=\"", sizeof("<reg name=\"") - 1);
-            pbXmlCur += sizeof("<reg name=\"") - 1;
-
-            gdbStubCtxMemcpy(pbXmlCur, pReg->pszName, cchRegName);
-            pbXmlCur += cchRegName;
-
-            gdbStubCtxMemcpy(pbXmlCur, "\" bitsize=\"", sizeof("\" bitsize=\"") - 1);
-            pbXmlCur += sizeof("\" bitsize=\"") - 1;
-
-            *pbXmlCur++ = '0' + (pReg->cRegBits / 10);
-            *pbXmlCur++ = '0' + (pReg->cRegBits % 10);
-
-            if (   pReg->enmType == GDBSTUBREGTYPE_PC
-                || pReg->enmType == GDBSTUBREGTYPE_STACK_PTR
-                || pReg->enmType == GDBSTUBREGTYPE_CODE_PTR)
-            {
-                size_t cchTypeName = pReg->enmType == GDBSTUBREGTYPE_STACK_PTR ? sizeof("data_ptr") - 1 : sizeof("code_ptr") - 1;
-                const char *pszTypeName = pReg->enmType == GDBSTUBREGTYPE_STACK_PTR ? "data_ptr" : "code_ptr";
-
-                gdbStubCtxMemcpy(pbXmlCur, "\" type=\"", sizeof("\" type=\"") - 1);
-                pbXmlCur += sizeof("\" type=\"") - 1;
-
-                gdbStubCtxMemcpy(pbXmlCur, pszTypeName, cchTypeName);
-                pbXmlCur += cchTypeName;
-            }
-
-            gdbStubCtxMemcpy(pbXmlCur, "\"/>\n", sizeof("\"/>\n") - 1);
-            pbXmlCur += sizeof("\"/>\n") - 1;
-        }
-
-        gdbStubCtxMemcpy(pbXmlCur, "</feature>\n", sizeof("</feature>\n") - 1);
-        pbXmlCur += sizeof("</feature>\n") - 1;
-
-        gdbStubCtxMemcpy(pbXmlCur, &s_szXmlTgtFooter[0], sizeof(s_szXmlTgtFooter) - 1);
-        pbXmlCur += sizeof(s_szXmlTgtFooter) - 1;
+        size_t cbThis = gdbStubCtxBinaryNeedsEscape(pbData[i]) ? 2 : 1;
+        if (cbEscaped + cbThis > cbBudget)
+            break;
+        cbEscaped += cbThis;
     }
-    else
-        rc = GDBSTUB_ERR_NO_MEMORY;
 
-    return rc;
+    *pcbEscaped = cbEscaped;
+    return i;
 }
 
 
 /**
- * Processes the 'Xfer:features:read' query.
+ * Sends the given binary data in the reply, escaping characters as required.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   pbArgs              Pointer to the start of the arguments in the packet.
- * @param   cbArgs              Size of arguments in bytes.
+ * @param   pbData              The binary data to send.
+ * @param   cbData              Size of the binary data in bytes.
  */
-static int gdbStubCtxPktProcessQueryXferFeatRead(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+static int gdbStubCtxReplySendDataBinary(PGDBSTUBCTXINT pThis, const uint8_t *pbData, size_t cbData)
 {
     int rc = GDBSTUB_INF_SUCCESS;
 
-    /* Skip the : following the Xfer:features:read start. */
-    if (   cbArgs < 1
-        || pbArgs[0] != ':')
-        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
-
-    cbArgs--;
-    pbArgs++;
-
-    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_TGT_DESC)
+    while (   cbData
+           && rc == GDBSTUB_INF_SUCCESS)
     {
-        /* Create the target XML description if not existing. */
-        if (!pThis->pbTgtXmlDesc)
-            rc = gdbStubCtxTgtXmlDescCreate(pThis);
+        /* Make sure there is room for an escaped character. */
+        if (pThis->cbOutBufMax - pThis->offOutBuf < 2)
+        {
+            rc = gdbStubCtxOutBufFlush(pThis);
+            if (rc != GDBSTUB_INF_SUCCESS)
+                break;
+        }
 
-        if (rc == GDBSTUB_INF_SUCCESS)
+        uint8_t *pbDst = &pThis->pbOutBuf[pThis->offOutBuf];
+        uint8_t *pbDstEnd = &pThis->pbOutBuf[pThis->cbOutBufMax - 1];
+        uint8_t uChkSum = pThis->uChkSumSend;
+        while (   cbData
+               && pbDst < pbDstEnd)
         {
-            /* Parse annex, offset and length and return the data. */
-            const char *pchAnnex = NULL;
-            size_t cchAnnex = 0;
-            uint32_t offRead = 0;
-            size_t cbRead = 0;
+            uint8_t b = *pbData++;
 
-            rc = gdbStubCtxPktProcessQueryXferParseAnnexOffLen(pbArgs, cbArgs,
-                                                               &pchAnnex, &cchAnnex,
-                                                               &offRead, &cbRead);
-            if (rc == GDBSTUB_INF_SUCCESS)
+            if (gdbStubCtxBinaryNeedsEscape(b))
             {
-                /* Check whether the annex is supported. */
-                if (   cchAnnex == sizeof("target.xml") - 1
-                    && !gdbStubMemcmp(pchAnnex, "target.xml", cchAnnex))
-                    rc = gdbStubCtxQueryXferReadReply(pThis, offRead, cbRead, pThis->pbTgtXmlDesc, pThis->cbTgtXmlDesc);
-                else
-                    rc = gdbStubCtxReplySendErr(pThis, 0);
+                *pbDst++ = GDBSTUB_PKT_ESCAPE;
+                uChkSum += GDBSTUB_PKT_ESCAPE;
+                b ^= GDBSTUB_PKT_ESCAPE_XOR;
             }
-            else
-                rc = gdbStubCtxReplySendErrSts(pThis, rc);
+
+            *pbDst++ = b;
+            uChkSum += b;
+            cbData--;
         }
-        else
-            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+
+        pThis->uChkSumSend = uChkSum;
+        pThis->offOutBuf   = pbDst - pThis->pbOutBuf;
     }
-    else
-        rc = gdbStubCtxReplySend(pThis, NULL, 0); /* Not supported. */
 
     return rc;
 }
 
 
 /**
- * Calls the given command handler and processes the reply.
+ * Finishes transmission of the current reply by sending the packet end character and the checksum.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   pCmd                The command to call - NULL if using the generic monitor command received callback in the
- *                              interface callback table.
- * @param   pszArgs             Argument string to call the command with.
+ *
+ * @note The reply stays queued in the output buffer until gdbStubCtxOutBufFlush() is called.
  */
-static int gdbStubCtxCmdProcess(PGDBSTUBCTXINT pThis, PCGDBSTUBCMD pCmd, const char *pszArgs)
+static int gdbStubCtxReplySendEnd(PGDBSTUBCTXINT pThis)
 {
-    int rc = gdbStubCtxReplySendBegin(pThis);
-    if (rc == GDBSTUB_INF_SUCCESS)
-    {
-        gdbStubOutCtxReset(&pThis->OutCtx);
-        int rcCmd = GDBSTUB_INF_SUCCESS;
-        if (pCmd)
-            rcCmd = pCmd->pfnCmd(pThis, &pThis->OutCtx.Hlp, pszArgs, pThis->pvUser);
-        else
-            rcCmd = pThis->pIf->pfnMonCmd(pThis, &pThis->OutCtx.Hlp, pszArgs, pThis->pvUser);
-        if (rcCmd == GDBSTUB_INF_SUCCESS)
-        {
-            if (!pThis->OutCtx.offScratch) /* No output, just send OK reply. */
-                rc = gdbStubCtxReplySendOkData(pThis);
-            else
-                rc = gdbStubCtxReplySendData(pThis, &pThis->OutCtx.abScratch[0], pThis->OutCtx.offScratch);
+    uint8_t achPktEnd[3];
 
-            /* Try to finish the reply in case of an error anyway (but we might be completely screwed at this point anyway). */
-            gdbStubCtxReplySendEnd(pThis);
-        }
-        else
-            rc = gdbStubCtxReplySendErrStsData(pThis, rcCmd);
-    }
+    achPktEnd[0] = GDBSTUB_PKT_END;
+    achPktEnd[1] = gdbStubCtxHexToChr(pThis->uChkSumSend >> 4);
+    achPktEnd[2] = gdbStubCtxHexToChr(pThis->uChkSumSend & 0xf);
 
-    return rc;
+    return gdbStubCtxOutBufAppend(pThis, &achPktEnd[0], sizeof(achPktEnd));
 }
 
 
+#if defined(GDBSTUB_SIMD_AVX2)
 /**
- * Processes the 'Rcmd' query.
+ * Encodes 32 bytes as 64 hex characters, AVX2 variant.
  *
- * @returns Status code.
- * @param   pThis               The GDB stub context.
- * @param   pbArgs              Pointer to the start of the arguments in the packet.
- * @param   cbArgs              Size of arguments in bytes.
+ * @returns nothing.
+ * @param   pbDst               Where to store the 64 hex characters.
+ * @param   pbSrc               The 32 bytes to encode.
  */
-static int gdbStubCtxPktProcessQueryRcmd(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+static inline void gdbStubCtxEncodeHex32Avx2(uint8_t *pbDst, const uint8_t *pbSrc)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
+    const __m256i Lut  = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+                                          '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    const __m256i Mask = _mm256_set1_epi8(0x0f);
+    __m256i Val = _mm256_loadu_si256((const __m256i *)pbSrc);
+    __m256i Hi  = _mm256_shuffle_epi8(Lut, _mm256_and_si256(_mm256_srli_epi16(Val, 4), Mask));
+    __m256i Lo  = _mm256_shuffle_epi8(Lut, _mm256_and_si256(Val, Mask));
+
+    /* Interleaving works on 128bit lanes, so the halves need to be put into the right order afterwards. */
+    __m256i Chr0 = _mm256_unpacklo_epi8(Hi, Lo);
+    __m256i Chr1 = _mm256_unpackhi_epi8(Hi, Lo);
+    _mm256_storeu_si256((__m256i *)pbDst,        _mm256_permute2x128_si256(Chr0, Chr1, 0x20));
+    _mm256_storeu_si256((__m256i *)(pbDst + 32), _mm256_permute2x128_si256(Chr0, Chr1, 0x31));
+}
+#endif
 
-    /* Skip the , following the qRcmd start. */
-    if (   cbArgs < 1
-        || pbArgs[0] != ',')
-        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
 
-    if (!pThis->pIf->paCmds)
-        return GDBSTUB_ERR_NOT_FOUND;
+#if defined(GDBSTUB_SIMD_SSSE3)
+/**
+ * Encodes 16 bytes as 32 hex characters, SSSE3 variant.
+ *
+ * @returns nothing.
+ * @param   pbDst               Where to store the 32 hex characters.
+ * @param   pbSrc               The 16 bytes to encode.
+ */
+static inline void gdbStubCtxEncodeHex16Ssse3(uint8_t *pbDst, const uint8_t *pbSrc)
+{
+    const __m128i Lut  = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    const __m128i Mask = _mm_set1_epi8(0x0f);
+    __m128i Val = _mm_loadu_si128((const __m128i *)pbSrc);
+    __m128i Hi  = _mm_shuffle_epi8(Lut, _mm_and_si128(_mm_srli_epi16(Val, 4), Mask));
+    __m128i Lo  = _mm_shuffle_epi8(Lut, _mm_and_si128(Val, Mask));
+
+    _mm_storeu_si128((__m128i *)pbDst,        _mm_unpacklo_epi8(Hi, Lo));
+    _mm_storeu_si128((__m128i *)(pbDst + 16), _mm_unpackhi_epi8(Hi, Lo));
+}
 
-    cbArgs--;
-    pbArgs++;
 
-    /* Decode the command. */
-    /** @todo Make this dynamic. */
-    char szCmd[4096];
-    if (cbArgs / 2 >= sizeof(szCmd))
-        return GDBSTUB_ERR_BUFFER_OVERFLOW;
+/**
+ * Converts 16 hex characters to their 4bit values, SSSE3 variant.
+ *
+ * @returns Flag whether all 16 characters are valid hex digits.
+ * @param   Chr                 The characters to convert.
+ * @param   pVal                Where to store the 4bit values.
+ */
+static inline bool gdbStubCtxChrToHex16Ssse3(__m128i Chr, __m128i *pVal)
+{
+    /* Unsigned compares are done by checking whether the minimum equals the value. */
+    __m128i Dig      = _mm_sub_epi8(Chr, _mm_set1_epi8('0'));
+    __m128i fDig     = _mm_cmpeq_epi8(_mm_min_epu8(Dig, _mm_set1_epi8(9)), Dig);
+    __m128i Alpha    = _mm_sub_epi8(_mm_or_si128(Chr, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i fAlpha   = _mm_cmpeq_epi8(_mm_min_epu8(Alpha, _mm_set1_epi8(5)), Alpha);
+
+    *pVal = _mm_or_si128(_mm_and_si128(fDig, Dig),
+                         _mm_and_si128(fAlpha, _mm_add_epi8(Alpha, _mm_set1_epi8(10))));
+    return _mm_movemask_epi8(_mm_or_si128(fDig, fAlpha)) == 0xffff;
+}
 
-    size_t cbDecoded = 0;
-    rc = gdbStubCtxParseHexStringAsByteBuf(pbArgs, cbArgs - 1, &szCmd[0], sizeof(szCmd), &cbDecoded);
-    if (rc == GDBSTUB_INF_SUCCESS)
-    {
-        const char *pszArgs = NULL;
 
-        cbDecoded /= 2;
-        szCmd[cbDecoded] = '\0'; /* Ensure zero termination. */
+/**
+ * Decodes 32 hex characters into 16 bytes, SSSE3 variant.
+ *
+ * @returns Flag whether all characters are valid hex digits.
+ * @param   pbDst               Where to store the 16 bytes.
+ * @param   pbSrc               The 32 characters to decode.
+ */
+static inline bool gdbStubCtxDecodeHex32Ssse3(uint8_t *pbDst, const uint8_t *pbSrc)
+{
+    __m128i Val0, Val1;
+    bool fValid0 = gdbStubCtxChrToHex16Ssse3(_mm_loadu_si128((const __m128i *)pbSrc), &Val0);
+    bool fValid1 = gdbStubCtxChrToHex16Ssse3(_mm_loadu_si128((const __m128i *)(pbSrc + 16)), &Val1);
+    if (!fValid0 || !fValid1)
+        return false;
+
+    /* Combine the high and low nibble of each pair into a 16bit value and pack them to bytes. */
+    const __m128i Mul = _mm_set1_epi16(0x0110);
+    __m128i Bytes = _mm_packus_epi16(_mm_maddubs_epi16(Val0, Mul), _mm_maddubs_epi16(Val1, Mul));
+    _mm_storeu_si128((__m128i *)pbDst, Bytes);
+    return true;
+}
+#endif
 
-        /** @todo Sanitize string. */
 
-        /* Look for the first space and take that as the separator between command identifier. */
-        uint8_t *pbDelim = gdbStubCtxMemchr(&szCmd[0], ' ', cbDecoded);
-        if (pbDelim)
-        {
-            *pbDelim = '\0';
-            pszArgs = pbDelim + 1;
-        }
+#if defined(GDBSTUB_SIMD_NEON)
+/**
+ * Encodes 16 bytes as 32 hex characters, NEON variant.
+ *
+ * @returns nothing.
+ * @param   pbDst               Where to store the 32 hex characters.
+ * @param   pbSrc               The 16 bytes to encode.
+ */
+static inline void gdbStubCtxEncodeHex16Neon(uint8_t *pbDst, const uint8_t *pbSrc)
+{
+    static const uint8_t s_abLut[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+    uint8x16_t Lut = vld1q_u8(&s_abLut[0]);
+    uint8x16_t Val = vld1q_u8(pbSrc);
+    uint8x16x2_t Chr;
+
+    Chr.val[0] = vqtbl1q_u8(Lut, vshrq_n_u8(Val, 4));
+    Chr.val[1] = vqtbl1q_u8(Lut, vandq_u8(Val, vdupq_n_u8(0x0f)));
+    vst2q_u8(pbDst, Chr); /* Stores the high and low characters interleaved. */
+}
 
-        /* Search for the command. */
-        PCGDBSTUBCMD pCmd = &pThis->pIf->paCmds[0];
-        rc = GDBSTUB_ERR_NOT_FOUND;
-        while (pCmd->pszCmd)
-        {
-            if (!gdbStubStrcmp(pCmd->pszCmd, &szCmd[0]))
-            {
-                rc = gdbStubCtxCmdProcess(pThis, pCmd, pszArgs);
-                break;
-            }
-            pCmd++;
-        }
 
-        if (   rc == GDBSTUB_ERR_NOT_FOUND
-            && pThis->pIf->pfnMonCmd)
-        {
-            /* Restore delimiter. */
-            if (pbDelim)
-                *pbDelim = ' ';
-            rc = gdbStubCtxCmdProcess(pThis, NULL, &szCmd[0]);
-        }
-        else
-            rc = gdbStubCtxReplySendErrSts(pThis, rc); /** @todo Send string. */
-    }
+/**
+ * Converts 16 hex characters to their 4bit values, NEON variant.
+ *
+ * @returns Mask with all bits set for the valid hex digits.
+ * @param   Chr                 The characters to convert.
+ * @param   pVal                Where to store the 4bit values.
+ */
+static inline uint8x16_t gdbStubCtxChrToHex16Neon(uint8x16_t Chr, uint8x16_t *pVal)
+{
+    uint8x16_t Dig    = vsubq_u8(Chr, vdupq_n_u8('0'));
+    uint8x16_t fDig   = vcleq_u8(Dig, vdupq_n_u8(9));
+    uint8x16_t Alpha  = vsubq_u8(vorrq_u8(Chr, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t fAlpha = vcleq_u8(Alpha, vdupq_n_u8(5));
 
-    return rc;
+    *pVal = vbslq_u8(fDig, Dig, vaddq_u8(Alpha, vdupq_n_u8(10)));
+    return vorrq_u8(fDig, fAlpha);
 }
 
 
 /**
- * List of supported query packets.
+ * Decodes 32 hex characters into 16 bytes, NEON variant.
+ *
+ * @returns Flag whether all characters are valid hex digits.
+ * @param   pbDst               Where to store the 16 bytes.
+ * @param   pbSrc               The 32 characters to decode.
  */
-static const GDBSTUBQPKTPROC g_aQPktProcs[] =
+static inline bool gdbStubCtxDecodeHex32Neon(uint8_t *pbDst, const uint8_t *pbSrc)
 {
-#define GDBSTUBQPKTPROC_INIT(a_Name, a_pfnProc) { a_Name, sizeof(a_Name) - 1, a_pfnProc }
-    GDBSTUBQPKTPROC_INIT("TStatus",            gdbStubCtxPktProcessQueryTStatus),
-    GDBSTUBQPKTPROC_INIT("Supported",          gdbStubCtxPktProcessQuerySupported),
-    GDBSTUBQPKTPROC_INIT("Xfer:features:read", gdbStubCtxPktProcessQueryXferFeatRead),
-    GDBSTUBQPKTPROC_INIT("Rcmd",               gdbStubCtxPktProcessQueryRcmd),
-#undef GDBSTUBQPKTPROC_INIT
-};
+    uint8x16x2_t Chr = vld2q_u8(pbSrc); /* Deinterleaves the high and low characters. */
+    uint8x16_t Hi, Lo;
+    uint8x16_t fValid = vandq_u8(gdbStubCtxChrToHex16Neon(Chr.val[0], &Hi),
+                                 gdbStubCtxChrToHex16Neon(Chr.val[1], &Lo));
+    if (vminvq_u8(fValid) != 0xff)
+        return false;
+
+    vst1q_u8(pbDst, vorrq_u8(vshlq_n_u8(Hi, 4), Lo));
+    return true;
+}
+#endif
 
 
 /**
- * Processes a 'q' packet, sending the appropriate reply.
+ * Encodes the given buffer as a hexstring string it into the given destination buffer.
  *
  * @returns Status code.
- * @param   pThis               The GDB stub context.
- * @param   pbQuery             The query packet data (without the 'q').
- * @param   cbQuery             Size of the remaining query packet in bytes.
+ * @param   pbDst               Where store the resulting hex string on success.
+ * @param   cbDst               Size of the destination buffer in bytes.
+ * @param   pvSrc               The data to encode.
+ * @param   cbSrc               Number of bytes to encode.
  */
-static int gdbStubCtxPktProcessQuery(PGDBSTUBCTXINT pThis, const uint8_t *pbQuery, size_t cbQuery)
+static int gdbStubCtxEncodeBinaryAsHex(uint8_t *pbDst, size_t cbDst, const void *pvSrc, size_t cbSrc)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
+    if (cbSrc * 2 > cbDst)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
 
-    /* Search the query and execute the processor or return an empty reply if not supported. */
-    for (uint32_t i = 0; i < ELEMENTS(g_aQPktProcs); i++)
+    const uint8_t *pbSrc = (const uint8_t *)pvSrc;
+#if defined(GDBSTUB_SIMD_AVX2)
+    for (; cbSrc >= 32; cbSrc -= 32, pbSrc += 32, pbDst += 64)
+        gdbStubCtxEncodeHex32Avx2(pbDst, pbSrc);
+#endif
+#if defined(GDBSTUB_SIMD_SSSE3)
+    for (; cbSrc >= 16; cbSrc -= 16, pbSrc += 16, pbDst += 32)
+        gdbStubCtxEncodeHex16Ssse3(pbDst, pbSrc);
+#endif
+#if defined(GDBSTUB_SIMD_NEON)
+    for (; cbSrc >= 16; cbSrc -= 16, pbSrc += 16, pbDst += 32)
+        gdbStubCtxEncodeHex16Neon(pbDst, pbSrc);
+#endif
+
+    /* The scalar variant handles the remainder (and everything if there is no SIMD support). */
+    for (size_t i = 0; i < cbSrc; i++)
     {
-        size_t cbCmp = g_aQPktProcs[i].cchName < cbQuery ? g_aQPktProcs[i].cchName : cbQuery;
+        uint8_t bSrc = *pbSrc++;
 
-        if (!gdbStubMemcmp(pbQuery, g_aQPktProcs[i].pszName, cbCmp))
-            return g_aQPktProcs[i].pfnProc(pThis, pbQuery + cbCmp, cbQuery - cbCmp);
+        *pbDst++ = gdbStubCtxHexToChr(bSrc >> 4);
+        *pbDst++ = gdbStubCtxHexToChr(bSrc & 0xf);
     }
 
-    return gdbStubCtxReplySend(pThis, NULL, 0);
+    return GDBSTUB_INF_SUCCESS;
 }
 
 
 /**
- * Processes a 'vCont[;action[:thread-id]]' packet.
+ * Makes the next chunk of the given target memory range accessible, either by mapping it directly
+ * serving it from the memory cache or by reading it into the given bounce buffer.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   pbArgs              Pointer to the start of the arguments in the packet.
- * @param   cbArgs              Size of arguments in bytes.
+ * @param   GdbTgtMemAddr       The target memory address to start at.
+ * @param   cb                  Number of bytes remaining to be accessed.
+ * @param   pbBounce            The bounce buffer to use if the memory can't be mapped.
+ * @param   cbBounce            Size of the bounce buffer in bytes.
+ * @param   ppbData             Where to store the pointer to the data on success.
+ * @param   pcbData             Where to store the number of bytes accessible through the pointer on success (at most cb).
+ * @param   pcbMapped           Where to store the number of bytes mapped as returned by the target, 0 if the memory
+ *                              is not mapped, pass to gdbStubCtxTgtMemRelease().
  */
-static int gdbStubCtxPktProcessVCont(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+static int gdbStubCtxTgtMemAcquire(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, size_t cb, uint8_t *pbBounce, size_t cbBounce,
+                                   const uint8_t **ppbData, size_t *pcbData, size_t *pcbMapped)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
+    /* Only the memory collected in the selected trace frame is available. */
+    if (pThis->idTraceFrameSel != UINT32_MAX)
+    {
+        *pcbMapped = 0;
+        return gdbStubCtxTraceFrameMemQuery(pThis, GdbTgtMemAddr, cb, ppbData, pcbData);
+    }
 
-    /* Skip the ; following the identifier. */
-    if (   cbArgs < 2
-        || pbArgs[0] != ';')
-        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+    const void *pvMap = NULL;
+    size_t cbMapped = 0;
+    int rc = gdbStubCtxIfTgtMemMap(pThis, GdbTgtMemAddr, cb, &pvMap, &cbMapped);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && cbMapped)
+    {
+        *ppbData   = (const uint8_t *)pvMap;
+        *pcbData   = MIN(cb, cbMapped);
+        *pcbMapped = cbMapped;
+        return GDBSTUB_INF_SUCCESS;
+    }
 
-    pbArgs++;
-    cbArgs--;
+    /* In non-stop mode other threads keep modifying the memory, so the cache can't be used. */
+    *pcbMapped = 0;
+    if (   pThis->paMemCacheLines
+        && !(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+        && gdbStubCtxMemCacheQuery(pThis, GdbTgtMemAddr, cb, ppbData, pcbData) == GDBSTUB_INF_SUCCESS)
+        return GDBSTUB_INF_SUCCESS;
 
-    /** @todo For now we don't care about multiple threads and ignore thread IDs and multiple actions. */
-    switch (pbArgs[0])
+    /*
+     * Fall back to reading the memory, also done if the cache line couldn't be filled as
+     * only a part of it might be accessible.
+     */
+    size_t cbThisRead = MIN(cb, cbBounce);
+    rc = gdbStubCtxIfTgtMemRead(pThis, GdbTgtMemAddr, pbBounce, cbThisRead);
+    if (rc == GDBSTUB_INF_SUCCESS)
     {
-        case 'c':
-        {
-            rc = gdbStubCtxIfTgtContinue(pThis);
-            if (rc == GDBSTUB_INF_SUCCESS)
-                pThis->enmTgtStateLast = GDBSTUBTGTSTATE_RUNNING;
-            break;
-        }
-        case 's':
-        {
-            rc = gdbStubCtxIfTgtStep(pThis);
-            if (rc == GDBSTUB_INF_SUCCESS)
-                rc = gdbStubCtxReplySendSigTrap(pThis);
-            break;
-        }
-        case 't':
-        {
-            rc = gdbStubCtxIfTgtStop(pThis);
-            if (rc == GDBSTUB_INF_SUCCESS)
-                rc = gdbStubCtxReplySendSigTrap(pThis);
-            break;
-        }
-        default:
-            rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+        *ppbData  = pbBounce;
+        *pcbData  = cbThisRead;
     }
 
     return rc;
@@ -2087,445 +3034,5469 @@ static int gdbStubCtxPktProcessVCont(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs
 
 
 /**
- * List of supported 'v<identifier>' packets.
+ * Writes the given data to the target memory, keeping the memory cache coherent.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       The target memory address to write to.
+ * @param   pvSrc               The data to write.
+ * @param   cbWrite             Number of bytes to write.
  */
-static const GDBSTUBVPKTPROC g_aVPktProcs[] =
+static int gdbStubCtxTgtMemWrite(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, void *pvSrc, size_t cbWrite)
 {
-#define GDBSTUBVPKTPROC_INIT(a_Name, a_pszReply, a_pfnProc) { a_Name, sizeof(a_Name) - 1, a_pszReply, sizeof(a_pszReply) - 1, a_pfnProc }
-    GDBSTUBVPKTPROC_INIT("Cont", "vCont;s;c;t", gdbStubCtxPktProcessVCont)
-#undef GDBSTUBVPKTPROC_INIT
-};
+    if (pThis->idTraceFrameSel != UINT32_MAX)
+        return GDBSTUB_ERR_NOT_SUPPORTED;
+
+    /* Invalidate even if the write fails, it might have been done partially. */
+    gdbStubCtxMemCacheInvalidateRange(pThis, GdbTgtMemAddr, cbWrite);
+    return gdbStubCtxIfTgtMemWrite(pThis, GdbTgtMemAddr, pvSrc, cbWrite);
+}
 
 
 /**
- * Processes a 'v<identifier>' packet, sending the appropriate reply.
+ * Releases a chunk of target memory acquired with gdbStubCtxTgtMemAcquire().
  *
- * @returns Status code.
+ * @returns nothing.
  * @param   pThis               The GDB stub context.
- * @param   pbPktRem            The remaining packet data (without the 'v').
- * @param   cbPktRem            Size of the remaining packet in bytes.
+ * @param   pbData              The data pointer returned by gdbStubCtxTgtMemAcquire().
+ * @param   cbMapped            The number of bytes mapped returned by gdbStubCtxTgtMemAcquire().
  */
-static int gdbStubCtxPktProcessV(PGDBSTUBCTXINT pThis, const uint8_t *pbPktRem, size_t cbPktRem)
+static void gdbStubCtxTgtMemRelease(PGDBSTUBCTXINT pThis, const uint8_t *pbData, size_t cbMapped)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
+    if (cbMapped)
+        gdbStubCtxIfTgtMemUnmap(pThis, pbData, cbMapped);
+}
 
-    /* Determine the end of the identifier, delimiters are '?', ';' or end of packet. */
-    bool fQuery = false;
-    const uint8_t *pbDelim = gdbStubCtxMemchr(pbPktRem, '?', cbPktRem);
-    if (!pbDelim)
-        pbDelim = gdbStubCtxMemchr(pbPktRem, ';', cbPktRem);
-    else
-        fQuery = true;
 
-    size_t cchId = 0;
-    if (pbDelim) /* Delimiter found, calculate length. */
-        cchId = pbDelim - pbPktRem;
-    else /* Not found, size goes till end of packet. */
-        cchId = cbPktRem;
+/**
+ * Sends the given binary data hex encoded in the reply, encoding directly into the output buffer.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pvData              The data to send.
+ * @param   cbData              Size of the data in bytes.
+ */
+static int gdbStubCtxReplySendDataHex(PGDBSTUBCTXINT pThis, const void *pvData, size_t cbData)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+    const uint8_t *pbData = (const uint8_t *)pvData;
 
-    /* Search the query and execute the processor or return an empty reply if not supported. */
-    for (uint32_t i = 0; i < ELEMENTS(g_aVPktProcs); i++)
+    while (   cbData
+           && rc == GDBSTUB_INF_SUCCESS)
     {
-        PCGDBSTUBVPKTPROC pVProc = &g_aVPktProcs[i];
-
-        if (   pVProc->cchName == cchId
-            && !gdbStubMemcmp(pbPktRem, pVProc->pszName, cchId))
+        /* Make sure there is room for at least one encoded byte. */
+        if (pThis->cbOutBufMax - pThis->offOutBuf < 2)
         {
-            /* Just send the static reply for a query and execute the processor for everything else. */
-            if (fQuery)
-                return gdbStubCtxReplySend(pThis, pVProc->pszReplyQ, pVProc->cchReplyQ);
+            rc = gdbStubCtxOutBufFlush(pThis);
+            if (rc != GDBSTUB_INF_SUCCESS)
+                break;
+        }
 
-            /* Execute the handler. */
-            return pVProc->pfnProc(pThis, pbPktRem + cchId, cbPktRem - cchId);
+        uint8_t *pbDst = &pThis->pbOutBuf[pThis->offOutBuf];
+        size_t cbThisEncode = MIN(cbData, (pThis->cbOutBufMax - pThis->offOutBuf) / 2);
+
+        rc = gdbStubCtxEncodeBinaryAsHex(pbDst, cbThisEncode * 2, pbData, cbThisEncode);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            pThis->uChkSumSend = gdbStubCtxChkSumUpdate(pThis->uChkSumSend, pbDst, cbThisEncode * 2);
+            pThis->offOutBuf += cbThisEncode * 2;
+            pbData           += cbThisEncode;
+            cbData           -= cbThisEncode;
         }
     }
 
-    return gdbStubCtxReplySend(pThis, NULL, 0);
+    return rc;
 }
 
 
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
 /**
- * Processes a completely received packet.
+ * Finishes the 'O' packet being sent when streaming the output.
  *
- * @returns Status code.
- * @param   pThis               The GDB stub context.
+ * @returns nothing.
+ * @param   pThis      The output context instance.
+ *
+ * @note Every completed packet gets written out right away so the remote end can display the output as it arrives.
  */
-static int gdbStubCtxPktProcess(PGDBSTUBCTXINT pThis)
+static void gdbStubOutCtxPktEnd(PGDBSTUBOUTCTX pThis)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
+    PGDBSTUBCTXINT pGdbStubCtx = pThis->pGdbStubCtx;
 
-    if (pThis->cbPkt >= 1)
+    pThis->cbPktOutput = 0;
+    pThis->rc = gdbStubCtxReplySendEnd(pGdbStubCtx);
+    if (   pThis->rc == GDBSTUB_INF_SUCCESS
+        && !pGdbStubCtx->fFlushManual)
+        pThis->rc = gdbStubCtxOutBufFlush(pGdbStubCtx);
+}
+
+
+/**
+ * Appends the given output to the given output context, hex encoding it directly into the reply.
+ *
+ * @returns nothing.
+ * @param   pThis      The output context instance.
+ * @param   pvOutput   The output to append.
+ * @param   cbOutput   Number of bytes to append.
+ */
+static void gdbStubOutCtxAppend(PGDBSTUBOUTCTX pThis, const void *pvOutput, size_t cbOutput)
+{
+    PGDBSTUBCTXINT pGdbStubCtx = pThis->pGdbStubCtx;
+    const uint8_t *pbOutput = (const uint8_t *)pvOutput;
+
+    pThis->cbOutput += cbOutput;
+    if (!pThis->fStream)
     {
-        switch (pThis->pbPktBuf[1])
+        if (pThis->rc == GDBSTUB_INF_SUCCESS)
+            pThis->rc = gdbStubCtxReplySendDataHex(pGdbStubCtx, pbOutput, cbOutput);
+        return;
+    }
+
+    while (   cbOutput
+           && pThis->rc == GDBSTUB_INF_SUCCESS)
+    {
+        if (!pThis->cbPktOutput)
         {
-            case '!': /* Enabled extended mode. */
-            {
-                if (pThis->pIf->pfnTgtRestart)
-                {
-                    pThis->fExtendedMode = true;
-                    rc = gdbStubCtxReplySendOk(pThis);
-                }
-                else /* Send empty reply to indicate extended mode is unsupported. */
-                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
-                break;
-            }
-            case '?':
-            {
-                /* Return signal state. */
-                rc = gdbStubCtxReplySendSigTrap(pThis);
+            uint8_t chOutput = 'O';
+
+            pThis->rc = gdbStubCtxReplySendBegin(pGdbStubCtx);
+            if (pThis->rc == GDBSTUB_INF_SUCCESS)
+                pThis->rc = gdbStubCtxReplySendData(pGdbStubCtx, &chOutput, sizeof(chOutput));
+            if (pThis->rc != GDBSTUB_INF_SUCCESS)
                 break;
-            }
-            case 's': /* Single step, target stopped immediately again. */
-            {
-                rc = gdbStubCtxIfTgtStep(pThis);
+        }
+
+        size_t cbThisOutput = MIN(cbOutput, pThis->cbPktOutputMax - pThis->cbPktOutput);
+        pThis->rc = gdbStubCtxReplySendDataHex(pGdbStubCtx, pbOutput, cbThisOutput);
+        pThis->cbPktOutput += cbThisOutput;
+        pbOutput           += cbThisOutput;
+        cbOutput           -= cbThisOutput;
+
+        if (   pThis->rc == GDBSTUB_INF_SUCCESS
+            && pThis->cbPktOutput == pThis->cbPktOutputMax)
+            gdbStubOutCtxPktEnd(pThis);
+    }
+}
+
+
+/**
+ * Converts a given unsigned integer into a string and appends it to the given output context.
+ *
+ * @returns nothing.
+ * @param   pThis      The output context instance.
+ * @param   u64        The value to log.
+ * @param   fHex       Flag whether to convert the value as hex instead of decimal.
+ * @param   cDigits    Minimum number of digits to log, if the number has fewer
+ *                     the gap is prepended with 0.
+ */
+static void gdbStubOutCtxAppendU64(PGDBSTUBOUTCTX pThis, uint64_t u64, bool fHex, uint32_t cDigits)
+{
+    static const char s_achDigits[] = "0123456789abcdef";
+    char achBuf[32];
+    unsigned offBuf = sizeof(achBuf);
+    uint32_t uBase = fHex ? 16 : 10;
+
+    /* The digits are stored backwards from the end, so the result can be appended at once. */
+    while (u64)
+    {
+        achBuf[--offBuf] = s_achDigits[u64 % uBase];
+        u64 /= uBase;
+    }
+
+    /* Prepend 0. */
+    cDigits = MIN(cDigits, sizeof(achBuf));
+    while (sizeof(achBuf) - offBuf < cDigits)
+        achBuf[--offBuf] = '0';
+
+    gdbStubOutCtxAppend(pThis, &achBuf[offBuf], sizeof(achBuf) - offBuf);
+}
+
+
+/**
+ * Converts a given signed 32bit integer into a string and appends it to the given output context.
+ *
+ * @returns nothing.
+ * @param   pThis      The output context instance.
+ * @param   i32        The value to log.
+ * @param   cDigits    Minimum number of digits to log, if the number has fewer
+ *                     the gap is prepended with 0.
+ */
+static void gdbStubOutCtxAppendS32(PGDBSTUBOUTCTX pThis, int32_t i32, uint32_t cDigits)
+{
+    /* Add sign? */
+    if (i32 < 0)
+    {
+        gdbStubOutCtxAppend(pThis, "-", 1);
+        i32 = ABS(i32);
+    }
+
+    /* Treat as unsigned from here on. */
+    gdbStubOutCtxAppendU64(pThis, (uint32_t)i32, false /*fHex*/, cDigits);
+}
+
+
+/**
+ * Appends a given string to the given output context.
+ *
+ * @returns nothing.
+ * @param   pThis      The output context instance.
+ * @param   psz        The string to append.
+ */
+static void gdbStubOutCtxAppendString(PGDBSTUBOUTCTX pThis, const char *psz)
+{
+    if (!psz)
+        psz = "<null>";
+
+    gdbStubOutCtxAppend(pThis, psz, gdbStubStrlen(psz));
+}
+
+
+/**
+ * @copydoc{GDBSTUBOUTHLP,pfnPrintf}
+ */
+static int gdbStubOutCtxPrintf(PCGDBSTUBOUTHLP pHlp, const char *pszFmt, ...)
+{
+    PGDBSTUBOUTCTX pThis = (PGDBSTUBOUTCTX)pHlp;
+    va_list hArgs;
+    va_start(hArgs, pszFmt);
+
+    while (*pszFmt)
+    {
+        char ch = *pszFmt++;
+
+        switch (ch)
+        {
+            case '%':
+            {
+                /* Format specifier. */
+                char chFmt = *pszFmt;
+                pszFmt++;
+
+                if (chFmt == '#')
+                {
+                    gdbStubOutCtxAppendString(pThis, "0x");
+                    chFmt = *pszFmt++;
+                }
+
+                switch (chFmt)
+                {
+                    case '%':
+                    {
+                        gdbStubOutCtxAppend(pThis, "%", 1);
+                        break;
+                    }
+                    case 'u':
+                    {
+                        uint32_t u32 = va_arg(hArgs, uint32_t);
+                        gdbStubOutCtxAppendU64(pThis, u32, false /*fHex*/, 1);
+                        break;
+                    }
+                    case 'U':
+                    {
+                        uint64_t u64 = va_arg(hArgs, uint64_t);
+                        gdbStubOutCtxAppendU64(pThis, u64, false /*fHex*/, 1);
+                        break;
+                    }
+                    case 'd':
+                    {
+                        int32_t i32 = va_arg(hArgs, int32_t);
+                        gdbStubOutCtxAppendS32(pThis, i32, 1);
+                        break;
+                    }
+                    case 's':
+                    {
+                        const char *psz = va_arg(hArgs, const char *);
+                        gdbStubOutCtxAppendString(pThis, psz);
+                        break;
+                    }
+                    case 'x':
+                    {
+                        uint32_t u32 = va_arg(hArgs, uint32_t);
+                        gdbStubOutCtxAppendU64(pThis, u32, true /*fHex*/, 1);
+                        break;
+                    }
+                    case 'X':
+                    {
+                        uint64_t u64 = va_arg(hArgs, uint64_t);
+                        gdbStubOutCtxAppendU64(pThis, u64, true /*fHex*/, 1);
+                        break;
+                    }
+                    case 'p':
+                    {
+                        void *pv = va_arg(hArgs, void *);
+                        gdbStubOutCtxAppendString(pThis, "0x");
+                        gdbStubOutCtxAppendU64(pThis, (uint64_t)(uintptr_t)pv, true /*fHex*/, 0);
+                    }
+                    default:
+                        /** @todo: Ignore or assert? */
+                        ;
+                }
+                break;
+            }
+            default:
+            {
+                /* Append everything up to the next format specifier at once. */
+                const char *pszStart = pszFmt - 1;
+                while (   *pszFmt
+                       && *pszFmt != '%')
+                    pszFmt++;
+
+                gdbStubOutCtxAppend(pThis, pszStart, pszFmt - pszStart);
+            }
+        }
+    }
+
+    va_end(hArgs);
+    return pThis->rc;
+}
+
+
+/**
+ * @copydoc{GDBSTUBOUTHLP,pfnWrite}
+ */
+static int gdbStubOutCtxWrite(PCGDBSTUBOUTHLP pHlp, const void *pvOutput, size_t cbOutput)
+{
+    PGDBSTUBOUTCTX pThis = (PGDBSTUBOUTCTX)pHlp;
+
+    gdbStubOutCtxAppend(pThis, pvOutput, cbOutput);
+    return pThis->rc;
+}
+
+
+/**
+ * Resets the given output context for the next command.
+ *
+ * @returns nothing.
+ * @param   pThis               The output context instance.
+ * @param   fStream             Flag whether to stream the output as 'O' packets.
+ */
+static void gdbStubOutCtxReset(PGDBSTUBOUTCTX pThis, bool fStream)
+{
+    pThis->rc          = GDBSTUB_INF_SUCCESS;
+    pThis->fStream     = fStream;
+    pThis->cbOutput    = 0;
+    pThis->cbPktOutput = 0;
+}
+
+
+/**
+ * Finishes the output of the command, completing the last 'O' packet when streaming.
+ *
+ * @returns Status code of sending the output.
+ * @param   pThis               The output context instance.
+ */
+static int gdbStubOutCtxFinish(PGDBSTUBOUTCTX pThis)
+{
+    if (   pThis->cbPktOutput
+        && pThis->rc == GDBSTUB_INF_SUCCESS)
+        gdbStubOutCtxPktEnd(pThis);
+
+    return pThis->rc;
+}
+
+
+/**
+ * Initializes the given output context.
+ *
+ * @returns nothing.
+ * @param   pThis               The output context instance.
+ * @param   pGdbStubCtx         The GDB stub context.
+ */
+static void gdbStubOutCtxInit(PGDBSTUBOUTCTX pThis, PGDBSTUBCTXINT pGdbStubCtx)
+{
+    pThis->Hlp.pfnPrintf    = gdbStubOutCtxPrintf;
+    pThis->Hlp.pfnWrite     = gdbStubOutCtxWrite;
+    pThis->pGdbStubCtx      = pGdbStubCtx;
+    pThis->cbPktOutputMax   = (pGdbStubCtx->cbPktMax - 1) / 2; /* 'O' and two hex characters per byte. */
+    gdbStubOutCtxReset(pThis, false /*fStream*/);
+}
+#endif /* !GDBSTUB_WITHOUT_MON_CMDS */
+
+
+/**
+ * Decodes the given ASCII hexstring as binary data up until the given separator is found or the end of the string is reached.
+ *
+ * @returns Status code.
+ * @param   pbBuf               The buffer containing the hexstring to convert.
+ * @param   cbBuf               Size of the buffer in bytes.
+ * @param   pvDst               Where to store the decoded data.
+ * @param   cbDst               Maximum buffer sizein bytes.
+ * @param   chSep               The character to stop conversion at.
+ * @param   ppbSep              Where to store the pointer in the buffer where the separator was found, optional.
+ */
+static int gdbStubCtxParseHexStringAsInteger(const uint8_t *pbBuf, size_t cbBuf, uint64_t *puVal, uint8_t chSep, const uint8_t **ppbSep)
+{
+    uint64_t uVal = 0;
+
+    while (   cbBuf
+           && *pbBuf != chSep)
+    {
+        uVal = uVal * 16 + gdbStubCtxChrToHex(*pbBuf++);
+        cbBuf--;
+    }
+
+    *puVal = uVal;
+
+    if (ppbSep)
+        *ppbSep = pbBuf;
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS) || !defined(GDBSTUB_WITHOUT_CRC) || !defined(GDBSTUB_WITHOUT_FLASH)
+/**
+ * Parses a hex number at the given position, stopping at the first character which is not a hex digit.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_PROTOCOL_VIOLATION if there is no hex digit at the given position.
+ * @param   ppbBuf              Pointer to the current position, updated to point after the number on success.
+ * @param   pcbBuf              Pointer to the number of bytes left, updated on success.
+ * @param   puVal               Where to store the value (only the lower 64bits of longer numbers are kept).
+ */
+static int gdbStubCtxParseHexNumber(const uint8_t **ppbBuf, size_t *pcbBuf, uint64_t *puVal)
+{
+    const uint8_t *pbBuf = *ppbBuf;
+    size_t cbBuf = *pcbBuf;
+    uint64_t uVal = 0;
+
+    while (   cbBuf
+           && gdbStubCtxChrToHex(*pbBuf) != 0xff)
+    {
+        uVal = (uVal << 4) | gdbStubCtxChrToHex(*pbBuf++);
+        cbBuf--;
+    }
+
+    if (cbBuf == *pcbBuf)
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    *ppbBuf = pbBuf;
+    *pcbBuf = cbBuf;
+    *puVal  = uVal;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Skips over the given character if it is at the given position.
+ *
+ * @returns Flag whether the character was found.
+ * @param   ppbBuf              Pointer to the current position, updated to point after the character if found.
+ * @param   pcbBuf              Pointer to the number of bytes left, updated if the character was found.
+ * @param   ch                  The character to skip.
+ */
+static bool gdbStubCtxParseChr(const uint8_t **ppbBuf, size_t *pcbBuf, uint8_t ch)
+{
+    if (   !*pcbBuf
+        || **ppbBuf != ch)
+        return false;
+
+    (*ppbBuf)++;
+    (*pcbBuf)--;
+    return true;
+}
+#endif
+
+
+/**
+ * Parses a thread ID.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_PROTOCOL_VIOLATION if there is no valid thread ID at the start of the buffer.
+ * @param   pbBuf               The buffer containing the thread ID.
+ * @param   cbBuf               Size of the buffer in bytes.
+ * @param   pidThrd             Where to store the thread ID, "-1" is returned as GDBTGTTHRDID_ALL.
+ * @param   ppbEnd              Where to store the pointer to the first character after the thread ID.
+ */
+static int gdbStubCtxParseThrdId(const uint8_t *pbBuf, size_t cbBuf, GDBTGTTHRDID *pidThrd, const uint8_t **ppbEnd)
+{
+    if (   cbBuf >= 2
+        && pbBuf[0] == '-'
+        && pbBuf[1] == '1')
+    {
+        *pidThrd = GDBTGTTHRDID_ALL;
+        *ppbEnd  = pbBuf + 2;
+        return GDBSTUB_INF_SUCCESS;
+    }
+
+    uint64_t uVal = 0;
+    size_t cch = 0;
+    while (   cch < cbBuf
+           && gdbStubCtxChrToHex(pbBuf[cch]) != 0xff)
+        uVal = uVal * 16 + gdbStubCtxChrToHex(pbBuf[cch++]);
+
+    if (   !cch
+        || uVal >= GDBTGTTHRDID_ALL)
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    *pidThrd = (GDBTGTTHRDID)uVal;
+    *ppbEnd  = pbBuf + cch;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Decodes the given ASCII hexstring as a byte buffer up until the given separator is found or the end of the string is reached.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_PROTOCOL_VIOLATION if the string contains characters which are not hex digits.
+ * @param   pbBuf               The buffer containing the hexstring to convert.
+ * @param   cbBuf               Size of the buffer in bytes.
+ * @param   pvDst               Where to store the decoded data.
+ * @param   cbDst               Maximum buffer size in bytes.
+ * @param   pcbDecoded          Where to store the number of consumed bytes from the input.
+ */
+static int gdbStubCtxParseHexStringAsByteBuf(const uint8_t *pbBuf, size_t cbBuf, void *pvDst, size_t cbDst, size_t *pcbDecoded)
+{
+    size_t cbDecode = MIN(cbBuf, cbDst * 2);
+
+    /* A single byte is constructed from two hex digits. */
+    if (cbDecode % 2 != 0)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    if (pcbDecoded)
+        *pcbDecoded = cbDecode;
+
+    uint8_t *pbDst = (uint8_t *)pvDst;
+    size_t cbLeft = cbDecode / 2;
+#if defined(GDBSTUB_SIMD_SSSE3)
+    for (; cbLeft >= 16; cbLeft -= 16, pbBuf += 32, pbDst += 16)
+        if (!gdbStubCtxDecodeHex32Ssse3(pbDst, pbBuf))
+            return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+#endif
+#if defined(GDBSTUB_SIMD_NEON)
+    for (; cbLeft >= 16; cbLeft -= 16, pbBuf += 32, pbDst += 16)
+        if (!gdbStubCtxDecodeHex32Neon(pbDst, pbBuf))
+            return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+#endif
+
+    /* The scalar variant handles the remainder (and everything if there is no SIMD support). */
+    while (cbLeft)
+    {
+        uint8_t uHi = gdbStubCtxChrToHex(*pbBuf);
+        uint8_t uLo = gdbStubCtxChrToHex(*(pbBuf + 1));
+        if ((uHi | uLo) == 0xff)
+            return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+        *pbDst++ = (uHi << 4) | uLo;
+        pbBuf += 2;
+        cbLeft--;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Decodes the given binary data containing escaped characters in place.
+ *
+ * @returns Status code.
+ * @param   pbBuf               The buffer containing the escaped binary data, the decoded data is written back to it.
+ * @param   cbBuf               Size of the buffer in bytes.
+ * @param   pcbDecoded          Where to store the number of bytes after decoding.
+ */
+static int gdbStubCtxDecodeBinaryInPlace(uint8_t *pbBuf, size_t cbBuf, size_t *pcbDecoded)
+{
+    /* Nothing needs to be moved up until the first escape character. */
+    uint8_t *pbSrc = (uint8_t *)gdbStubCtxMemchr(pbBuf, GDBSTUB_PKT_ESCAPE, cbBuf);
+    if (!pbSrc)
+    {
+        *pcbDecoded = cbBuf;
+        return GDBSTUB_INF_SUCCESS;
+    }
+
+    uint8_t *pbSrcEnd = pbBuf + cbBuf;
+    uint8_t *pbDst = pbSrc;
+    while (pbSrc < pbSrcEnd)
+    {
+        if (*pbSrc == GDBSTUB_PKT_ESCAPE)
+        {
+            /* The escape character must be followed by the escaped character. */
+            if (pbSrc + 1 == pbSrcEnd)
+                return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+            *pbDst++ = pbSrc[1] ^ GDBSTUB_PKT_ESCAPE_XOR;
+            pbSrc += 2;
+        }
+        else
+            *pbDst++ = *pbSrc++;
+    }
+
+    *pcbDecoded = pbDst - pbBuf;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Sends the given reply packet, doing the framing, checksumming, etc. in one call.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbReplyPkt          The reply packet to send.
+ * @param   cbReplyPkt          Size of the reply packet in bytes.
+ */
+static int gdbStubCtxReplySend(PGDBSTUBCTXINT pThis, const uint8_t *pbReplyPkt, size_t cbReplyPkt)
+{
+    int rc = gdbStubCtxReplySendBegin(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        rc = gdbStubCtxReplySendData(pThis, pbReplyPkt, cbReplyPkt);
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = gdbStubCtxReplySendEnd(pThis);
+    }
+
+    return rc;
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
+/**
+ * Sends a 'OK' part of a reply packet only (packet start and end needs to be handled separately).
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxReplySendOkData(PGDBSTUBCTXINT pThis)
+{
+    char achOk[2] = { 'O', 'K' };
+    return gdbStubCtxReplySendData(pThis, &achOk[0], sizeof(achOk));
+}
+#endif /* !GDBSTUB_WITHOUT_MON_CMDS */
+
+
+/**
+ * Sends a 'OK' reply packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxReplySendOk(PGDBSTUBCTXINT pThis)
+{
+    char achOk[2] = { 'O', 'K' };
+    return gdbStubCtxReplySend(pThis, &achOk[0], sizeof(achOk));
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
+/**
+ * Sends a 'E NN' part of a reply packet only (packet start and end needs to be handled separately).
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   uErr                The error code to send.
+ */
+static int gdbStubCtxReplySendErrData(PGDBSTUBCTXINT pThis, uint8_t uErr)
+{
+    char achErr[3] = { 'E', 0, 0 };
+    achErr[1] = gdbStubCtxHexToChr(uErr >> 4);
+    achErr[2] = gdbStubCtxHexToChr(uErr & 0xf);
+    return gdbStubCtxReplySendData(pThis, &achErr[0], sizeof(achErr));
+}
+#endif /* !GDBSTUB_WITHOUT_MON_CMDS */
+
+
+/**
+ * Sends a 'E NN' reply packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   uErr                The error code to send.
+ */
+static int gdbStubCtxReplySendErr(PGDBSTUBCTXINT pThis, uint8_t uErr)
+{
+    char achErr[3] = { 'E', 0, 0 };
+    achErr[1] = gdbStubCtxHexToChr(uErr >> 4);
+    achErr[2] = gdbStubCtxHexToChr(uErr & 0xf);
+    return gdbStubCtxReplySend(pThis, &achErr[0], sizeof(achErr));
+}
+
+
+/**
+ * Sends a stop reply (T <signal>) packet to indicate that the target has stopped, including
+ * the expedited registers so the remote end doesn't have to query them.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   uSignal             The signal number to report.
+ * @param   idThrd              The thread which stopped, GDBTGTTHRDID_ANY for the currently selected one.
+ * @param   fNotify             Flag whether to send the stop as a '%Stop' notification instead of a reply.
+ *
+ * @note If reading the expedited registers fails the stop is reported without them.
+ */
+static int gdbStubCtxReplySendStop(PGDBSTUBCTXINT pThis, uint8_t uSignal, GDBTGTTHRDID idThrd, bool fNotify)
+{
+    uint8_t achSigTrap[3] = { 'T', gdbStubCtxHexToChr(uSignal >> 4), gdbStubCtxHexToChr(uSignal & 0xf) };
+    uint8_t *pbRegs = (uint8_t *)pThis->pvRegsScratch;
+    GDBTGTTHRDID idThrdPrev = pThis->idThrdGen;
+    bool fThrd = false;
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /*
+     * The expedited registers are read from the stopped thread which becomes the selected one in all-stop mode,
+     * in non-stop mode the selection must not change behind the back of the remote end.
+     */
+    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS)
+    {
+        fThrd = gdbStubCtxThrdSelect(pThis, idThrd) == GDBSTUB_INF_SUCCESS;
+        idThrd = pThis->idThrdGen;
+    }
+
+    bool fRegs =    (   fThrd
+                     || !(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+                 && pThis->cRegsExpedite
+                 && gdbStubCtxRegsRead(pThis, pThis->paidxRegsExpedite, pThis->cRegsExpedite, pbRegs) == GDBSTUB_INF_SUCCESS;
+
+    if (   fThrd
+        && (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+        && idThrdPrev != GDBTGTTHRDID_ANY)
+        gdbStubCtxThrdSelect(pThis, idThrdPrev);
+
+    if (fNotify)
+        rc = gdbStubCtxNotifySendBegin(pThis, "Stop");
+    else
+        rc = gdbStubCtxReplySendBegin(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendData(pThis, &achSigTrap[0], sizeof(achSigTrap));
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && fThrd)
+    {
+        char achThrd[sizeof("thread:") + 16] = "thread:";
+        size_t cchThrd = sizeof("thread:") - 1;
+
+        cchThrd += gdbStubCtxFmtHexU64(&achThrd[cchThrd], idThrd);
+        achThrd[cchThrd++] = ';';
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)&achThrd[0], cchThrd);
+    }
+
+    for (uint32_t i = 0; i < pThis->cRegsExpedite && fRegs && rc == GDBSTUB_INF_SUCCESS; i++)
+    {
+        /* Each register is sent as "<register number>:<value>;". */
+        uint32_t idxReg = pThis->paidxRegsExpedite[i];
+        size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8;
+        char achReg[17];
+        size_t cchReg = gdbStubCtxFmtHexU64(&achReg[0], idxReg);
+
+        achReg[cchReg++] = ':';
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)&achReg[0], cchReg);
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = gdbStubCtxReplySendDataHex(pThis, pbRegs, cbReg);
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)";", 1);
+
+        pbRegs += cbReg;
+    }
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendEnd(pThis);
+
+    return rc;
+}
+
+
+/**
+ * Sends a signal trap (T 05) packet to indicate that the target has stopped.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxReplySendSigTrap(PGDBSTUBCTXINT pThis)
+{
+    return gdbStubCtxReplySendStop(pThis, 5 /*SIGTRAP*/, GDBTGTTHRDID_ANY, false /*fNotify*/);
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
+/**
+ * Sends a GDB stub status code indicating an error using the error reply packet,
+ * data part only, packet start and and end needs to be handled separately.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   rc                  The status code to send.
+ */
+static int gdbStubCtxReplySendErrStsData(PGDBSTUBCTXINT pThis, int rc)
+{
+    /** Todo convert error codes maybe. */
+    return gdbStubCtxReplySendErrData(pThis, (-rc) & 0xff);
+}
+#endif /* !GDBSTUB_WITHOUT_MON_CMDS */
+
+
+/**
+ * Sends a GDB stub status code indicating an error using the error reply packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   rc                  The status code to send.
+ */
+static int gdbStubCtxReplySendErrSts(PGDBSTUBCTXINT pThis, int rc)
+{
+    /** Todo convert error codes maybe. */
+    return gdbStubCtxReplySendErr(pThis, (-rc) & 0xff);
+}
+
+
+/**
+ * Parses the arguments of a 'Z' and 'z' packet.
+ *
+ * @returns Status code.
+ * @param   pbArgs                  Pointer to the start of the first argument.
+ * @param   cbArgs                  Number of argument bytes (including the packet end character).
+ * @param   penmTpType              Where to store the tracepoint type on success.
+ * @param   pGdbTgtAddr             Where to store the address on success.
+ * @param   puKind                  Where to store the kind argument on success.
+ * @param   ppbCondList             Where to store the pointer to the condition list following the kind argument,
+ *                                  NULL if there is none.
+ * @param   pcbCondList             Where to store the size of the condition list in bytes (excluding the packet end character).
+ */
+static int gdbStubCtxParseTpPktArgs(const uint8_t *pbArgs, size_t cbArgs, GDBSTUBTPTYPE *penmTpType, GDBTGTMEMADDR *pGdbTgtAddr, uint64_t *puKind,
+                                    const uint8_t **ppbCondList, size_t *pcbCondList)
+{
+    const uint8_t *pbPktSep = NULL;
+    uint64_t uType = 0;
+
+    /* The kind might be followed by a ';' separated condition list. */
+    const uint8_t *pbCondSep = (const uint8_t *)gdbStubCtxMemchr(pbArgs, ';', cbArgs);
+    *ppbCondList = pbCondSep ? pbCondSep + 1 : NULL;
+    *pcbCondList = pbCondSep ? (size_t)(&pbArgs[cbArgs - 1] - (pbCondSep + 1)) : 0;
+
+    int rc = gdbStubCtxParseHexStringAsInteger(pbArgs, cbArgs, &uType,
+                                               ',', &pbPktSep);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        cbArgs -= (uintptr_t)(pbPktSep - pbArgs) - 1;
+        rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, cbArgs, pGdbTgtAddr,
+                                               ',', &pbPktSep);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            cbArgs -= (uintptr_t)(pbPktSep - pbArgs) - 1;
+            rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, cbArgs, puKind,
+                                                   pbCondSep ? ';' : GDBSTUB_PKT_END, NULL);
+            if (rc == GDBSTUB_INF_SUCCESS)
+            {
+                switch (uType)
+                {
+                    case 0:
+                        *penmTpType = GDBSTUBTPTYPE_EXEC_SW;
+                        break;
+                    case 1:
+                        *penmTpType = GDBSTUBTPTYPE_EXEC_HW;
+                        break;
+                    case 2:
+                        *penmTpType = GDBSTUBTPTYPE_MEM_WRITE;
+                        break;
+                    case 3:
+                        *penmTpType = GDBSTUBTPTYPE_MEM_READ;
+                        break;
+                    case 4:
+                        *penmTpType = GDBSTUBTPTYPE_MEM_ACCESS;
+                        break;
+                    default:
+                        rc = GDBSTUB_ERR_INVALID_PARAMETER;
+                        break;
+                }
+            }
+        }
+    }
+
+    return rc;
+}
+
+
+/**
+ * Agent expression opcodes, see the "Agent Expressions" appendix of the GDB manual.
+ */
+#define GDBSTUBAX_OP_ADD                    0x02
+#define GDBSTUBAX_OP_SUB                    0x03
+#define GDBSTUBAX_OP_MUL                    0x04
+#define GDBSTUBAX_OP_DIV_SIGNED             0x05
+#define GDBSTUBAX_OP_DIV_UNSIGNED           0x06
+#define GDBSTUBAX_OP_REM_SIGNED             0x07
+#define GDBSTUBAX_OP_REM_UNSIGNED           0x08
+#define GDBSTUBAX_OP_LSH                    0x09
+#define GDBSTUBAX_OP_RSH_SIGNED             0x0a
+#define GDBSTUBAX_OP_RSH_UNSIGNED           0x0b
+#define GDBSTUBAX_OP_TRACE                  0x0c
+#define GDBSTUBAX_OP_TRACE_QUICK            0x0d
+#define GDBSTUBAX_OP_LOG_NOT                0x0e
+#define GDBSTUBAX_OP_BIT_AND                0x0f
+#define GDBSTUBAX_OP_BIT_OR                 0x10
+#define GDBSTUBAX_OP_BIT_XOR                0x11
+#define GDBSTUBAX_OP_BIT_NOT                0x12
+#define GDBSTUBAX_OP_EQUAL                  0x13
+#define GDBSTUBAX_OP_LESS_SIGNED            0x14
+#define GDBSTUBAX_OP_LESS_UNSIGNED          0x15
+#define GDBSTUBAX_OP_EXT                    0x16
+#define GDBSTUBAX_OP_REF8                   0x17
+#define GDBSTUBAX_OP_REF16                  0x18
+#define GDBSTUBAX_OP_REF32                  0x19
+#define GDBSTUBAX_OP_REF64                  0x1a
+#define GDBSTUBAX_OP_IF_GOTO                0x20
+#define GDBSTUBAX_OP_GOTO                   0x21
+#define GDBSTUBAX_OP_CONST8                 0x22
+#define GDBSTUBAX_OP_CONST16                0x23
+#define GDBSTUBAX_OP_CONST32                0x24
+#define GDBSTUBAX_OP_CONST64                0x25
+#define GDBSTUBAX_OP_REG                    0x26
+#define GDBSTUBAX_OP_END                    0x27
+#define GDBSTUBAX_OP_DUP                    0x28
+#define GDBSTUBAX_OP_POP                    0x29
+#define GDBSTUBAX_OP_ZERO_EXT               0x2a
+#define GDBSTUBAX_OP_SWAP                   0x2b
+#define GDBSTUBAX_OP_TRACENZ                0x2f
+#define GDBSTUBAX_OP_TRACE16                0x30
+#define GDBSTUBAX_OP_PICK                   0x32
+#define GDBSTUBAX_OP_ROT                    0x33
+
+
+/**
+ * Agent expression opcode descriptors indexed by the opcode, floating point, trace state variable
+ * and printf opcodes are not supported.
+ */
+static const GDBSTUBAXOPDESC g_aAxOps[] =
+{
+#define GDBSTUBAXOPDESC_INIT(a_cbImm, a_cPop, a_cPush) { a_cbImm, a_cPop, a_cPush }
+#define GDBSTUBAXOPDESC_INVALID                        { GDBSTUBAX_OP_INVALID, 0, 0 }
+    GDBSTUBAXOPDESC_INVALID,            /* 0x00 */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x01 float */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x02 add */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x03 sub */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x04 mul */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x05 div_signed */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x06 div_unsigned */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x07 rem_signed */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x08 rem_unsigned */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x09 lsh */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x0a rsh_signed */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x0b rsh_unsigned */
+    GDBSTUBAXOPDESC_INIT(0, 2, 0),      /* 0x0c trace */
+    GDBSTUBAXOPDESC_INIT(1, 1, 1),      /* 0x0d trace_quick */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x0e log_not */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x0f bit_and */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x10 bit_or */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x11 bit_xor */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x12 bit_not */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x13 equal */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x14 less_signed */
+    GDBSTUBAXOPDESC_INIT(0, 2, 1),      /* 0x15 less_unsigned */
+    GDBSTUBAXOPDESC_INIT(1, 1, 1),      /* 0x16 ext */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x17 ref8 */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x18 ref16 */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x19 ref32 */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x1a ref64 */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x1b ref_float */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x1c ref_double */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x1d ref_long_double */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x1e l_to_d */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x1f d_to_l */
+    GDBSTUBAXOPDESC_INIT(2, 1, 0),      /* 0x20 if_goto */
+    GDBSTUBAXOPDESC_INIT(2, 0, 0),      /* 0x21 goto */
+    GDBSTUBAXOPDESC_INIT(1, 0, 1),      /* 0x22 const8 */
+    GDBSTUBAXOPDESC_INIT(2, 0, 1),      /* 0x23 const16 */
+    GDBSTUBAXOPDESC_INIT(4, 0, 1),      /* 0x24 const32 */
+    GDBSTUBAXOPDESC_INIT(8, 0, 1),      /* 0x25 const64 */
+    GDBSTUBAXOPDESC_INIT(2, 0, 1),      /* 0x26 reg */
+    GDBSTUBAXOPDESC_INIT(0, 1, 1),      /* 0x27 end */
+    GDBSTUBAXOPDESC_INIT(0, 1, 2),      /* 0x28 dup */
+    GDBSTUBAXOPDESC_INIT(0, 1, 0),      /* 0x29 pop */
+    GDBSTUBAXOPDESC_INIT(1, 1, 1),      /* 0x2a zero_ext */
+    GDBSTUBAXOPDESC_INIT(0, 2, 2),      /* 0x2b swap */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x2c getv */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x2d setv */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x2e tracev */
+    GDBSTUBAXOPDESC_INIT(0, 2, 0),      /* 0x2f tracenz */
+    GDBSTUBAXOPDESC_INIT(2, 1, 1),      /* 0x30 trace16 */
+    GDBSTUBAXOPDESC_INVALID,            /* 0x31 */
+    GDBSTUBAXOPDESC_INIT(1, 0, 1),      /* 0x32 pick */
+    GDBSTUBAXOPDESC_INIT(0, 3, 3),      /* 0x33 rot */
+#undef GDBSTUBAXOPDESC_INVALID
+#undef GDBSTUBAXOPDESC_INIT
+};
+
+
+/**
+ * Discards all trace frames.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxTraceBufReset(PGDBSTUBCTXINT pThis)
+{
+    pThis->offTraceTail        = 0;
+    pThis->offTraceHead        = 0;
+    pThis->offTraceWrap        = 0;
+    pThis->fTraceWrapped       = false;
+    pThis->cbTraceFrame        = 0;
+    pThis->cTraceFrames        = 0;
+    pThis->cTraceFramesDropped = 0;
+    pThis->idTraceFrameSel     = UINT32_MAX;
+    pThis->offTraceFrameSel    = 0;
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+/**
+ * Returns the number of bytes occupied by the trace frames.
+ *
+ * @returns Number of bytes used.
+ * @param   pThis               The GDB stub context.
+ */
+static size_t gdbStubCtxTraceBufUsed(PGDBSTUBCTXINT pThis)
+{
+    return   pThis->fTraceWrapped
+           ? pThis->offTraceWrap - pThis->offTraceTail + pThis->offTraceHead
+           : pThis->offTraceHead - pThis->offTraceTail;
+}
+#endif /* !GDBSTUB_WITHOUT_TRACEPOINTS */
+
+
+/**
+ * Drops the oldest trace frame.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxTraceFrameDrop(PGDBSTUBCTXINT pThis)
+{
+    pThis->offTraceTail = gdbStubCtxTraceFrameNext(pThis, pThis->offTraceTail);
+    pThis->cTraceFrames--;
+    pThis->cTraceFramesDropped++;
+
+    /* All frames before the wrap point are gone, the buffer is linear again. */
+    if (   pThis->fTraceWrapped
+        && !pThis->offTraceTail)
+        pThis->fTraceWrapped = false;
+}
+
+
+/**
+ * Makes room for the given number of bytes at the end of the trace frame being collected,
+ * dropping the oldest frames if the buffer is circular.
+ *
+ * @returns Pointer to the room or NULL if the buffer is full.
+ * @param   pThis               The GDB stub context.
+ * @param   cb                  Number of bytes required.
+ *
+ * @note A frame is always contiguous, so the frame being collected might get moved to the start of the buffer
+ *       invalidating any pointer returned earlier.
+ */
+static uint8_t *gdbStubCtxTraceBufAlloc(PGDBSTUBCTXINT pThis, size_t cb)
+{
+    for (;;)
+    {
+        size_t offLimit = pThis->fTraceWrapped ? pThis->offTraceTail : pThis->cbTraceBuf;
+        size_t offFree  = pThis->offTraceHead + pThis->cbTraceFrame;
+
+        if (offLimit - offFree >= cb)
+        {
+            pThis->cbTraceFrame += cb;
+            return &pThis->pbTraceBuf[offFree];
+        }
+
+        if (!pThis->fTraceCircular)
+            return NULL;
+
+        if (pThis->fTraceWrapped)
+            gdbStubCtxTraceFrameDrop(pThis);
+        else
+        {
+            /* A frame which doesn't fit when starting at the beginning doesn't fit at all. */
+            if (!pThis->offTraceHead)
+                return NULL;
+
+            /* Drop the oldest frames until the frame fits in front of the remaining ones and move it to the start. */
+            size_t cbNeeded = pThis->cbTraceFrame + cb;
+            while (   pThis->cTraceFrames
+                   && pThis->offTraceTail < cbNeeded)
+                gdbStubCtxTraceFrameDrop(pThis);
+
+            gdbStubCtxMemmove(pThis->pbTraceBuf, &pThis->pbTraceBuf[pThis->offTraceHead], pThis->cbTraceFrame);
+            if (pThis->cTraceFrames)
+            {
+                pThis->offTraceWrap  = pThis->offTraceHead;
+                pThis->fTraceWrapped = true;
+            }
+            else
+                pThis->offTraceTail = 0;
+            pThis->offTraceHead = 0;
+        }
+    }
+}
+
+
+/**
+ * Starts collecting a new trace frame.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the trace buffer is full.
+ * @param   pThis               The GDB stub context.
+ * @param   uTpNum              The number of the tracepoint hit.
+ */
+static int gdbStubCtxTraceFrameBegin(PGDBSTUBCTXINT pThis, uint32_t uTpNum)
+{
+    pThis->cbTraceFrame = 0;
+
+    uint8_t *pbHdr = gdbStubCtxTraceBufAlloc(pThis, GDBSTUBTRACE_FRAME_HDR_SIZE);
+    if (!pbHdr)
+        return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+    gdbStubValToLe(pbHdr, uTpNum, sizeof(uint16_t));
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Completes the trace frame being collected.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxTraceFrameEnd(PGDBSTUBCTXINT pThis)
+{
+    gdbStubValToLe(&pThis->pbTraceBuf[pThis->offTraceHead + sizeof(uint16_t)],
+                   pThis->cbTraceFrame - GDBSTUBTRACE_FRAME_HDR_SIZE, sizeof(uint32_t));
+    pThis->offTraceHead += pThis->cbTraceFrame;
+    pThis->cbTraceFrame  = 0;
+    pThis->cTraceFrames++;
+}
+
+
+/**
+ * Collects the given target memory into the trace frame being collected.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the trace buffer is full.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       The target memory address to start at.
+ * @param   cb                  Number of bytes to collect.
+ * @param   fStopAtZero         Flag whether to stop after the first zero byte.
+ *
+ * @note Blocks failing to read are left out of the frame, the remote end sees them as unavailable.
+ */
+static int gdbStubCtxTraceFrameMemCollect(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr, uint64_t cb, bool fStopAtZero)
+{
+    /* The size of a memory block is limited to 16bit. */
+    while (cb)
+    {
+        size_t cbBlock = (size_t)MIN(cb, UINT16_MAX);
+        uint8_t *pbBlock = gdbStubCtxTraceBufAlloc(pThis, GDBSTUBTRACE_BLOCK_MEM_HDR_SIZE + cbBlock);
+        if (!pbBlock)
+            return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+        uint8_t *pbData = &pbBlock[GDBSTUBTRACE_BLOCK_MEM_HDR_SIZE];
+        int rc = gdbStubCtxIfTgtMemRead(pThis, GdbTgtMemAddr, pbData, cbBlock);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            const uint8_t *pbZero = fStopAtZero ? (const uint8_t *)gdbStubCtxMemchr(pbData, 0, cbBlock) : NULL;
+            if (pbZero)
+            {
+                /* Keep the terminator, nothing to collect after it. */
+                size_t cbStr = (size_t)(pbZero - pbData) + 1;
+                pThis->cbTraceFrame -= cbBlock - cbStr;
+                cbBlock = cbStr;
+                cb      = cbStr;
+            }
+
+            pbBlock[0] = 'M';
+            gdbStubValToLe(&pbBlock[1], GdbTgtMemAddr, sizeof(uint64_t));
+            gdbStubValToLe(&pbBlock[1 + sizeof(uint64_t)], cbBlock, sizeof(uint16_t));
+        }
+        else /* Drop the block, the memory is unavailable in the frame, and go on with the next one. */
+            pThis->cbTraceFrame -= GDBSTUBTRACE_BLOCK_MEM_HDR_SIZE + cbBlock;
+
+        GdbTgtMemAddr += cbBlock;
+        cb            -= cbBlock;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Reads the given register for an agent expression.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   idxReg              The register number.
+ * @param   puVal               Where to store the register value (the lower 64bits for bigger registers).
+ */
+static int gdbStubCtxAxRegRead(PGDBSTUBCTXINT pThis, uint32_t idxReg, uint64_t *puVal)
+{
+    if (idxReg >= GDBSTUBCTX_REGS_COUNT(pThis))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    int rc = gdbStubCtxRegsRead(pThis, &idxReg, 1, pThis->pvRegsScratch);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        *puVal = gdbStubValFromLe((const uint8_t *)pThis->pvRegsScratch, GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8);
+
+    return rc;
+}
+
+
+/**
+ * Evaluates the given agent expression.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_NOT_SUPPORTED if the expression uses an unsupported opcode.
+ * @retval  GDBSTUB_ERR_INVALID_PARAMETER if the expression is malformed or doesn't finish within GDBSTUBAX_STEPS_MAX steps.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the expression exceeds the maximum stack depth.
+ * @param   pThis               The GDB stub context.
+ * @param   pbCode              The bytecode of the expression.
+ * @param   cbCode              Size of the bytecode in bytes.
+ * @param   fTrace              Flag whether the expression is a tracepoint action allowed to collect memory
+ *                              into the trace frame being collected.
+ * @param   puResult            Where to store the value on top of the stack when the expression ends.
+ *
+ * @note Target values are assumed to be little endian like all supported architectures are.
+ */
+static int gdbStubCtxAxEval(PGDBSTUBCTXINT pThis, const uint8_t *pbCode, size_t cbCode, bool fTrace, uint64_t *puResult)
+{
+    uint64_t au64Stack[GDBSTUBAX_STACK_MAX];
+    uint32_t cStack = 0;
+    size_t offCode = 0;
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    for (uint32_t cSteps = 0; cSteps < GDBSTUBAX_STEPS_MAX && rc == GDBSTUB_INF_SUCCESS; cSteps++)
+    {
+        /* Running off the end without an 'end' opcode is an error. */
+        if (offCode >= cbCode)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+
+        uint8_t bOp = pbCode[offCode++];
+        if (   bOp >= ELEMENTS(g_aAxOps)
+            || g_aAxOps[bOp].cbImm == GDBSTUBAX_OP_INVALID)
+            return GDBSTUB_ERR_NOT_SUPPORTED;
+
+        PCGDBSTUBAXOPDESC pOpDesc = &g_aAxOps[bOp];
+        if (cbCode - offCode < pOpDesc->cbImm)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+        if (cStack < pOpDesc->cPop)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+        if (cStack - pOpDesc->cPop + pOpDesc->cPush > GDBSTUBAX_STACK_MAX)
+            return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+        /* Immediate operands are big endian. */
+        uint64_t uImm = 0;
+        for (uint32_t i = 0; i < pOpDesc->cbImm; i++)
+            uImm = (uImm << 8) | pbCode[offCode++];
+
+        /* Take the operands off the stack, the first one is the deepest, and make room for the results. */
+        uint64_t au64Ops[3] = { 0 };
+        cStack -= pOpDesc->cPop;
+        for (uint32_t i = 0; i < pOpDesc->cPop; i++)
+            au64Ops[i] = au64Stack[cStack + i];
+
+        uint64_t *pu64Res = &au64Stack[cStack];
+        cStack += pOpDesc->cPush;
+
+        switch (bOp)
+        {
+            case GDBSTUBAX_OP_ADD:
+                *pu64Res = au64Ops[0] + au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_SUB:
+                *pu64Res = au64Ops[0] - au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_MUL:
+                *pu64Res = au64Ops[0] * au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_DIV_SIGNED:
+            case GDBSTUBAX_OP_REM_SIGNED:
+            {
+                if (!au64Ops[1])
+                    return GDBSTUB_ERR_INVALID_PARAMETER;
+
+                /* Dividing the most negative value by -1 overflows. */
+                if ((int64_t)au64Ops[1] == -1)
+                    *pu64Res = bOp == GDBSTUBAX_OP_DIV_SIGNED ? 0 - au64Ops[0] : 0;
+                else if (bOp == GDBSTUBAX_OP_DIV_SIGNED)
+                    *pu64Res = (uint64_t)((int64_t)au64Ops[0] / (int64_t)au64Ops[1]);
+                else
+                    *pu64Res = (uint64_t)((int64_t)au64Ops[0] % (int64_t)au64Ops[1]);
+                break;
+            }
+            case GDBSTUBAX_OP_DIV_UNSIGNED:
+            case GDBSTUBAX_OP_REM_UNSIGNED:
+            {
+                if (!au64Ops[1])
+                    return GDBSTUB_ERR_INVALID_PARAMETER;
+
+                *pu64Res =   bOp == GDBSTUBAX_OP_DIV_UNSIGNED
+                           ? au64Ops[0] / au64Ops[1]
+                           : au64Ops[0] % au64Ops[1];
+                break;
+            }
+            case GDBSTUBAX_OP_LSH:
+                *pu64Res = au64Ops[1] < 64 ? au64Ops[0] << au64Ops[1] : 0;
+                break;
+            case GDBSTUBAX_OP_RSH_SIGNED:
+                *pu64Res = (uint64_t)((int64_t)au64Ops[0] >> MIN(au64Ops[1], 63));
+                break;
+            case GDBSTUBAX_OP_RSH_UNSIGNED:
+                *pu64Res = au64Ops[1] < 64 ? au64Ops[0] >> au64Ops[1] : 0;
+                break;
+            case GDBSTUBAX_OP_TRACE:
+            case GDBSTUBAX_OP_TRACE_QUICK:
+            case GDBSTUBAX_OP_TRACENZ:
+            case GDBSTUBAX_OP_TRACE16:
+            {
+                if (!fTrace)
+                    return GDBSTUB_ERR_NOT_SUPPORTED;
+
+                /* The quick variants take the size from the immediate and leave the address on the stack. */
+                uint64_t cbTrace = au64Ops[1];
+                if (   bOp == GDBSTUBAX_OP_TRACE_QUICK
+                    || bOp == GDBSTUBAX_OP_TRACE16)
+                {
+                    cbTrace  = uImm;
+                    *pu64Res = au64Ops[0];
+                }
+
+                rc = gdbStubCtxTraceFrameMemCollect(pThis, au64Ops[0], cbTrace, bOp == GDBSTUBAX_OP_TRACENZ);
+                break;
+            }
+            case GDBSTUBAX_OP_LOG_NOT:
+                *pu64Res = !au64Ops[0];
+                break;
+            case GDBSTUBAX_OP_BIT_AND:
+                *pu64Res = au64Ops[0] & au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_BIT_OR:
+                *pu64Res = au64Ops[0] | au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_BIT_XOR:
+                *pu64Res = au64Ops[0] ^ au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_BIT_NOT:
+                *pu64Res = ~au64Ops[0];
+                break;
+            case GDBSTUBAX_OP_EQUAL:
+                *pu64Res = au64Ops[0] == au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_LESS_SIGNED:
+                *pu64Res = (int64_t)au64Ops[0] < (int64_t)au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_LESS_UNSIGNED:
+                *pu64Res = au64Ops[0] < au64Ops[1];
+                break;
+            case GDBSTUBAX_OP_EXT:
+            {
+                *pu64Res = au64Ops[0];
+                if (   uImm
+                    && uImm < 64)
+                {
+                    uint64_t fSign = (uint64_t)1 << (uImm - 1);
+                    *pu64Res = ((au64Ops[0] & ((fSign << 1) - 1)) ^ fSign) - fSign;
+                }
+                break;
+            }
+            case GDBSTUBAX_OP_ZERO_EXT:
+                *pu64Res = uImm < 64 ? au64Ops[0] & (((uint64_t)1 << uImm) - 1) : au64Ops[0];
+                break;
+            case GDBSTUBAX_OP_REF8:
+            case GDBSTUBAX_OP_REF16:
+            case GDBSTUBAX_OP_REF32:
+            case GDBSTUBAX_OP_REF64:
+            {
+                uint8_t abVal[8];
+                size_t cbVal = (size_t)1 << (bOp - GDBSTUBAX_OP_REF8);
+
+                rc = gdbStubCtxIfTgtMemRead(pThis, au64Ops[0], &abVal[0], cbVal);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                    *pu64Res = gdbStubValFromLe(&abVal[0], cbVal);
+                break;
+            }
+            case GDBSTUBAX_OP_IF_GOTO:
+                if (au64Ops[0])
+                    offCode = (size_t)uImm;
+                break;
+            case GDBSTUBAX_OP_GOTO:
+                offCode = (size_t)uImm;
+                break;
+            case GDBSTUBAX_OP_CONST8:
+            case GDBSTUBAX_OP_CONST16:
+            case GDBSTUBAX_OP_CONST32:
+            case GDBSTUBAX_OP_CONST64:
+                *pu64Res = uImm;
+                break;
+            case GDBSTUBAX_OP_REG:
+                rc = gdbStubCtxAxRegRead(pThis, (uint32_t)uImm, pu64Res);
+                break;
+            case GDBSTUBAX_OP_END:
+                *puResult = au64Ops[0];
+                return GDBSTUB_INF_SUCCESS;
+            case GDBSTUBAX_OP_DUP:
+                pu64Res[0] = au64Ops[0];
+                pu64Res[1] = au64Ops[0];
+                break;
+            case GDBSTUBAX_OP_POP:
+                break;
+            case GDBSTUBAX_OP_SWAP:
+                pu64Res[0] = au64Ops[1];
+                pu64Res[1] = au64Ops[0];
+                break;
+            case GDBSTUBAX_OP_PICK:
+            {
+                /* The new entry was already accounted for. */
+                if (uImm + 1 >= cStack)
+                    return GDBSTUB_ERR_INVALID_PARAMETER;
+                *pu64Res = au64Stack[cStack - 2 - uImm];
+                break;
+            }
+            case GDBSTUBAX_OP_ROT:
+                /* a b c => c a b */
+                pu64Res[0] = au64Ops[2];
+                pu64Res[1] = au64Ops[0];
+                pu64Res[2] = au64Ops[1];
+                break;
+            default:
+                return GDBSTUB_ERR_INTERNAL_ERROR;
+        }
+    }
+
+    return   rc == GDBSTUB_INF_SUCCESS
+           ? GDBSTUB_ERR_INVALID_PARAMETER
+           : rc;
+}
+
+
+/**
+ * Returns the condition slot of the given breakpoint.
+ *
+ * @returns Pointer to the slot or NULL if the breakpoint has no conditions.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtTpAddr        The breakpoint address.
+ * @param   enmTpType           The breakpoint type.
+ */
+static PGDBSTUBBPCOND gdbStubCtxBpCondFind(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType)
+{
+    for (uint32_t i = 0; i < pThis->cBpConds; i++)
+    {
+        PGDBSTUBBPCOND pBpCond = &pThis->paBpConds[i];
+
+        if (   pBpCond->fUsed
+            && pBpCond->GdbTgtTpAddr == GdbTgtTpAddr
+            && pBpCond->enmTpType == enmTpType)
+            return pBpCond;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Frees the given condition slot.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ * @param   pBpCond             The slot to free.
+ */
+static void gdbStubCtxBpCondFree(PGDBSTUBCTXINT pThis, PGDBSTUBBPCOND pBpCond)
+{
+    pBpCond->fUsed = false;
+    pThis->cBpCondsUsed--;
+}
+
+
+/**
+ * Replaces the conditions of the given breakpoint with the given condition list of a 'Z' packet,
+ * the breakpoint gets a new slot if it had no conditions so far.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if all slots are occupied or the conditions exceed the maximum size.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtTpAddr        The breakpoint address.
+ * @param   enmTpType           The breakpoint type.
+ * @param   pbCondList          The condition list, "X<size>,<bytecode>" entries separated by ';'.
+ * @param   cbCondList          Size of the condition list in bytes.
+ *
+ * @note If the condition list is malformed the breakpoint loses all its conditions.
+ */
+static int gdbStubCtxBpCondSet(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType,
+                               const uint8_t *pbCondList, size_t cbCondList)
+{
+    PGDBSTUBBPCOND pBpCond = gdbStubCtxBpCondFind(pThis, GdbTgtTpAddr, enmTpType);
+    if (!pBpCond)
+    {
+        for (uint32_t i = 0; i < pThis->cBpConds; i++)
+        {
+            if (!pThis->paBpConds[i].fUsed)
+            {
+                pBpCond = &pThis->paBpConds[i];
+                pBpCond->fUsed        = true;
+                pBpCond->enmTpType    = enmTpType;
+                pBpCond->GdbTgtTpAddr = GdbTgtTpAddr;
+                pThis->cBpCondsUsed++;
+                break;
+            }
+        }
+
+        if (!pBpCond)
+            return GDBSTUB_ERR_BUFFER_OVERFLOW;
+    }
+
+    int rc = GDBSTUB_INF_SUCCESS;
+    pBpCond->cbConds = 0;
+    while (   cbCondList
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        const uint8_t *pbSep = NULL;
+        uint64_t cbCode = 0;
+
+        if (*pbCondList != 'X')
+        {
+            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+            break;
+        }
+
+        rc = gdbStubCtxParseHexStringAsInteger(pbCondList + 1, cbCondList - 1, &cbCode, ',', &pbSep);
+        if (rc != GDBSTUB_INF_SUCCESS)
+            break;
+
+        size_t cbLeft = cbCondList - (size_t)(pbSep - pbCondList);
+        size_t cbFree = pThis->cbBpCondsMax - pBpCond->cbConds;
+        if (   !cbLeft
+            || !cbCode
+            || cbCode > (cbLeft - 1) / 2)
+            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+        else if (   cbCode > UINT16_MAX
+                 || cbFree < sizeof(uint16_t)
+                 || cbCode > cbFree - sizeof(uint16_t))
+            rc = GDBSTUB_ERR_BUFFER_OVERFLOW;
+        else
+        {
+            uint8_t *pbCond = &pBpCond->pbConds[pBpCond->cbConds];
+
+            rc = gdbStubCtxParseHexStringAsByteBuf(pbSep + 1, cbCode * 2, pbCond + sizeof(uint16_t), cbCode, NULL);
+            if (rc == GDBSTUB_INF_SUCCESS)
+            {
+                pbCond[0] = (uint8_t)cbCode;
+                pbCond[1] = (uint8_t)(cbCode >> 8);
+                pBpCond->cbConds += sizeof(uint16_t) + cbCode;
+
+                /* Skip over the bytecode and the separator to the next condition. */
+                cbLeft     -= 1 + cbCode * 2;
+                pbCondList  = pbSep + 1 + cbCode * 2;
+                cbCondList  = cbLeft;
+                if (cbCondList)
+                {
+                    if (*pbCondList == ';')
+                    {
+                        pbCondList++;
+                        cbCondList--;
+                    }
+                    else
+                        rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+                }
+            }
+        }
+    }
+
+    if (   rc != GDBSTUB_INF_SUCCESS
+        || !pBpCond->cbConds)
+        gdbStubCtxBpCondFree(pThis, pBpCond);
+
+    return rc;
+}
+
+
+/**
+ * Records the given breakpoint being inserted or removed by the remote end.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtTpAddr        The breakpoint address.
+ * @param   enmTpType           The breakpoint type, only breakpoints are recorded and no watchpoints.
+ * @param   fInsert             Flag whether the breakpoint was inserted or removed.
+ */
+static void gdbStubCtxBpTrack(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, bool fInsert)
+{
+    if (   enmTpType != GDBSTUBTPTYPE_EXEC_SW
+        && enmTpType != GDBSTUBTPTYPE_EXEC_HW)
+        return;
+
+    for (uint32_t i = 0; i < pThis->cBps; i++)
+    {
+        if (   pThis->aBps[i].GdbTgtTpAddr == GdbTgtTpAddr
+            && pThis->aBps[i].enmTpType == enmTpType)
+        {
+            /* Inserting an existing breakpoint again only replaces its conditions. */
+            if (!fInsert)
+                pThis->aBps[i] = pThis->aBps[--pThis->cBps];
+            return;
+        }
+    }
+
+    if (fInsert)
+    {
+        if (pThis->cBps < GDBSTUBCTX_BPS_MAX)
+        {
+            pThis->aBps[pThis->cBps].enmTpType    = enmTpType;
+            pThis->aBps[pThis->cBps].GdbTgtTpAddr = GdbTgtTpAddr;
+            pThis->cBps++;
+        }
+        else
+            pThis->cBpsUntracked++;
+    }
+    else if (pThis->cBpsUntracked)
+        pThis->cBpsUntracked--;
+}
+
+
+/**
+ * Returns whether the remote end inserted a breakpoint at the given program counter.
+ *
+ * @returns Flag whether there is a breakpoint, also true if there are too many breakpoints to tell.
+ * @param   pThis               The GDB stub context.
+ * @param   uPc                 The program counter of the stopped thread.
+ * @param   fUncondOnly         Flag whether to only consider breakpoints without conditions.
+ */
+static bool gdbStubCtxBpIsInserted(PGDBSTUBCTXINT pThis, uint64_t uPc, bool fUncondOnly)
+{
+    if (pThis->cBpsUntracked)
+        return true;
+
+    for (uint32_t i = 0; i < pThis->cBps; i++)
+    {
+        if (   pThis->aBps[i].GdbTgtTpAddr == uPc
+            && (   !fUncondOnly
+                || !gdbStubCtxBpCondFind(pThis, pThis->aBps[i].GdbTgtTpAddr, pThis->aBps[i].enmTpType)))
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * Evaluates the conditions of the breakpoints at the given program counter.
+ *
+ * @returns Flag whether a condition holds or there is no breakpoint with conditions at the program counter.
+ * @param   pThis               The GDB stub context.
+ * @param   uPc                 The program counter of the stopped thread.
+ * @param   pfFound             Where to store the flag whether there is a breakpoint with conditions at the program counter.
+ *
+ * @note A condition failing to evaluate is treated as holding so the stop gets reported.
+ */
+static bool gdbStubCtxBpCondsEval(PGDBSTUBCTXINT pThis, uint64_t uPc, bool *pfFound)
+{
+    *pfFound = false;
+    for (uint32_t i = 0; i < pThis->cBpConds; i++)
+    {
+        PGDBSTUBBPCOND pBpCond = &pThis->paBpConds[i];
+
+        if (   !pBpCond->fUsed
+            || pBpCond->GdbTgtTpAddr != uPc)
+            continue;
+
+        *pfFound = true;
+        size_t offCond = 0;
+        while (offCond < pBpCond->cbConds)
+        {
+            size_t cbCode = pBpCond->pbConds[offCond] | ((size_t)pBpCond->pbConds[offCond + 1] << 8);
+            uint64_t uResult = 0;
+
+            if (   gdbStubCtxAxEval(pThis, &pBpCond->pbConds[offCond + sizeof(uint16_t)], cbCode, false /*fTrace*/,
+                                    &uResult) != GDBSTUB_INF_SUCCESS
+                || uResult)
+                return true;
+
+            offCond += sizeof(uint16_t) + cbCode;
+        }
+    }
+
+    return !*pfFound;
+}
+
+
+/**
+ * Returns whether the given tracepoint location gets set in the target, locations sharing
+ * an address with an earlier one are only set once.
+ *
+ * @returns Flag whether the location gets set in the target.
+ * @param   pThis               The GDB stub context.
+ * @param   idxTp               The tracepoint slot index.
+ */
+static bool gdbStubCtxTracePointIsArmed(PGDBSTUBCTXINT pThis, uint32_t idxTp)
+{
+    PGDBSTUBTRACEPOINT pTp = &pThis->paTracePoints[idxTp];
+    if (   !pTp->fUsed
+        || !pTp->fEnabled)
+        return false;
+
+    for (uint32_t i = 0; i < idxTp; i++)
+    {
+        if (   pThis->paTracePoints[i].fUsed
+            && pThis->paTracePoints[i].fEnabled
+            && pThis->paTracePoints[i].GdbTgtTpAddr == pTp->GdbTgtTpAddr)
+            return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * Sets or clears the enabled tracepoints in the target.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   fSet                Flag whether to set or clear the tracepoints.
+ *
+ * @note Setting stops at the first failure and clears everything set so far.
+ */
+static int gdbStubCtxTracePointsArm(PGDBSTUBCTXINT pThis, bool fSet)
+{
+    for (uint32_t i = 0; i < pThis->cTracePoints; i++)
+    {
+        if (!gdbStubCtxTracePointIsArmed(pThis, i))
+            continue;
+
+        GDBTGTMEMADDR GdbTgtTpAddr = pThis->paTracePoints[i].GdbTgtTpAddr;
+        uint64_t      uKind        = pThis->paTracePoints[i].uKind;
+        if (fSet)
+        {
+            int rc = gdbStubCtxIfTgtTpSet(pThis, GdbTgtTpAddr, GDBSTUBTPTYPE_EXEC_SW, uKind, GDBSTUBTPACTION_TRACE);
+            if (rc != GDBSTUB_INF_SUCCESS)
+            {
+                while (i-- > 0)
+                {
+                    if (gdbStubCtxTracePointIsArmed(pThis, i))
+                        gdbStubCtxIfTgtTpClear(pThis, pThis->paTracePoints[i].GdbTgtTpAddr, GDBSTUBTPTYPE_EXEC_SW,
+                                               pThis->paTracePoints[i].uKind);
+                }
+                return rc;
+            }
+        }
+        else
+            gdbStubCtxIfTgtTpClear(pThis, GdbTgtTpAddr, GDBSTUBTPTYPE_EXEC_SW, uKind);
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Stops tracing, clearing the tracepoints in the target.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ * @param   enmStop             The reason tracing stops.
+ * @param   uTpNum              The tracepoint number causing the stop.
+ */
+static void gdbStubCtxTraceStop(PGDBSTUBCTXINT pThis, GDBSTUBTRACESTOP enmStop, uint32_t uTpNum)
+{
+    if (!pThis->fTraceRunning)
+        return;
+
+    gdbStubCtxTracePointsArm(pThis, false /*fSet*/);
+    pThis->fTraceRunning = false;
+    pThis->enmTraceStop  = enmStop;
+    pThis->uTraceStopTp  = uTpNum;
+}
+
+
+/**
+ * Collects a trace frame for the given tracepoint, holding all registers followed by the memory
+ * collected by the actions.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the trace buffer is full, the partial frame is discarded.
+ * @param   pThis               The GDB stub context.
+ * @param   pTp                 The tracepoint hit.
+ *
+ * @note Failing to collect memory doesn't discard the frame, the memory is unavailable in the frame.
+ */
+static int gdbStubCtxTraceFrameCollect(PGDBSTUBCTXINT pThis, PGDBSTUBTRACEPOINT pTp)
+{
+    int rc = gdbStubCtxTraceFrameBegin(pThis, pTp->uNum);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        uint8_t *pbRegs = gdbStubCtxTraceBufAlloc(pThis, 1 + GDBSTUBCTX_REGS_SIZE(pThis));
+        if (pbRegs)
+        {
+            pbRegs[0] = 'R';
+            rc = gdbStubCtxRegsRead(pThis, pThis->paidxRegs, GDBSTUBCTX_REGS_COUNT(pThis), &pbRegs[1]);
+        }
+        else
+            rc = GDBSTUB_ERR_BUFFER_OVERFLOW;
+    }
+
+    size_t offAction = pTp->cbCond;
+    while (   offAction < pTp->cbActions
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        const uint8_t *pbAction = &pTp->pbActions[offAction];
+        size_t cbData = pbAction[1] | ((size_t)pbAction[2] << 8);
+        const uint8_t *pbData = &pbAction[1 + sizeof(uint16_t)];
+
+        if (pbAction[0] == 'M')
+        {
+            uint32_t idxRegBase = (uint32_t)gdbStubValFromLe(&pbData[0], sizeof(uint32_t));
+            GDBTGTMEMADDR GdbTgtMemAddr = gdbStubValFromLe(&pbData[sizeof(uint32_t)], sizeof(uint64_t));
+            uint64_t cbCollect = gdbStubValFromLe(&pbData[sizeof(uint32_t) + sizeof(uint64_t)], sizeof(uint32_t));
+            uint64_t uBase = 0;
+
+            if (   idxRegBase == GDBSTUBTRACE_ACTION_MEM_ABS
+                || gdbStubCtxAxRegRead(pThis, idxRegBase, &uBase) == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxTraceFrameMemCollect(pThis, GdbTgtMemAddr + uBase, cbCollect, false /*fStopAtZero*/);
+        }
+        else
+        {
+            uint64_t uResult = 0;
+            rc = gdbStubCtxAxEval(pThis, pbData, cbData, true /*fTrace*/, &uResult);
+        }
+
+        if (rc != GDBSTUB_ERR_BUFFER_OVERFLOW)
+            rc = GDBSTUB_INF_SUCCESS;
+        offAction += 1 + sizeof(uint16_t) + cbData;
+    }
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        gdbStubCtxTraceFrameEnd(pThis);
+    else
+        pThis->cbTraceFrame = 0;
+
+    return rc;
+}
+
+
+/**
+ * Collects trace frames for all enabled tracepoints at the given program counter whose condition holds.
+ *
+ * @returns Flag whether there is an enabled tracepoint at the program counter.
+ * @param   pThis               The GDB stub context.
+ * @param   uPc                 The program counter of the stopped thread.
+ *
+ * @note A condition failing to evaluate is treated as false.
+ */
+static bool gdbStubCtxTracePointsHit(PGDBSTUBCTXINT pThis, uint64_t uPc)
+{
+    bool fHit = false;
+
+    for (uint32_t i = 0; i < pThis->cTracePoints && pThis->fTraceRunning; i++)
+    {
+        PGDBSTUBTRACEPOINT pTp = &pThis->paTracePoints[i];
+        if (   !pTp->fUsed
+            || !pTp->fEnabled
+            || pTp->GdbTgtTpAddr != uPc)
+            continue;
+
+        fHit = true;
+        uint64_t uResult = 1;
+        if (   pTp->cbCond
+            && (   gdbStubCtxAxEval(pThis, pTp->pbActions, pTp->cbCond, false /*fTrace*/, &uResult) != GDBSTUB_INF_SUCCESS
+                || !uResult))
+            continue;
+
+        pTp->cHits++;
+        if (gdbStubCtxTraceFrameCollect(pThis, pTp) == GDBSTUB_ERR_BUFFER_OVERFLOW)
+            gdbStubCtxTraceStop(pThis, GDBSTUBTRACESTOP_FULL, pTp->uNum);
+        else if (   pTp->cPass
+                 && pTp->cHits >= pTp->cPass)
+            gdbStubCtxTraceStop(pThis, GDBSTUBTRACESTOP_PASS_COUNT, pTp->uNum);
+    }
+
+    return fHit;
+}
+
+
+/**
+ * Checks whether the given stop hit a breakpoint whose conditions are all false or a tracepoint, collecting
+ * the trace frames and resuming the stopped thread (or the whole target in all-stop mode) without involving
+ * the remote end in that case.
+ *
+ * @returns Flag whether the stop was consumed, false if it must be reported.
+ * @param   pThis               The GDB stub context.
+ * @param   idThrd              The thread which stopped.
+ * @param   enmReason           The reason the thread stopped.
+ */
+static bool gdbStubCtxStopConsume(PGDBSTUBCTXINT pThis, GDBTGTTHRDID idThrd, GDBSTUBSTOPREASON enmReason)
+{
+    /* A single step might end up on a conditional breakpoint, the step completing must be reported nevertheless. */
+    bool fStepPending = pThis->fStepPending;
+    pThis->fStepPending = false;
+
+    if (   fStepPending
+        || enmReason != GDBSTUBSTOPREASON_TRAP
+        || (   !pThis->cBpCondsUsed
+            && !pThis->fTraceRunning))
+        return false;
+
+    /* The target executed code, so nothing cached is valid anymore. */
+    gdbStubCtxCachesInvalidate(pThis);
+
+    /* Evaluate in the context of the stopped thread without changing the selection of the remote end. */
+    GDBTGTTHRDID idThrdPrev = pThis->idThrdGen;
+    bool fThrd = (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS) != 0;
+    if (   fThrd
+        && gdbStubCtxThrdSelect(pThis, idThrd) != GDBSTUB_INF_SUCCESS)
+        return false;
+
+    /* The live registers and memory are needed, not the ones from a trace frame the remote end looks at. */
+    uint32_t idTraceFrameSel = pThis->idTraceFrameSel;
+    pThis->idTraceFrameSel = UINT32_MAX;
+
+    idThrd = pThis->idThrdGen;
+    bool fReport = true;
+    uint64_t uPc = 0;
+    if (gdbStubCtxAxRegRead(pThis, pThis->idxRegPc, &uPc) == GDBSTUB_INF_SUCCESS)
+    {
+        bool fBpCond = false;
+
+        /* Another breakpoint without conditions at the same address gets reported regardless. */
+        fReport =    gdbStubCtxBpCondsEval(pThis, uPc, &fBpCond)
+                  || gdbStubCtxBpIsInserted(pThis, uPc, true /*fUncondOnly*/);
+        if (   pThis->fTraceRunning
+            && gdbStubCtxTracePointsHit(pThis, uPc)
+            && !gdbStubCtxBpIsInserted(pThis, uPc, false /*fUncondOnly*/))
+            fReport = false;
+    }
+
+    if (   idTraceFrameSel != UINT32_MAX
+        && gdbStubCtxTraceFrameFind(pThis, idTraceFrameSel, &pThis->offTraceFrameSel))
+        pThis->idTraceFrameSel = idTraceFrameSel;
+
+    if (   fThrd
+        && idThrdPrev != GDBTGTTHRDID_ANY)
+        gdbStubCtxThrdSelect(pThis, idThrdPrev);
+
+    if (fReport)
+        return false;
+
+    int rc;
+    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+    {
+        rc = gdbStubCtxRegsCacheFlush(pThis);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            gdbStubCtxCachesInvalidate(pThis);
+            rc = gdbStubCtxIfTgtThrdAction(pThis, idThrd, GDBSTUBTHRDACTION_CONTINUE);
+        }
+    }
+    else
+        rc = gdbStubCtxTgtResume(pThis, false /*fStep*/);
+
+    /* Better report the stop than leaving the target stopped without the remote end knowing. */
+    return rc == GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Formats the given prefix followed by the given value as a hex number.
+ *
+ * @returns Number of characters written.
+ * @param   pchDst              Where to store the string (not terminated).
+ * @param   pszPrefix           The prefix.
+ * @param   u64                 The value to format.
+ */
+static size_t gdbStubCtxFmtPrefixedHexU64(char *pchDst, const char *pszPrefix, uint64_t u64)
+{
+    size_t cchPrefix = gdbStubStrlen(pszPrefix);
+
+    gdbStubCtxMemcpy(pchDst, pszPrefix, cchPrefix);
+    return cchPrefix + gdbStubCtxFmtHexU64(&pchDst[cchPrefix], u64);
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+/**
+ * Processes the 'TStatus' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryTStatus(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    static const char *s_apszTraceStop[] = { ";tnotrun:", ";tstop:", ";tfull:", ";tpasscount:" };
+
+    if (!pThis->cTracePoints)
+    {
+        char achReply[2] = { 'T', '0' };
+        return gdbStubCtxReplySend(pThis, &achReply[0], sizeof(achReply));
+    }
+
+    char achReply[256];
+    size_t cchReply = 0;
+
+    achReply[cchReply++] = 'T';
+    achReply[cchReply++] = pThis->fTraceRunning ? '1' : '0';
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], s_apszTraceStop[pThis->enmTraceStop], pThis->uTraceStopTp);
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], ";tframes:", pThis->cTraceFrames);
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], ";tcreated:", (uint64_t)pThis->cTraceFrames + pThis->cTraceFramesDropped);
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], ";tfree:", pThis->cbTraceBuf - gdbStubCtxTraceBufUsed(pThis));
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], ";tsize:", pThis->cbTraceBuf);
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], ";circular:", pThis->fTraceCircular);
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], ";disconn:", 0);
+    return gdbStubCtxReplySend(pThis, (const uint8_t *)&achReply[0], cchReply);
+}
+
+
+/**
+ * Processes the 'TBuffer' query, returning the raw trace frames from the oldest to the newest.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryTBuffer(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    uint64_t offRead = 0;
+    uint64_t cbRead = 0;
+
+    if (!pThis->cTracePoints)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    if (   !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &offRead) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ',')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cbRead) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, GDBSTUB_PKT_END))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    size_t cbUsed = gdbStubCtxTraceBufUsed(pThis);
+    if (offRead >= cbUsed)
+        return gdbStubCtxReplySend(pThis, (const uint8_t *)"l", 1);
+
+    /* The oldest frames come first, followed by the ones at the start of the buffer if the frames wrapped around. */
+    size_t cbFirst = (pThis->fTraceWrapped ? pThis->offTraceWrap : pThis->offTraceHead) - pThis->offTraceTail;
+    size_t off = (size_t)offRead;
+    size_t cb = (size_t)MIN(cbRead, MIN(cbUsed - off, pThis->cbPktMax / 2));
+
+    int rc = gdbStubCtxReplySendBegin(pThis);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && off < cbFirst)
+    {
+        size_t cbThisRead = MIN(cb, cbFirst - off);
+
+        rc = gdbStubCtxReplySendDataHex(pThis, &pThis->pbTraceBuf[pThis->offTraceTail + off], cbThisRead);
+        off += cbThisRead;
+        cb  -= cbThisRead;
+    }
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && cb)
+        rc = gdbStubCtxReplySendDataHex(pThis, &pThis->pbTraceBuf[off - cbFirst], cb);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendEnd(pThis);
+
+    return rc;
+}
+#endif /* !GDBSTUB_WITHOUT_TRACEPOINTS */
+
+
+#if !defined(GDBSTUB_WITHOUT_CRC)
+/**
+ * CRC-32 lookup table for the polynomial 0x04c11db7 processed MSB first, matching what the remote end
+ * computes for the 'CRC' query (not the reflected variant used by zlib).
+ */
+static const uint32_t g_au32Crc32[256] =
+{
+    0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b,
+    0x1a864db2, 0x1e475005, 0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61,
+    0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd, 0x4c11db70, 0x48d0c6c7,
+    0x4593e01e, 0x4152fda9, 0x5f15adac, 0x5bd4b01b, 0x569796c2, 0x52568b75,
+    0x6a1936c8, 0x6ed82b7f, 0x639b0da6, 0x675a1011, 0x791d4014, 0x7ddc5da3,
+    0x709f7b7a, 0x745e66cd, 0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039,
+    0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5, 0xbe2b5b58, 0xbaea46ef,
+    0xb7a96036, 0xb3687d81, 0xad2f2d84, 0xa9ee3033, 0xa4ad16ea, 0xa06c0b5d,
+    0xd4326d90, 0xd0f37027, 0xddb056fe, 0xd9714b49, 0xc7361b4c, 0xc3f706fb,
+    0xceb42022, 0xca753d95, 0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1,
+    0xe13ef6f4, 0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d, 0x34867077, 0x30476dc0,
+    0x3d044b19, 0x39c556ae, 0x278206ab, 0x23431b1c, 0x2e003dc5, 0x2ac12072,
+    0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16, 0x018aeb13, 0x054bf6a4,
+    0x0808d07d, 0x0cc9cdca, 0x7897ab07, 0x7c56b6b0, 0x71159069, 0x75d48dde,
+    0x6b93dddb, 0x6f52c06c, 0x6211e6b5, 0x66d0fb02, 0x5e9f46bf, 0x5a5e5b08,
+    0x571d7dd1, 0x53dc6066, 0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
+    0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e, 0xbfa1b04b, 0xbb60adfc,
+    0xb6238b25, 0xb2e29692, 0x8aad2b2f, 0x8e6c3698, 0x832f1041, 0x87ee0df6,
+    0x99a95df3, 0x9d684044, 0x902b669d, 0x94ea7b2a, 0xe0b41de7, 0xe4750050,
+    0xe9362689, 0xedf73b3e, 0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2,
+    0xc6bcf05f, 0xc27dede8, 0xcf3ecb31, 0xcbffd686, 0xd5b88683, 0xd1799b34,
+    0xdc3abded, 0xd8fba05a, 0x690ce0ee, 0x6dcdfd59, 0x608edb80, 0x644fc637,
+    0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb, 0x4f040d56, 0x4bc510e1,
+    0x46863638, 0x42472b8f, 0x5c007b8a, 0x58c1663d, 0x558240e4, 0x51435d53,
+    0x251d3b9e, 0x21dc2629, 0x2c9f00f0, 0x285e1d47, 0x36194d42, 0x32d850f5,
+    0x3f9b762c, 0x3b5a6b9b, 0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff,
+    0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623, 0xf12f560e, 0xf5ee4bb9,
+    0xf8ad6d60, 0xfc6c70d7, 0xe22b20d2, 0xe6ea3d65, 0xeba91bbc, 0xef68060b,
+    0xd727bbb6, 0xd3e6a601, 0xdea580d8, 0xda649d6f, 0xc423cd6a, 0xc0e2d0dd,
+    0xcda1f604, 0xc960ebb3, 0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7,
+    0xae3afba2, 0xaafbe615, 0xa7b8c0cc, 0xa379dd7b, 0x9b3660c6, 0x9ff77d71,
+    0x92b45ba8, 0x9675461f, 0x8832161a, 0x8cf30bad, 0x81b02d74, 0x857130c3,
+    0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640, 0x4e8ee645, 0x4a4ffbf2,
+    0x470cdd2b, 0x43cdc09c, 0x7b827d21, 0x7f436096, 0x7200464f, 0x76c15bf8,
+    0x68860bfd, 0x6c47164a, 0x61043093, 0x65c52d24, 0x119b4be9, 0x155a565e,
+    0x18197087, 0x1cd86d30, 0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
+    0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088, 0x2497d08d, 0x2056cd3a,
+    0x2d15ebe3, 0x29d4f654, 0xc5a92679, 0xc1683bce, 0xcc2b1d17, 0xc8ea00a0,
+    0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb, 0xdbee767c, 0xe3a1cbc1, 0xe760d676,
+    0xea23f0af, 0xeee2ed18, 0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4,
+    0x89b8fd09, 0x8d79e0be, 0x803ac667, 0x84fbdbd0, 0x9abc8bd5, 0x9e7d9662,
+    0x933eb0bb, 0x97ffad0c, 0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668,
+    0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
+};
+
+
+/**
+ * Updates the given CRC-32 with the given data.
+ *
+ * @returns Updated CRC-32.
+ * @param   u32Crc              The CRC-32 to update.
+ * @param   pbData              The data to process.
+ * @param   cbData              Number of bytes to process.
+ */
+static uint32_t gdbStubCrc32Update(uint32_t u32Crc, const uint8_t *pbData, size_t cbData)
+{
+    while (cbData--)
+        u32Crc = (u32Crc << 8) ^ g_au32Crc32[((u32Crc >> 24) ^ *pbData++) & 0xff];
+
+    return u32Crc;
+}
+
+
+/**
+ * Processes the 'CRC' query, computing the CRC-32 of a target memory range so the remote end
+ * can verify memory without reading it back.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryCrc(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    uint64_t GdbTgtAddr = 0;
+    uint64_t cbLeft = 0;
+
+    if (   !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &GdbTgtAddr) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ',')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cbLeft) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, GDBSTUB_PKT_END))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    /* Unlike 'm' there is no partial result, any inaccessible byte fails the whole query. */
+    uint8_t abTmp[1024];
+    uint32_t u32Crc = UINT32_MAX;
+    int rc = GDBSTUB_INF_SUCCESS;
+    while (   cbLeft
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        const uint8_t *pbData = NULL;
+        size_t cbData = 0;
+        size_t cbMapped = 0;
+        size_t cbThisAcquire = (size_t)MIN(cbLeft, (uint64_t)SIZE_MAX);
+
+        rc = gdbStubCtxTgtMemAcquire(pThis, GdbTgtAddr, cbThisAcquire, &abTmp[0], sizeof(abTmp),
+                                     &pbData, &cbData, &cbMapped);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            u32Crc = gdbStubCrc32Update(u32Crc, pbData, cbData);
+            gdbStubCtxTgtMemRelease(pThis, pbData, cbMapped);
+
+            GdbTgtAddr += cbData;
+            cbLeft     -= cbData;
+        }
+    }
+
+    if (rc != GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendErrSts(pThis, rc);
+
+    char achReply[32];
+    size_t cchReply = gdbStubCtxFmtPrefixedHexU64(&achReply[0], "C", u32Crc);
+    return gdbStubCtxReplySend(pThis, (const uint8_t *)&achReply[0], cchReply);
+}
+#endif /* !GDBSTUB_WITHOUT_CRC */
+
+
+/**
+ * @copydoc{FNGDBSTUBQPKTPROC}
+ */
+static int gdbStubCtxPktProcessFeatXmlRegs(PGDBSTUBCTXINT pThis, const uint8_t *pbVal, size_t cbVal)
+{
+    /*
+     * xmlRegisters contain a list of supported architectures delimited by ','.
+     * Check that the architecture is in the supported list.
+     */
+    int rc = GDBSTUB_INF_SUCCESS;
+    while (cbVal)
+    {
+        /* Find the next delimiter. */
+        size_t cbThisVal = cbVal;
+        const uint8_t *pbDelim = gdbStubCtxMemchr(pbVal, ',', cbVal);
+        if (pbDelim)
+            cbThisVal = pbDelim - pbVal;
+
+        size_t cchArch = gdbStubStrlen(s_aGdbArchMapping[GDBSTUBIF_ARCH(pThis->pIf)]);
+        if (!gdbStubMemcmp(pbVal, s_aGdbArchMapping[GDBSTUBIF_ARCH(pThis->pIf)], MIN(cbVal, cchArch)))
+        {
+            /* Set the flag to support the qXfer:features:read packet. */
+            pThis->fFeatures |= GDBSTUBCTX_FEATURES_F_TGT_DESC;
+            break;
+        }
+
+        cbVal -= cbThisVal + (pbDelim ? 1 : 0);
+        pbVal = pbDelim + (pbDelim ? 1 : 0);
+    }
+
+    return rc;
+}
+
+
+/**
+ * Features which can be reported by the remote GDB which we might support.
+ *
+ * @note The sorting matters for features which start the same, the longest must come first.
+ */
+static const GDBSTUBFEATDESC g_aGdbFeatures[] =
+{
+#define GDBSTUBFEATDESC_INIT(a_Name, a_pfnHnd, a_fVal) { a_Name, sizeof(a_Name) - 1, a_pfnHnd, a_fVal }
+    GDBSTUBFEATDESC_INIT("xmlRegisters",   gdbStubCtxPktProcessFeatXmlRegs, true),
+#undef GDBSTUBFEATDESC_INIT
+};
+
+
+/**
+ * Calculates the feature length of the next feature pointed to by the given arguments buffer.
+ *
+ * @returns Status code.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ * @param   pcbArg              Where to store the size of the argument in bytes on success (excluding the delimiter).
+ * @param   pfTerminator        Whereto store the flag whether the packet terminator (#) was seen as a delimiter.
+ */
+static int gdbStubCtxQueryPktQueryFeatureLen(const uint8_t *pbArgs, size_t cbArgs, size_t *pcbArg, bool *pfTerminator)
+{
+    const uint8_t *pbArgCur = pbArgs;
+
+    while (   cbArgs
+           && *pbArgCur != ';'
+           && *pbArgCur != GDBSTUB_PKT_END)
+    {
+        cbArgs--;
+        pbArgCur++;
+    }
+
+    if (   !cbArgs
+        && *pbArgCur != ';'
+        && *pbArgCur != GDBSTUB_PKT_END)
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    *pcbArg       = pbArgCur - pbArgs;
+    *pfTerminator = *pbArgCur == GDBSTUB_PKT_END ? true : false;
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Appends the given feature to the reply of the 'qSupported' packet, adding the ';' delimiter as required.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pszFeat             The feature string to append.
+ * @param   pfFirst             Flag whether this is the first feature in the reply, updated on return.
+ */
+static int gdbStubCtxPktProcessQuerySupportedReplyFeat(PGDBSTUBCTXINT pThis, const char *pszFeat, bool *pfFirst)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    if (!*pfFirst)
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)";", 1);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)pszFeat, gdbStubStrlen(pszFeat));
+
+    *pfFirst = false;
+    return rc;
+}
+
+
+/**
+ * Sends the reply to the 'qSupported' packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxPktProcessQuerySupportedReply(PGDBSTUBCTXINT pThis)
+{
+    bool fFirst = true;
+    int rc = gdbStubCtxReplySendBegin(pThis);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_TGT_DESC))
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "qXfer:features:read+", &fFirst);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && pThis->pbMemMap)
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "qXfer:memory-map:read+", &fFirst);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "QStartNoAckMode+", &fFirst);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "binary-upload+", &fFirst);
+#if !defined(GDBSTUB_WITHOUT_NON_STOP)
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "QNonStop+", &fFirst);
+#endif
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && pThis->cBpConds)
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "ConditionalBreakpoints+", &fFirst);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && pThis->cTracePoints)
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "ConditionalTracepoints+", &fFirst);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && pThis->cTracePoints)
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, "tracenz+", &fFirst);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        /* Let the remote end know how big packets can get so bulk transfers don't get split up unnecessarily. */
+        char szPktSize[sizeof("PacketSize=") + 16] = "PacketSize=";
+        size_t cch = gdbStubCtxFmtHexU64(&szPktSize[sizeof("PacketSize=") - 1], pThis->cbPktMax);
+        szPktSize[sizeof("PacketSize=") - 1 + cch] = '\0';
+
+        rc = gdbStubCtxPktProcessQuerySupportedReplyFeat(pThis, &szPktSize[0], &fFirst);
+    }
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendEnd(pThis);
+
+    return rc;
+}
+
+
+/**
+ * Processes the 'Supported' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQuerySupported(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    /* Skip the : following the qSupported start. */
+    if (   cbArgs < 1
+        || pbArgs[0] != ':')
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    cbArgs--;
+    pbArgs++;
+
+    /*
+     * Each feature but the last one are separated by ; and the last one is delimited by the # packet end symbol.
+     * We first determine the boundaries of the reported feature and pass it to the appropriate handler.
+     */
+    int rc = GDBSTUB_INF_SUCCESS;
+    while (   cbArgs
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        bool fTerminator = false;
+        size_t cbArg = 0;
+        rc = gdbStubCtxQueryPktQueryFeatureLen(pbArgs, cbArgs, &cbArg, &fTerminator);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            /* Search for the feature handler. */
+            for (uint32_t i = 0; i < ELEMENTS(g_aGdbFeatures); i++)
+            {
+                PCGDBSTUBFEATDESC pFeatDesc = &g_aGdbFeatures[i];
+
+                if (   cbArg > pFeatDesc->cchName /* At least one character must come after the feature name ('+', '-' or '='). */
+                    && !gdbStubMemcmp(pFeatDesc->pszName, pbArgs, pFeatDesc->cchName))
+                {
+                    /* Found, execute handler after figuring out whether there is a value attached. */
+                    const uint8_t *pbVal = pbArgs + pFeatDesc->cchName;
+                    size_t cbVal = cbArg - pFeatDesc->cchName;
+
+                    if (pFeatDesc->fVal)
+                    {
+                        if (   *pbVal == '='
+                            && cbVal > 1)
+                        {
+                            pbVal++;
+                            cbVal--;
+                        }
+                        else
+                            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+                    }
+                    else if (   cbVal != 1
+                             || (   *pbVal != '+'
+                                 && *pbVal != '-')) /* '+' and '-' are allowed to indicate support for a particular feature. */
+                        rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                        rc = pFeatDesc->pfnHandler(pThis, pbVal, cbVal);
+                    break;
+                }
+            }
+
+            cbArgs -= cbArg;
+            pbArgs += cbArg;
+            if (!fTerminator)
+            {
+                cbArgs--;
+                pbArgs++;
+            }
+            else
+                break;
+        }
+    }
+
+    /* If everything went alright send the reply with our supported features. */
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxPktProcessQuerySupportedReply(pThis);
+
+    return rc;
+}
+
+
+/**
+ * Sends the reply to a 'qXfer:<object>:read:...' request.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   offRead             Where to start reading from within the object.
+ * @param   cbRead              How much to read.
+ * @param   pbObj               The start of the object.
+ * @param   cbObj               Size of the object.
+ */
+static int gdbStubCtxQueryXferReadReply(PGDBSTUBCTXINT pThis, uint32_t offRead, size_t cbRead, const uint8_t *pbObj, size_t cbObj)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    if (offRead < cbObj)
+    {
+        /*
+         * The reply is allowed to be shorter than what was requested, so send as much as fits
+         * into a single packet after escaping (one byte is required for the 'l'/'m' prefix).
+         */
+        size_t cbEscaped = 0;
+        size_t cbThisRead = offRead + cbRead < cbObj ? cbRead : cbObj - offRead;
+        cbThisRead = gdbStubCtxBinaryEscapedFit(pbObj + offRead, cbThisRead, pThis->cbPktMax - 1, &cbEscaped);
+
+        uint8_t chPrefix = offRead + cbThisRead == cbObj ? 'l' : 'm';
+        rc = gdbStubCtxReplySendBegin(pThis);
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = gdbStubCtxReplySendData(pThis, &chPrefix, sizeof(chPrefix));
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = gdbStubCtxReplySendDataBinary(pThis, pbObj + offRead, cbThisRead);
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = gdbStubCtxReplySendEnd(pThis);
+    }
+    else if (offRead == cbObj)
+        rc = gdbStubCtxReplySend(pThis, "l", sizeof("l") - 1);
+    else
+        rc = gdbStubCtxReplySendErr(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    return rc;
+}
+
+
+/**
+ * Parses the annex:offset,length part of a 'qXfer:<object>:read:...' request.
+ *
+ * @returns Status code.
+ * @param   pbArgs              Start of the arguments beginning with <annex>.
+ * @param   cbArgs              Number of bytes remaining for the arguments.
+ * @param   ppchAnnex           Where to store the pointer to the beginning of the annex on success.
+ * @param   pcchAnnex           Where to store the number of characters for the annex on success.
+ * @param   poff                Where to store the offset on success.
+ * @param   pcb                 Where to store the length on success.
+ */
+static int gdbStubCtxPktProcessQueryXferParseAnnexOffLen(const uint8_t *pbArgs, size_t cbArgs, const char **ppchAnnex, size_t *pcchAnnex,
+                                                         uint32_t *poffRead, size_t *pcbRead)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+    const uint8_t *pbSep = gdbStubCtxMemchr(pbArgs, ':', cbArgs);
+    if (pbSep)
+    {
+        *ppchAnnex = (const char *)pbArgs;
+        *pcchAnnex = pbSep - pbArgs;
+
+        pbSep++;
+        cbArgs -= *pcchAnnex + 1;
+
+        uint64_t u64Tmp = 0;
+        const uint8_t *pbLenStart = NULL;
+        rc = gdbStubCtxParseHexStringAsInteger(pbSep, cbArgs, &u64Tmp, ',', &pbLenStart);
+        if (   rc == GDBSTUB_INF_SUCCESS
+            && (uint32_t)u64Tmp == u64Tmp)
+        {
+            *poffRead = (uint32_t)u64Tmp;
+            cbArgs -= pbLenStart - pbSep;
+
+            rc = gdbStubCtxParseHexStringAsInteger(pbLenStart + 1, cbArgs, &u64Tmp, '#', &pbLenStart);
+            if (   rc == GDBSTUB_INF_SUCCESS
+                && (size_t)u64Tmp == u64Tmp)
+                *pcbRead = (size_t)u64Tmp;
+            else
+                rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+        }
+        else
+            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+    }
+    else
+        rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    return rc;
+}
+
+
+/**
+ * Appends the given string to the target XML description.
+ *
+ * @returns Offset after the appended string.
+ * @param   pbDesc              Where to store the description, NULL to only compute the size.
+ * @param   off                 Current offset into the description.
+ * @param   psz                 The string to append.
+ */
+static size_t gdbStubTgtDescAppend(uint8_t *pbDesc, size_t off, const char *psz)
+{
+    size_t cch = gdbStubStrlen(psz);
+
+    if (pbDesc)
+        gdbStubCtxMemcpy(&pbDesc[off], psz, cch);
+
+    return off + cch;
+}
+
+
+/**
+ * Formats the target XML description for the given register table (a single feature
+ * containing all registers).
+ *
+ * @returns Size of the target XML description in bytes.
+ * @param   pIf                 The interface callback table.
+ * @param   pbDesc              Where to store the description, NULL to only compute the size.
+ */
+static size_t gdbStubTgtDescFmt(PCGDBSTUBIF pIf, uint8_t *pbDesc)
+{
+    size_t off = 0;
+
+    off = gdbStubTgtDescAppend(pbDesc, off, GDBSTUB_TGT_DESC_START);
+    off = gdbStubTgtDescAppend(pbDesc, off, s_aGdbArchMapping[GDBSTUBIF_ARCH(pIf)]);
+    off = gdbStubTgtDescAppend(pbDesc, off, "</architecture>\n<feature name=\"");
+    off = gdbStubTgtDescAppend(pbDesc, off, s_aGdbArchFeatMapping[GDBSTUBIF_ARCH(pIf)]);
+    off = gdbStubTgtDescAppend(pbDesc, off, "\">\n");
+
+    for (PCGDBSTUBREG pReg = GDBSTUBIF_REGS(pIf); pReg->pszName; pReg++)
+    {
+        char achBits[16];
+        uint32_t cchBits = 0;
+        uint32_t cRegBits = pReg->cRegBits;
+
+        /* Format the bitsize in decimal (backwards). */
+        do
+        {
+            achBits[sizeof(achBits) - 2 - cchBits++] = '0' + (cRegBits % 10);
+            cRegBits /= 10;
+        } while (cRegBits);
+        achBits[sizeof(achBits) - 1] = '\0';
+
+        off = gdbStubTgtDescAppend(pbDesc, off, "<reg name=\"");
+        off = gdbStubTgtDescAppend(pbDesc, off, pReg->pszName);
+        off = gdbStubTgtDescAppend(pbDesc, off, "\" bitsize=\"");
+        off = gdbStubTgtDescAppend(pbDesc, off, &achBits[sizeof(achBits) - 1 - cchBits]);
+
+        if (pReg->enmType == GDBSTUBREGTYPE_STACK_PTR)
+            off = gdbStubTgtDescAppend(pbDesc, off, "\" type=\"data_ptr");
+        else if (   pReg->enmType == GDBSTUBREGTYPE_PC
+                 || pReg->enmType == GDBSTUBREGTYPE_CODE_PTR)
+            off = gdbStubTgtDescAppend(pbDesc, off, "\" type=\"code_ptr");
+
+        off = gdbStubTgtDescAppend(pbDesc, off, "\"/>\n");
+    }
+
+    return gdbStubTgtDescAppend(pbDesc, off, GDBSTUB_TGT_DESC_END);
+}
+
+
+/**
+ * Formats the XML memory map for the given memory region table.
+ *
+ * @returns Size of the XML memory map in bytes.
+ * @param   paMemRegions        The memory region table.
+ * @param   pbMap               Where to store the memory map, NULL to only compute the size.
+ */
+static size_t gdbStubMemMapFmt(PCGDBSTUBMEMREGION paMemRegions, uint8_t *pbMap)
+{
+    static const char *s_apszMemRegionType[] = { NULL, "ram", "rom", "flash" };
+    size_t off = 0;
+
+    off = gdbStubTgtDescAppend(pbMap, off,
+                               "<?xml version=\"1.0\"?>\n"
+                               "<!DOCTYPE memory-map PUBLIC \"+//IDN gnu.org//DTD GDB Memory Map V1.0//EN\"\n"
+                               "                            \"http://sourceware.org/gdb/gdb-memory-map.dtd\">\n"
+                               "<memory-map>\n");
+
+    for (PCGDBSTUBMEMREGION pRegion = &paMemRegions[0]; pRegion->cbRegion; pRegion++)
+    {
+        char szHex[sizeof("0x") + 16];
+
+        off = gdbStubTgtDescAppend(pbMap, off, "<memory type=\"");
+        off = gdbStubTgtDescAppend(pbMap, off, s_apszMemRegionType[pRegion->enmType]);
+        off = gdbStubTgtDescAppend(pbMap, off, "\" start=\"");
+        szHex[gdbStubCtxFmtPrefixedHexU64(&szHex[0], "0x", pRegion->GdbTgtMemAddrStart)] = '\0';
+        off = gdbStubTgtDescAppend(pbMap, off, &szHex[0]);
+        off = gdbStubTgtDescAppend(pbMap, off, "\" length=\"");
+        szHex[gdbStubCtxFmtPrefixedHexU64(&szHex[0], "0x", pRegion->cbRegion)] = '\0';
+        off = gdbStubTgtDescAppend(pbMap, off, &szHex[0]);
+
+        if (pRegion->enmType == GDBSTUBMEMREGIONTYPE_FLASH)
+        {
+            off = gdbStubTgtDescAppend(pbMap, off, "\">\n  <property name=\"blocksize\">");
+            szHex[gdbStubCtxFmtPrefixedHexU64(&szHex[0], "0x", pRegion->cbBlock)] = '\0';
+            off = gdbStubTgtDescAppend(pbMap, off, &szHex[0]);
+            off = gdbStubTgtDescAppend(pbMap, off, "</property>\n</memory>\n");
+        }
+        else
+            off = gdbStubTgtDescAppend(pbMap, off, "\"/>\n");
+    }
+
+    return gdbStubTgtDescAppend(pbMap, off, "</memory-map>\n");
+}
+
+
+/**
+ * Returns the target description annex with the given name.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pchAnnex            The annex name (not terminated).
+ * @param   cchAnnex            Number of characters in the annex name.
+ * @param   ppbDesc             Where to store the pointer to the description on success.
+ * @param   pcbDesc             Where to store the size of the description on success.
+ */
+static int gdbStubCtxTgtDescAnnexQuery(PGDBSTUBCTXINT pThis, const char *pchAnnex, size_t cchAnnex,
+                                       const uint8_t **ppbDesc, size_t *pcbDesc)
+{
+    PCGDBSTUBTGTDESCANNEX pAnnex = pThis->pIf->paTgtDescAnnexes;
+
+    if (!pAnnex)
+    {
+        /* Only the generated description. */
+        if (   cchAnnex == sizeof("target.xml") - 1
+            && !gdbStubMemcmp(pchAnnex, "target.xml", cchAnnex))
+        {
+            *ppbDesc = pThis->pbTgtXmlDesc;
+            *pcbDesc = pThis->cbTgtXmlDesc;
+            return GDBSTUB_INF_SUCCESS;
+        }
+
+        return GDBSTUB_ERR_NOT_FOUND;
+    }
+
+    for (; pAnnex->pszAnnex; pAnnex++)
+    {
+        if (   gdbStubStrlen(pAnnex->pszAnnex) == cchAnnex
+            && !gdbStubMemcmp(pchAnnex, pAnnex->pszAnnex, cchAnnex))
+        {
+            *ppbDesc = (const uint8_t *)pAnnex->pvDesc;
+            *pcbDesc = pAnnex->cbDesc;
+            return GDBSTUB_INF_SUCCESS;
+        }
+    }
+
+    return GDBSTUB_ERR_NOT_FOUND;
+}
+
+
+/**
+ * Processes the 'Xfer:features:read' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryXferFeatRead(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* Skip the : following the Xfer:features:read start. */
+    if (   cbArgs < 1
+        || pbArgs[0] != ':')
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    cbArgs--;
+    pbArgs++;
+
+    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_TGT_DESC)
+    {
+        /* Parse annex, offset and length and return the data. */
+        const char *pchAnnex = NULL;
+        size_t cchAnnex = 0;
+        uint32_t offRead = 0;
+        size_t cbRead = 0;
+
+        rc = gdbStubCtxPktProcessQueryXferParseAnnexOffLen(pbArgs, cbArgs,
+                                                           &pchAnnex, &cchAnnex,
+                                                           &offRead, &cbRead);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            /* The chunks are escaped straight from the description, either prebuilt or created along with the context. */
+            const uint8_t *pbDesc = NULL;
+            size_t cbDesc = 0;
+
+            if (gdbStubCtxTgtDescAnnexQuery(pThis, pchAnnex, cchAnnex, &pbDesc, &cbDesc) == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxQueryXferReadReply(pThis, offRead, cbRead, pbDesc, cbDesc);
+            else
+                rc = gdbStubCtxReplySendErr(pThis, 0);
+        }
+        else
+            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+    }
+    else
+        rc = gdbStubCtxReplySend(pThis, NULL, 0); /* Not supported. */
+
+    return rc;
+}
+
+
+/**
+ * Processes the 'Xfer:memory-map:read' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryXferMemMapRead(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    /* Skip the : following the Xfer:memory-map:read start. */
+    if (   cbArgs < 1
+        || pbArgs[0] != ':')
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    if (!pThis->pbMemMap)
+        return gdbStubCtxReplySend(pThis, NULL, 0); /* Not supported. */
+
+    /* There is only one memory map, so the annex is always empty. */
+    const char *pchAnnex = NULL;
+    size_t cchAnnex = 0;
+    uint32_t offRead = 0;
+    size_t cbRead = 0;
+
+    int rc = gdbStubCtxPktProcessQueryXferParseAnnexOffLen(pbArgs + 1, cbArgs - 1,
+                                                           &pchAnnex, &cchAnnex,
+                                                           &offRead, &cbRead);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        if (!cchAnnex)
+            rc = gdbStubCtxQueryXferReadReply(pThis, offRead, cbRead, pThis->pbMemMap, pThis->cbMemMap);
+        else
+            rc = gdbStubCtxReplySendErr(pThis, 0);
+    }
+    else
+        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+
+    return rc;
+}
+
+
+/**
+ * List of supported 'qXfer' objects and operations.
+ */
+static const GDBSTUBQPKTPROC g_aQXferPktProcs[] =
+{
+#define GDBSTUBQPKTPROC_INIT(a_Name, a_pfnProc) { a_Name, sizeof(a_Name) - 1, a_pfnProc }
+    GDBSTUBQPKTPROC_INIT(":features:read",     gdbStubCtxPktProcessQueryXferFeatRead),
+    GDBSTUBQPKTPROC_INIT(":memory-map:read",   gdbStubCtxPktProcessQueryXferMemMapRead),
+#undef GDBSTUBQPKTPROC_INIT
+};
+
+
+/**
+ * Processes the 'Xfer' query, dispatching on the object and operation.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryXfer(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    for (uint32_t i = 0; i < ELEMENTS(g_aQXferPktProcs); i++)
+    {
+        PCGDBSTUBQPKTPROC pQProc = &g_aQXferPktProcs[i];
+
+        if (   cbArgs >= pQProc->cchName
+            && !gdbStubMemcmp(pbArgs, pQProc->pszName, pQProc->cchName))
+            return pQProc->pfnProc(pThis, pbArgs + pQProc->cchName, cbArgs - pQProc->cchName);
+    }
+
+    return gdbStubCtxReplySend(pThis, NULL, 0);
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
+/**
+ * Calls the given command handler and processes the reply.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pCmd                The command to call - NULL if using the generic monitor command received callback in the
+ *                              interface callback table.
+ * @param   pszArgs             Argument string to call the command with.
+ */
+static int gdbStubCtxCmdProcess(PGDBSTUBCTXINT pThis, PCGDBSTUBCMD pCmd, const char *pszArgs)
+{
+    PGDBSTUBOUTCTX pOutCtx = &pThis->OutCtx;
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* When streaming the output goes into 'O' packets ahead of the reply, otherwise it makes up the reply. */
+    gdbStubOutCtxReset(pOutCtx, pThis->fMonOutputStream);
+    if (!pOutCtx->fStream)
+        rc = gdbStubCtxReplySendBegin(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        int rcCmd = GDBSTUB_INF_SUCCESS;
+        if (pCmd)
+            rcCmd = pCmd->pfnCmd(pThis, &pOutCtx->Hlp, pszArgs, pThis->pvUser);
+        else
+            rcCmd = pThis->pIf->pfnMonCmd(pThis, &pOutCtx->Hlp, pszArgs, pThis->pvUser);
+
+        /*
+         * Without streaming an error reply can't follow output which is already part of the reply,
+         * the status is appended to the output instead.
+         */
+        bool fOutput = pOutCtx->cbOutput != 0;
+        if (   !pOutCtx->fStream
+            && fOutput
+            && rcCmd != GDBSTUB_INF_SUCCESS)
+        {
+            gdbStubOutCtxAppendString(pOutCtx, "Command failed with status ");
+            gdbStubOutCtxAppendS32(pOutCtx, rcCmd, 0 /*cDigits*/);
+            gdbStubOutCtxAppend(pOutCtx, "\n", 1);
+        }
+
+        rc = gdbStubOutCtxFinish(pOutCtx);
+        if (pOutCtx->fStream)
+        {
+            if (rc == GDBSTUB_INF_SUCCESS)
+                rc = rcCmd == GDBSTUB_INF_SUCCESS ? gdbStubCtxReplySendOk(pThis) : gdbStubCtxReplySendErrSts(pThis, rcCmd);
+        }
+        else
+        {
+            if (   rc == GDBSTUB_INF_SUCCESS
+                && !fOutput)
+            {
+                if (rcCmd != GDBSTUB_INF_SUCCESS)
+                    rc = gdbStubCtxReplySendErrStsData(pThis, rcCmd);
+                else /* No output, just send OK reply. */
+                    rc = gdbStubCtxReplySendOkData(pThis);
+            }
+
+            /* Try to finish the reply in case of an error anyway (but we might be completely screwed at this point anyway). */
+            gdbStubCtxReplySendEnd(pThis);
+        }
+    }
+
+    return rc;
+}
+
+
+#if defined(GDBSTUB_WITH_STATS)
+/**
+ * Interface callback names for the statistics, indexed by GDBSTUBSTATSIF.
+ */
+static const char *g_apszStatsIfNames[GDBSTUBSTATSIF_COUNT] =
+{
+    "TgtGetState",
+    "TgtStop",
+    "TgtRestart",
+    "TgtKill",
+    "TgtStep",
+    "TgtCont",
+    "TgtMemRead",
+    "TgtMemWrite",
+    "TgtMemMap",
+    "TgtRegsRead",
+    "TgtRegsWrite",
+    "TgtTpSet",
+    "TgtTpClear",
+    "TgtThrdsQuery",
+    "TgtThrdSelect",
+    "TgtThrdGetState",
+    "TgtThrdAction",
+    "TgtFlashErase",
+    "TgtFlashWrite",
+    "TgtFlashDone"
+};
+
+
+/**
+ * Prints the given latency statistics including the non empty histogram buckets.
+ *
+ * @returns nothing.
+ * @param   pHlp                The output helpers.
+ * @param   pszName             The name of the statistics.
+ * @param   pLat                The latency statistics to print.
+ */
+static void gdbStubCtxStatsLatPrint(PCGDBSTUBOUTHLP pHlp, const char *pszName, PCGDBSTUBSTATSLAT pLat)
+{
+    pHlp->pfnPrintf(pHlp, "  %s: %U calls, avg %U ns, max %U ns\n", pszName, pLat->cSamples,
+                    pLat->cNsTotal / pLat->cSamples, pLat->cNsMax);
+    pHlp->pfnPrintf(pHlp, "   ");
+    for (uint32_t i = 0; i < GDBSTUBSTATS_LAT_BUCKETS; i++)
+    {
+        if (!pLat->acBuckets[i])
+            continue;
+
+        /* The bucket bounds are powers of two of 1024ns, printed as microseconds for brevity. */
+        if (i < GDBSTUBSTATS_LAT_BUCKETS - 1)
+            pHlp->pfnPrintf(pHlp, " <%uus:%U", 1U << i, pLat->acBuckets[i]);
+        else
+            pHlp->pfnPrintf(pHlp, " >=%uus:%U", 1U << (i - 1), pLat->acBuckets[i]);
+    }
+    pHlp->pfnPrintf(pHlp, "\n");
+}
+
+
+/**
+ * @copydoc{GDBSTUBCMD,pfnCmd} - Built-in 'stats' monitor command.
+ */
+static int gdbStubCtxCmdStats(GDBSTUBCTX hGdbStubCtx, PCGDBSTUBOUTHLP pHlp, const char *pszArgs, void *pvUser)
+{
+    PGDBSTUBCTXINT pThis = hGdbStubCtx;
+    PCGDBSTUBSTATS pStats = &pThis->Stats;
+
+    (void)pvUser;
+
+    if (pszArgs && *pszArgs)
+    {
+        if (   gdbStubStrlen(pszArgs) != sizeof("reset") - 1
+            || gdbStubMemcmp(pszArgs, "reset", sizeof("reset") - 1))
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+
+        /* Deferred until the accounting of the packet carrying the command is done. */
+        pThis->fStatsReset = true;
+        return GDBSTUB_INF_SUCCESS;
+    }
+
+    pHlp->pfnPrintf(pHlp, "received %U bytes, %U acks, %U naks\n", pStats->cbIn, pStats->cAcksRecv, pStats->cNaksRecv);
+    pHlp->pfnPrintf(pHlp, "sent %U bytes, %U acks, %U naks\n", pStats->cbOut, pStats->cAcksSent, pStats->cNaksSent);
+
+    pHlp->pfnPrintf(pHlp, "packets:\n");
+    for (uint32_t i = 0; i < GDBSTUBSTATS_PKT_TYPES; i++)
+    {
+        PCGDBSTUBSTATSPKT pPkt = &pStats->aPkts[i];
+        char szType[2] = { (char)i, '\0' };
+
+        if (!pPkt->cPkts)
+            continue;
+
+        pHlp->pfnPrintf(pHlp, "  %s: %U packets, %U bytes in, %U bytes out, avg %U ns\n",
+                        i ? &szType[0] : "<empty>", pPkt->cPkts, pPkt->cbIn, pPkt->cbOut,
+                        pPkt->cNsTotal / pPkt->cPkts);
+    }
+
+    pHlp->pfnPrintf(pHlp, "latencies:\n");
+    if (pStats->PktProcess.cSamples)
+        gdbStubCtxStatsLatPrint(pHlp, "PktProcess", &pStats->PktProcess);
+    for (uint32_t i = 0; i < GDBSTUBSTATSIF_COUNT; i++)
+    {
+        if (pStats->aTgtIf[i].cSamples)
+            gdbStubCtxStatsLatPrint(pHlp, g_apszStatsIfNames[i], &pStats->aTgtIf[i]);
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * The built-in monitor command reporting the statistics.
+ */
+static const GDBSTUBCMD g_CmdStats = { "stats", "Shows the protocol statistics, 'stats reset' clears them", gdbStubCtxCmdStats };
+#endif
+
+
+/**
+ * Processes the 'Rcmd' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryRcmd(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* Skip the , following the qRcmd start. */
+    if (   cbArgs < 1
+        || pbArgs[0] != ',')
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+#if !defined(GDBSTUB_WITH_STATS) /* There is always the built-in stats command otherwise. */
+    if (   !pThis->pIf->paCmds
+        && !pThis->pIf->pfnMonCmd)
+        return GDBSTUB_ERR_NOT_FOUND;
+#endif
+
+    cbArgs--;
+    pbArgs++;
+
+    /* Decode the command. */
+    /** @todo Make this dynamic. */
+    char szCmd[4096];
+    if (cbArgs / 2 >= sizeof(szCmd))
+        return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+    size_t cbDecoded = 0;
+    rc = gdbStubCtxParseHexStringAsByteBuf(pbArgs, cbArgs - 1, &szCmd[0], sizeof(szCmd), &cbDecoded);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        const char *pszArgs = NULL;
+
+        cbDecoded /= 2;
+        szCmd[cbDecoded] = '\0'; /* Ensure zero termination. */
+
+        /** @todo Sanitize string. */
+
+        /* Look for the first space and take that as the separator between command identifier. */
+        uint8_t *pbDelim = gdbStubCtxMemchr(&szCmd[0], ' ', cbDecoded);
+        if (pbDelim)
+        {
+            *pbDelim = '\0';
+            pszArgs = pbDelim + 1;
+        }
+
+        /* Search for the command. */
+        size_t cchCmd = pbDelim ? (size_t)(pbDelim - (uint8_t *)&szCmd[0]) : gdbStubStrlen(&szCmd[0]);
+        uint32_t idxCmd = pThis->pIf->paCmds
+                        ? gdbStubNameIdxLookup(&pThis->IdxCmds, pThis->pIf->paCmds, sizeof(*pThis->pIf->paCmds),
+                                               &szCmd[0], cchCmd)
+                        : UINT32_MAX;
+        if (idxCmd != UINT32_MAX)
+            rc = gdbStubCtxCmdProcess(pThis, &pThis->pIf->paCmds[idxCmd], pszArgs);
+#if defined(GDBSTUB_WITH_STATS)
+        else if (   cchCmd == sizeof("stats") - 1
+                 && !gdbStubMemcmp(&szCmd[0], g_CmdStats.pszCmd, cchCmd))
+            rc = gdbStubCtxCmdProcess(pThis, &g_CmdStats, pszArgs);
+#endif
+        else if (pThis->pIf->pfnMonCmd)
+        {
+            /* Restore delimiter. */
+            if (pbDelim)
+                *pbDelim = ' ';
+            rc = gdbStubCtxCmdProcess(pThis, NULL, &szCmd[0]);
+        }
+        else
+            rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_NOT_FOUND); /** @todo Send string. */
+    }
+
+    return rc;
+}
+#endif /* !GDBSTUB_WITHOUT_MON_CMDS */
+
+
+/**
+ * Sends the next chunk of the thread list to the remote end.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   idxStart            Index of the first thread to report.
+ */
+static int gdbStubCtxPktProcessQueryThrdInfoReply(PGDBSTUBCTXINT pThis, uint32_t idxStart)
+{
+    if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    /* Each thread takes at most 9 characters in the reply, the minimum packet size is large enough for a full chunk. */
+    GDBTGTTHRDID aidThrds[32];
+    uint32_t cThrds = 0;
+    int rc = gdbStubCtxIfTgtThrdsQuery(pThis, idxStart, &aidThrds[0], ELEMENTS(aidThrds), &cThrds);
+    if (rc != GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendErrSts(pThis, rc);
+
+    if (!cThrds)
+        return gdbStubCtxReplySend(pThis, (const uint8_t *)"l", 1);
+
+    pThis->idxThrdInfoNext = idxStart + cThrds;
+
+    rc = gdbStubCtxReplySendBegin(pThis);
+    for (uint32_t i = 0; i < cThrds && rc == GDBSTUB_INF_SUCCESS; i++)
+    {
+        char achThrd[17];
+        size_t cchThrd = 0;
+
+        achThrd[cchThrd++] = i == 0 ? 'm' : ',';
+        cchThrd += gdbStubCtxFmtHexU64(&achThrd[cchThrd], aidThrds[i]);
+        rc = gdbStubCtxReplySendData(pThis, (const uint8_t *)&achThrd[0], cchThrd);
+    }
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxReplySendEnd(pThis);
+
+    return rc;
+}
+
+
+/**
+ * Processes the 'fThreadInfo' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryFThrdInfo(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    return gdbStubCtxPktProcessQueryThrdInfoReply(pThis, 0 /*idxStart*/);
+}
+
+
+/**
+ * Processes the 'sThreadInfo' query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQuerySThrdInfo(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    return gdbStubCtxPktProcessQueryThrdInfoReply(pThis, pThis->idxThrdInfoNext);
+}
+
+
+/**
+ * Processes the 'C' (current thread) query.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessQueryCurThrd(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    int rc = gdbStubCtxThrdSelect(pThis, GDBTGTTHRDID_ANY);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        char achThrd[sizeof("QC") + 16] = "QC";
+        size_t cchThrd = sizeof("QC") - 1;
+
+        cchThrd += gdbStubCtxFmtHexU64(&achThrd[cchThrd], pThis->idThrdGen);
+        rc = gdbStubCtxReplySend(pThis, (const uint8_t *)&achThrd[0], cchThrd);
+    }
+    else
+        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+
+    return rc;
+}
+
+
+/**
+ * List of supported query packets.
+ */
+static const GDBSTUBQPKTPROC g_aQPktProcs[] =
+{
+#define GDBSTUBQPKTPROC_INIT(a_Name, a_pfnProc) { a_Name, sizeof(a_Name) - 1, a_pfnProc }
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+    GDBSTUBQPKTPROC_INIT("TStatus",            gdbStubCtxPktProcessQueryTStatus),
+    GDBSTUBQPKTPROC_INIT("TBuffer",            gdbStubCtxPktProcessQueryTBuffer),
+#endif
+#if !defined(GDBSTUB_WITHOUT_CRC)
+    GDBSTUBQPKTPROC_INIT("CRC",                gdbStubCtxPktProcessQueryCrc),
+#endif
+    GDBSTUBQPKTPROC_INIT("Supported",          gdbStubCtxPktProcessQuerySupported),
+    GDBSTUBQPKTPROC_INIT("Xfer",               gdbStubCtxPktProcessQueryXfer),
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
+    GDBSTUBQPKTPROC_INIT("Rcmd",               gdbStubCtxPktProcessQueryRcmd),
+#endif
+    GDBSTUBQPKTPROC_INIT("fThreadInfo",        gdbStubCtxPktProcessQueryFThrdInfo),
+    GDBSTUBQPKTPROC_INIT("sThreadInfo",        gdbStubCtxPktProcessQuerySThrdInfo),
+    GDBSTUBQPKTPROC_INIT("C",                  gdbStubCtxPktProcessQueryCurThrd),
+#undef GDBSTUBQPKTPROC_INIT
+};
+
+
+/**
+ * Processes a 'q' packet, sending the appropriate reply.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbQuery             The query packet data (without the 'q').
+ * @param   cbQuery             Size of the remaining query packet in bytes.
+ */
+static int gdbStubCtxPktProcessQuery(PGDBSTUBCTXINT pThis, const uint8_t *pbQuery, size_t cbQuery)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* Search the query and execute the processor or return an empty reply if not supported. */
+    size_t cchName = gdbStubPktNameLen(pbQuery, ":,;");
+    uint32_t idxProc = gdbStubNameIdxLookup(&pThis->IdxQPktProcs, &g_aQPktProcs[0], sizeof(g_aQPktProcs[0]),
+                                            pbQuery, cchName);
+    if (idxProc != UINT32_MAX)
+        return g_aQPktProcs[idxProc].pfnProc(pThis, pbQuery + cchName, cbQuery - cchName);
+
+    return gdbStubCtxReplySend(pThis, NULL, 0);
+}
+
+
+/**
+ * Processes the 'QStartNoAckMode' packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetStartNoAckMode(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    /* The acknowledge for this packet was already queued, everything afterwards goes without. */
+    pThis->fFeatures |= GDBSTUBCTX_FEATURES_F_NO_ACK_MODE;
+    return gdbStubCtxReplySendOk(pThis);
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_NON_STOP)
+/**
+ * Processes the 'QNonStop' set packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetNonStop(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    if (   cbArgs != 3
+        || pbArgs[0] != ':'
+        || (   pbArgs[1] != '0'
+            && pbArgs[1] != '1'))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    if (pbArgs[1] == '1')
+        pThis->fFeatures |= GDBSTUBCTX_FEATURES_F_NON_STOP;
+    else
+        pThis->fFeatures &= ~GDBSTUBCTX_FEATURES_F_NON_STOP;
+    pThis->fStopNotifyInFlight = false;
+
+    return gdbStubCtxReplySendOk(pThis);
+}
+#endif /* !GDBSTUB_WITHOUT_NON_STOP */
+
+
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+/**
+ * Returns the slot of the given tracepoint location.
+ *
+ * @returns Pointer to the slot or NULL if the location isn't defined.
+ * @param   pThis               The GDB stub context.
+ * @param   uNum                The tracepoint number.
+ * @param   GdbTgtTpAddr        The tracepoint address.
+ */
+static PGDBSTUBTRACEPOINT gdbStubCtxTracePointFind(PGDBSTUBCTXINT pThis, uint64_t uNum, GDBTGTMEMADDR GdbTgtTpAddr)
+{
+    for (uint32_t i = 0; i < pThis->cTracePoints; i++)
+    {
+        PGDBSTUBTRACEPOINT pTp = &pThis->paTracePoints[i];
+
+        if (   pTp->fUsed
+            && pTp->uNum == uNum
+            && pTp->GdbTgtTpAddr == GdbTgtTpAddr)
+            return pTp;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Parses an agent expression ("<size>,<bytecode>" following the 'X') and appends it to the action list
+ * of the given tracepoint.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the expression doesn't fit into the action list.
+ * @param   pThis               The GDB stub context.
+ * @param   pTp                 The tracepoint.
+ * @param   ppbArgs             Pointer to the start of the expression, updated to point after it on success.
+ * @param   pcbArgs             Pointer to the number of bytes left in the packet, updated on success.
+ * @param   fCond               Flag whether the expression is the condition stored without the action header.
+ */
+static int gdbStubCtxTracePointExprParse(PGDBSTUBCTXINT pThis, PGDBSTUBTRACEPOINT pTp, const uint8_t **ppbArgs, size_t *pcbArgs,
+                                         bool fCond)
+{
+    const uint8_t *pbArgs = *ppbArgs;
+    size_t cbArgs = *pcbArgs;
+    uint64_t cbCode = 0;
+
+    if (   gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cbCode) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ',')
+        || !cbCode
+        || cbCode > cbArgs / 2)
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    size_t cbHdr = fCond ? 0 : 1 + sizeof(uint16_t);
+    size_t cbFree = pThis->cbTracePointMax - pTp->cbActions;
+    if (   cbCode > UINT16_MAX
+        || cbFree < cbHdr
+        || cbCode > cbFree - cbHdr)
+        return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+    uint8_t *pbAction = &pTp->pbActions[pTp->cbActions];
+    int rc = gdbStubCtxParseHexStringAsByteBuf(pbArgs, cbCode * 2, &pbAction[cbHdr], cbCode, NULL);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        if (fCond)
+            pTp->cbCond = cbCode;
+        else
+        {
+            pbAction[0] = 'X';
+            gdbStubValToLe(&pbAction[1], cbCode, sizeof(uint16_t));
+        }
+        pTp->cbActions += cbHdr + cbCode;
+
+        *ppbArgs = pbArgs + cbCode * 2;
+        *pcbArgs = cbArgs - cbCode * 2;
+    }
+
+    return rc;
+}
+
+
+/**
+ * Parses the actions of a 'QTDP' packet continuing a tracepoint definition and appends them to the action list.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pTp                 The tracepoint.
+ * @param   pbArgs              The actions.
+ * @param   cbArgs              Size of the actions in bytes including the packet end character.
+ *
+ * @note All registers are collected for every hit, so register collection actions are ignored.
+ */
+static int gdbStubCtxTracePointActionsParse(PGDBSTUBCTXINT pThis, PGDBSTUBTRACEPOINT pTp, const uint8_t *pbArgs, size_t cbArgs)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    while (   cbArgs
+           && *pbArgs != GDBSTUB_PKT_END
+           && *pbArgs != '-'
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        uint8_t chAction = *pbArgs++;
+        cbArgs--;
+
+        switch (chAction)
+        {
+            case 'R':
+            {
+                uint64_t fRegs = 0;
+                rc = gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &fRegs);
+                break;
+            }
+            case 'M':
+            {
+                uint64_t idxRegBase = 0;
+                uint64_t offMem = 0;
+                uint64_t cbMem = 0;
+
+                /* The base register is -1 (or its 32bit two's complement) for absolute addresses. */
+                bool fAbs = gdbStubCtxParseChr(&pbArgs, &cbArgs, '-');
+                if (   gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &idxRegBase) != GDBSTUB_INF_SUCCESS
+                    || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ',')
+                    || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &offMem) != GDBSTUB_INF_SUCCESS
+                    || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ',')
+                    || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cbMem) != GDBSTUB_INF_SUCCESS)
+                    rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+                else
+                {
+                    if (   fAbs
+                        || idxRegBase >= UINT32_MAX)
+                        idxRegBase = GDBSTUBTRACE_ACTION_MEM_ABS;
+                    else if (idxRegBase >= GDBSTUBCTX_REGS_COUNT(pThis))
+                        rc = GDBSTUB_ERR_INVALID_PARAMETER;
+
+                    if (   rc == GDBSTUB_INF_SUCCESS
+                        && (   cbMem > UINT32_MAX
+                            || pThis->cbTracePointMax - pTp->cbActions < 1 + sizeof(uint16_t) + GDBSTUBTRACE_ACTION_MEM_SIZE))
+                        rc = GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        uint8_t *pbAction = &pTp->pbActions[pTp->cbActions];
+
+                        pbAction[0] = 'M';
+                        gdbStubValToLe(&pbAction[1], GDBSTUBTRACE_ACTION_MEM_SIZE, sizeof(uint16_t));
+                        gdbStubValToLe(&pbAction[3], idxRegBase, sizeof(uint32_t));
+                        gdbStubValToLe(&pbAction[3 + sizeof(uint32_t)], offMem, sizeof(uint64_t));
+                        gdbStubValToLe(&pbAction[3 + sizeof(uint32_t) + sizeof(uint64_t)], cbMem, sizeof(uint32_t));
+                        pTp->cbActions += 1 + sizeof(uint16_t) + GDBSTUBTRACE_ACTION_MEM_SIZE;
+                    }
+                }
+                break;
+            }
+            case 'X':
+                rc = gdbStubCtxTracePointExprParse(pThis, pTp, &pbArgs, &cbArgs, false /*fCond*/);
+                break;
+            case 'S': /* While stepping actions. */
+                rc = GDBSTUB_ERR_NOT_SUPPORTED;
+                break;
+            default:
+                rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+                break;
+        }
+    }
+
+    return rc;
+}
+
+
+/**
+ * Processes the 'QTDP' set packet, defining a tracepoint location or adding actions to it.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetTDP(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    uint64_t uNum = 0;
+    GDBTGTMEMADDR GdbTgtTpAddr = 0;
+
+    if (!pThis->cTracePoints)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    /* Tracepoints can't be installed while tracing is running. */
+    if (pThis->fTraceRunning)
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_NOT_SUPPORTED);
+
+    if (!gdbStubCtxParseChr(&pbArgs, &cbArgs, ':'))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    bool fActions = gdbStubCtxParseChr(&pbArgs, &cbArgs, '-');
+    if (   gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &uNum) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &GdbTgtTpAddr) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':'))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    int rc = GDBSTUB_INF_SUCCESS;
+    PGDBSTUBTRACEPOINT pTp = gdbStubCtxTracePointFind(pThis, uNum, GdbTgtTpAddr);
+    if (fActions)
+    {
+        if (pTp)
+            rc = gdbStubCtxTracePointActionsParse(pThis, pTp, pbArgs, cbArgs);
+        else
+            rc = GDBSTUB_ERR_NOT_FOUND;
+    }
+    else
+    {
+        uint64_t cSteps = 0;
+        uint64_t cPass = 0;
+        uint8_t chEnabled = cbArgs ? *pbArgs : 0;
+
+        if (   (   chEnabled != 'E'
+                && chEnabled != 'D')
+            || !gdbStubCtxParseChr(&pbArgs, &cbArgs, chEnabled)
+            || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+            || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cSteps) != GDBSTUB_INF_SUCCESS
+            || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+            || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cPass) != GDBSTUB_INF_SUCCESS)
+            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+        else if (cSteps) /* While stepping isn't supported. */
+            rc = GDBSTUB_ERR_NOT_SUPPORTED;
+
+        if (   rc == GDBSTUB_INF_SUCCESS
+            && !pTp)
+        {
+            for (uint32_t i = 0; i < pThis->cTracePoints && !pTp; i++)
+            {
+                if (!pThis->paTracePoints[i].fUsed)
+                    pTp = &pThis->paTracePoints[i];
+            }
+
+            if (!pTp)
+                rc = GDBSTUB_ERR_BUFFER_OVERFLOW;
+        }
+
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            pTp->fUsed        = true;
+            pTp->fEnabled     = chEnabled == 'E';
+            pTp->uNum         = (uint32_t)uNum;
+            pTp->GdbTgtTpAddr = GdbTgtTpAddr;
+            pTp->uKind        = s_auGdbArchBpKind[GDBSTUBIF_ARCH(pThis->pIf)];
+            pTp->cPass        = cPass;
+            pTp->cHits        = 0;
+            pTp->cbCond       = 0;
+            pTp->cbActions    = 0;
+
+            /* Optional fast tracepoint instruction length (treated like a normal tracepoint) and condition. */
+            while (   rc == GDBSTUB_INF_SUCCESS
+                   && gdbStubCtxParseChr(&pbArgs, &cbArgs, ':'))
+            {
+                uint64_t cbInstr = 0;
+
+                if (gdbStubCtxParseChr(&pbArgs, &cbArgs, 'F'))
+                    rc = gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cbInstr);
+                else if (   gdbStubCtxParseChr(&pbArgs, &cbArgs, 'X')
+                         && !pTp->cbCond)
+                    rc = gdbStubCtxTracePointExprParse(pThis, pTp, &pbArgs, &cbArgs, true /*fCond*/);
+                else
+                    rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+            }
+
+            /* A trailing '-' announces actions in further packets. */
+            gdbStubCtxParseChr(&pbArgs, &cbArgs, '-');
+            if (   rc == GDBSTUB_INF_SUCCESS
+                && !gdbStubCtxParseChr(&pbArgs, &cbArgs, GDBSTUB_PKT_END))
+                rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+            if (rc != GDBSTUB_INF_SUCCESS)
+                pTp->fUsed = false;
+        }
+    }
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendOk(pThis);
+
+    return gdbStubCtxReplySendErrSts(pThis, rc);
+}
+
+
+/**
+ * Processes the 'QTinit' set packet, deleting all tracepoints and trace frames.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetTinit(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    if (!pThis->cTracePoints)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    gdbStubCtxTraceStop(pThis, GDBSTUBTRACESTOP_NOT_RUN, 0);
+    for (uint32_t i = 0; i < pThis->cTracePoints; i++)
+        pThis->paTracePoints[i].fUsed = false;
+    gdbStubCtxTraceBufReset(pThis);
+    pThis->enmTraceStop = GDBSTUBTRACESTOP_NOT_RUN;
+    pThis->uTraceStopTp = 0;
+
+    return gdbStubCtxReplySendOk(pThis);
+}
+
+
+/**
+ * Processes the 'QTStart' set packet, discarding all trace frames and setting the tracepoints in the target.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetTStart(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    if (!pThis->cTracePoints)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    gdbStubCtxTraceStop(pThis, GDBSTUBTRACESTOP_NOT_RUN, 0);
+    gdbStubCtxTraceBufReset(pThis);
+    for (uint32_t i = 0; i < pThis->cTracePoints; i++)
+        pThis->paTracePoints[i].cHits = 0;
+
+    int rc = gdbStubCtxTracePointsArm(pThis, true /*fSet*/);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        pThis->fTraceRunning = true;
+        pThis->enmTraceStop  = GDBSTUBTRACESTOP_NOT_RUN;
+        pThis->uTraceStopTp  = 0;
+        rc = gdbStubCtxReplySendOk(pThis);
+    }
+    else
+        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+
+    return rc;
+}
+
+
+/**
+ * Processes the 'QTStop' set packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetTStop(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    if (!pThis->cTracePoints)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    gdbStubCtxTraceStop(pThis, GDBSTUBTRACESTOP_USER, 0);
+    return gdbStubCtxReplySendOk(pThis);
+}
+
+
+/**
+ * Processes the 'QTFrame' set packet, selecting the trace frame register and memory accesses are served from.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetTFrame(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    static const char *s_apszKinds[] = { "pc:", "tdp:", "range:", "outside:" };
+    uint64_t uStart = 0;
+    uint64_t uEnd = 0;
+    uint32_t idxKind = 0;
+
+    if (!pThis->cTracePoints)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    if (!gdbStubCtxParseChr(&pbArgs, &cbArgs, ':'))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    /* Either a frame number or a search for the next frame matching the given criteria. */
+    for (idxKind = 0; idxKind < ELEMENTS(s_apszKinds); idxKind++)
+    {
+        size_t cchKind = gdbStubStrlen(s_apszKinds[idxKind]);
+        if (   cbArgs > cchKind
+            && !gdbStubMemcmp(pbArgs, s_apszKinds[idxKind], cchKind))
+        {
+            pbArgs += cchKind;
+            cbArgs -= cchKind;
+            break;
+        }
+    }
+
+    bool fDeselect = idxKind == ELEMENTS(s_apszKinds) && gdbStubCtxParseChr(&pbArgs, &cbArgs, '-');
+    if (   gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &uStart) != GDBSTUB_INF_SUCCESS
+        || (   idxKind >= 2
+            && idxKind < ELEMENTS(s_apszKinds)
+            && (   !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+                || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &uEnd) != GDBSTUB_INF_SUCCESS))
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, GDBSTUB_PKT_END))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    /* Searches start after the selected frame. */
+    uint32_t idFrame = pThis->idTraceFrameSel != UINT32_MAX ? pThis->idTraceFrameSel + 1 : pThis->cTraceFramesDropped;
+    uint32_t idFrameEnd = pThis->cTraceFramesDropped + pThis->cTraceFrames;
+    size_t offFrame = 0;
+    bool fFound = false;
+
+    pThis->idTraceFrameSel = UINT32_MAX;
+    if (idxKind == ELEMENTS(s_apszKinds))
+        fFound =    !fDeselect
+                 && uStart < UINT32_MAX
+                 && gdbStubCtxTraceFrameFind(pThis, (uint32_t)uStart, &offFrame);
+    else if (gdbStubCtxTraceFrameFind(pThis, idFrame, &offFrame))
+    {
+        for (; idFrame < idFrameEnd && !fFound; idFrame++)
+        {
+            if (idxKind == 1)
+                fFound = gdbStubValFromLe(&pThis->pbTraceBuf[offFrame], sizeof(uint16_t)) == uStart;
+            else
+            {
+                uint64_t uPc = 0;
+
+                gdbStubCtxTraceFrameRegsRead(pThis, offFrame, &pThis->idxRegPc, 1, pThis->pvRegsScratch);
+                uPc = gdbStubValFromLe((const uint8_t *)pThis->pvRegsScratch, GDBSTUBIF_REGS(pThis->pIf)[pThis->idxRegPc].cRegBits / 8);
+                if (idxKind == 0)
+                    fFound = uPc == uStart;
+                else
+                    fFound = (uPc >= uStart && uPc <= uEnd) == (idxKind == 2);
+            }
+
+            if (!fFound)
+                offFrame = gdbStubCtxTraceFrameNext(pThis, offFrame);
+        }
+        idFrame--;
+        uStart = idFrame;
+    }
+
+    if (!fFound)
+        return gdbStubCtxReplySend(pThis, (const uint8_t *)"F-1", 3);
+
+    pThis->idTraceFrameSel  = (uint32_t)uStart;
+    pThis->offTraceFrameSel = offFrame;
+
+    char achReply[2 + 2 * 16];
+    size_t cchReply = gdbStubCtxFmtPrefixedHexU64(&achReply[0], "F", uStart);
+    cchReply += gdbStubCtxFmtPrefixedHexU64(&achReply[cchReply], "T", gdbStubValFromLe(&pThis->pbTraceBuf[offFrame], sizeof(uint16_t)));
+    return gdbStubCtxReplySend(pThis, (const uint8_t *)&achReply[0], cchReply);
+}
+
+
+/**
+ * Processes the 'QTBuffer' set packet, only selecting whether the trace buffer is circular is supported.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessSetTBuffer(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    uint64_t fCircular = 0;
+
+    if (   !pThis->cTracePoints
+        || cbArgs <= sizeof(":circular:") - 1
+        || gdbStubMemcmp(pbArgs, ":circular:", sizeof(":circular:") - 1))
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    pbArgs += sizeof(":circular:") - 1;
+    cbArgs -= sizeof(":circular:") - 1;
+    if (   gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &fCircular) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, GDBSTUB_PKT_END))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    pThis->fTraceCircular = fCircular != 0;
+    return gdbStubCtxReplySendOk(pThis);
+}
+#endif /* !GDBSTUB_WITHOUT_TRACEPOINTS */
+
+
+/**
+ * List of supported general set packets.
+ */
+static const GDBSTUBQPKTPROC g_aQSetPktProcs[] =
+{
+#define GDBSTUBQPKTPROC_INIT(a_Name, a_pfnProc) { a_Name, sizeof(a_Name) - 1, a_pfnProc }
+    GDBSTUBQPKTPROC_INIT("StartNoAckMode",     gdbStubCtxPktProcessSetStartNoAckMode),
+#if !defined(GDBSTUB_WITHOUT_NON_STOP)
+    GDBSTUBQPKTPROC_INIT("NonStop",            gdbStubCtxPktProcessSetNonStop),
+#endif
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+    GDBSTUBQPKTPROC_INIT("TDP",                gdbStubCtxPktProcessSetTDP),
+    GDBSTUBQPKTPROC_INIT("Tinit",              gdbStubCtxPktProcessSetTinit),
+    GDBSTUBQPKTPROC_INIT("TStart",             gdbStubCtxPktProcessSetTStart),
+    GDBSTUBQPKTPROC_INIT("TStop",              gdbStubCtxPktProcessSetTStop),
+    GDBSTUBQPKTPROC_INIT("TFrame",             gdbStubCtxPktProcessSetTFrame),
+    GDBSTUBQPKTPROC_INIT("TBuffer",            gdbStubCtxPktProcessSetTBuffer),
+#endif
+#undef GDBSTUBQPKTPROC_INIT
+};
+
+
+/**
+ * Processes a 'Q' packet, sending the appropriate reply.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbSet               The set packet data (without the 'Q').
+ * @param   cbSet               Size of the remaining set packet in bytes.
+ */
+static int gdbStubCtxPktProcessSet(PGDBSTUBCTXINT pThis, const uint8_t *pbSet, size_t cbSet)
+{
+    /* Search the packet and execute the processor or return an empty reply if not supported. */
+    size_t cchName = gdbStubPktNameLen(pbSet, ":,;");
+    uint32_t idxProc = gdbStubNameIdxLookup(&pThis->IdxQSetPktProcs, &g_aQSetPktProcs[0], sizeof(g_aQSetPktProcs[0]),
+                                            pbSet, cchName);
+    if (idxProc != UINT32_MAX)
+        return g_aQSetPktProcs[idxProc].pfnProc(pThis, pbSet + cchName, cbSet - cchName);
+
+    return gdbStubCtxReplySend(pThis, NULL, 0);
+}
+
+
+/**
+ * Parses the next action of a 'vCont' packet.
+ *
+ * @returns Status code.
+ * @param   ppbArgs             Pointer to the start of the action (the ';' preceding it), updated to point after the action on success.
+ * @param   pcbArgs             Pointer to the number of bytes left in the packet, updated on success.
+ * @param   penmAction          Where to store the action.
+ * @param   pidThrd             Where to store the thread the action applies to, GDBTGTTHRDID_ALL if none is given.
+ *
+ * @note The signal to deliver with the 'C' and 'S' actions is ignored.
+ */
+static int gdbStubCtxVContActionParse(const uint8_t **ppbArgs, size_t *pcbArgs, GDBSTUBTHRDACTION *penmAction, GDBTGTTHRDID *pidThrd)
+{
+    const uint8_t *pbArgs = *ppbArgs;
+    size_t cbArgs = *pcbArgs;
+
+    if (   cbArgs < 2
+        || pbArgs[0] != ';')
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    uint8_t chAction = pbArgs[1];
+    pbArgs += 2;
+    cbArgs -= 2;
+
+    switch (chAction)
+    {
+        case 'c':
+        case 'C':
+            *penmAction = GDBSTUBTHRDACTION_CONTINUE;
+            break;
+        case 's':
+        case 'S':
+            *penmAction = GDBSTUBTHRDACTION_STEP;
+            break;
+        case 't':
+            *penmAction = GDBSTUBTHRDACTION_STOP;
+            break;
+        default:
+            return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+    }
+
+    if (   chAction == 'C'
+        || chAction == 'S')
+    {
+        while (   cbArgs
+               && gdbStubCtxChrToHex(*pbArgs) != 0xff)
+        {
+            pbArgs++;
+            cbArgs--;
+        }
+    }
+
+    *pidThrd = GDBTGTTHRDID_ALL;
+    if (   cbArgs
+        && *pbArgs == ':')
+    {
+        const uint8_t *pbEnd = NULL;
+        int rc = gdbStubCtxParseThrdId(pbArgs + 1, cbArgs - 1, pidThrd, &pbEnd);
+        if (rc != GDBSTUB_INF_SUCCESS)
+            return rc;
+
+        cbArgs -= pbEnd - pbArgs;
+        pbArgs  = pbEnd;
+    }
+
+    /* The next action or the end of the packet must follow. */
+    if (   !cbArgs
+        || (   *pbArgs != ';'
+            && *pbArgs != GDBSTUB_PKT_END))
+        return GDBSTUB_ERR_PROTOCOL_VIOLATION;
+
+    *ppbArgs = pbArgs;
+    *pcbArgs = cbArgs;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Returns the action of a (validated) 'vCont' action list applying to the given thread.
+ *
+ * @returns Action, GDBSTUBTHRDACTION_INVALID if no action applies to the thread.
+ * @param   pbArgs              Pointer to the start of the action list.
+ * @param   cbArgs              Size of the action list in bytes.
+ * @param   idThrd              The thread to look for.
+ *
+ * @note Like specified by the protocol the leftmost action matching the thread wins.
+ */
+static GDBSTUBTHRDACTION gdbStubCtxVContActionForThrd(const uint8_t *pbArgs, size_t cbArgs, GDBTGTTHRDID idThrd)
+{
+    while (   cbArgs
+           && *pbArgs == ';')
+    {
+        GDBSTUBTHRDACTION enmAction = GDBSTUBTHRDACTION_INVALID;
+        GDBTGTTHRDID idThrdAction = GDBTGTTHRDID_ALL;
+
+        if (gdbStubCtxVContActionParse(&pbArgs, &cbArgs, &enmAction, &idThrdAction) != GDBSTUB_INF_SUCCESS)
+            break;
+
+        if (   idThrdAction == GDBTGTTHRDID_ALL
+            || idThrdAction == GDBTGTTHRDID_ANY
+            || idThrdAction == idThrd)
+            return enmAction;
+    }
+
+    return GDBSTUBTHRDACTION_INVALID;
+}
+
+
+/**
+ * Applies a (validated) 'vCont' action list to all threads of the target.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the action list.
+ * @param   cbArgs              Size of the action list in bytes.
+ * @param   pfResumed           Where to store the flag whether at least one thread was resumed.
+ */
+static int gdbStubCtxVContApply(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs, bool *pfResumed)
+{
+    /* Write back modified registers before any thread executes code. */
+    int rc = gdbStubCtxRegsCacheFlush(pThis);
+    if (rc != GDBSTUB_INF_SUCCESS)
+        return rc;
+
+    gdbStubCtxCachesInvalidate(pThis);
+
+    GDBTGTTHRDID aidThrds[32];
+    uint32_t idxStart = 0;
+    uint32_t cThrds = 0;
+    do
+    {
+        rc = gdbStubCtxIfTgtThrdsQuery(pThis, idxStart, &aidThrds[0], ELEMENTS(aidThrds), &cThrds);
+        for (uint32_t i = 0; i < cThrds && rc == GDBSTUB_INF_SUCCESS; i++)
+        {
+            /* Threads without a matching action keep their state. */
+            GDBSTUBTHRDACTION enmAction = gdbStubCtxVContActionForThrd(pbArgs, cbArgs, aidThrds[i]);
+            if (enmAction != GDBSTUBTHRDACTION_INVALID)
+            {
+                rc = gdbStubCtxIfTgtThrdAction(pThis, aidThrds[i], enmAction);
+                if (enmAction != GDBSTUBTHRDACTION_STOP)
+                    *pfResumed = true;
+                if (enmAction == GDBSTUBTHRDACTION_STEP)
+                    pThis->fStepPending = true;
+            }
+        }
+
+        idxStart += cThrds;
+    } while (   rc == GDBSTUB_INF_SUCCESS
+             && cThrds);
+
+    return rc;
+}
+
+
+/**
+ * Processes a 'vCont[;action[:thread-id]]...' packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessVCont(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* Validate the whole action list upfront so nothing gets applied for a malformed packet. */
+    GDBSTUBTHRDACTION enmActionFirst = GDBSTUBTHRDACTION_INVALID;
+    const uint8_t *pbCur = pbArgs;
+    size_t cbCur = cbArgs;
+    do
+    {
+        GDBSTUBTHRDACTION enmAction = GDBSTUBTHRDACTION_INVALID;
+        GDBTGTTHRDID idThrd = GDBTGTTHRDID_ALL;
+
+        rc = gdbStubCtxVContActionParse(&pbCur, &cbCur, &enmAction, &idThrd);
+        if (enmActionFirst == GDBSTUBTHRDACTION_INVALID)
+            enmActionFirst = enmAction;
+    } while (   rc == GDBSTUB_INF_SUCCESS
+             && *pbCur == ';');
+
+    if (rc != GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS)
+    {
+        bool fResumed = false;
+
+        /* All stops are reported through GDBStubCtxNotifyThrdStop(), in non-stop mode the packet is acknowledged right away. */
+        rc = gdbStubCtxVContApply(pThis, pbArgs, cbArgs, &fResumed);
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+                rc = gdbStubCtxReplySendOk(pThis);
+            else if (fResumed)
+                pThis->enmTgtStateLast = GDBSTUBTGTSTATE_RUNNING;
+        }
+        else
+            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+
+        return rc;
+    }
+
+    /* Without thread support the first action applies to the whole target. */
+    switch (enmActionFirst)
+    {
+        case GDBSTUBTHRDACTION_CONTINUE:
+        {
+            rc = gdbStubCtxTgtResume(pThis, false /*fStep*/);
+            if (rc == GDBSTUB_INF_SUCCESS)
+                pThis->enmTgtStateLast = GDBSTUBTGTSTATE_RUNNING;
+            break;
+        }
+        case GDBSTUBTHRDACTION_STEP:
+        {
+            rc = gdbStubCtxTgtResume(pThis, true /*fStep*/);
+            if (rc == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxReplySendSigTrap(pThis);
+            break;
+        }
+        case GDBSTUBTHRDACTION_STOP:
+        {
+            rc = gdbStubCtxIfTgtStop(pThis);
+            if (rc == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxReplySendSigTrap(pThis);
+            break;
+        }
+        default:
+            rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+    }
+
+    return rc;
+}
+
+
+/**
+ * Sends the next stop waiting to be collected by the remote end in non-stop mode, or the OK reply if there is none.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxReplySendStopNext(PGDBSTUBCTXINT pThis)
+{
+    GDBTGTTHRDID idThrd = GDBTGTTHRDID_ANY;
+    GDBSTUBSTOPREASON enmReason = GDBSTUBSTOPREASON_INVALID;
+
+    while (gdbStubCtxStopEvtDequeue(pThis, &idThrd, &enmReason))
+    {
+        if (gdbStubCtxStopConsume(pThis, idThrd, enmReason))
+            continue;
+
+        gdbStubCtxCachesInvalidate(pThis);
+        return gdbStubCtxReplySendStop(pThis, gdbStubCtxStopReasonToSignal(enmReason), idThrd, false /*fNotify*/);
+    }
+
+    /* Everything was collected, the next stop gets announced through a notification again. */
+    pThis->fStopNotifyInFlight = false;
+    return gdbStubCtxReplySendOk(pThis);
+}
+
+
+/**
+ * Reports the stops of all stopped threads in non-stop mode (the reply to '?'), the remote end collects
+ * the remaining ones through 'vStopped'.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxReplySendStopAll(PGDBSTUBCTXINT pThis)
+{
+    /*
+     * Stops waiting to be collected keep their reason, every other stopped thread gets queued
+     * once as stopped on request.
+     */
+    gdbStubCtxEvtQueueDrain(pThis);
+
+    GDBTGTTHRDID aidThrds[32];
+    uint32_t idxStart = 0;
+    uint32_t cThrds = 0;
+    int rc = GDBSTUB_INF_SUCCESS;
+    do
+    {
+        rc = gdbStubCtxIfTgtThrdsQuery(pThis, idxStart, &aidThrds[0], ELEMENTS(aidThrds), &cThrds);
+        for (uint32_t i = 0; i < cThrds && rc == GDBSTUB_INF_SUCCESS; i++)
+        {
+            if (   gdbStubCtxIfTgtThrdGetState(pThis, aidThrds[i]) == GDBSTUBTGTSTATE_STOPPED
+                && !gdbStubCtxStopEvtIsPending(pThis, aidThrds[i]))
+            {
+                if (!gdbStubCtxStopEvtPush(pThis, aidThrds[i], GDBSTUBSTOPREASON_STOP_REQUEST))
+                    rc = GDBSTUB_ERR_BUFFER_OVERFLOW;
+            }
+        }
+
+        idxStart += cThrds;
+    } while (   rc == GDBSTUB_INF_SUCCESS
+             && cThrds);
+
+    if (rc != GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendErrSts(pThis, rc);
+
+    pThis->fStopNotifyInFlight = true;
+    return gdbStubCtxReplySendStopNext(pThis);
+}
+
+
+#if !defined(GDBSTUB_WITHOUT_NON_STOP)
+/**
+ * Processes a 'vStopped' packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessVStopped(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP))
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    return gdbStubCtxReplySendStopNext(pThis);
+}
+#endif /* !GDBSTUB_WITHOUT_NON_STOP */
+
+
+#if !defined(GDBSTUB_WITHOUT_FLASH)
+/**
+ * Returns the memory region containing the given address.
+ *
+ * @returns Pointer to the memory region or NULL if the address is outside of all regions.
+ * @param   pThis               The GDB stub context.
+ * @param   GdbTgtMemAddr       The target memory address to look up.
+ */
+static PCGDBSTUBMEMREGION gdbStubCtxMemRegionFind(PGDBSTUBCTXINT pThis, GDBTGTMEMADDR GdbTgtMemAddr)
+{
+    for (PCGDBSTUBMEMREGION pRegion = &pThis->pIf->paMemRegions[0]; pRegion->cbRegion; pRegion++)
+    {
+        if (   GdbTgtMemAddr >= pRegion->GdbTgtMemAddrStart
+            && GdbTgtMemAddr - pRegion->GdbTgtMemAddrStart < pRegion->cbRegion)
+            return pRegion;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Hands the pending flash erase block to the target.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxFlashBlockFlush(PGDBSTUBCTXINT pThis)
+{
+    if (!pThis->cbFlashBlock)
+        return GDBSTUB_INF_SUCCESS;
+
+    /* The block is gone even if the write fails, the remote end aborts the flash operation anyway. */
+    int rc = gdbStubCtxIfTgtFlashWrite(pThis, pThis->GdbTgtMemAddrFlashBlock, pThis->pbFlashBlock, pThis->cbFlashBlock);
+    gdbStubCtxMemCacheInvalidateRange(pThis, pThis->GdbTgtMemAddrFlashBlock, pThis->cbFlashBlock);
+    pThis->cbFlashBlock = 0;
+    return rc;
+}
+
+
+/**
+ * Processes a 'vFlashErase' packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessVFlashErase(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    uint64_t GdbTgtAddr = 0;
+    uint64_t cbErase = 0;
+
+    if (!pThis->pbFlashBlock)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    if (   !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &GdbTgtAddr) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ',')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &cbErase) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, GDBSTUB_PKT_END))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    /* The remote end aligns the range to the erase blocks of a single region according to the memory map. */
+    int rc = GDBSTUB_INF_SUCCESS;
+    PCGDBSTUBMEMREGION pRegion = gdbStubCtxMemRegionFind(pThis, GdbTgtAddr);
+    if (   !pRegion
+        || pRegion->enmType != GDBSTUBMEMREGIONTYPE_FLASH
+        || (GdbTgtAddr - pRegion->GdbTgtMemAddrStart) % pRegion->cbBlock
+        || cbErase % pRegion->cbBlock
+        || cbErase > pRegion->cbRegion - (GdbTgtAddr - pRegion->GdbTgtMemAddrStart))
+        rc = GDBSTUB_ERR_INVALID_PARAMETER;
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxFlashBlockFlush(pThis);
+    if (   rc == GDBSTUB_INF_SUCCESS
+        && cbErase)
+    {
+        rc = gdbStubCtxIfTgtFlashErase(pThis, GdbTgtAddr, (size_t)cbErase);
+        gdbStubCtxMemCacheInvalidateRange(pThis, GdbTgtAddr, (size_t)cbErase);
+    }
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendOk(pThis);
+
+    return gdbStubCtxReplySendErrSts(pThis, rc);
+}
+
+
+/**
+ * Processes a 'vFlashWrite' packet, merging the data into the erase block buffer.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessVFlashWrite(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    uint64_t GdbTgtAddr = 0;
+
+    if (!pThis->pbFlashBlock)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    if (   !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':')
+        || gdbStubCtxParseHexNumber(&pbArgs, &cbArgs, &GdbTgtAddr) != GDBSTUB_INF_SUCCESS
+        || !gdbStubCtxParseChr(&pbArgs, &cbArgs, ':'))
+        return gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+
+    /* The data goes up to the end character, decode it in place like for 'X'. */
+    uint8_t *pbData = (uint8_t *)pbArgs;
+    size_t cbData = 0;
+    int rc = gdbStubCtxDecodeBinaryInPlace(pbData, cbArgs - 1, &cbData);
+
+    /*
+     * The remote end writes the data in ascending order, so a block is complete once a write to
+     * another block arrives. A block which is only written partially keeps the rest of its current content.
+     */
+    while (   cbData
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        PCGDBSTUBMEMREGION pRegion = gdbStubCtxMemRegionFind(pThis, GdbTgtAddr);
+        if (   !pRegion
+            || pRegion->enmType != GDBSTUBMEMREGIONTYPE_FLASH)
+        {
+            rc = GDBSTUB_ERR_INVALID_PARAMETER;
+            break;
+        }
+
+        GDBTGTMEMADDR GdbTgtAddrBlock = GdbTgtAddr - (GdbTgtAddr - pRegion->GdbTgtMemAddrStart) % pRegion->cbBlock;
+        size_t offBlock = (size_t)(GdbTgtAddr - GdbTgtAddrBlock);
+        size_t cbThisWrite = MIN(cbData, pRegion->cbBlock - offBlock);
+
+        if (   pThis->cbFlashBlock
+            && pThis->GdbTgtMemAddrFlashBlock != GdbTgtAddrBlock)
+            rc = gdbStubCtxFlashBlockFlush(pThis);
+        if (   rc == GDBSTUB_INF_SUCCESS
+            && !pThis->cbFlashBlock)
+        {
+            if (   cbThisWrite != pRegion->cbBlock
+                && gdbStubCtxIfTgtMemRead(pThis, GdbTgtAddrBlock, pThis->pbFlashBlock, pRegion->cbBlock) != GDBSTUB_INF_SUCCESS)
+                gdbStubCtxMemset(pThis->pbFlashBlock, 0xff, pRegion->cbBlock);
+
+            pThis->GdbTgtMemAddrFlashBlock = GdbTgtAddrBlock;
+            pThis->cbFlashBlock            = pRegion->cbBlock;
+        }
+
+        if (rc == GDBSTUB_INF_SUCCESS)
+        {
+            gdbStubCtxMemcpy(&pThis->pbFlashBlock[offBlock], pbData, cbThisWrite);
+            GdbTgtAddr += cbThisWrite;
+            pbData     += cbThisWrite;
+            cbData     -= cbThisWrite;
+        }
+    }
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendOk(pThis);
+
+    return gdbStubCtxReplySendErrSts(pThis, rc);
+}
+
+
+/**
+ * Processes a 'vFlashDone' packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbArgs              Pointer to the start of the arguments in the packet.
+ * @param   cbArgs              Size of arguments in bytes.
+ */
+static int gdbStubCtxPktProcessVFlashDone(PGDBSTUBCTXINT pThis, const uint8_t *pbArgs, size_t cbArgs)
+{
+    (void)pbArgs;
+    (void)cbArgs;
+
+    if (!pThis->pbFlashBlock)
+        return gdbStubCtxReplySend(pThis, NULL, 0);
+
+    int rc = gdbStubCtxFlashBlockFlush(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxIfTgtFlashDone(pThis);
+
+    if (rc == GDBSTUB_INF_SUCCESS)
+        return gdbStubCtxReplySendOk(pThis);
+
+    return gdbStubCtxReplySendErrSts(pThis, rc);
+}
+#endif /* !GDBSTUB_WITHOUT_FLASH */
+
+
+/**
+ * List of supported 'v<identifier>' packets.
+ */
+static const GDBSTUBVPKTPROC g_aVPktProcs[] =
+{
+#define GDBSTUBVPKTPROC_INIT(a_Name, a_pszReply, a_pfnProc) { a_Name, sizeof(a_Name) - 1, a_pszReply, sizeof(a_pszReply) - 1, a_pfnProc }
+    GDBSTUBVPKTPROC_INIT("Cont",       "vCont;c;C;s;S;t", gdbStubCtxPktProcessVCont),
+#if !defined(GDBSTUB_WITHOUT_NON_STOP)
+    GDBSTUBVPKTPROC_INIT("Stopped",    "",                gdbStubCtxPktProcessVStopped),
+#endif
+#if !defined(GDBSTUB_WITHOUT_FLASH)
+    GDBSTUBVPKTPROC_INIT("FlashErase", "",                gdbStubCtxPktProcessVFlashErase),
+    GDBSTUBVPKTPROC_INIT("FlashWrite", "",                gdbStubCtxPktProcessVFlashWrite),
+    GDBSTUBVPKTPROC_INIT("FlashDone",  "",                gdbStubCtxPktProcessVFlashDone),
+#endif
+#undef GDBSTUBVPKTPROC_INIT
+};
+
+
+/**
+ * Processes a 'v<identifier>' packet, sending the appropriate reply.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   pbPktRem            The remaining packet data (without the 'v').
+ * @param   cbPktRem            Size of the remaining packet in bytes.
+ */
+static int gdbStubCtxPktProcessV(PGDBSTUBCTXINT pThis, const uint8_t *pbPktRem, size_t cbPktRem)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* Determine the end of the identifier, delimiters are '?', ';', ':' or end of packet. */
+    size_t cchId = gdbStubPktNameLen(pbPktRem, "?;:");
+    bool fQuery = pbPktRem[cchId] == '?';
+
+    /* Search the query and execute the processor or return an empty reply if not supported. */
+    uint32_t idxProc = gdbStubNameIdxLookup(&pThis->IdxVPktProcs, &g_aVPktProcs[0], sizeof(g_aVPktProcs[0]),
+                                            pbPktRem, cchId);
+    if (idxProc != UINT32_MAX)
+    {
+        PCGDBSTUBVPKTPROC pVProc = &g_aVPktProcs[idxProc];
+
+        /* Just send the static reply for a query and execute the processor for everything else. */
+        if (fQuery)
+            return gdbStubCtxReplySend(pThis, pVProc->pszReplyQ, pVProc->cchReplyQ);
+
+        /* Execute the handler. */
+        return pVProc->pfnProc(pThis, pbPktRem + cchId, cbPktRem - cchId);
+    }
+
+    return gdbStubCtxReplySend(pThis, NULL, 0);
+}
+
+
+/**
+ * Processes a completely received packet.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxPktProcess(PGDBSTUBCTXINT pThis)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+#if defined(GDBSTUB_WITH_STATS)
+    /* Empty packets are accounted at index 0, the reply is accounted before it gets flushed. */
+    PGDBSTUBSTATSPKT pStatsPkt = &pThis->Stats.aPkts[pThis->cbPkt > 1 ? pThis->pbPktBuf[1] & (GDBSTUBSTATS_PKT_TYPES - 1) : 0];
+    uint64_t cbOutStart = pThis->Stats.cbOut + pThis->offOutBuf;
+    GDBSTUB_STATS_PROFILE_START(pThis, TsStart);
+
+    pStatsPkt->cPkts++;
+    pStatsPkt->cbIn += pThis->cbPkt + 3; /* Start and end character plus the checksum. */
+#endif
+
+    if (pThis->cbPkt >= 1)
+    {
+        switch (pThis->pbPktBuf[1])
+        {
+            case '!': /* Enabled extended mode. */
+            {
+                if (pThis->pIf->pfnTgtRestart)
+                {
+                    pThis->fExtendedMode = true;
+                    rc = gdbStubCtxReplySendOk(pThis);
+                }
+                else /* Send empty reply to indicate extended mode is unsupported. */
+                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                break;
+            }
+            case '?':
+            {
+                /* Return signal state. */
+                if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+                    rc = gdbStubCtxReplySendStopAll(pThis);
+                else
+                    rc = gdbStubCtxReplySendSigTrap(pThis);
+                break;
+            }
+            case 'H': /* Set thread for subsequent operations. */
+            {
+                GDBTGTTHRDID idThrd = GDBTGTTHRDID_ANY;
+                const uint8_t *pbEnd = NULL;
+
+                if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                else if (   pThis->cbPkt < 3
+                         || gdbStubCtxParseThrdId(&pThis->pbPktBuf[3], pThis->cbPkt - 2, &idThrd, &pbEnd) != GDBSTUB_INF_SUCCESS
+                         || *pbEnd != GDBSTUB_PKT_END)
+                    rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                else if (pThis->pbPktBuf[2] == 'g')
+                {
+                    rc = gdbStubCtxThrdSelect(pThis, idThrd);
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                        rc = gdbStubCtxReplySendOk(pThis);
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else if (pThis->pbPktBuf[2] == 'c') /* Resuming is controlled through vCont only. */
+                    rc = gdbStubCtxReplySendOk(pThis);
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                break;
+            }
+            case 'T': /* Query whether a thread is alive. */
+            {
+                GDBTGTTHRDID idThrd = GDBTGTTHRDID_ANY;
+                const uint8_t *pbEnd = NULL;
+
+                if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_THRDS))
+                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                else if (   gdbStubCtxParseThrdId(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &idThrd, &pbEnd) != GDBSTUB_INF_SUCCESS
+                         || *pbEnd != GDBSTUB_PKT_END)
+                    rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                else if (gdbStubCtxIfTgtThrdGetState(pThis, idThrd) != GDBSTUBTGTSTATE_INVALID)
+                    rc = gdbStubCtxReplySendOk(pThis);
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_NOT_FOUND);
+                break;
+            }
+            case 's': /* Single step, target stopped immediately again. */
+            {
+                rc = gdbStubCtxTgtResume(pThis, true /*fStep*/);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                    rc = gdbStubCtxReplySendSigTrap(pThis);
+                break;
+            }
+            case 'c': /* Continue, no response */
+            {
+                rc = gdbStubCtxTgtResume(pThis, false /*fStep*/);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                    pThis->enmTgtStateLast = GDBSTUBTGTSTATE_RUNNING;
+                break;
+            }
+            case 'g': /* Read general registers. */
+            {
+                /* Get at the first batch before starting the reply so an error can still be reported. */
+                uint32_t idxReg = 0;
+                size_t cbBatch = 0;
+                uint32_t cRegsBatch = gdbStubCtxRegsBatchQuery(pThis, pThis->paidxRegs, GDBSTUBCTX_REGS_COUNT(pThis), &cbBatch);
+
+                rc = gdbStubCtxRegsRead(pThis, pThis->paidxRegs, cRegsBatch, pThis->pvRegsScratch);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    /*
+                     * Encode directly into the output buffer, the packet buffer might hold data
+                     * received after this packet.
+                     */
+                    rc = gdbStubCtxReplySendBegin(pThis);
+
+                    /* A later failing read results in a short reply, the remote end treats the missing registers as unavailable. */
+                    while (   cRegsBatch
+                           && rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        rc = gdbStubCtxReplySendDataHex(pThis, pThis->pvRegsScratch, cbBatch);
+
+                        idxReg    += cRegsBatch;
+                        cRegsBatch = gdbStubCtxRegsBatchQuery(pThis, &pThis->paidxRegs[idxReg], GDBSTUBCTX_REGS_COUNT(pThis) - idxReg, &cbBatch);
+                        if (   cRegsBatch
+                            && rc == GDBSTUB_INF_SUCCESS
+                            && gdbStubCtxRegsRead(pThis, &pThis->paidxRegs[idxReg], cRegsBatch, pThis->pvRegsScratch) != GDBSTUB_INF_SUCCESS)
+                            break;
+                    }
+
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                        rc = gdbStubCtxReplySendEnd(pThis);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'G': /* Write general registers. */
+            {
+                size_t cchRegs = pThis->cbPkt - 2; /* Exclude the packet type and end character. */
+
+                /* The data must cover all registers in the same layout as returned by 'g'. */
+                if (cchRegs == GDBSTUBCTX_REGS_SIZE(pThis) * 2)
+                {
+                    /* Decode and write the registers in batches fitting into the scratch space. */
+                    const uint8_t *pbRegsHex = &pThis->pbPktBuf[2];
+                    uint32_t idxReg = 0;
+
+                    rc = GDBSTUB_INF_SUCCESS;
+                    while (   idxReg < GDBSTUBCTX_REGS_COUNT(pThis)
+                           && rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        size_t cbBatch = 0;
+                        uint32_t cRegsBatch = gdbStubCtxRegsBatchQuery(pThis, &pThis->paidxRegs[idxReg], GDBSTUBCTX_REGS_COUNT(pThis) - idxReg, &cbBatch);
+
+                        rc = gdbStubCtxParseHexStringAsByteBuf(pbRegsHex, cbBatch * 2, pThis->pvRegsScratch, cbBatch, NULL);
+                        if (rc == GDBSTUB_INF_SUCCESS)
+                            rc = gdbStubCtxRegsWrite(pThis, &pThis->paidxRegs[idxReg], cRegsBatch, pThis->pvRegsScratch);
+
+                        pbRegsHex += cbBatch * 2;
+                        idxReg    += cRegsBatch;
+                    }
+
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                        rc = gdbStubCtxReplySendOk(pThis);
+                    else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
+                        rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                break;
+            }
+            case 'm': /* Read memory. */
+            {
+                GDBTGTMEMADDR GdbTgtAddr = 0;
+                const uint8_t *pbPktSep = NULL;
+
+                rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
+                                                       ',', &pbPktSep);
                 if (rc == GDBSTUB_INF_SUCCESS)
-                    rc = gdbStubCtxReplySendSigTrap(pThis);
+                {
+                    size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
+                    size_t cbRead = 0;
+                    rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbRead, GDBSTUB_PKT_END, NULL);
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        /* The remote end has to cope with a short read if the request doesn't fit into a single packet. */
+                        cbRead = MIN(cbRead, pThis->cbPktMax / 2);
+
+                        /* Get at the first chunk before starting the reply so an error can still be reported. */
+                        uint8_t abTmp[1024];
+                        const uint8_t *pbData = NULL;
+                        size_t cbData = 0;
+                        size_t cbMapped = 0;
+                        if (cbRead)
+                            rc = gdbStubCtxTgtMemAcquire(pThis, GdbTgtAddr, cbRead, &abTmp[0], sizeof(abTmp),
+                                                         &pbData, &cbData, &cbMapped);
+                        if (rc == GDBSTUB_INF_SUCCESS)
+                        {
+                            rc = gdbStubCtxReplySendBegin(pThis);
+
+                            /* A later failing read just results in a short reply. */
+                            while (   cbData
+                                   && rc == GDBSTUB_INF_SUCCESS)
+                            {
+                                rc = gdbStubCtxReplySendDataHex(pThis, pbData, cbData);
+                                gdbStubCtxTgtMemRelease(pThis, pbData, cbMapped);
+
+                                GdbTgtAddr += cbData;
+                                cbRead     -= cbData;
+                                cbData      = 0;
+                                if (   cbRead
+                                    && rc == GDBSTUB_INF_SUCCESS
+                                    && gdbStubCtxTgtMemAcquire(pThis, GdbTgtAddr, cbRead, &abTmp[0], sizeof(abTmp),
+                                                               &pbData, &cbData, &cbMapped) != GDBSTUB_INF_SUCCESS)
+                                    break;
+                            }
+
+                            if (rc == GDBSTUB_INF_SUCCESS)
+                                rc = gdbStubCtxReplySendEnd(pThis);
+                        }
+                        else
+                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    }
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'x': /* Read memory, binary data. */
+            {
+                GDBTGTMEMADDR GdbTgtAddr = 0;
+                const uint8_t *pbPktSep = NULL;
+
+                rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
+                                                       ',', &pbPktSep);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
+                    size_t cbRead = 0;
+                    rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbRead, GDBSTUB_PKT_END, NULL);
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        /* Escaping can at most double the size, no point in reading more than that would fit. */
+                        size_t cbBudget = pThis->cbPktMax - 1; /* The 'b' prefix takes one byte. */
+                        cbRead = MIN(cbRead, cbBudget);
+
+                        /* Get at the first chunk before starting the reply so an error can still be reported. */
+                        uint8_t abTmp[1024];
+                        const uint8_t *pbData = NULL;
+                        size_t cbData = 0;
+                        size_t cbMapped = 0;
+                        if (cbRead)
+                            rc = gdbStubCtxTgtMemAcquire(pThis, GdbTgtAddr, cbRead, &abTmp[0], sizeof(abTmp),
+                                                         &pbData, &cbData, &cbMapped);
+                        if (rc == GDBSTUB_INF_SUCCESS)
+                        {
+                            uint8_t chPrefix = 'b';
+
+                            rc = gdbStubCtxReplySendBegin(pThis);
+                            if (rc == GDBSTUB_INF_SUCCESS)
+                                rc = gdbStubCtxReplySendData(pThis, &chPrefix, sizeof(chPrefix));
+
+                            /* The reply may contain less than requested if escaping exceeds the packet size or a read fails later on. */
+                            while (   cbData
+                                   && rc == GDBSTUB_INF_SUCCESS)
+                            {
+                                size_t cbEscaped = 0;
+                                size_t cbFit = gdbStubCtxBinaryEscapedFit(pbData, cbData, cbBudget, &cbEscaped);
+
+                                rc = gdbStubCtxReplySendDataBinary(pThis, pbData, cbFit);
+                                gdbStubCtxTgtMemRelease(pThis, pbData, cbMapped);
+
+                                cbBudget   -= cbEscaped;
+                                cbRead     -= cbFit;
+                                GdbTgtAddr += cbFit;
+                                if (cbFit < cbData)
+                                    break;
+
+                                cbData = 0;
+                                if (   cbRead
+                                    && rc == GDBSTUB_INF_SUCCESS
+                                    && gdbStubCtxTgtMemAcquire(pThis, GdbTgtAddr, cbRead, &abTmp[0], sizeof(abTmp),
+                                                               &pbData, &cbData, &cbMapped) != GDBSTUB_INF_SUCCESS)
+                                    break;
+                            }
+
+                            if (rc == GDBSTUB_INF_SUCCESS)
+                                rc = gdbStubCtxReplySendEnd(pThis);
+                        }
+                        else
+                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    }
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'M': /* Write memory. */
+            {
+                GDBTGTMEMADDR GdbTgtAddr = 0;
+                const uint8_t *pbPktSep = NULL;
+
+                rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
+                                                       ',', &pbPktSep);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
+                    size_t cbWrite = 0;
+                    rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbWrite, ':', &pbPktSep);
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
+                        const uint8_t *pbDataCur = pbPktSep + 1;
+                        size_t cbDataLeft = pThis->cbPkt - 1 - cbProcessed - 1 - 1;
+
+                        while (   cbWrite
+                               && !rc)
+                        {
+                            uint8_t abTmp[4096];
+                            size_t cbThisWrite = MIN(cbWrite, sizeof(abTmp));
+                            size_t cbDecoded = 0;
+
+                            rc = gdbStubCtxParseHexStringAsByteBuf(pbDataCur, cbDataLeft, &abTmp[0], cbThisWrite, &cbDecoded);
+                            if (!rc)
+                                rc = gdbStubCtxTgtMemWrite(pThis, GdbTgtAddr, &abTmp[0], cbThisWrite);
+
+                            GdbTgtAddr += cbThisWrite;
+                            cbWrite    -= cbThisWrite;
+                            pbDataCur  += cbDecoded;
+                            cbDataLeft -= cbDecoded;
+                        }
+
+                        if (rc == GDBSTUB_INF_SUCCESS)
+                            rc = gdbStubCtxReplySendOk(pThis);
+                        else
+                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    }
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'X': /* Write memory, binary data. */
+            {
+                GDBTGTMEMADDR GdbTgtAddr = 0;
+                const uint8_t *pbPktSep = NULL;
+
+                rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
+                                                       ',', &pbPktSep);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
+                    size_t cbWrite = 0;
+                    rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbWrite, ':', &pbPktSep);
+                    if (   rc == GDBSTUB_INF_SUCCESS
+                        && *pbPktSep == ':')
+                    {
+                        /* The data goes up to the end character, decode it in place and hand it to the target directly. */
+                        uint8_t *pbData = (uint8_t *)pbPktSep + 1;
+                        size_t cbDecoded = 0;
+
+                        rc = gdbStubCtxDecodeBinaryInPlace(pbData, &pThis->pbPktBuf[pThis->cbPkt] - pbData, &cbDecoded);
+                        if (   rc == GDBSTUB_INF_SUCCESS
+                            && cbDecoded != cbWrite)
+                            rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+                        if (   rc == GDBSTUB_INF_SUCCESS
+                            && cbWrite) /* GDB probes for support with an empty write. */
+                            rc = gdbStubCtxTgtMemWrite(pThis, GdbTgtAddr, pbData, cbWrite);
+
+                        if (rc == GDBSTUB_INF_SUCCESS)
+                            rc = gdbStubCtxReplySendOk(pThis);
+                        else
+                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    }
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'p': /* Read a single register */
+            {
+                uint64_t uReg = 0;
+                int rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &uReg,
+                                                           GDBSTUB_PKT_END, NULL);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    uint32_t idxReg = (uint32_t)uReg;
+
+                    if (idxReg < GDBSTUBCTX_REGS_COUNT(pThis))
+                    {
+                        rc = gdbStubCtxRegsRead(pThis, &idxReg, 1, pThis->pvRegsScratch);
+                        if (rc == GDBSTUB_INF_SUCCESS)
+                        {
+                            size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8;
+
+                            rc = gdbStubCtxReplySendBegin(pThis);
+                            if (rc == GDBSTUB_INF_SUCCESS)
+                                rc = gdbStubCtxReplySendDataHex(pThis, pThis->pvRegsScratch, cbReg);
+                            if (rc == GDBSTUB_INF_SUCCESS)
+                                rc = gdbStubCtxReplySendEnd(pThis);
+                        }
+                        else
+                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    }
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'P': /* Write a single register */
+            {
+                uint64_t uReg = 0;
+                const uint8_t *pbPktSep = NULL;
+                rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &uReg,
+                                                       '=', &pbPktSep);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    uint32_t idxReg = (uint32_t)uReg;
+
+                    if (idxReg < GDBSTUBCTX_REGS_COUNT(pThis))
+                    {
+                        size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
+                        size_t cchVal = pThis->cbPkt - 1 - cbProcessed - 2; /* Exclude the separator and end character. */
+                        size_t cbReg = GDBSTUBIF_REGS(pThis->pIf)[idxReg].cRegBits / 8;
+
+                        /* The value must have exactly the size of the register. */
+                        if (cchVal == cbReg * 2)
+                        {
+                            rc = gdbStubCtxParseHexStringAsByteBuf(pbPktSep + 1, cchVal, pThis->pvRegsScratch, cbReg, NULL);
+                            if (rc == GDBSTUB_INF_SUCCESS)
+                            {
+                                rc = gdbStubCtxRegsWrite(pThis, &idxReg, 1, pThis->pvRegsScratch);
+                                if (rc == GDBSTUB_INF_SUCCESS)
+                                    rc = gdbStubCtxReplySendOk(pThis);
+                                else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
+                                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                                else
+                                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                            }
+                            else
+                                rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                        }
+                        else
+                            rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                    }
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'Z': /* Insert a breakpoint/watchpoint. */
+            {
+                GDBSTUBTPTYPE enmTpType = 0;
+                GDBTGTMEMADDR GdbTgtTpAddr = 0;
+                uint64_t      uKind = 0;
+                const uint8_t *pbCondList = NULL;
+                size_t        cbCondList = 0;
+
+                rc = gdbStubCtxParseTpPktArgs(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &enmTpType, &GdbTgtTpAddr, &uKind,
+                                              &pbCondList, &cbCondList);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    /*
+                     * Setting an existing breakpoint again replaces its conditions, conditions are only
+                     * supported for breakpoints and only sent by the remote end if enabled.
+                     */
+                    if (!pbCondList)
+                    {
+                        PGDBSTUBBPCOND pBpCond = gdbStubCtxBpCondFind(pThis, GdbTgtTpAddr, enmTpType);
+                        if (pBpCond)
+                            gdbStubCtxBpCondFree(pThis, pBpCond);
+                    }
+                    else if (   pThis->cBpConds
+                             && (   enmTpType == GDBSTUBTPTYPE_EXEC_SW
+                                 || enmTpType == GDBSTUBTPTYPE_EXEC_HW))
+                        rc = gdbStubCtxBpCondSet(pThis, GdbTgtTpAddr, enmTpType, pbCondList, cbCondList);
+                    else
+                        rc = GDBSTUB_ERR_PROTOCOL_VIOLATION;
+                }
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    /* Software breakpoints are usually implemented by patching the target memory. */
+                    if (enmTpType == GDBSTUBTPTYPE_EXEC_SW)
+                        gdbStubCtxMemCacheInvalidateRange(pThis, GdbTgtTpAddr, uKind ? (size_t)uKind : 1);
+
+                    rc = gdbStubCtxIfTgtTpSet(pThis, GdbTgtTpAddr, enmTpType, uKind, GDBSTUBTPACTION_STOP);
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                        gdbStubCtxBpTrack(pThis, GdbTgtTpAddr, enmTpType, true /*fInsert*/);
+                    else
+                    {
+                        /* Don't keep conditions for a breakpoint which doesn't exist. */
+                        PGDBSTUBBPCOND pBpCond = gdbStubCtxBpCondFind(pThis, GdbTgtTpAddr, enmTpType);
+                        if (pBpCond)
+                            gdbStubCtxBpCondFree(pThis, pBpCond);
+                    }
+
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                        rc = gdbStubCtxReplySendOk(pThis);
+                    else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
+                        rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'z': /* Remove a breakpoint/watchpoint. */
+            {
+                GDBSTUBTPTYPE enmTpType = 0;
+                GDBTGTMEMADDR GdbTgtTpAddr = 0;
+                uint64_t      uKind = 0;
+                const uint8_t *pbCondList = NULL;
+                size_t        cbCondList = 0;
+
+                rc = gdbStubCtxParseTpPktArgs(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &enmTpType, &GdbTgtTpAddr, &uKind,
+                                              &pbCondList, &cbCondList);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                {
+                    PGDBSTUBBPCOND pBpCond = gdbStubCtxBpCondFind(pThis, GdbTgtTpAddr, enmTpType);
+                    if (pBpCond)
+                        gdbStubCtxBpCondFree(pThis, pBpCond);
+
+                    /* Software breakpoints are usually implemented by patching the target memory. */
+                    if (enmTpType == GDBSTUBTPTYPE_EXEC_SW)
+                        gdbStubCtxMemCacheInvalidateRange(pThis, GdbTgtTpAddr, uKind ? (size_t)uKind : 1);
+
+                    rc = gdbStubCtxIfTgtTpClear(pThis, GdbTgtTpAddr, enmTpType, uKind);
+                    if (rc == GDBSTUB_INF_SUCCESS)
+                    {
+                        gdbStubCtxBpTrack(pThis, GdbTgtTpAddr, enmTpType, false /*fInsert*/);
+                        rc = gdbStubCtxReplySendOk(pThis);
+                    }
+                    else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
+                        rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                    else
+                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                }
+                else
+                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                break;
+            }
+            case 'q': /* Query packet */
+            {
+                rc = gdbStubCtxPktProcessQuery(pThis, &pThis->pbPktBuf[2], pThis->cbPkt - 1);
+                break;
+            }
+            case 'Q': /* General set packet */
+            {
+                rc = gdbStubCtxPktProcessSet(pThis, &pThis->pbPktBuf[2], pThis->cbPkt - 1);
                 break;
             }
-            case 'c': /* Continue, no response */
+            case 'v': /* Multiletter identifier (verbose?) */
             {
-                rc = gdbStubCtxIfTgtContinue(pThis);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                    pThis->enmTgtStateLast = GDBSTUBTGTSTATE_RUNNING;
+                rc = gdbStubCtxPktProcessV(pThis, &pThis->pbPktBuf[2], pThis->cbPkt - 1);
                 break;
             }
-            case 'g': /* Read general registers. */
+            case 'R': /* Restart target. */
             {
-                rc = gdbStubCtxIfTgtRegsRead(pThis, pThis->paidxRegs, pThis->cRegs, pThis->pvRegsScratch);
-                if (rc == GDBSTUB_INF_SUCCESS)
+                if (pThis->fExtendedMode) /* No reply if supported. */
                 {
-                    size_t cbReplyPkt = pThis->cbRegs * 2; /* One byte needs two characters. */
-
-                    /* Encode data and send. */
-                    rc = gdbStubCtxEnsurePktBufSpace(pThis, cbReplyPkt);
-                    if (rc == GDBSTUB_INF_SUCCESS)
-                    {
-                        rc = gdbStubCtxEncodeBinaryAsHex(pThis->pbPktBuf, pThis->cbPktBufMax, pThis->pvRegsScratch, pThis->cbRegs);
-                        if (rc == GDBSTUB_INF_SUCCESS)
-                            rc = gdbStubCtxReplySend(pThis, pThis->pbPktBuf, cbReplyPkt);
-                        else
-                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                    }
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    gdbStubCtxCachesInvalidate(pThis);
+                    rc = gdbStubCtxIfTgtRestart(pThis);
                 }
                 else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
+                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
                 break;
             }
-            case 'm': /* Read memory. */
+            case 'k': /* Kill target. */
             {
-                GDBTGTMEMADDR GdbTgtAddr = 0;
-                const uint8_t *pbPktSep = NULL;
+                gdbStubCtxCachesInvalidate(pThis);
+                rc = gdbStubCtxIfTgtKill(pThis);
+                break;
+            }
+            default:
+                /* Not supported, send empty reply. */
+                rc = gdbStubCtxReplySend(pThis, NULL, 0);
+        }
+    }
 
-                int rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
-                                                           ',', &pbPktSep);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                {
-                    size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
-                    size_t cbRead = 0;
-                    rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbRead, GDBSTUB_PKT_END, NULL);
-                    if (rc == GDBSTUB_INF_SUCCESS)
-                    {
-                        size_t cbReplyPkt = cbRead * 2; /* One byte needs two characters. */
+#if defined(GDBSTUB_WITH_STATS)
+    uint64_t cNsPkt = gdbStubCtxStatsTsQuery(pThis) - TsStart;
 
-                        rc = gdbStubCtxEnsurePktBufSpace(pThis, cbReplyPkt);
-                        if (rc == GDBSTUB_INF_SUCCESS)
-                        {
-                            uint8_t *pbPktBuf = pThis->pbPktBuf;
-                            size_t cbPktBufLeft = cbReplyPkt;
+    gdbStubCtxStatsLatAdd(&pThis->Stats.PktProcess, cNsPkt);
+    pStatsPkt->cNsTotal += cNsPkt;
+    pStatsPkt->cbOut    += pThis->Stats.cbOut + pThis->offOutBuf - cbOutStart;
 
-                            while (   cbRead
-                                   && rc == GDBSTUB_INF_SUCCESS)
-                            {
-                                size_t cbThisRead = cbRead < 1024 ? cbRead : 1024;
-                                uint8_t abTmp[1024];
+    if (pThis->fStatsReset)
+    {
+        gdbStubCtxMemset(&pThis->Stats, 0, sizeof(pThis->Stats));
+        pThis->fStatsReset = false;
+    }
+#endif
 
-                                rc = gdbStubCtxIfTgtMemRead(pThis, GdbTgtAddr, &abTmp[0], cbThisRead);
-                                if (rc != GDBSTUB_INF_SUCCESS)
-                                    break;
+    return rc;
+}
 
-                                rc = gdbStubCtxEncodeBinaryAsHex(pbPktBuf, cbPktBufLeft, &abTmp[0], cbThisRead);
-                                if (rc != GDBSTUB_INF_SUCCESS)
-                                    break;
 
-                                GdbTgtAddr   += cbThisRead;
-                                cbRead       -= cbThisRead;
-                                pbPktBuf     += cbThisRead;
-                                cbPktBufLeft -= cbThisRead;
-                            }
+/**
+ * Resets the packet buffer.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxPktBufReset(PGDBSTUBCTXINT pThis)
+{
+    pThis->offPktBuf        = 0;
+    pThis->offPktStart      = 0;
+    pThis->cbPkt            = 0;
+    pThis->cbChksumRecvLeft = 2;
+}
 
-                            if (rc == GDBSTUB_INF_SUCCESS)
-                                rc = gdbStubCtxReplySend(pThis, pThis->pbPktBuf, cbReplyPkt);
-                            else
-                                rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                        }
-                        else
-                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                    }
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                }
-                else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                break;
-            }
-            case 'M': /* Write memory. */
-            {
-                GDBTGTMEMADDR GdbTgtAddr = 0;
-                const uint8_t *pbPktSep = NULL;
 
-                int rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &GdbTgtAddr,
-                                                           ',', &pbPktSep);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                {
-                    size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
-                    size_t cbWrite = 0;
-                    rc = gdbStubCtxParseHexStringAsInteger(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &cbWrite, ':', &pbPktSep);
-                    if (rc == GDBSTUB_INF_SUCCESS)
-                    {
-                        cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
-                        const uint8_t *pbDataCur = pbPktSep + 1;
-                        size_t cbDataLeft = pThis->cbPkt - 1 - cbProcessed - 1 - 1;
+/**
+ * Resets the given GDB stub context to the initial state.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxReset(PGDBSTUBCTXINT pThis)
+{
+    pThis->enmState = GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START;
+    gdbStubCtxPktBufReset(pThis);
+}
 
-                        while (   cbWrite
-                               && !rc)
-                        {
-                            uint8_t abTmp[4096];
-                            size_t cbThisWrite = MIN(cbWrite, sizeof(abTmp));
-                            size_t cbDecoded = 0;
 
-                            rc = gdbStubCtxParseHexStringAsByteBuf(pbDataCur, cbDataLeft, &abTmp[0], cbThisWrite, &cbDecoded);
-                            if (!rc)
-                                rc = gdbStubCtxIfTgtMemWrite(pThis, GdbTgtAddr, &abTmp[0], cbThisWrite);
+/**
+ * Drops the packet being received because it exceeds the packet buffer, the rest of it is discarded
+ * as it arrives without looking for the start of the next packet in its body.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxPktBufOverflow(PGDBSTUBCTXINT pThis)
+{
+    pThis->enmState = pThis->enmState == GDBSTUBRECVSTATE_PACKET_RECEIVE_CHECKSUM
+                    ? GDBSTUBRECVSTATE_PACKET_DISCARD_CHECKSUM
+                    : GDBSTUBRECVSTATE_PACKET_DISCARD_BODY;
+    pThis->offPktBuf   = 0;
+    pThis->offPktStart = 0;
+    pThis->cbPkt       = 0;
+}
+
+
+/**
+ * Makes room at the end of the packet buffer for the rest of the packet being received by moving it
+ * to the start of the packet buffer, drops the packet if it fills the whole packet buffer already.
+ *
+ * @returns nothing.
+ * @param   pThis               The GDB stub context.
+ */
+static void gdbStubCtxPktBufCompact(PGDBSTUBCTXINT pThis)
+{
+    if (pThis->offPktStart)
+    {
+        gdbStubCtxMemmove(pThis->pbPktBuf, &pThis->pbPktBuf[pThis->offPktStart], pThis->offPktBuf - pThis->offPktStart);
+        pThis->offPktBuf  -= pThis->offPktStart;
+        pThis->offPktStart = 0;
+    }
+    else
+        gdbStubCtxPktBufOverflow(pThis);
+}
+
+
+/**
+ * Stops the target because of an out of band interrupt character and reports it to the remote end.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxOobInterrupt(PGDBSTUBCTXINT pThis)
+{
+    int rc = gdbStubCtxIfTgtStop(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+    {
+        /* Don't report the stop a second time in the receive loop. */
+        pThis->enmTgtStateLast = GDBSTUBTGTSTATE_STOPPED;
+        rc = gdbStubCtxReplySendSigTrap(pThis);
+    }
+
+    return rc;
+}
+
+
+/**
+ * Searches for the start character in the current data buffer.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   cbData              Number of new bytes in the packet buffer, starting at the current offset.
+ * @param   pcbProcessed        Where to store the amount of bytes processed.
+ */
+static int gdbStubCtxPktBufSearchStart(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+    uint8_t *pbData = &pThis->pbPktBuf[pThis->offPktBuf];
+    size_t offStart = gdbStubCtxScanStart(pbData, cbData);
+
+    GDBSTUB_STATS_ACKS_COUNT(pThis, pbData, offStart);
+    if (   offStart < cbData
+        && pbData[offStart] == GDBSTUB_PKT_START)
+    {
+        /*
+         * Found the start character, the packet is parsed where it is and only moved to the start of the
+         * packet buffer once it runs out of room, see gdbStubCtxPktBufCompact().
+         */
+        pThis->enmState    = GDBSTUBRECVSTATE_PACKET_RECEIVE_BODY;
+        pThis->offPktStart = pThis->offPktBuf + (uint32_t)offStart;
+        pThis->offPktBuf   = pThis->offPktStart + 1;
+        pThis->uChkSumRecv = 0;
+        *pcbProcessed = offStart + 1;
+    }
+    else if (offStart < cbData)
+    {
+        /* Out of band interrupt, stop target and send packet to indicate the target has stopped. */
+        rc = gdbStubCtxOobInterrupt(pThis);
+
+        /* Continue searching after the interrupt character. */
+        pThis->offPktBuf += offStart + 1;
+        *pcbProcessed = offStart + 1;
+    }
+    else
+    {
+        /* Not found, ignore the received data and reset the packet buffer. */
+        gdbStubCtxPktBufReset(pThis);
+        *pcbProcessed = cbData;
+    }
+
+    return rc;
+}
+
+
+/**
+ * Searches for the end character in the current data buffer, updating the receive checksum on the way.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   cbData              Number of new bytes in the packet buffer, starting at the current offset.
+ * @param   pcbProcessed        Where to store the amount of bytes processed.
+ */
+static int gdbStubCtxPktBufSearchEnd(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+{
+    /*
+     * The escaped characters are xored with 0x20 so a packet end character can't
+     * appear inside the packet body.
+     */
+    size_t offEnd = gdbStubCtxScanEnd(&pThis->pbPktBuf[pThis->offPktBuf], cbData, &pThis->uChkSumRecv);
+    if (offEnd < cbData)
+    {
+        /* Found the end character, next comes the checksum. */
+        pThis->enmState   = GDBSTUBRECVSTATE_PACKET_RECEIVE_CHECKSUM;
+        *pcbProcessed     = offEnd + 1;
+        pThis->offPktBuf += *pcbProcessed;
+        pThis->cbPkt      = pThis->offPktBuf - pThis->offPktStart - 1; /* Don't account for the start and end character. */
+    }
+    else
+    {
+        /* Not found, still in the middle of a packet. */
+        /** @todo Look for out of band characters. */
+        *pcbProcessed    = cbData;
+        pThis->offPktBuf += cbData;
+    }
+
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+/**
+ * Verifies the checksum of the complete packet in the packet buffer and processes it, writing out
+ * the acknowledge and reply.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ */
+static int gdbStubCtxPktComplete(PGDBSTUBCTXINT pThis)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NO_ACK_MODE)
+    {
+        /*
+         * The transport is reliable when the remote end requested no acknowledges,
+         * so there is nothing we could do about a checksum mismatch anyway and the verification is skipped.
+         */
+        rc = gdbStubCtxPktProcess(pThis);
+    }
+    else
+    {
+        /* The checksum of the packet body was already calculated while searching for the end. */
+        uint8_t uChkSumHi = gdbStubCtxChrToHex(pThis->pbPktBuf[pThis->cbPkt + 1]);
+        uint8_t uChkSumLo = gdbStubCtxChrToHex(pThis->pbPktBuf[pThis->cbPkt + 2]);
+
+        if (   (uChkSumHi | uChkSumLo) != 0xff
+            && ((uChkSumHi << 4) | uChkSumLo) == pThis->uChkSumRecv)
+        {
+            /*
+             * Checksum matches, queue the acknowledge and continue processing the complete payload,
+             * the ACK goes out together with the reply.
+             */
+            char chAck = '+';
+            GDBSTUB_STATS_ADD(pThis, cAcksSent, 1);
+            rc = gdbStubCtxOutBufAppend(pThis, &chAck, sizeof(chAck));
+            if (rc == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxPktProcess(pThis);
+        }
+        else
+        {
+            /* Send NACK and reset for the next packet. */
+            char chAck = '-';
+            GDBSTUB_STATS_ADD(pThis, cNaksSent, 1);
+            rc = gdbStubCtxOutBufAppend(pThis, &chAck, sizeof(chAck));
+        }
+    }
+
+    /* The reply stays queued so the replies for pipelined packets go out together. */
+    return rc;
+}
+
+
+/**
+ * Processes the checksum.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   cbData              Number of new bytes in the packet buffer, starting at the current offset.
+ * @param   pcbProcessed        Where to store the amount of bytes processed.
+ */
+static int gdbStubCtxPktBufProcessChksum(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
+    size_t cbChksumProcessed = MIN(cbData, pThis->cbChksumRecvLeft);
+
+    /* The checksum characters stay in the packet buffer right after the end character. */
+    pThis->cbChksumRecvLeft -= cbChksumProcessed;
+    pThis->offPktBuf        += cbChksumProcessed;
+    *pcbProcessed            = cbChksumProcessed;
+
+    if (!pThis->cbChksumRecvLeft)
+    {
+        /* The packet processing expects the packet at the start of the packet buffer. */
+        uint8_t *pbPktBufSaved = pThis->pbPktBuf;
+
+        pThis->pbPktBuf = &pbPktBufSaved[pThis->offPktStart];
+        rc = gdbStubCtxPktComplete(pThis);
+        pThis->pbPktBuf = pbPktBufSaved;
+
+        /*
+         * Wait for the next packet, anything received after the checksum is kept at the
+         * current offset and is searched next.
+         */
+        pThis->enmState         = GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START;
+        pThis->cbPkt            = 0;
+        pThis->cbChksumRecvLeft = 2;
+    }
+
+    return rc;
+}
 
-                            GdbTgtAddr += cbThisWrite;
-                            cbWrite    -= cbThisWrite;
-                            pbDataCur  += cbDecoded;
-                            cbDataLeft -= cbDecoded;
-                        }
 
-                        if (rc == GDBSTUB_INF_SUCCESS)
-                            rc = gdbStubCtxReplySendOk(pThis);
-                        else
-                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                    }
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                }
-                else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                break;
-            }
-            case 'p': /* Read a single register */
-            {
-                uint64_t uReg = 0;
-                int rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &uReg,
-                                                           GDBSTUB_PKT_END, NULL);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                {
-                    uint32_t idxReg = (uint32_t)uReg;
+/**
+ * Discards the data of a packet exceeding the packet buffer.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   cbData              Number of new bytes in the packet buffer, starting at the current offset.
+ * @param   pcbProcessed        Where to store the amount of bytes processed.
+ */
+static int gdbStubCtxPktBufDiscard(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+{
+    size_t cbProcessed = cbData;
 
-                    if (idxReg < pThis->cRegs)
-                    {
-                        rc = gdbStubCtxIfTgtRegsRead(pThis, &idxReg, 1, pThis->pvRegsScratch);
-                        if (rc == GDBSTUB_INF_SUCCESS)
-                        {
-                            size_t cbReg = pThis->pIf->paRegs[idxReg].cRegBits / 8;
-                            size_t cbReplyPkt = cbReg * 2; /* One byte needs two characters. */
+    if (pThis->enmState == GDBSTUBRECVSTATE_PACKET_DISCARD_BODY)
+    {
+        const uint8_t *pbData = &pThis->pbPktBuf[pThis->offPktBuf];
+        const uint8_t *pbEnd = (const uint8_t *)gdbStubCtxMemchr(pbData, GDBSTUB_PKT_END, cbData);
+        if (pbEnd)
+        {
+            pThis->enmState = GDBSTUBRECVSTATE_PACKET_DISCARD_CHECKSUM;
+            cbProcessed = (size_t)(pbEnd - pbData) + 1;
+        }
+    }
+    else
+    {
+        cbProcessed = MIN(cbData, pThis->cbChksumRecvLeft);
+        pThis->cbChksumRecvLeft -= cbProcessed;
+        if (!pThis->cbChksumRecvLeft)
+        {
+            pThis->enmState         = GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START;
+            pThis->cbChksumRecvLeft = 2;
+        }
+    }
 
-                            /* Encode data and send. */
-                            rc = gdbStubCtxEnsurePktBufSpace(pThis, cbReplyPkt);
-                            if (rc == GDBSTUB_INF_SUCCESS)
-                            {
-                                rc = gdbStubCtxEncodeBinaryAsHex(pThis->pbPktBuf, pThis->cbPktBufMax, pThis->pvRegsScratch, cbReg);
-                                if (rc == GDBSTUB_INF_SUCCESS)
-                                    rc = gdbStubCtxReplySend(pThis, pThis->pbPktBuf, cbReplyPkt);
-                                else
-                                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                            }
-                            else
-                                rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                        }
-                        else
-                            rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                    }
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
-                }
-                else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                break;
-            }
-            case 'P': /* Write a single register */
-            {
-                uint64_t uReg = 0;
-                const uint8_t *pbPktSep = NULL;
-                int rc = gdbStubCtxParseHexStringAsInteger(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &uReg,
-                                                           '=', &pbPktSep);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                {
-                    uint32_t idxReg = (uint32_t)uReg;
+    /* Anything following the packet is searched next. */
+    pThis->offPktBuf += cbProcessed;
+    *pcbProcessed     = cbProcessed;
+    return GDBSTUB_INF_SUCCESS;
+}
 
-                    if (idxReg < pThis->cRegs)
-                    {
-                        size_t cbProcessed = pbPktSep - &pThis->pbPktBuf[2];
-                        uint32_t u32RegVal = 0;
-                        rc = gdbStubCtxParseHexStringAsByteBuf(pbPktSep + 1, pThis->cbPkt - 1 - cbProcessed - 1, &u32RegVal, sizeof(u32RegVal), NULL);
-                        if (rc == GDBSTUB_INF_SUCCESS)
-                        {
-                            rc = gdbStubCtxIfTgtRegsWrite(pThis, &idxReg, 1, &u32RegVal);
-                            if (rc == GDBSTUB_INF_SUCCESS)
-                                rc = gdbStubCtxReplySendOk(pThis);
-                            else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
-                                rc = gdbStubCtxReplySend(pThis, NULL, 0);
-                            else
-                                rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                        }
-                    }
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, GDBSTUB_ERR_PROTOCOL_VIOLATION);
-                }
-                else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                break;
-            }
-            case 'Z': /* Insert a breakpoint/watchpoint. */
-            {
-                GDBSTUBTPTYPE enmTpType = 0;
-                GDBTGTMEMADDR GdbTgtTpAddr = 0;
-                uint64_t      uKind = 0;
 
-                int rc = gdbStubCtxParseTpPktArgs(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &enmTpType, &GdbTgtTpAddr, &uKind);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                {
-                    rc = gdbStubCtxIfTgtTpSet(pThis, GdbTgtTpAddr, enmTpType, GDBSTUBTPACTION_STOP);
-                    if (rc == GDBSTUB_INF_SUCCESS)
-                        rc = gdbStubCtxReplySendOk(pThis);
-                    else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
-                        rc = gdbStubCtxReplySend(pThis, NULL, 0);
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                }
-                else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                break;
-            }
-            case 'z': /* Remove a breakpoint/watchpoint. */
-            {
-                GDBSTUBTPTYPE enmTpType = 0;
-                GDBTGTMEMADDR GdbTgtTpAddr = 0;
-                uint64_t      uKind = 0;
+/**
+ * Process read data in the packet buffer based on the current state.
+ *
+ * @returns Status code.
+ * @param   pThis               The GDB stub context.
+ * @param   cbData              Number of new bytes in the packet buffer.
+ */
+static int gdbStubCtxPktBufProcess(PGDBSTUBCTXINT pThis, size_t cbData)
+{
+    int rc = GDBSTUB_INF_SUCCESS;
 
-                int rc = gdbStubCtxParseTpPktArgs(&pThis->pbPktBuf[2], pThis->cbPkt - 1, &enmTpType, &GdbTgtTpAddr, &uKind);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                {
-                    rc = gdbStubCtxIfTgtTpClear(pThis, GdbTgtTpAddr);
-                    if (rc == GDBSTUB_INF_SUCCESS)
-                        rc = gdbStubCtxReplySendOk(pThis);
-                    else if (rc == GDBSTUB_ERR_NOT_SUPPORTED)
-                        rc = gdbStubCtxReplySend(pThis, NULL, 0);
-                    else
-                        rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                }
-                else
-                    rc = gdbStubCtxReplySendErrSts(pThis, rc);
-                break;
-            }
-            case 'q': /* Query packet */
+    while (   cbData
+           && rc == GDBSTUB_INF_SUCCESS)
+    {
+        size_t cbProcessed = 0;
+
+        switch (pThis->enmState)
+        {
+            case GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START:
             {
-                rc = gdbStubCtxPktProcessQuery(pThis, &pThis->pbPktBuf[2], pThis->cbPkt - 1);
+                rc = gdbStubCtxPktBufSearchStart(pThis, cbData, &cbProcessed);
                 break;
             }
-            case 'v': /* Multiletter identifier (verbose?) */
+            case GDBSTUBRECVSTATE_PACKET_RECEIVE_BODY:
             {
-                rc = gdbStubCtxPktProcessV(pThis, &pThis->pbPktBuf[2], pThis->cbPkt - 1);
+                rc = gdbStubCtxPktBufSearchEnd(pThis, cbData, &cbProcessed);
                 break;
             }
-            case 'R': /* Restart target. */
+            case GDBSTUBRECVSTATE_PACKET_RECEIVE_CHECKSUM:
             {
-                if (pThis->fExtendedMode) /* No reply if supported. */
-                    rc = gdbStubCtxIfTgtRestart(pThis);
-                else
-                    rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                rc = gdbStubCtxPktBufProcessChksum(pThis, cbData, &cbProcessed);
                 break;
             }
-            case 'k': /* Kill target. */
+            case GDBSTUBRECVSTATE_PACKET_DISCARD_BODY:
+            case GDBSTUBRECVSTATE_PACKET_DISCARD_CHECKSUM:
             {
-                rc = gdbStubCtxIfTgtKill(pThis);
+                rc = gdbStubCtxPktBufDiscard(pThis, cbData, &cbProcessed);
                 break;
             }
             default:
-                /* Not supported, send empty reply. */
-                rc = gdbStubCtxReplySend(pThis, NULL, 0);
+                /* Should never happen. */
+                rc = GDBSTUB_ERR_INTERNAL_ERROR;
         }
+
+        cbData -= cbProcessed;
     }
 
+    /* Start over at the beginning of the packet buffer if nothing is left over from the previous packet. */
+    if (pThis->enmState == GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START)
+        gdbStubCtxPktBufReset(pThis);
+    else if (   pThis->enmState == GDBSTUBRECVSTATE_PACKET_DISCARD_BODY
+             || pThis->enmState == GDBSTUBRECVSTATE_PACKET_DISCARD_CHECKSUM)
+        pThis->offPktBuf = 0;
+
     return rc;
 }
 
 
 /**
- * Resets the packet buffer.
+ * Reports a stop notified through GDBStubCtxNotifyStop() or GDBStubCtxNotifyThrdStop() to the remote end
+ * if there is one.
  *
- * @returns nothing.
+ * @returns Status code.
  * @param   pThis               The GDB stub context.
  */
-static void gdbStubCtxPktBufReset(PGDBSTUBCTXINT pThis)
+static int gdbStubCtxStopPendingProcess(PGDBSTUBCTXINT pThis)
 {
-    pThis->offPktBuf        = 0;
-    pThis->cbPkt            = 0;
-    pThis->cbChksumRecvLeft = 2;
+    int rc = GDBSTUB_INF_SUCCESS;
+    GDBTGTTHRDID idThrd = GDBTGTTHRDID_ANY;
+    GDBSTUBSTOPREASON enmReason = GDBSTUBSTOPREASON_INVALID;
+
+    if (pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+    {
+        /* Only one notification can be outstanding, the remote end collects the remaining stops through 'vStopped'. */
+        while (   !pThis->fStopNotifyInFlight
+               && gdbStubCtxStopEvtDequeue(pThis, &idThrd, &enmReason))
+        {
+            if (gdbStubCtxStopConsume(pThis, idThrd, enmReason))
+                continue;
+
+            pThis->fStopNotifyInFlight = true;
+            gdbStubCtxCachesInvalidate(pThis);
+
+            rc = gdbStubCtxReplySendStop(pThis, gdbStubCtxStopReasonToSignal(enmReason), idThrd, true /*fNotify*/);
+        }
+
+        return rc;
+    }
+
+    /*
+     * Don't report a stop twice (a single step was already reported synchronously for example), only the first stop
+     * gets reported as all threads are stopped afterwards anyway.
+     */
+    bool fReport = false;
+    GDBTGTTHRDID idThrdCur = GDBTGTTHRDID_ANY;
+    GDBSTUBSTOPREASON enmReasonCur = GDBSTUBSTOPREASON_INVALID;
+    while (gdbStubCtxStopEvtDequeue(pThis, &idThrdCur, &enmReasonCur))
+    {
+        if (   !fReport
+            && pThis->enmTgtStateLast != GDBSTUBTGTSTATE_STOPPED)
+        {
+            fReport   = true;
+            idThrd    = idThrdCur;
+            enmReason = enmReasonCur;
+        }
+    }
+
+    if (   fReport
+        && !gdbStubCtxStopConsume(pThis, idThrd, enmReason))
+    {
+        pThis->enmTgtStateLast = GDBSTUBTGTSTATE_STOPPED;
+        gdbStubCtxCachesInvalidate(pThis);
+
+        rc = gdbStubCtxReplySendStop(pThis, gdbStubCtxStopReasonToSignal(enmReason), idThrd, false /*fNotify*/);
+    }
+
+    return rc;
 }
 
 
 /**
- * Resets the given GDB stub context to the initial state.
+ * Checks whether the target stopped since the last invocation and reports it to the remote end.
  *
- * @returns nothing.
+ * @returns Status code.
  * @param   pThis               The GDB stub context.
  */
-static void gdbStubCtxReset(PGDBSTUBCTXINT pThis)
+static int gdbStubCtxTgtStateCheck(PGDBSTUBCTXINT pThis)
 {
-    pThis->enmState = GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START;
-    gdbStubCtxPktBufReset(pThis);
+    int rc = GDBSTUB_INF_SUCCESS;
+
+    /* In non-stop mode every stop is reported through GDBStubCtxNotifyThrdStop(). */
+    if (!(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP))
+    {
+        GDBSTUBTGTSTATE enmTgtState = gdbStubCtxIfTgtGetState(pThis);
+        if (enmTgtState != pThis->enmTgtStateLast)
+            gdbStubCtxCachesInvalidate(pThis);
+
+        if (   enmTgtState == GDBSTUBTGTSTATE_STOPPED
+            && pThis->enmTgtStateLast != GDBSTUBTGTSTATE_STOPPED)
+        {
+            /* The target is running again if the stop was consumed by a breakpoint condition. */
+            if (gdbStubCtxStopConsume(pThis, GDBTGTTHRDID_ANY, GDBSTUBSTOPREASON_TRAP))
+                enmTgtState = GDBSTUBTGTSTATE_RUNNING;
+            else
+                rc = gdbStubCtxReplySendSigTrap(pThis);
+        }
+
+        pThis->enmTgtStateLast = enmTgtState;
+    }
+
+    return rc;
 }
 
 
 /**
- * Searches for the start character in the current data buffer.
+ * Sends the console output queued through GDBStubCtxNotifyOutput() as 'O' packets if the remote end accepts them.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   cbData              Number of new bytes in the packet buffer.
- * @param   pcbProcessed        Where to store the amount of bytes processed.
+ *
+ * @note The remote end only accepts output in all-stop mode while waiting for the resumed target to stop,
+ *       the output is kept until then.
  */
-static int gdbStubCtxPktBufSearchStart(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+static int gdbStubCtxConsOutProcess(PGDBSTUBCTXINT pThis)
 {
     int rc = GDBSTUB_INF_SUCCESS;
-    uint8_t *pbStart = gdbStubCtxMemchr(pThis->pbPktBuf, GDBSTUB_PKT_START, cbData);
-    if (pbStart)
-    {
-        /* Found the start character, align the start to the beginning of the packet buffer and advance the state machine. */
-        gdbStubCtxMemmove(pThis->pbPktBuf, pbStart, cbData - (pbStart - pThis->pbPktBuf));
-        pThis->enmState = GDBSTUBRECVSTATE_PACKET_RECEIVE_BODY;
-        *pcbProcessed = (uintptr_t)(pbStart - pThis->pbPktBuf);
-        pThis->offPktBuf = 0;
-    }
-    else
+
+    if (   pThis->cbConsOut
+        && !(pThis->fFeatures & GDBSTUBCTX_FEATURES_F_NON_STOP)
+        && pThis->enmTgtStateLast == GDBSTUBTGTSTATE_RUNNING)
     {
-        /* Check for out of band characters. */
-        if (gdbStubCtxMemchr(pThis->pbPktBuf, GDBSTUB_OOB_INTERRUPT, cbData) != NULL)
+        uint32_t offConsOut = 0;
+        while (   rc == GDBSTUB_INF_SUCCESS
+               && offConsOut < pThis->cbConsOut)
         {
-            /* Stop target and send packet to indicate the target has stopped. */
-            rc = gdbStubCtxIfTgtStop(pThis);
+            uint32_t cbThisSend = MIN(pThis->cbConsOut - offConsOut, GDBSTUBCTX_CONS_OUT_PKT_MAX);
+            uint8_t chOutput = 'O';
+
+            rc = gdbStubCtxReplySendBegin(pThis);
             if (rc == GDBSTUB_INF_SUCCESS)
-                rc = gdbStubCtxReplySendSigTrap(pThis);
+                rc = gdbStubCtxReplySendData(pThis, &chOutput, sizeof(chOutput));
+            if (rc == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxReplySendDataHex(pThis, &pThis->abConsOut[offConsOut], cbThisSend);
+            if (rc == GDBSTUB_INF_SUCCESS)
+                rc = gdbStubCtxReplySendEnd(pThis);
+
+            offConsOut += cbThisSend;
         }
 
-        /* Not found, ignore the received data and reset the packet buffer. */
-        gdbStubCtxPktBufReset(pThis);
-        *pcbProcessed = cbData;
+        pThis->cbConsOut = 0;
     }
 
     return rc;
@@ -2533,103 +8504,108 @@ static int gdbStubCtxPktBufSearchStart(PGDBSTUBCTXINT pThis, size_t cbData, size
 
 
 /**
- * Searches for the end character in the current data buffer.
+ * Processes everything queued by other threads: a requested disconnect, console output and stops.
  *
  * @returns Status code.
+ * @retval  GDBSTUB_ERR_PEER_DISCONNECTED if a disconnect was requested through GDBStubCtxDisconnect().
  * @param   pThis               The GDB stub context.
- * @param   cbData              Number of new bytes in the packet buffer.
- * @param   pcbProcessed        Where to store the amount of bytes processed.
  */
-static int gdbStubCtxPktBufSearchEnd(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+static int gdbStubCtxEvtsPendingProcess(PGDBSTUBCTXINT pThis)
 {
-    uint8_t *pbEnd = gdbStubCtxMemchr(&pThis->pbPktBuf[pThis->offPktBuf], GDBSTUB_PKT_END, cbData);
-    if (pbEnd)
-    {
-#if 0 /* This should not be necessary as the escaped character is xored with 0x20 so the search should not trigger. */
-        /*
-         * Check whether this is an escaped character not denoting the end of a packet.
-         * The pointer arithmetic is safe because we always store the start character of a packet
-         * in the buffer as well so the worst case with the smallest packet $#hh is properly detected.
-         * Just sending # before the start character will be ignored in gdbStubCtxPktBufSearchStart()
-         * and we don't end up here at all.
-         */
-        if (*(pbEnd - 1) != GDBSTUB_PKT_ESCAPE)
-#endif
-        {
-            /* Found the end character, next comes the checksum. */
-            pThis->enmState = GDBSTUBRECVSTATE_PACKET_RECEIVE_CHECKSUM;
-        }
-        *pcbProcessed     = (uintptr_t)(pbEnd - &pThis->pbPktBuf[pThis->offPktBuf]) + 1;
-        pThis->offPktBuf += *pcbProcessed;
-        pThis->cbPkt      = pThis->offPktBuf - 1; /* Don't account for the start and end character. */
-    }
-    else
-    {
-        /* Not found, still in the middle of a packet. */
-        /** @todo Look for out of band characters. */
-        *pcbProcessed    = cbData;
-        pThis->offPktBuf += cbData;
-    }
+    if (atomic_load_explicit(&pThis->fDisconnectReq, memory_order_acquire))
+        return GDBSTUB_ERR_PEER_DISCONNECTED;
 
-    return GDBSTUB_INF_SUCCESS;
+    /* Output is sent before any stop as the remote end doesn't accept it once the target is stopped. */
+    gdbStubCtxEvtQueueDrain(pThis);
+    int rc = gdbStubCtxConsOutProcess(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxStopPendingProcess(pThis);
+
+    return rc;
 }
 
 
 /**
- * Processes the checksum.
+ * The main receive loop.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   cbData              Number of new bytes in the packet buffer.
- * @param   pcbProcessed        Where to store the amount of bytes processed.
  */
-static int gdbStubCtxPktBufProcessChksum(PGDBSTUBCTXINT pThis, size_t cbData, size_t *pcbProcessed)
+static int gdbStubCtxRecv(PGDBSTUBCTXINT pThis)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
-    size_t cbChksumProcessed = (cbData < pThis->cbChksumRecvLeft) ? cbData : pThis->cbChksumRecvLeft;
+    int rc = gdbStubCtxTgtStateCheck(pThis);
 
-    pThis->cbChksumRecvLeft -= cbChksumProcessed;
-    if (!pThis->cbChksumRecvLeft)
+    while (rc == GDBSTUB_INF_SUCCESS)
     {
-        /* Verify checksum of the whole packet. */
-        uint8_t uChkSum =   gdbStubCtxChrToHex(pThis->pbPktBuf[pThis->offPktBuf]) << 4
-                          | gdbStubCtxChrToHex(pThis->pbPktBuf[pThis->offPktBuf + 1]);
+        /* Process events from other threads right away, this is checked again after being woken up from polling. */
+        rc = gdbStubCtxEvtsPendingProcess(pThis);
+        if (rc != GDBSTUB_INF_SUCCESS)
+            break;
 
-        uint8_t uSum = 0;
-        for (uint32_t i = 1; i < pThis->cbPkt; i++)
-            uSum += pThis->pbPktBuf[i];
+        size_t cbRead = gdbStubCtxIoIfPeek(pThis);
 
-        if (uSum == uChkSum)
+        if (cbRead)
         {
-            /* Checksum matches, send acknowledge and continue processing the complete payload. */
-            char chAck = '+';
-            rc = gdbStubCtxIoIfWrite(pThis, &chAck, sizeof(chAck));
+            if (pThis->offPktBuf == pThis->cbPktBufMax)
+            {
+                /*
+                 * Move the packet being received out of the way of the ones processed before it, if it starts at the
+                 * beginning already it exceeds the maximum packet size we advertised. It gets dropped then and the receive
+                 * resynchronizes with the start of the next one after its checksum.
+                 */
+                gdbStubCtxPktBufCompact(pThis);
+            }
+
+            size_t cbThisRead = 0;
+            cbRead = MIN(cbRead, pThis->cbPktBufMax - pThis->offPktBuf);
+            rc = gdbStubCtxIoIfRead(pThis, &pThis->pbPktBuf[pThis->offPktBuf], cbRead, &cbThisRead);
             if (rc == GDBSTUB_INF_SUCCESS)
-                rc = gdbStubCtxPktProcess(pThis);
+            {
+                GDBSTUB_STATS_ADD(pThis, cbIn, cbThisRead);
+                rc = gdbStubCtxPktBufProcess(pThis, cbThisRead);
+            }
         }
         else
         {
-            /* Send NACK and reset for the next packet. */
-            char chAck = '-';
-            rc = gdbStubCtxIoIfWrite(pThis, &chAck, sizeof(chAck));
+            /*
+             * Everything received so far was processed, write out the queued replies at once
+             * (always before blocking as the remote end might wait for them).
+             */
+            if (pThis->pIoIf->pfnPoll)
+            {
+                rc = gdbStubCtxOutBufFlush(pThis);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                    rc = gdbStubCtxIoIfPoll(pThis);
+            }
+            else
+            {
+                if (!pThis->fFlushManual)
+                    rc = gdbStubCtxOutBufFlush(pThis);
+                if (rc == GDBSTUB_INF_SUCCESS)
+                    rc = GDBSTUB_INF_TRY_AGAIN;
+            }
         }
-
-        gdbStubCtxReset(pThis);
     }
 
-    *pcbProcessed += cbChksumProcessed;
+    /* Write out whatever was queued, even if processing failed. */
+    if (   rc != GDBSTUB_INF_TRY_AGAIN
+        && !pThis->fFlushManual)
+        gdbStubCtxOutBufFlush(pThis);
+
     return rc;
 }
 
 
 /**
- * Process read data in the packet buffer based on the current state.
+ * Processes data handed over by the caller, complete packets are processed in place and only
+ * packets crossing the buffer boundaries are assembled in the packet buffer.
  *
  * @returns Status code.
  * @param   pThis               The GDB stub context.
- * @param   cbData              Number of new bytes in the packet buffer.
+ * @param   pbData              The data to process.
+ * @param   cbData              Number of bytes to process.
  */
-static int gdbStubCtxPktBufProcess(PGDBSTUBCTXINT pThis, size_t cbData)
+static int gdbStubCtxFeed(PGDBSTUBCTXINT pThis, uint8_t *pbData, size_t cbData)
 {
     int rc = GDBSTUB_INF_SUCCESS;
 
@@ -2638,28 +8614,84 @@ static int gdbStubCtxPktBufProcess(PGDBSTUBCTXINT pThis, size_t cbData)
     {
         size_t cbProcessed = 0;
 
-        switch (pThis->enmState)
+        if (pThis->enmState == GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START)
         {
-            case GDBSTUBRECVSTATE_PACKET_WAIT_FOR_START:
+            size_t offStart = gdbStubCtxScanStart(pbData, cbData);
+
+            GDBSTUB_STATS_ACKS_COUNT(pThis, pbData, offStart);
+            if (offStart == cbData)
+                cbProcessed = cbData; /* Nothing of interest. */
+            else if (pbData[offStart] != GDBSTUB_PKT_START)
             {
-                rc = gdbStubCtxPktBufSearchStart(pThis, cbData, &cbProcessed);
-                break;
+                rc = gdbStubCtxOobInterrupt(pThis);
+                cbProcessed = offStart + 1;
             }
-            case GDBSTUBRECVSTATE_PACKET_RECEIVE_BODY:
+            else
             {
-                rc = gdbStubCtxPktBufSearchEnd(pThis, cbData, &cbProcessed);
-                break;
+                uint8_t uChkSum = 0;
+                uint8_t *pbPkt = &pbData[offStart];
+                size_t cbPktRem = cbData - offStart;
+                size_t offEnd = gdbStubCtxScanEnd(&pbPkt[1], cbPktRem - 1, &uChkSum);
+
+                if (   offEnd + 1 + 2 < cbPktRem
+                    && offEnd + 1 + 1 + 2 > pThis->cbPktBufMax)
+                {
+                    /* The packet exceeds the maximum packet size we advertised, drop it like gdbStubCtxRecv() does. */
+                    cbProcessed = offStart + offEnd + 1 + 1 + 2;
+                }
+                else if (offEnd + 1 + 2 < cbPktRem)
+                {
+                    /*
+                     * The complete packet including the checksum is in the buffer, let the packet buffer point to
+                     * the caller's data while processing it.
+                     */
+                    uint8_t *pbPktBufSaved = pThis->pbPktBuf;
+
+                    pThis->pbPktBuf    = pbPkt;
+                    pThis->cbPkt       = offEnd + 1;
+                    pThis->uChkSumRecv = uChkSum;
+                    rc = gdbStubCtxPktComplete(pThis);
+                    pThis->pbPktBuf    = pbPktBufSaved;
+                    pThis->cbPkt       = 0;
+                    cbProcessed = offStart + offEnd + 1 + 1 + 2;
+                }
+                else
+                {
+                    /* The packet continues in the next chunk, assemble it in the packet buffer. */
+                    size_t cbCopy = MIN(cbPktRem, pThis->cbPktBufMax);
+
+                    gdbStubCtxMemcpy(pThis->pbPktBuf, pbPkt, cbCopy);
+                    rc = gdbStubCtxPktBufProcess(pThis, cbCopy);
+                    cbProcessed = offStart + cbCopy;
+                }
             }
-            case GDBSTUBRECVSTATE_PACKET_RECEIVE_CHECKSUM:
+        }
+        else
+        {
+            /* Only copy the remainder of the current packet so the next one can be processed in place again. */
+            size_t cbCopy = pThis->cbChksumRecvLeft;
+            if (   pThis->enmState == GDBSTUBRECVSTATE_PACKET_RECEIVE_BODY
+                || pThis->enmState == GDBSTUBRECVSTATE_PACKET_DISCARD_BODY)
             {
-                rc = gdbStubCtxPktBufProcessChksum(pThis, cbData, &cbProcessed);
-                break;
+                const uint8_t *pbEnd = (const uint8_t *)gdbStubCtxMemchr(pbData, GDBSTUB_PKT_END, cbData);
+                cbCopy = pbEnd ? (size_t)(pbEnd - pbData) + 1 + 2 : cbData;
             }
-            default:
-                /* Should never happen. */
-                rc = GDBSTUB_ERR_INTERNAL_ERROR;
+            cbCopy = MIN(cbCopy, cbData);
+
+            if (pThis->offPktBuf == pThis->cbPktBufMax)
+            {
+                /* The packet exceeds the maximum packet size we advertised, see gdbStubCtxRecv(). */
+                gdbStubCtxPktBufCompact(pThis);
+                continue;
+            }
+
+            cbCopy = MIN(cbCopy, pThis->cbPktBufMax - pThis->offPktBuf);
+            gdbStubCtxMemcpy(&pThis->pbPktBuf[pThis->offPktBuf], pbData, cbCopy);
+            rc = gdbStubCtxPktBufProcess(pThis, cbCopy);
+            cbProcessed = cbCopy;
         }
 
+        pbData += cbProcessed;
         cbData -= cbProcessed;
     }
 
@@ -2668,118 +8700,498 @@ static int gdbStubCtxPktBufProcess(PGDBSTUBCTXINT pThis, size_t cbData)
 
 
 /**
- * The main receive loop.
+ * Validates the given configuration and computes the layout of all memory required by a context.
  *
  * @returns Status code.
- * @param   pThis               The GDB stub context.
+ * @param   pIf                 The interface callback table.
+ * @param   pCfg                The configuration to use, NULL for the defaults.
+ * @param   pLayout             Where to store the memory layout.
  */
-static int gdbStubCtxRecv(PGDBSTUBCTXINT pThis)
+static int gdbStubCtxMemLayoutQuery(PCGDBSTUBIF pIf, PCGDBSTUBCFG pCfg, PGDBSTUBCTXMEMLAYOUT pLayout)
 {
-    int rc = GDBSTUB_INF_SUCCESS;
+    size_t cbPktMax = GDBSTUB_PKT_SIZE_DEF;
+    if (   pCfg
+        && pCfg->cbPktMax)
+    {
+        if (pCfg->cbPktMax < GDBSTUB_PKT_SIZE_MIN)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+        cbPktMax = pCfg->cbPktMax;
+    }
 
-    GDBSTUBTGTSTATE enmTgtState = gdbStubCtxIfTgtGetState(pThis);
-    if (   enmTgtState == GDBSTUBTGTSTATE_STOPPED
-        && pThis->enmTgtStateLast != GDBSTUBTGTSTATE_STOPPED)
-        rc = gdbStubCtxReplySendSigTrap(pThis);
+    size_t cbMemCacheLine = GDBSTUB_MEM_CACHE_LINE_SIZE_DEF;
+    uint32_t cMemCacheLines = 0;
+    if (   pCfg
+        && pCfg->cbMemCache)
+    {
+        if (pCfg->cbMemCacheLine)
+            cbMemCacheLine = pCfg->cbMemCacheLine;
+
+        /* The line size must be a power of two and the cache must hold at least one line. */
+        if (   (cbMemCacheLine & (cbMemCacheLine - 1))
+            || pCfg->cbMemCache < cbMemCacheLine)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+        cMemCacheLines = (uint32_t)(pCfg->cbMemCache / cbMemCacheLine);
+    }
+
+#if defined(GDBSTUB_FIXED_REGS)
+    /* Everything about the registers is known at build time. */
+    uint32_t cRegs = GDBSTUBCTX_REGS_COUNT(NULL);
+    size_t cbRegs = sizeof(GDBSTUBFIXEDREGS);
+    size_t cbRegMax = sizeof(GDBSTUBFIXEDREG);
+    size_t cbRegsExpedite = 0 GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_EXPEDITE_SIZE);
+    size_t cbRegsExpediteDef = 0 GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_EXPEDITE_DEF_SIZE);
+    bool fRegPc = false GDBSTUB_FIXED_REGS(GDBSTUB_FIXED_REG_IS_PC);
+#else
+    uint32_t cRegs = 0;
+    size_t cbRegs = 0;
+    size_t cbRegMax = 0;
+    size_t cbRegsExpedite = 0;
+    size_t cbRegsExpediteDef = 0;
+    bool fRegPc = false;
+    PCGDBSTUBREG paRegs = GDBSTUBIF_REGS(pIf);
+    while (paRegs[cRegs].pszName != NULL)
+    {
+        size_t cbReg = paRegs[cRegs].cRegBits / 8;
+
+        if (paRegs[cRegs].enmType == GDBSTUBREGTYPE_PC)
+            fRegPc = true;
+
+        cbRegs  += cbReg;
+        cbRegMax = MAX(cbRegMax, cbReg);
+        if (paRegs[cRegs].fFlags & GDBSTUBREG_F_EXPEDITE)
+            cbRegsExpedite += cbReg;
+        else if (   paRegs[cRegs].enmType == GDBSTUBREGTYPE_PC
+                 || paRegs[cRegs].enmType == GDBSTUBREGTYPE_STACK_PTR)
+            cbRegsExpediteDef += cbReg;
+        cRegs++;
+    }
+#endif
 
-    pThis->enmTgtStateLast = enmTgtState;
+    /* The stop reply reads the expedited registers in one go, defaulting to the program counter and stack pointer. */
+    if (!cbRegsExpedite)
+        cbRegsExpedite = cbRegsExpediteDef;
 
-    while (rc == GDBSTUB_INF_SUCCESS)
+    /* Breakpoint conditions can only be matched against the program counter. */
+    uint32_t cBpConds = 0;
+    size_t cbBpCondsMax = GDBSTUB_BP_CONDS_SIZE_DEF;
+    if (   pCfg
+        && pCfg->cBpConds
+        && fRegPc)
     {
-        size_t cbRead = gdbStubCtxIoIfPeek(pThis);
+        if (pCfg->cbBpCondsMax)
+            cbBpCondsMax = pCfg->cbBpCondsMax;
+        cBpConds = pCfg->cBpConds;
+    }
 
-        if (cbRead)
+    /* Same for tracepoints, every frame holds all registers (the configuration is ignored if they were stripped). */
+    uint32_t cTracePoints = 0;
+    size_t cbTracePointMax = GDBSTUB_TRACE_POINT_SIZE_DEF;
+    size_t cbTraceBuf = 0;
+#if !defined(GDBSTUB_WITHOUT_TRACEPOINTS)
+    if (   pCfg
+        && pCfg->cTracePoints
+        && fRegPc)
+    {
+        if (pCfg->cbTracePointMax)
+            cbTracePointMax = pCfg->cbTracePointMax;
+        cbTraceBuf = pCfg->cbTraceBuf ? pCfg->cbTraceBuf : GDBSTUB_TRACE_BUF_SIZE_DEF;
+        if (cbTraceBuf < GDBSTUBTRACE_FRAME_HDR_SIZE + 1 + cbRegs)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+        cTracePoints = pCfg->cTracePoints;
+    }
+#endif
+
+    /* Flash regions require the flash callbacks and must be made up of whole erase blocks. */
+    size_t cbFlashBlockMax = 0;
+    if (pIf->paMemRegions)
+    {
+        for (PCGDBSTUBMEMREGION pRegion = &pIf->paMemRegions[0]; pRegion->cbRegion; pRegion++)
         {
-            rc = gdbStubCtxEnsurePktBufSpace(pThis, cbRead);
-            if (rc == GDBSTUB_INF_SUCCESS)
+            if (   pRegion->enmType != GDBSTUBMEMREGIONTYPE_RAM
+                && pRegion->enmType != GDBSTUBMEMREGIONTYPE_ROM
+                && pRegion->enmType != GDBSTUBMEMREGIONTYPE_FLASH)
+                return GDBSTUB_ERR_INVALID_PARAMETER;
+
+            if (pRegion->enmType == GDBSTUBMEMREGIONTYPE_FLASH)
             {
-                size_t cbThisRead = 0;
-                rc = gdbStubCtxIoIfRead(pThis, &pThis->pbPktBuf[pThis->offPktBuf], cbRead, &cbThisRead);
-                if (rc == GDBSTUB_INF_SUCCESS)
-                    rc = gdbStubCtxPktBufProcess(pThis, cbThisRead);
+#if defined(GDBSTUB_WITHOUT_FLASH)
+                return GDBSTUB_ERR_NOT_SUPPORTED;
+#endif
+                if (   !pIf->pfnTgtFlashErase
+                    || !pIf->pfnTgtFlashWrite
+                    || !pRegion->cbBlock
+                    || pRegion->cbRegion % pRegion->cbBlock)
+                    return GDBSTUB_ERR_INVALID_PARAMETER;
+
+                cbFlashBlockMax = MAX(cbFlashBlockMax, pRegion->cbBlock);
             }
         }
-        else
-        {
-            /* Block when poll is available. */
-            if (pThis->pIoIf->pfnPoll)
-                rc = gdbStubCtxIoIfPoll(pThis);
-            else
-                rc = GDBSTUB_INF_TRY_AGAIN;
-        }
     }
 
-    return rc;
+    /* The reply to 'g' must always fit into a single packet. */
+    if (cbPktMax < cbRegs * 2)
+        cbPktMax = cbRegs * 2;
+
+    pLayout->cbPktMax        = cbPktMax;
+    pLayout->cRegs           = cRegs;
+    pLayout->cbRegs          = cbRegs;
+    pLayout->cbRegsScratch   = MAX(MIN(cbRegs, GDBSTUBCTX_REGS_SCRATCH_SIZE), MAX(cbRegMax, cbRegsExpedite));
+    pLayout->fRegsCache      = pCfg && (pCfg->fFlags & GDBSTUBCFG_F_REGS_CACHE);
+    pLayout->cMemCacheLines  = cMemCacheLines;
+    pLayout->cbMemCacheLine  = cbMemCacheLine;
+    pLayout->cBpConds        = cBpConds;
+    pLayout->cbBpCondsMax    = cbBpCondsMax;
+    pLayout->cTracePoints    = cTracePoints;
+    pLayout->cbTracePointMax = cbTracePointMax;
+    pLayout->cbTraceBuf      = cbTraceBuf;
+    pLayout->cbFlashBlockMax = cbFlashBlockMax;
+
+    /*
+     * Everything lives in a single memory block starting with the context structure, followed by the register
+     * scratch space and index arrays (and the register cache), the packet buffer, the output buffer, the memory
+     * cache, the breakpoint conditions, the tracepoints, the trace frame buffer, the target XML description,
+     * the XML memory map and the flash erase block buffer.
+     */
+    size_t cbRegsCache = pLayout->fRegsCache ? 2 * cRegs * sizeof(uint32_t) + cbRegs + cRegs : 0;
+    size_t offCur = GDBSTUBCTX_MEM_ALIGN(sizeof(GDBSTUBCTXINT));
+
+    pLayout->offRegsScratch = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(GDBSTUBCTX_MEM_ALIGN(pLayout->cbRegsScratch) + 2 * cRegs * sizeof(uint32_t) + cbRegsCache);
+
+    /*
+     * The packet buffer holds a complete packet including the framing, the output buffer
+     * additionally has room for the acknowledge so both go out in a single write.
+     */
+    pLayout->offPktBuf = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cbPktMax + GDBSTUB_PKT_FRAMING_SIZE);
+    pLayout->offOutBuf = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cbPktMax + GDBSTUB_PKT_FRAMING_SIZE + 1);
+
+    /* The line descriptors come first followed by the data of all lines. */
+    pLayout->offMemCache = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cMemCacheLines * sizeof(GDBSTUBMEMCACHELINE) + cMemCacheLines * cbMemCacheLine);
+
+    /* The slots come first followed by the condition lists of all slots. */
+    pLayout->offBpConds = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cBpConds * sizeof(GDBSTUBBPCOND) + cBpConds * cbBpCondsMax);
+
+    /* Same for the tracepoints and their actions. */
+    pLayout->offTracePoints = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cTracePoints * sizeof(GDBSTUBTRACEPOINT) + cTracePoints * cbTracePointMax);
+    pLayout->offTraceBuf = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cbTraceBuf);
+
+    /* Nothing to generate if the target brings a prebuilt description or it was fixed at build time. */
+    pLayout->offTgtXmlDesc = offCur;
+#if defined(GDBSTUB_FIXED_REGS)
+    pLayout->cbTgtXmlDesc  = 0;
+#else
+    pLayout->cbTgtXmlDesc  = pIf->paTgtDescAnnexes ? 0 : gdbStubTgtDescFmt(pIf, NULL);
+#endif
+    offCur += GDBSTUBCTX_MEM_ALIGN(pLayout->cbTgtXmlDesc);
+    pLayout->offMemMap = offCur;
+    pLayout->cbMemMap  = pIf->paMemRegions ? gdbStubMemMapFmt(pIf->paMemRegions, NULL) : 0;
+    offCur += GDBSTUBCTX_MEM_ALIGN(pLayout->cbMemMap);
+    pLayout->offFlashBlock = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(cbFlashBlockMax);
+
+    /* The buckets of the hashed indices over the packet processor and command tables. */
+    uint32_t cCmds = 0;
+    if (pIf->paCmds)
+    {
+        while (pIf->paCmds[cCmds].pszCmd)
+            cCmds++;
+        if (cCmds >= UINT16_MAX)
+            return GDBSTUB_ERR_INVALID_PARAMETER;
+    }
+
+    pLayout->cCmds                = cCmds;
+    pLayout->cBucketsQPktProcs    = gdbStubNameIdxBucketsQuery(ELEMENTS(g_aQPktProcs));
+    pLayout->cBucketsQSetPktProcs = gdbStubNameIdxBucketsQuery(ELEMENTS(g_aQSetPktProcs));
+    pLayout->cBucketsVPktProcs    = gdbStubNameIdxBucketsQuery(ELEMENTS(g_aVPktProcs));
+    pLayout->cBucketsCmds         = gdbStubNameIdxBucketsQuery(cCmds);
+    pLayout->offNameIdxBuckets    = offCur;
+    offCur += GDBSTUBCTX_MEM_ALIGN(  (  pLayout->cBucketsQPktProcs + pLayout->cBucketsQSetPktProcs
+                                      + pLayout->cBucketsVPktProcs + pLayout->cBucketsCmds)
+                                   * sizeof(uint16_t));
+
+    pLayout->cbTotal = offCur;
+    return GDBSTUB_INF_SUCCESS;
 }
 
 
-int GDBStubCtxCreate(PGDBSTUBCTX phCtx, PCGDBSTUBIOIF pIoIf, PCGDBSTUBIF pIf, void *pvUser)
+int GDBStubCtxCreateEx(PGDBSTUBCTX phCtx, PCGDBSTUBIOIF pIoIf, PCGDBSTUBIF pIf, PCGDBSTUBCFG pCfg, void *pvUser)
 {
     if (!phCtx || !pIoIf || !pIf)
         return GDBSTUB_ERR_INVALID_PARAMETER;
 
-    int rc = GDBSTUB_INF_SUCCESS;
-    PGDBSTUBCTXINT pThis = (PGDBSTUBCTXINT)pIf->pfnMemAlloc(NULL, pvUser, sizeof(*pThis));
-    if (pThis)
+    bool fArena = pCfg && pCfg->pvArena;
+    if (   !fArena
+        && (!pIf->pfnMemAlloc || !pIf->pfnMemFree))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    GDBSTUBCTXMEMLAYOUT Layout;
+    int rc = gdbStubCtxMemLayoutQuery(pIf, pCfg, &Layout);
+    if (rc != GDBSTUB_INF_SUCCESS)
+        return rc;
+
+    uint8_t *pbMem = NULL;
+    if (fArena)
     {
-        pThis->pIoIf           = pIoIf;
-        pThis->pIf             = pIf;
-        pThis->pvUser          = pvUser;
-        pThis->cbPktBufMax     = 0;
-        pThis->pbPktBuf        = NULL;
-        pThis->enmTgtStateLast = GDBSTUBTGTSTATE_INVALID;
-        pThis->fFeatures       = GDBSTUBCTX_FEATURES_F_TGT_DESC;
-        pThis->pbTgtXmlDesc    = NULL;
-        pThis->cbTgtXmlDesc    = 0;
-        pThis->fExtendedMode   = false;
-        gdbStubOutCtxInit(&pThis->OutCtx, pThis);
+        /* The arena might not be aligned, GDBStubCtxQueryArenaSize() accounts for that. */
+        uintptr_t uArena = (uintptr_t)pCfg->pvArena;
+        size_t cbAlign = GDBSTUBCTX_MEM_ALIGN(uArena) - uArena;
+        if (   pCfg->cbArena < cbAlign
+            || pCfg->cbArena - cbAlign < Layout.cbTotal)
+            return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+        pbMem = (uint8_t *)pCfg->pvArena + cbAlign;
+    }
+    else
+    {
+        pbMem = (uint8_t *)pIf->pfnMemAlloc(NULL, pvUser, Layout.cbTotal);
+        if (!pbMem)
+            return GDBSTUB_ERR_NO_MEMORY;
+    }
 
-        uint32_t cRegs = 0;
-        size_t cbRegs = 0;
-        while (pIf->paRegs[cRegs].pszName != NULL)
+    PGDBSTUBCTXINT pThis = (PGDBSTUBCTXINT)pbMem;
+    uint32_t cRegs = Layout.cRegs;
+    size_t cbRegs = Layout.cbRegs;
+    PCGDBSTUBREG paRegs = GDBSTUBIF_REGS(pIf);
+
+    pThis->pIoIf           = pIoIf;
+    pThis->pIf             = pIf;
+    pThis->pvUser          = pvUser;
+    pThis->pvIoUser        = pCfg && pCfg->pvIoUser ? pCfg->pvIoUser : pvUser;
+    pThis->fArena          = fArena;
+    pThis->fFlushManual    = pCfg && (pCfg->fFlags & GDBSTUBCFG_F_FLUSH_MANUAL);
+    pThis->fMonOutputStream = pCfg && (pCfg->fFlags & GDBSTUBCFG_F_MON_OUTPUT_STREAM);
+    pThis->enmTgtStateLast = GDBSTUBTGTSTATE_INVALID;
+    pThis->fStopNotifyInFlight = false;
+    pThis->idThrdGen       = GDBTGTTHRDID_ANY;
+    pThis->idxThrdInfoNext = 0;
+    pThis->fFeatures       = GDBSTUBCTX_FEATURES_F_TGT_DESC;
+    pThis->uEvtPosDeq      = 0;
+    pThis->idxStopEvtFirst = 0;
+    pThis->cStopEvts       = 0;
+    pThis->cbConsOut       = 0;
+    atomic_init(&pThis->uEvtPosEnq, 0);
+    atomic_init(&pThis->fDisconnectReq, false);
+    for (uint32_t i = 0; i < ELEMENTS(pThis->aEvts); i++)
+        atomic_init(&pThis->aEvts[i].uSeq, i);
+
+    /* Thread support requires all of the thread callbacks. */
+    if (   pIf->pfnTgtThrdsQuery
+        && pIf->pfnTgtThrdSelect
+        && pIf->pfnTgtThrdGetState
+        && pIf->pfnTgtThrdAction)
+        pThis->fFeatures |= GDBSTUBCTX_FEATURES_F_THRDS;
+    pThis->fExtendedMode   = false;
+    pThis->offOutBuf       = 0;
+    pThis->cRegsExpedite   = 0;
+    pThis->pbRegsCache     = NULL;
+    pThis->paMemCacheLines = NULL;
+    pThis->pbMemCache      = NULL;
+    pThis->cMemCacheLines  = 0;
+    pThis->cbMemCacheLine  = 0;
+    pThis->idxRegPc        = UINT32_MAX;
+    pThis->paBpConds       = NULL;
+    pThis->cBpConds        = 0;
+    pThis->cBpCondsUsed    = 0;
+    pThis->cbBpCondsMax    = 0;
+    pThis->fStepPending    = false;
+    pThis->cBps            = 0;
+    pThis->cBpsUntracked   = 0;
+    pThis->paTracePoints   = NULL;
+    pThis->cTracePoints    = 0;
+    pThis->cbTracePointMax = 0;
+    pThis->pbTraceBuf      = NULL;
+    pThis->cbTraceBuf      = 0;
+    pThis->fTraceRunning   = false;
+    pThis->fTraceCircular  = false;
+    pThis->enmTraceStop    = GDBSTUBTRACESTOP_NOT_RUN;
+    pThis->uTraceStopTp    = 0;
+    gdbStubCtxTraceBufReset(pThis);
+    pThis->cRegs           = cRegs;
+    pThis->cbRegs          = cbRegs;
+    pThis->cbPktMax        = Layout.cbPktMax;
+    pThis->pbPktBuf        = &pbMem[Layout.offPktBuf];
+    pThis->cbPktBufMax     = Layout.cbPktMax + GDBSTUB_PKT_FRAMING_SIZE;
+    pThis->pbOutBuf        = &pbMem[Layout.offOutBuf];
+    pThis->cbOutBufMax     = Layout.cbPktMax + GDBSTUB_PKT_FRAMING_SIZE + 1;
+#if defined(GDBSTUB_FIXED_REGS)
+    pThis->pbTgtXmlDesc    = (const uint8_t *)&g_szFixedTgtDesc[0];
+    pThis->cbTgtXmlDesc    = sizeof(g_szFixedTgtDesc) - 1;
+#else
+    pThis->pbTgtXmlDesc    = &pbMem[Layout.offTgtXmlDesc];
+    pThis->cbTgtXmlDesc    = Layout.cbTgtXmlDesc;
+#endif
+    pThis->pbMemMap        = pIf->paMemRegions ? &pbMem[Layout.offMemMap] : NULL;
+    pThis->cbMemMap        = Layout.cbMemMap;
+    pThis->pbFlashBlock    = Layout.cbFlashBlockMax ? &pbMem[Layout.offFlashBlock] : NULL;
+    pThis->GdbTgtMemAddrFlashBlock = 0;
+    pThis->cbFlashBlock    = 0;
+#if !defined(GDBSTUB_WITHOUT_MON_CMDS)
+    gdbStubOutCtxInit(&pThis->OutCtx, pThis);
+#endif
+#if defined(GDBSTUB_WITH_STATS)
+    gdbStubCtxMemset(&pThis->Stats, 0, sizeof(pThis->Stats));
+    pThis->fStatsReset = false;
+#endif
+
+    /* Set up the scratch space for register content and index array. */
+    pThis->pvRegsScratch     = &pbMem[Layout.offRegsScratch];
+    pThis->cbRegsScratch     = Layout.cbRegsScratch;
+    pThis->paidxRegs         = (uint32_t *)((uint8_t *)pThis->pvRegsScratch + GDBSTUBCTX_MEM_ALIGN(Layout.cbRegsScratch));
+    pThis->paidxRegsExpedite = &pThis->paidxRegs[cRegs];
+
+    if (Layout.fRegsCache)
+    {
+        /* The register cache lives right after the index arrays, starts out invalid. */
+        pThis->paoffRegsCache      = &pThis->paidxRegsExpedite[cRegs];
+        pThis->paidxRegsCacheBatch = &pThis->paoffRegsCache[cRegs];
+        pThis->pbRegsCache         = (uint8_t *)&pThis->paidxRegsCacheBatch[cRegs];
+        pThis->pafRegsCache        = &pThis->pbRegsCache[cbRegs];
+
+        uint32_t offReg = 0;
+        for (uint32_t i = 0; i < cRegs; i++)
         {
-            cbRegs += pIf->paRegs[cRegs].cRegBits / 8;
-            cRegs++;
+            pThis->paoffRegsCache[i] = offReg;
+            offReg += paRegs[i].cRegBits / 8;
         }
 
-        pThis->cRegs = cRegs;
-        pThis->cbRegs = cbRegs;
+        gdbStubCtxRegsCacheInvalidate(pThis);
+    }
+
+    /* GDB always sets or queries all registers so we can statically initialize the index array. */
+    for (uint32_t i = 0; i < GDBSTUBCTX_REGS_COUNT(pThis); i++)
+    {
+        pThis->paidxRegs[i] = i;
+        if (paRegs[i].fFlags & GDBSTUBREG_F_EXPEDITE)
+            pThis->paidxRegsExpedite[pThis->cRegsExpedite++] = i;
+        if (   paRegs[i].enmType == GDBSTUBREGTYPE_PC
+            && pThis->idxRegPc == UINT32_MAX)
+            pThis->idxRegPc = i;
+    }
 
-        /* Allocate scratch space for register content and index array. */
-        void *pvRegsScratch = gdbStubCtxIfMemAlloc(pThis, cRegs * cbRegs + cRegs * sizeof(uint32_t));
-        if (pvRegsScratch)
+    /* Default to the program counter and stack pointer if nothing was marked explicitly. */
+    if (!pThis->cRegsExpedite)
+    {
+        for (uint32_t i = 0; i < GDBSTUBCTX_REGS_COUNT(pThis); i++)
         {
-            pThis->pvRegsScratch = pvRegsScratch;
-            pThis->paidxRegs     = (uint32_t *)((uint8_t *)pvRegsScratch + (cRegs * cbRegs));
+            if (   paRegs[i].enmType == GDBSTUBREGTYPE_PC
+                || paRegs[i].enmType == GDBSTUBREGTYPE_STACK_PTR)
+                pThis->paidxRegsExpedite[pThis->cRegsExpedite++] = i;
+        }
+    }
 
-            /* GDB always sets or queries all registers so we can statically initialize the index array. */
-            for (uint32_t i = 0; i < pThis->cRegs; i++)
-                pThis->paidxRegs[i] = i;
+    if (Layout.cMemCacheLines)
+    {
+        pThis->paMemCacheLines = (PGDBSTUBMEMCACHELINE)&pbMem[Layout.offMemCache];
+        pThis->pbMemCache      = (uint8_t *)&pThis->paMemCacheLines[Layout.cMemCacheLines];
+        pThis->cMemCacheLines  = Layout.cMemCacheLines;
+        pThis->cbMemCacheLine  = Layout.cbMemCacheLine;
+        for (uint32_t i = 0; i < Layout.cMemCacheLines; i++)
+            pThis->paMemCacheLines[i].fValid = false;
+    }
 
-            gdbStubCtxReset(pThis);
-            *phCtx = pThis;
-            return GDBSTUB_INF_SUCCESS;
+    if (Layout.cBpConds)
+    {
+        uint8_t *pbConds = &pbMem[Layout.offBpConds + Layout.cBpConds * sizeof(GDBSTUBBPCOND)];
+
+        pThis->paBpConds    = (PGDBSTUBBPCOND)&pbMem[Layout.offBpConds];
+        pThis->cBpConds     = Layout.cBpConds;
+        pThis->cbBpCondsMax = Layout.cbBpCondsMax;
+        for (uint32_t i = 0; i < Layout.cBpConds; i++)
+        {
+            pThis->paBpConds[i].fUsed   = false;
+            pThis->paBpConds[i].cbConds = 0;
+            pThis->paBpConds[i].pbConds = &pbConds[i * Layout.cbBpCondsMax];
         }
-        else
-            rc = GDBSTUB_ERR_NO_MEMORY;
+    }
 
-        pIf->pfnMemFree(NULL, pvUser, pThis);
+    if (Layout.cTracePoints)
+    {
+        uint8_t *pbActions = &pbMem[Layout.offTracePoints + Layout.cTracePoints * sizeof(GDBSTUBTRACEPOINT)];
+
+        pThis->paTracePoints   = (PGDBSTUBTRACEPOINT)&pbMem[Layout.offTracePoints];
+        pThis->cTracePoints    = Layout.cTracePoints;
+        pThis->cbTracePointMax = Layout.cbTracePointMax;
+        pThis->pbTraceBuf      = &pbMem[Layout.offTraceBuf];
+        pThis->cbTraceBuf      = Layout.cbTraceBuf;
+        for (uint32_t i = 0; i < Layout.cTracePoints; i++)
+        {
+            pThis->paTracePoints[i].fUsed     = false;
+            pThis->paTracePoints[i].cbActions = 0;
+            pThis->paTracePoints[i].pbActions = &pbActions[i * Layout.cbTracePointMax];
+        }
     }
-    else
-        rc = GDBSTUB_ERR_NO_MEMORY;
+
+#if !defined(GDBSTUB_FIXED_REGS)
+    if (!pIf->paTgtDescAnnexes)
+        gdbStubTgtDescFmt(pIf, &pbMem[Layout.offTgtXmlDesc]);
+#endif
+    if (pIf->paMemRegions)
+        gdbStubMemMapFmt(pIf->paMemRegions, pThis->pbMemMap);
+
+    uint16_t *paidxBuckets = (uint16_t *)&pbMem[Layout.offNameIdxBuckets];
+    gdbStubNameIdxInit(&pThis->IdxQPktProcs, paidxBuckets, Layout.cBucketsQPktProcs,
+                       &g_aQPktProcs[0], sizeof(g_aQPktProcs[0]), ELEMENTS(g_aQPktProcs));
+    paidxBuckets += Layout.cBucketsQPktProcs;
+    gdbStubNameIdxInit(&pThis->IdxQSetPktProcs, paidxBuckets, Layout.cBucketsQSetPktProcs,
+                       &g_aQSetPktProcs[0], sizeof(g_aQSetPktProcs[0]), ELEMENTS(g_aQSetPktProcs));
+    paidxBuckets += Layout.cBucketsQSetPktProcs;
+    gdbStubNameIdxInit(&pThis->IdxVPktProcs, paidxBuckets, Layout.cBucketsVPktProcs,
+                       &g_aVPktProcs[0], sizeof(g_aVPktProcs[0]), ELEMENTS(g_aVPktProcs));
+    paidxBuckets += Layout.cBucketsVPktProcs;
+    gdbStubNameIdxInit(&pThis->IdxCmds, paidxBuckets, Layout.cBucketsCmds,
+                       pIf->paCmds, sizeof(*pIf->paCmds), Layout.cCmds);
+    gdbStubCtxReset(pThis);
+    *phCtx = pThis;
+    return GDBSTUB_INF_SUCCESS;
+}
+
+int GDBStubCtxCreate(PGDBSTUBCTX phCtx, PCGDBSTUBIOIF pIoIf, PCGDBSTUBIF pIf, void *pvUser)
+{
+    return GDBStubCtxCreateEx(phCtx, pIoIf, pIf, NULL, pvUser);
+}
+
+int GDBStubCtxQueryArenaSize(PCGDBSTUBIF pIf, PCGDBSTUBCFG pCfg, size_t *pcbArena)
+{
+    if (!pIf || !pcbArena)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    GDBSTUBCTXMEMLAYOUT Layout;
+    int rc = gdbStubCtxMemLayoutQuery(pIf, pCfg, &Layout);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        *pcbArena = Layout.cbTotal + GDBSTUBCTX_MEM_ALIGNMENT - 1; /* Room for aligning the start of the arena. */
 
     return rc;
 }
 
+int GDBStubTgtDescGenerate(PCGDBSTUBIF pIf, void *pvBuf, size_t cbBuf, size_t *pcbDesc)
+{
+    if (   !pIf
+        || !pcbDesc
+        || (!pvBuf && cbBuf))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    size_t cbDesc = gdbStubTgtDescFmt(pIf, NULL);
+    *pcbDesc = cbDesc;
+    if (cbBuf < cbDesc)
+        return GDBSTUB_ERR_BUFFER_OVERFLOW;
+
+    gdbStubTgtDescFmt(pIf, (uint8_t *)pvBuf);
+    return GDBSTUB_INF_SUCCESS;
+}
+
 void GDBStubCtxDestroy(GDBSTUBCTX hCtx)
 {
     PGDBSTUBCTXINT pThis = hCtx;
-    PCGDBSTUBIF pIf = pThis->pIf;
-    void *pvUser = pThis->pvUser;
 
-    if (pThis->pbPktBuf)
-        pIf->pfnMemFree(pThis, pvUser, pThis->pbPktBuf);
-    pIf->pfnMemFree(NULL, pvUser, pThis);
+    /* Everything was allocated in a single block along with the context. */
+    if (!pThis->fArena)
+        pThis->pIf->pfnMemFree(NULL, pThis->pvUser, pThis);
 }
 
 int GDBStubCtxRun(GDBSTUBCTX hCtx)
@@ -2792,6 +9204,44 @@ int GDBStubCtxRun(GDBSTUBCTX hCtx)
     return gdbStubCtxRecv(pThis);
 }
 
+int GDBStubCtxFeed(GDBSTUBCTX hCtx, void *pvData, size_t cbData)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (   !pThis
+        || (!pvData && cbData))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    GDBSTUB_STATS_ADD(pThis, cbIn, cbData);
+
+    int rc = gdbStubCtxTgtStateCheck(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxEvtsPendingProcess(pThis);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        rc = gdbStubCtxFeed(pThis, (uint8_t *)pvData, cbData);
+
+    /* Write out whatever was queued, even if processing failed. */
+    if (!pThis->fFlushManual)
+    {
+        int rc2 = gdbStubCtxOutBufFlush(pThis);
+        if (rc == GDBSTUB_INF_SUCCESS)
+            rc = rc2;
+    }
+
+    return rc;
+}
+
+
+int GDBStubCtxFlush(GDBSTUBCTX hCtx)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (!pThis)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    return gdbStubCtxOutBufFlush(pThis);
+}
+
 int GDBStubCtxReset(GDBSTUBCTX hCtx)
 {
     PGDBSTUBCTXINT pThis = hCtx;
@@ -2799,6 +9249,134 @@ int GDBStubCtxReset(GDBSTUBCTX hCtx)
     if (!pThis)
         return GDBSTUB_ERR_INVALID_PARAMETER;
 
+    /* Anything negotiated with the previous remote end is gone. */
+    pThis->fFeatures &= ~(GDBSTUBCTX_FEATURES_F_NO_ACK_MODE | GDBSTUBCTX_FEATURES_F_NON_STOP);
+    pThis->fStopNotifyInFlight = false;
+    pThis->fStepPending        = false;
+
+    /* The conditions of the previous remote end don't apply anymore. */
+    for (uint32_t i = 0; i < pThis->cBpConds; i++)
+        pThis->paBpConds[i].fUsed = false;
+    pThis->cBpCondsUsed  = 0;
+    pThis->cBps          = 0;
+    pThis->cBpsUntracked = 0;
+
+    /* Same for the tracepoints, tracing doesn't continue without the remote end. */
+    gdbStubCtxTraceStop(pThis, GDBSTUBTRACESTOP_NOT_RUN, 0);
+    for (uint32_t i = 0; i < pThis->cTracePoints; i++)
+        pThis->paTracePoints[i].fUsed = false;
+    gdbStubCtxTraceBufReset(pThis);
+    pThis->fTraceCircular = false;
+    pThis->enmTraceStop   = GDBSTUBTRACESTOP_NOT_RUN;
+    pThis->uTraceStopTp   = 0;
+
+    /* A flash operation of the previous remote end is never completed. */
+    pThis->cbFlashBlock = 0;
+
+    /* A requested disconnect applies to the previous remote end, so does its console output. */
+    atomic_store_explicit(&pThis->fDisconnectReq, false, memory_order_relaxed);
+    pThis->cbConsOut = 0;
+
     gdbStubCtxReset(pThis);
     return GDBSTUB_INF_SUCCESS;
 }
+
+
+int GDBStubCtxNotifyStop(GDBSTUBCTX hCtx, GDBSTUBSTOPREASON enmReason)
+{
+    return GDBStubCtxNotifyThrdStop(hCtx, GDBTGTTHRDID_ANY, enmReason);
+}
+
+
+int GDBStubCtxNotifyThrdStop(GDBSTUBCTX hCtx, GDBTGTTHRDID idThrd, GDBSTUBSTOPREASON enmReason)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (   !pThis
+        || idThrd == GDBTGTTHRDID_ALL
+        || (   enmReason != GDBSTUBSTOPREASON_TRAP
+            && enmReason != GDBSTUBSTOPREASON_INTERRUPT
+            && enmReason != GDBSTUBSTOPREASON_STOP_REQUEST))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    int rc = gdbStubCtxEvtEnqueue(pThis, GDBSTUBCTXEVTTYPE_STOP, idThrd, enmReason, NULL, 0);
+    if (rc == GDBSTUB_INF_SUCCESS)
+        gdbStubCtxIoIfPollWakeup(pThis);
+
+    return rc;
+}
+
+
+int GDBStubCtxNotifyOutput(GDBSTUBCTX hCtx, const void *pvOutput, size_t cbOutput)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (   !pThis
+        || (!pvOutput && cbOutput))
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    int rc = GDBSTUB_INF_SUCCESS;
+    const uint8_t *pbOutput = (const uint8_t *)pvOutput;
+    while (   rc == GDBSTUB_INF_SUCCESS
+           && cbOutput)
+    {
+        size_t cbThisOutput = MIN(cbOutput, GDBSTUBCTX_EVT_OUTPUT_MAX);
+
+        rc = gdbStubCtxEvtEnqueue(pThis, GDBSTUBCTXEVTTYPE_OUTPUT, GDBTGTTHRDID_ANY, GDBSTUBSTOPREASON_INVALID,
+                                  pbOutput, cbThisOutput);
+        pbOutput += cbThisOutput;
+        cbOutput -= cbThisOutput;
+    }
+
+    /* Whatever was queued gets sent, even if the rest didn't fit. */
+    if (pbOutput != (const uint8_t *)pvOutput)
+        gdbStubCtxIoIfPollWakeup(pThis);
+
+    return rc;
+}
+
+
+int GDBStubCtxDisconnect(GDBSTUBCTX hCtx)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (!pThis)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+    atomic_store_explicit(&pThis->fDisconnectReq, true, memory_order_release);
+    gdbStubCtxIoIfPollWakeup(pThis);
+    return GDBSTUB_INF_SUCCESS;
+}
+
+
+int GDBStubCtxQueryStats(GDBSTUBCTX hCtx, PGDBSTUBSTATS pStats)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (   !pThis
+        || !pStats)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+#if defined(GDBSTUB_WITH_STATS)
+    gdbStubCtxMemcpy(pStats, &pThis->Stats, sizeof(*pStats));
+    return GDBSTUB_INF_SUCCESS;
+#else
+    return GDBSTUB_ERR_NOT_SUPPORTED;
+#endif
+}
+
+
+int GDBStubCtxResetStats(GDBSTUBCTX hCtx)
+{
+    PGDBSTUBCTXINT pThis = hCtx;
+
+    if (!pThis)
+        return GDBSTUB_ERR_INVALID_PARAMETER;
+
+#if defined(GDBSTUB_WITH_STATS)
+    gdbStubCtxMemset(&pThis->Stats, 0, sizeof(pThis->Stats));
+    return GDBSTUB_INF_SUCCESS;
+#else
+    return GDBSTUB_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -0,0 +1,140 @@
+/** @file
+ * Generic GDB stub library - multi-session server.
+ */
+
+/*
+ * Copyright (C) 2020 Alexander Eichner <alexander.eichner@campus.tu-berlin.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef __libgdbstub_server_h
+#define __libgdbstub_server_h
+
+#include <libgdbstub.h>
+
+
+/** Opaque GDB stub server handle. */
+typedef struct GDBSTUBSRVINT *GDBSTUBSRV;
+/** Pointer to a GDB stub server handle. */
+typedef GDBSTUBSRV *PGDBSTUBSRV;
+
+/** Default number of worker threads. */
+#define GDBSTUBSRV_WORKERS_DEF      2
+/** Number of milliseconds a connection may not accept any of the data sent to it before it gets closed. */
+#define GDBSTUBSRV_WRITE_TIMEOUT_MS 10000
+
+
+/**
+ * Server callback table.
+ */
+typedef struct GDBSTUBSRVIF
+{
+    /**
+     * Called when the remote end connected to an endpoint, returns the target to debug.
+     *
+     * @returns Status code, the connection is closed on failure.
+     * @param   hSrv                The server handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the server.
+     * @param   pvEndpoint          Opaque user data passed when the endpoint was added.
+     * @param   ppIf                Where to store the interface callback table of the target.
+     * @param   ppCfg               Where to store the configuration of the stub context, NULL for the defaults.
+     *                              GDBSTUBCFG::pvIoUser is ignored as the server owns the I/O interface.
+     * @param   ppvTgtUser          Where to store the opaque user data passed to the interface callbacks of the target.
+     */
+    int    (*pfnConnect) (GDBSTUBSRV hSrv, void *pvUser, void *pvEndpoint, PCGDBSTUBIF *ppIf, PCGDBSTUBCFG *ppCfg,
+                          void **ppvTgtUser);
+
+    /**
+     * Called after the stub context for a new connection was created, before any packet is processed - optional.
+     *
+     * @returns nothing.
+     * @param   hSrv                The server handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the server.
+     * @param   hCtx                The GDB stub context handle of the connection (for GDBStubCtxNotifyStop() for example).
+     * @param   pvTgtUser           The opaque user data of the target as returned by pfnConnect().
+     */
+    void   (*pfnConnected) (GDBSTUBSRV hSrv, void *pvUser, GDBSTUBCTX hCtx, void *pvTgtUser);
+
+    /**
+     * Called when a connection for which pfnConnect() succeeded is closed.
+     *
+     * @returns nothing.
+     * @param   hSrv                The server handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the server.
+     * @param   hCtx                The GDB stub context handle of the connection, NULL if creating it failed.
+     * @param   pvTgtUser           The opaque user data of the target as returned by pfnConnect().
+     *
+     * @note The stub context is destroyed afterwards, the target must not use the handle after returning.
+     */
+    void   (*pfnDisconnect) (GDBSTUBSRV hSrv, void *pvUser, GDBSTUBCTX hCtx, void *pvTgtUser);
+
+} GDBSTUBSRVIF;
+/** Pointer to a server callback table. */
+typedef GDBSTUBSRVIF *PGDBSTUBSRVIF;
+/** Pointer to a const server callback table. */
+typedef const GDBSTUBSRVIF *PCGDBSTUBSRVIF;
+
+
+/**
+ * Creates a new GDB stub server, serving all of its connections from a small pool of worker threads.
+ *
+ * @returns Status code.
+ * @param   phSrv                   Where to store the handle to the server on success.
+ * @param   pSrvIf                  The server callback table.
+ * @param   cWorkers                Number of worker threads to start, 0 for GDBSTUBSRV_WORKERS_DEF.
+ * @param   pvUser                  Opaque user data passed to the server callbacks.
+ *
+ * @note Each connection gets processed by a single worker at a time, so the interface callbacks of a target
+ *       are never invoked concurrently for the same connection.
+ * @note A remote end which stops reading its data for GDBSTUBSRV_WRITE_TIMEOUT_MS gets disconnected so it
+ *       can't keep a worker blocked.
+ */
+int GDBStubSrvCreate(PGDBSTUBSRV phSrv, PCGDBSTUBSRVIF pSrvIf, uint32_t cWorkers, void *pvUser);
+
+/**
+ * Destroys the given GDB stub server, closing all endpoints and connections.
+ *
+ * @returns nothing.
+ * @param   hSrv                    The server handle to destroy.
+ */
+void GDBStubSrvDestroy(GDBSTUBSRV hSrv);
+
+/**
+ * Adds a TCP endpoint accepting connections from the remote end.
+ *
+ * @returns Status code.
+ * @param   hSrv                    The server handle.
+ * @param   pszAddr                 The address to listen on, NULL for all addresses.
+ * @param   uPort                   The port to listen on.
+ * @param   pvEndpoint              Opaque user data passed to GDBSTUBSRVIF::pfnConnect() for every connection
+ *                                  accepted on the endpoint (identifying the target for example).
+ */
+int GDBStubSrvListenTcp(GDBSTUBSRV hSrv, const char *pszAddr, uint16_t uPort, void *pvEndpoint);
+
+/**
+ * Adds an already connected stream socket (a UNIX domain or vsock socket for example) to the server.
+ *
+ * @returns Status code.
+ * @param   hSrv                    The server handle.
+ * @param   iFd                     The socket descriptor, the server takes ownership even on failure.
+ * @param   pvEndpoint              Opaque user data passed to GDBSTUBSRVIF::pfnConnect().
+ */
+int GDBStubSrvAttachFd(GDBSTUBSRV hSrv, int iFd, void *pvEndpoint);
+
+#endif /* __libgdbstub_server_h */
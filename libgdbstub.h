@@ -33,6 +33,13 @@
 /** Target address space address. */
 typedef uint64_t GDBTGTMEMADDR;
 
+/** Target thread ID as presented to the remote end, valid IDs are in the range 1..GDBTGTTHRDID_ALL-1. */
+typedef uint32_t GDBTGTTHRDID;
+/** Special thread ID referring to an arbitrary thread. */
+#define GDBTGTTHRDID_ANY    0
+/** Special thread ID referring to all threads. */
+#define GDBTGTTHRDID_ALL    UINT32_MAX
+
 /** Opaque GDB stub context handle. */
 typedef struct GDBSTUBCTXINT *GDBSTUBCTX;
 /** Pointer to a GDB stub context handle. */
@@ -94,6 +101,42 @@ typedef enum GDBSTUBTGTSTATE
 } GDBSTUBTGTSTATE;
 
 
+/**
+ * The reason the target stopped, passed to GDBStubCtxNotifyStop() and GDBStubCtxNotifyThrdStop().
+ */
+typedef enum GDBSTUBSTOPREASON
+{
+    /** Invalid reason, do not use. */
+    GDBSTUBSTOPREASON_INVALID = 0,
+    /** The target hit a breakpoint, watchpoint or finished a single step (reported as SIGTRAP). */
+    GDBSTUBSTOPREASON_TRAP,
+    /** The target was interrupted externally (reported as SIGINT). */
+    GDBSTUBSTOPREASON_INTERRUPT,
+    /** The thread stopped because of a GDBSTUBTHRDACTION_STOP action (reported as signal 0). */
+    GDBSTUBSTOPREASON_STOP_REQUEST,
+    /** 32bit hack. */
+    GDBSTUBSTOPREASON_32BIT_HACK = 0x7fffffff
+} GDBSTUBSTOPREASON;
+
+
+/**
+ * Action to apply to a single thread of the target.
+ */
+typedef enum GDBSTUBTHRDACTION
+{
+    /** Invalid action, do not use. */
+    GDBSTUBTHRDACTION_INVALID = 0,
+    /** Let the thread run. */
+    GDBSTUBTHRDACTION_CONTINUE,
+    /** Single step the thread. */
+    GDBSTUBTHRDACTION_STEP,
+    /** Stop the thread. */
+    GDBSTUBTHRDACTION_STOP,
+    /** 32bit hack. */
+    GDBSTUBTHRDACTION_32BIT_HACK = 0x7fffffff
+} GDBSTUBTHRDACTION;
+
+
 /**
  * Trace point type.
  */
@@ -125,7 +168,10 @@ typedef enum GDBSTUBTPACTION
     GDBSTUBTPACTION_INVALID = 0,
     /** Stops execution of the target and returns control to the debugger. */
     GDBSTUBTPACTION_STOP,
-    /** @todo Dump data, execute commands, etc. */
+    /** Stops execution of the target like GDBSTUBTPACTION_STOP, the stub collects a trace frame and resumes
+     * the target right away without involving the debugger. Used for the tracepoints set by the stub itself. */
+    GDBSTUBTPACTION_TRACE,
+    /** @todo Execute commands, etc. */
     GDBSTUBTPACTION_32BIT_HACK = 0x7fffffff
 } GDBSTUBTPACTION;
 
@@ -163,12 +209,75 @@ typedef struct GDBSTUBREG
     uint32_t                    cRegBits;
     /** Register type. */
     GDBSTUBREGTYPE              enmType;
+    /** Register flags, combination of GDBSTUBREG_F_XXX. */
+    uint32_t                    fFlags;
 } GDBSTUBREG;
 /** Pointer to a register entry. */
 typedef GDBSTUBREG *PGDBSTUBREG;
 /** Pointer to a const register entry. */
 typedef const GDBSTUBREG *PCGDBSTUBREG;
 
+/** The register is sent along with every stop reply so the remote end doesn't need to query it afterwards.
+ * If no register has this flag set the program counter and stack pointer are sent. */
+#define GDBSTUBREG_F_EXPEDITE          (1U << 0)
+
+
+/**
+ * Prebuilt target description annex.
+ */
+typedef struct GDBSTUBTGTDESCANNEX
+{
+    /** The annex name the remote end requests through 'qXfer:features:read', NULL terminates the table. */
+    const char                  *pszAnnex;
+    /** The XML content. */
+    const void                  *pvDesc;
+    /** Size of the XML content in bytes (without any terminator). */
+    size_t                      cbDesc;
+} GDBSTUBTGTDESCANNEX;
+/** Pointer to a prebuilt target description annex. */
+typedef GDBSTUBTGTDESCANNEX *PGDBSTUBTGTDESCANNEX;
+/** Pointer to a const prebuilt target description annex. */
+typedef const GDBSTUBTGTDESCANNEX *PCGDBSTUBTGTDESCANNEX;
+
+
+/**
+ * Memory region type.
+ */
+typedef enum GDBSTUBMEMREGIONTYPE
+{
+    /** Invalid region type, do not use. */
+    GDBSTUBMEMREGIONTYPE_INVALID = 0,
+    /** Ordinary memory the remote end can read and write. */
+    GDBSTUBMEMREGIONTYPE_RAM,
+    /** Read-only memory. */
+    GDBSTUBMEMREGIONTYPE_ROM,
+    /** Flash memory which is only written through the flash callbacks in erase block granularity. */
+    GDBSTUBMEMREGIONTYPE_FLASH,
+    /** 32bit hack. */
+    GDBSTUBMEMREGIONTYPE_32BIT_HACK = 0x7fffffff
+} GDBSTUBMEMREGIONTYPE;
+
+
+/**
+ * A memory region entry of the memory map reported to the remote end.
+ */
+typedef struct GDBSTUBMEMREGION
+{
+    /** Start address of the region. */
+    GDBTGTMEMADDR               GdbTgtMemAddrStart;
+    /** Size of the region in bytes, 0 terminates the table. */
+    size_t                      cbRegion;
+    /** The region type. */
+    GDBSTUBMEMREGIONTYPE        enmType;
+    /** Size of an erase block in bytes for GDBSTUBMEMREGIONTYPE_FLASH, the blocks start at the beginning of
+     * the region and the region size must be a multiple of it. Ignored for the other types. */
+    size_t                      cbBlock;
+} GDBSTUBMEMREGION;
+/** Pointer to a memory region entry. */
+typedef GDBSTUBMEMREGION *PGDBSTUBMEMREGION;
+/** Pointer to a const memory region entry. */
+typedef const GDBSTUBMEMREGION *PCGDBSTUBMEMREGION;
+
 
 /** Forward decleration of a const output helper structure. */
 typedef const struct GDBSTUBOUTHLP *PCGDBSTUBOUTHLP;
@@ -189,6 +298,16 @@ typedef struct GDBSTUBOUTHLP
      */
     int (*pfnPrintf) (PCGDBSTUBOUTHLP pHlp, const char *pszFmt, ...);
 
+    /**
+     * Writes the given output as is, for large preformatted output.
+     *
+     * @returns Status code.
+     * @param   pHlp                Pointer to this structure.
+     * @param   pvOutput            The output to write.
+     * @param   cbOutput            Number of bytes to write.
+     */
+    int (*pfnWrite) (PCGDBSTUBOUTHLP pHlp, const void *pvOutput, size_t cbOutput);
+
 } GDBSTUBCMDOUTHLP;
 
 
@@ -224,10 +343,11 @@ typedef const GDBSTUBCMD *PCGDBSTUBCMD;
  */
 typedef struct GDBSTUBIF
 {
-    /** Architecture supported by this interface. */
+    /** Architecture supported by this interface, ignored if the library was built with GDBSTUB_FIXED_ARCH. */
     GDBSTUBTGTARCH              enmArch;
     /** Register entries for the target (the index will be used by the getter/setter callbacks),
-     * ended by an entry with a NULL name and 0 register bit size. */
+     * ended by an entry with a NULL name and 0 register bit size. Ignored if the library was built with
+     * GDBSTUB_FIXED_REGS, the register indizes refer to that table then (see examples/gdbstub-config-arm.h). */
     PCGDBSTUBREG                paRegs;
     /** Custom command descriptors, terminated by a NULL entry. */
     PCGDBSTUBCMD                paCmds;
@@ -365,9 +485,16 @@ typedef struct GDBSTUBIF
      * @param   pvUser              Opaque user data passed during creation of the stub context.
      * @param   GdbTgtTpAddr        The target address space memory address to set the trace point at.
      * @param   enmTpType           The tracepoint type (working on instructions or memory accesses).
+     * @param   uKind               For memory trace points the number of bytes to watch starting at the given address,
+     *                              for instruction trace points the architecture specific breakpoint kind
+     *                              (usually the size of the breakpoint instruction).
      * @param   enmTpAction         The action to execute if the tracepoint is hit.
+     *
+     * @note The remote end might set the same trace point more than once (to update the conditions evaluated by
+     *       the stub for example), this must not result in a duplicate.
      */
-    int    (*pfnTgtTpSet) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, GDBSTUBTPACTION enmTpAction);
+    int    (*pfnTgtTpSet) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind,
+                           GDBSTUBTPACTION enmTpAction);
 
     /**
      * Clears a previously set trace point at the given address - optional.
@@ -376,8 +503,10 @@ typedef struct GDBSTUBIF
      * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
      * @param   pvUser              Opaque user data passed during creation of the stub context.
      * @param   GdbTgtTpAddr        The target address space memory address to remove the trace point from.
+     * @param   enmTpType           The tracepoint type as given when it was set.
+     * @param   uKind               The number of bytes watched or the breakpoint kind as given when it was set.
      */
-    int    (*pfnTgtTpClear) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr);
+    int    (*pfnTgtTpClear) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtTpAddr, GDBSTUBTPTYPE enmTpType, uint64_t uKind);
 
     /**
      * Monitor command received callback - optional.
@@ -394,6 +523,148 @@ typedef struct GDBSTUBIF
      */
     int (*pfnMonCmd) (GDBSTUBCTX hGdbStubCtx, PCGDBSTUBOUTHLP pHlp, const char *pszCmd, void *pvUser);
 
+    /**
+     * Maps the given target address space range for reading - optional.
+     *
+     * @returns Status code.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   GdbTgtMemAddr       The target address space memory address to start the mapping at.
+     * @param   cbMap               Number of bytes the stub wants to access.
+     * @param   ppvMap              Where to store the pointer to the read-only mapping on success.
+     * @param   pcbMapped           Where to store the number of contiguous bytes accessible through the mapping
+     *                              on success, can be less than requested.
+     *
+     * @note This is meant for targets which have the memory in the host address space already (emulators for example)
+     *       so the stub can encode the data directly from there. If the callback is not available or fails the
+     *       stub falls back to pfnTgtMemRead().
+     */
+    int    (*pfnTgtMemMap) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtMemAddr, size_t cbMap, const void **ppvMap, size_t *pcbMapped);
+
+    /**
+     * Releases a mapping established with pfnTgtMemMap() - optional.
+     *
+     * @returns nothing.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   pvMap               The mapping as returned by pfnTgtMemMap().
+     * @param   cbMapped            The number of bytes mapped as returned by pfnTgtMemMap().
+     */
+    void   (*pfnTgtMemUnmap) (GDBSTUBCTX hGdbStubCtx, void *pvUser, const void *pvMap, size_t cbMapped);
+
+    /**
+     * Enumerates the threads of the target - optional.
+     *
+     * @returns Status code.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   idxStart            Index of the first thread to return.
+     * @param   paidThrds           Where to store the thread IDs.
+     * @param   cThrds              Maximum number of thread IDs to return.
+     * @param   pcThrds             Where to store the number of thread IDs returned, 0 if there are no more threads.
+     *
+     * @note Thread support (the 'H', 'T', 'qfThreadInfo' packets, per thread vCont actions and the non-stop mode)
+     *       is only enabled if this and the remaining pfnTgtThrd* callbacks are provided.
+     */
+    int    (*pfnTgtThrdsQuery) (GDBSTUBCTX hGdbStubCtx, void *pvUser, uint32_t idxStart, GDBTGTTHRDID *paidThrds, uint32_t cThrds,
+                                uint32_t *pcThrds);
+
+    /**
+     * Selects the thread the register and memory callbacks operate on - optional.
+     *
+     * @returns Status code.
+     * @retval  GDBSTUB_ERR_NOT_FOUND if the thread doesn't exist.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   idThrd              The thread to select.
+     */
+    int    (*pfnTgtThrdSelect) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTTHRDID idThrd);
+
+    /**
+     * Returns the state of the given thread - optional.
+     *
+     * @returns Thread state, GDBSTUBTGTSTATE_INVALID if the thread doesn't exist.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   idThrd              The thread to query.
+     */
+    GDBSTUBTGTSTATE (*pfnTgtThrdGetState) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTTHRDID idThrd);
+
+    /**
+     * Applies the given action to a single thread - optional.
+     *
+     * @returns Status code.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   idThrd              The thread to apply the action to.
+     * @param   enmAction           The action to apply.
+     *
+     * @note This must not wait for the thread to stop, every stop (including the ones caused by GDBSTUBTHRDACTION_STEP
+     *       and GDBSTUBTHRDACTION_STOP) is reported through GDBStubCtxNotifyThrdStop(). In all-stop mode the target
+     *       is expected to stop all threads before reporting a stop.
+     */
+    int    (*pfnTgtThrdAction) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTTHRDID idThrd, GDBSTUBTHRDACTION enmAction);
+
+    /** Prebuilt target description annexes, terminated by a NULL entry - optional. The table must contain the
+     * "target.xml" annex which can reference the others (separate core, FPU or vector features for example) through
+     * <xi:include href="..."/>. The content is served directly from the given memory which must stay valid for the
+     * lifetime of the context. If NULL the description is generated from the register table during creation,
+     * see GDBStubTgtDescGenerate(). */
+    PCGDBSTUBTGTDESCANNEX       paTgtDescAnnexes;
+
+    /** Memory regions of the target sorted by address, terminated by an entry with a 0 size - optional. If given the
+     * remote end gets a memory map through 'qXfer:memory-map:read' and treats any memory outside of the regions
+     * as inaccessible. Flash regions require the pfnTgtFlashErase() and pfnTgtFlashWrite() callbacks. */
+    PCGDBSTUBMEMREGION          paMemRegions;
+
+    /**
+     * Erases a flash memory range - optional.
+     *
+     * @returns Status code.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   GdbTgtMemAddr       Start of the range, aligned to an erase block of the region.
+     * @param   cbErase             Number of bytes to erase, a multiple of the erase block size of the region.
+     */
+    int    (*pfnTgtFlashErase) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtMemAddr, size_t cbErase);
+
+    /**
+     * Writes a single erase block of flash memory - optional.
+     *
+     * @returns Status code.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   GdbTgtMemAddr       Start of the erase block.
+     * @param   pvSrc               The complete content of the erase block.
+     * @param   cbWrite             Size of the erase block in bytes.
+     *
+     * @note The stub merges all writes of the remote end to an erase block, so every block is written once
+     *       per flash operation at most. Bytes the remote end didn't write keep the content read through
+     *       pfnTgtMemRead() before the first write to the block (the erased value usually).
+     */
+    int    (*pfnTgtFlashWrite) (GDBSTUBCTX hGdbStubCtx, void *pvUser, GDBTGTMEMADDR GdbTgtMemAddr, const void *pvSrc, size_t cbWrite);
+
+    /**
+     * Called when the remote end finished a flash operation, after the last block was written - optional.
+     *
+     * @returns Status code.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     */
+    int    (*pfnTgtFlashDone) (GDBSTUBCTX hGdbStubCtx, void *pvUser);
+
+    /**
+     * Returns a monotonic timestamp in nanoseconds - optional.
+     *
+     * @returns Timestamp in nanoseconds.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     *
+     * @note Only used for the latency statistics if the library is built with GDBSTUB_WITH_STATS,
+     *       all latencies are recorded as 0 without it.
+     */
+    uint64_t (*pfnTimeNsQuery) (GDBSTUBCTX hGdbStubCtx, void *pvUser);
+
 } GDBSTUBIF;
 /** Pointer to a interface callback table. */
 typedef GDBSTUBIF *PGDBSTUBIF;
@@ -407,20 +678,22 @@ typedef const GDBSTUBIF *PCGDBSTUBIF;
 typedef struct GDBSTUBIOIF
 {
     /** 
-     * Returns amount of data available for reading (for optimized buffer allocations).
+     * Returns amount of data available for reading (for optimized buffer allocations) - optional if all data
+     * is handed over through GDBStubCtxFeed().
      *
      * @returns Amount of bytes available for reading.
      * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
-     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   pvUser              Opaque user data passed during creation of the stub context (or GDBSTUBCFG::pvIoUser).
      */
     size_t (*pfnPeek) (GDBSTUBCTX hGdbStubCtx, void *pvUser);
 
     /**
-     * Read data from the underlying transport layer - non blocking.
+     * Read data from the underlying transport layer - non blocking, optional if all data is handed over
+     * through GDBStubCtxFeed().
      *
      * @returns Status code.
      * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
-     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   pvUser              Opaque user data passed during creation of the stub context (or GDBSTUBCFG::pvIoUser).
      * @param   pvDst               Where to store the read data.
      * @param   cbRead              Maximum number of bytes to read.
      * @param   pcbRead             Where to store the number of bytes actually read.
@@ -432,12 +705,14 @@ typedef struct GDBSTUBIOIF
      *
      * @returns Status code.
      * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
-     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   pvUser              Opaque user data passed during creation of the stub context (or GDBSTUBCFG::pvIoUser).
      * @param   pvPkt               The packet data to write.
      * @param   cbPkt               The number of bytes to write.
      *
      * @note Unlike the read callback this should only return when the whole packet has been written
      *       or an unrecoverable error occurred.
+     * @note The stub assembles the acknowledge and the complete framed reply for a packet in an internal
+     *       buffer and hands it over with a single call (unless the reply exceeds the buffer size).
      */
     int    (*pfnWrite) (GDBSTUBCTX hGdbStubCtx, void *pvUser, const void *pvPkt, size_t cbPkt);
 
@@ -446,12 +721,25 @@ typedef struct GDBSTUBIOIF
      *
      * @returns Status code.
      * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
-     * @param   pvUser              Opaque user data passed during creation of the stub context.
+     * @param   pvUser              Opaque user data passed during creation of the stub context (or GDBSTUBCFG::pvIoUser).
      *
      * @note This is an optional callback, if not available and there is no data to read from the underlying
      *       transport layer GDBStubCtxRun() will return and must be invoked again when there is something to read.
      */
     int    (*pfnPoll) (GDBSTUBCTX hGdbStubCtx, void *pvUser);
+
+    /**
+     * Wakes up a thread blocked in the poll callback - optional.
+     *
+     * @returns nothing.
+     * @param   hGdbStubCtx         The GDB stub context handle invoking the callback.
+     * @param   pvUser              Opaque user data passed during creation of the stub context (or GDBSTUBCFG::pvIoUser).
+     *
+     * @note This gets called from GDBStubCtxNotifyStop() and the other functions callable from any thread on the
+     *       notifying thread, so it must be safe to call concurrently with the poll callback. The poll callback
+     *       should return GDBSTUB_INF_SUCCESS when woken up.
+     */
+    void   (*pfnPollWakeup) (GDBSTUBCTX hGdbStubCtx, void *pvUser);
 } GDBSTUBIOIF;
 /** Pointer to a I/O interface callback table. */
 typedef GDBSTUBIOIF *PGDBSTUBIOIF;
@@ -459,6 +747,225 @@ typedef GDBSTUBIOIF *PGDBSTUBIOIF;
 typedef const GDBSTUBIOIF *PCGDBSTUBIOIF;
 
 
+/** Default maximum packet size in bytes if not configured otherwise. */
+#define GDBSTUB_PKT_SIZE_DEF           (16 * 1024)
+/** Minimum packet size in bytes which can be configured. */
+#define GDBSTUB_PKT_SIZE_MIN           512
+/** Default memory cache line size in bytes if not configured otherwise. */
+#define GDBSTUB_MEM_CACHE_LINE_SIZE_DEF 1024
+/** Default maximum size of the conditions of a single breakpoint in bytes. */
+#define GDBSTUB_BP_CONDS_SIZE_DEF      256
+/** Default maximum size of the condition and actions of a single tracepoint in bytes. */
+#define GDBSTUB_TRACE_POINT_SIZE_DEF   512
+/** Default size of the trace frame buffer in bytes. */
+#define GDBSTUB_TRACE_BUF_SIZE_DEF     (64 * 1024)
+
+
+/** Number of buckets of a latency histogram. */
+#define GDBSTUBSTATS_LAT_BUCKETS       16
+/** Number of packet types distinguished by the statistics (indexed by the first character of the packet). */
+#define GDBSTUBSTATS_PKT_TYPES         128
+
+
+/**
+ * Interface callbacks the latency is recorded for.
+ */
+typedef enum GDBSTUBSTATSIF
+{
+    /** GDBSTUBIF::pfnTgtGetState. */
+    GDBSTUBSTATSIF_TGT_GET_STATE = 0,
+    /** GDBSTUBIF::pfnTgtStop. */
+    GDBSTUBSTATSIF_TGT_STOP,
+    /** GDBSTUBIF::pfnTgtRestart. */
+    GDBSTUBSTATSIF_TGT_RESTART,
+    /** GDBSTUBIF::pfnTgtKill. */
+    GDBSTUBSTATSIF_TGT_KILL,
+    /** GDBSTUBIF::pfnTgtStep. */
+    GDBSTUBSTATSIF_TGT_STEP,
+    /** GDBSTUBIF::pfnTgtCont. */
+    GDBSTUBSTATSIF_TGT_CONT,
+    /** GDBSTUBIF::pfnTgtMemRead. */
+    GDBSTUBSTATSIF_TGT_MEM_READ,
+    /** GDBSTUBIF::pfnTgtMemWrite. */
+    GDBSTUBSTATSIF_TGT_MEM_WRITE,
+    /** GDBSTUBIF::pfnTgtMemMap. */
+    GDBSTUBSTATSIF_TGT_MEM_MAP,
+    /** GDBSTUBIF::pfnTgtRegsRead. */
+    GDBSTUBSTATSIF_TGT_REGS_READ,
+    /** GDBSTUBIF::pfnTgtRegsWrite. */
+    GDBSTUBSTATSIF_TGT_REGS_WRITE,
+    /** GDBSTUBIF::pfnTgtTpSet. */
+    GDBSTUBSTATSIF_TGT_TP_SET,
+    /** GDBSTUBIF::pfnTgtTpClear. */
+    GDBSTUBSTATSIF_TGT_TP_CLEAR,
+    /** GDBSTUBIF::pfnTgtThrdsQuery. */
+    GDBSTUBSTATSIF_TGT_THRDS_QUERY,
+    /** GDBSTUBIF::pfnTgtThrdSelect. */
+    GDBSTUBSTATSIF_TGT_THRD_SELECT,
+    /** GDBSTUBIF::pfnTgtThrdGetState. */
+    GDBSTUBSTATSIF_TGT_THRD_GET_STATE,
+    /** GDBSTUBIF::pfnTgtThrdAction. */
+    GDBSTUBSTATSIF_TGT_THRD_ACTION,
+    /** GDBSTUBIF::pfnTgtFlashErase. */
+    GDBSTUBSTATSIF_TGT_FLASH_ERASE,
+    /** GDBSTUBIF::pfnTgtFlashWrite. */
+    GDBSTUBSTATSIF_TGT_FLASH_WRITE,
+    /** GDBSTUBIF::pfnTgtFlashDone. */
+    GDBSTUBSTATSIF_TGT_FLASH_DONE,
+    /** Number of entries. */
+    GDBSTUBSTATSIF_COUNT
+} GDBSTUBSTATSIF;
+
+
+/**
+ * Latency statistics.
+ */
+typedef struct GDBSTUBSTATSLAT
+{
+    /** Number of samples. */
+    uint64_t                    cSamples;
+    /** Sum of all samples in nanoseconds. */
+    uint64_t                    cNsTotal;
+    /** Largest sample in nanoseconds. */
+    uint64_t                    cNsMax;
+    /** Histogram, bucket 0 counts the samples below 1024ns, bucket i the samples below 1024ns << i
+     * and the last bucket all remaining ones. */
+    uint64_t                    acBuckets[GDBSTUBSTATS_LAT_BUCKETS];
+} GDBSTUBSTATSLAT;
+/** Pointer to latency statistics. */
+typedef GDBSTUBSTATSLAT *PGDBSTUBSTATSLAT;
+/** Pointer to const latency statistics. */
+typedef const GDBSTUBSTATSLAT *PCGDBSTUBSTATSLAT;
+
+
+/**
+ * Statistics of a single packet type.
+ */
+typedef struct GDBSTUBSTATSPKT
+{
+    /** Number of packets received. */
+    uint64_t                    cPkts;
+    /** Number of bytes received including the framing. */
+    uint64_t                    cbIn;
+    /** Number of bytes sent in reply including the framing. */
+    uint64_t                    cbOut;
+    /** Time spent processing the packets in nanoseconds, including the interface callbacks. */
+    uint64_t                    cNsTotal;
+} GDBSTUBSTATSPKT;
+/** Pointer to the statistics of a single packet type. */
+typedef GDBSTUBSTATSPKT *PGDBSTUBSTATSPKT;
+/** Pointer to the const statistics of a single packet type. */
+typedef const GDBSTUBSTATSPKT *PCGDBSTUBSTATSPKT;
+
+
+/**
+ * Statistics collected by a GDB stub context.
+ */
+typedef struct GDBSTUBSTATS
+{
+    /** Number of bytes received. */
+    uint64_t                    cbIn;
+    /** Number of bytes sent. */
+    uint64_t                    cbOut;
+    /** Number of acknowledges received. */
+    uint64_t                    cAcksRecv;
+    /** Number of negative acknowledges received (the remote end requesting a retransmission). */
+    uint64_t                    cNaksRecv;
+    /** Number of acknowledges sent. */
+    uint64_t                    cAcksSent;
+    /** Number of negative acknowledges sent because of a checksum mismatch (each causes a retransmission). */
+    uint64_t                    cNaksSent;
+    /** Processing latency of all packets, including the interface callbacks. */
+    GDBSTUBSTATSLAT             PktProcess;
+    /** Latency of the individual interface callbacks, indexed by GDBSTUBSTATSIF. */
+    GDBSTUBSTATSLAT             aTgtIf[GDBSTUBSTATSIF_COUNT];
+    /** Statistics for each packet type, indexed by the first character of the packet. */
+    GDBSTUBSTATSPKT             aPkts[GDBSTUBSTATS_PKT_TYPES];
+} GDBSTUBSTATS;
+/** Pointer to GDB stub statistics. */
+typedef GDBSTUBSTATS *PGDBSTUBSTATS;
+/** Pointer to const GDB stub statistics. */
+typedef const GDBSTUBSTATS *PCGDBSTUBSTATS;
+
+
+/**
+ * GDB stub context configuration passed during creation.
+ *
+ * @note Members which are 0 select the default.
+ */
+typedef struct GDBSTUBCFG
+{
+    /** Maximum packet size in bytes (excluding the framing) the stub accepts and advertises to the remote end,
+     * the packet buffers are allocated once with this size during creation. Defaults to GDBSTUB_PKT_SIZE_DEF
+     * and is increased automatically if the reply to read all registers would exceed it. */
+    size_t                      cbPktMax;
+    /** Configuration flags, combination of GDBSTUBCFG_F_XXX. */
+    uint32_t                    fFlags;
+    /** Size of the target memory read cache in bytes, 0 disables the cache. The cache is only used
+     * while the target is stopped and is invalidated whenever the target resumes or memory is written. */
+    size_t                      cbMemCache;
+    /** Size of a single memory cache line in bytes, must be a power of two. A cache line gets read with a single
+     * memory read callback invocation. Defaults to GDBSTUB_MEM_CACHE_LINE_SIZE_DEF. */
+    size_t                      cbMemCacheLine;
+    /** Opaque user data passed to the I/O interface callbacks instead of the one given during creation, if not NULL.
+     * This allows keeping the transport state separate from the target state. */
+    void                        *pvIoUser;
+    /** Memory supplied by the caller holding the context and all of its buffers, if not NULL the
+     * allocation callbacks are never invoked (and can be NULL), see GDBStubCtxQueryArenaSize(). */
+    void                        *pvArena;
+    /** Size of the arena in bytes. */
+    size_t                      cbArena;
+    /** Maximum number of breakpoints with conditions evaluated by the stub, 0 disables conditional breakpoints.
+     * A breakpoint stop (GDBSTUBSTOPREASON_TRAP with the program counter pointing to the breakpoint address) is only
+     * reported if one of its conditions holds, the target is resumed right away otherwise. */
+    uint32_t                    cBpConds;
+    /** Maximum size of all conditions (agent expression bytecode) of a single breakpoint in bytes.
+     * Defaults to GDBSTUB_BP_CONDS_SIZE_DEF. */
+    size_t                      cbBpCondsMax;
+    /** Maximum number of tracepoint locations the remote end can define, 0 disables tracepoints. While tracing
+     * the stub sets the tracepoints with GDBSTUBTPACTION_TRACE, collects a frame on each hit (a GDBSTUBSTOPREASON_TRAP
+     * stop with the program counter pointing to the tracepoint address) and resumes the target right away.
+     * A breakpoint of the remote end at a tracepoint address is not reported while tracing. */
+    uint32_t                    cTracePoints;
+    /** Maximum size of the condition and actions of a single tracepoint in bytes.
+     * Defaults to GDBSTUB_TRACE_POINT_SIZE_DEF. */
+    size_t                      cbTracePointMax;
+    /** Size of the buffer holding the collected trace frames in bytes, allocated once during creation.
+     * Defaults to GDBSTUB_TRACE_BUF_SIZE_DEF. */
+    size_t                      cbTraceBuf;
+} GDBSTUBCFG;
+/** Pointer to a GDB stub configuration. */
+typedef GDBSTUBCFG *PGDBSTUBCFG;
+/** Pointer to a const GDB stub configuration. */
+typedef const GDBSTUBCFG *PCGDBSTUBCFG;
+
+/** Cache the register content while the target is stopped, registers are only read once after each stop
+ * and modified registers are written back right before the target is resumed. */
+#define GDBSTUBCFG_F_REGS_CACHE        (1U << 0)
+/** Don't write out the queued replies when GDBStubCtxRun() or GDBStubCtxFeed() return, they are only written when
+ * the output buffer fills up, before blocking in GDBSTUBIOIF::pfnPoll or when GDBStubCtxFlush() is called. */
+#define GDBSTUBCFG_F_FLUSH_MANUAL      (1U << 1)
+/** Stream the output of monitor commands to the remote end as 'O' packets of the advertised packet size while the
+ * command runs instead of collecting it into a single reply, so large output is displayed as it is produced. */
+#define GDBSTUBCFG_F_MON_OUTPUT_STREAM (1U << 2)
+
+
+/*
+ * Threading model:
+ *
+ * A context is driven by a single thread at a time, the owner, calling GDBStubCtxRun(), GDBStubCtxFeed(),
+ * GDBStubCtxFlush(), GDBStubCtxReset(), the statistics functions and finally GDBStubCtxDestroy(). All
+ * interface callbacks except GDBSTUBIOIF::pfnPollWakeup are invoked on the owner, the context itself takes
+ * no locks. The owner may change between calls as long as the caller synchronizes the hand over.
+ *
+ * GDBStubCtxNotifyStop(), GDBStubCtxNotifyThrdStop(), GDBStubCtxNotifyOutput() and GDBStubCtxDisconnect()
+ * can be called from any number of threads concurrently (also from within the interface callbacks). They
+ * never block or take a lock: events go into a bounded lock-free queue in the context and the owner gets
+ * woken up through GDBSTUBIOIF::pfnPollWakeup, it processes them in order before looking at the next data
+ * from the remote end. They must not be called anymore once GDBStubCtxDestroy() was called.
+ */
+
+
 /**
  * Creates a new GDB stub context with the given callback table.
  *
@@ -470,6 +977,45 @@ typedef const GDBSTUBIOIF *PCGDBSTUBIOIF;
  */
 int GDBStubCtxCreate(PGDBSTUBCTX phCtx, PCGDBSTUBIOIF pIoIf, PCGDBSTUBIF pIf, void *pvUser);
 
+/**
+ * Creates a new GDB stub context with the given callback table and configuration.
+ *
+ * @returns Status code.
+ * @param   phCtx                   Where to store the handle to the GDB stub context on success.
+ * @param   pIoIf                   The I/O interface callback table pointer.
+ * @param   pIf                     The interface callback table pointer.
+ * @param   pCfg                    The configuration to use, NULL for the defaults.
+ * @param   pvUser                  Opaque user data to pass to the interface callbacks.
+ */
+int GDBStubCtxCreateEx(PGDBSTUBCTX phCtx, PCGDBSTUBIOIF pIoIf, PCGDBSTUBIF pIf, PCGDBSTUBCFG pCfg, void *pvUser);
+
+/**
+ * Returns the size of the arena required to create a GDB stub context with the given configuration.
+ *
+ * @returns Status code.
+ * @param   pIf                     The interface callback table pointer.
+ * @param   pCfg                    The configuration to use, NULL for the defaults.
+ * @param   pcbArena                Where to store the size of the arena in bytes on success.
+ *
+ * @note Without an arena all memory is allocated with a single GDBSTUBIF::pfnMemAlloc call during creation,
+ *       nothing gets allocated while processing packets.
+ */
+int GDBStubCtxQueryArenaSize(PCGDBSTUBIF pIf, PCGDBSTUBCFG pCfg, size_t *pcbArena);
+
+/**
+ * Generates the target description for the register table of the given interface, like it is done during context
+ * creation if no prebuilt description is supplied. This allows generating the description once (or at build time
+ * with a small host program) to provide it through GDBSTUBIF::paTgtDescAnnexes.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the buffer is too small, the required size is returned in pcbDesc.
+ * @param   pIf                     The interface callback table pointer.
+ * @param   pvBuf                   Where to store the description, the content is not terminated.
+ * @param   cbBuf                   Size of the buffer in bytes.
+ * @param   pcbDesc                 Where to store the size of the description in bytes.
+ */
+int GDBStubTgtDescGenerate(PCGDBSTUBIF pIf, void *pvBuf, size_t cbBuf, size_t *pcbDesc);
+
 /**
  * Destroys a given GDB stub context.
  *
@@ -483,15 +1029,126 @@ void GDBStubCtxDestroy(GDBSTUBCTX hCtx);
  *
  * @returns Status code.
  * @param   hCtx                    The GDB stub context handle.
+ *
+ * @note All complete packets received are processed before the queued replies are written out at once.
  */
 int GDBStubCtxRun(GDBSTUBCTX hCtx);
 
+/**
+ * Writes out all replies queued so far.
+ *
+ * @returns Status code.
+ * @param   hCtx                    The GDB stub context handle.
+ *
+ * @note Must not be called concurrently with GDBStubCtxRun() or GDBStubCtxFeed(), only required
+ *       with GDBSTUBCFG_F_FLUSH_MANUAL.
+ */
+int GDBStubCtxFlush(GDBSTUBCTX hCtx);
+
+/**
+ * Processes data received from the remote end by the caller instead of reading it through the I/O interface.
+ *
+ * @returns Status code.
+ * @param   hCtx                    The GDB stub context handle.
+ * @param   pvData                  The received data.
+ * @param   cbData                  Number of bytes received.
+ *
+ * @note Complete packets are processed directly from the given buffer which might get modified while doing so
+ *       (escaped binary data is decoded in place), only packets crossing the buffer boundaries are copied.
+ *       Replies are still written through GDBSTUBIOIF::pfnWrite.
+ * @note Stops and output notified asynchronously are sent during the next call, GDBStubCtxRun() can be used to
+ *       send them without any new data if GDBSTUBIOIF::pfnPeek is not available.
+ */
+int GDBStubCtxFeed(GDBSTUBCTX hCtx, void *pvData, size_t cbData);
+
 /**
  * Resets the given GDB stub context to an initial state without freeing allocated scratch buffers.
+ * Anything negotiated with the remote end (like the no acknowledge mode) is reset as well so the context
+ * can be used for a new connection.
  *
  * @returns Status code.
  * @param   hCtx                    The GDB stub context handle.
  */
 int GDBStubCtxReset(GDBSTUBCTX hCtx);
 
+/**
+ * Notifies the GDB stub context that the target stopped, the stop reply is sent to the remote end
+ * by the thread running GDBStubCtxRun() as soon as possible.
+ *
+ * @returns Status code.
+ * @param   hCtx                    The GDB stub context handle.
+ * @param   enmReason               The reason the target stopped.
+ *
+ * @note This can be called from any thread, a thread blocking in the poll callback gets woken up
+ *       through the optional GDBSTUBIOIF::pfnPollWakeup callback. Without a poll callback the stop
+ *       reply is sent during the next GDBStubCtxRun() invocation.
+ * @note In all-stop mode notifications while the target is already considered stopped by the stub are ignored.
+ */
+int GDBStubCtxNotifyStop(GDBSTUBCTX hCtx, GDBSTUBSTOPREASON enmReason);
+
+/**
+ * Notifies the GDB stub context that the given thread stopped, like GDBStubCtxNotifyStop() but reporting
+ * the thread to the remote end.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if too many stops are waiting to be reported already.
+ * @param   hCtx                    The GDB stub context handle.
+ * @param   idThrd                  The thread which stopped.
+ * @param   enmReason               The reason the thread stopped.
+ *
+ * @note In non-stop mode every notification is reported to the remote end (through the '%Stop' notification
+ *       and the following 'vStopped' packets), in all-stop mode only the first one is reported.
+ */
+int GDBStubCtxNotifyThrdStop(GDBSTUBCTX hCtx, GDBTGTTHRDID idThrd, GDBSTUBSTOPREASON enmReason);
+
+/**
+ * Queues output for the console of the remote end, sent as 'O' packets by the thread running the context.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_BUFFER_OVERFLOW if the event queue is full, only the leading part of the output was queued.
+ * @param   hCtx                    The GDB stub context handle.
+ * @param   pvOutput                The output to send.
+ * @param   cbOutput                Number of bytes to send.
+ *
+ * @note This can be called from any thread. The remote end accepts output only in all-stop mode while the resumed
+ *       target runs, so it is kept until then and dropped if too much piles up. Output from concurrent callers
+ *       might get interleaved in chunks of a few dozen bytes.
+ */
+int GDBStubCtxNotifyOutput(GDBSTUBCTX hCtx, const void *pvOutput, size_t cbOutput);
+
+/**
+ * Requests the thread running the context to drop the connection to the remote end.
+ *
+ * @returns Status code.
+ * @param   hCtx                    The GDB stub context handle.
+ *
+ * @note This can be called from any thread. GDBStubCtxRun() and GDBStubCtxFeed() return GDBSTUB_ERR_PEER_DISCONNECTED
+ *       after writing out the queued replies until GDBStubCtxReset() is called, closing the connection is up to
+ *       the caller (the server does it for every error).
+ */
+int GDBStubCtxDisconnect(GDBSTUBCTX hCtx);
+
+/**
+ * Queries the statistics collected by the given GDB stub context.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_NOT_SUPPORTED if the library was built without GDBSTUB_WITH_STATS.
+ * @param   hCtx                    The GDB stub context handle.
+ * @param   pStats                  Where to store the statistics.
+ *
+ * @note The statistics are also available to the remote end through the built-in "monitor stats" command
+ *       (a custom command with the same name takes precedence). They are updated without synchronization,
+ *       so this must be called from the thread running the context to get consistent values.
+ */
+int GDBStubCtxQueryStats(GDBSTUBCTX hCtx, PGDBSTUBSTATS pStats);
+
+/**
+ * Resets the statistics of the given GDB stub context.
+ *
+ * @returns Status code.
+ * @retval  GDBSTUB_ERR_NOT_SUPPORTED if the library was built without GDBSTUB_WITH_STATS.
+ * @param   hCtx                    The GDB stub context handle.
+ */
+int GDBStubCtxResetStats(GDBSTUBCTX hCtx);
+
 #endif /* __libgdbstub_h */